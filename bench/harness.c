@@ -0,0 +1,258 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+/*!
+ * @file  harness.c
+ * @brief Micro-benchmark harness.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "harness.h"
+#include "preprocessor/environment.h"
+#include "timer.h"
+#include "topology.h"
+
+/* <!-- Timing {{{ --> */
+
+static int
+reboot_bench_compare_(const void *left, const void *right)
+{
+   uint64_t a = *(const uint64_t *) left;
+   uint64_t b = *(const uint64_t *) right;
+
+   return (a > b) - (a < b);
+}
+
+/*!
+ * Every  sample times a single call, the counter being
+ * cheap enough for the overhead of the two reads, tens
+ * of  ticks,  to only matter for kernels  that  should
+ * rather be timed over a larger input.
+ */
+static void
+reboot_bench_time_(
+   const reboot_bench_variant_t *variant, void *state,
+   const reboot_bench_options_t *options, uint64_t *samples,
+   reboot_bench_result_t *result
+) {
+   unsigned repetitions = options->repetitions;
+   unsigned i;
+
+   for (i = 0; i < options->warmup; ++i) {
+      variant->function(state);
+   }
+
+   for (i = 0; i < repetitions; ++i) {
+      uint64_t start = REBOOT_RDTSC();
+
+      variant->function(state);
+
+      samples[i] = REBOOT_RDTSCP() - start;
+   }
+
+   qsort(samples, repetitions, sizeof *samples, reboot_bench_compare_);
+
+   result->min    = samples[0];
+   result->median = samples[repetitions / 2u];
+   result->p99    = samples[(repetitions - 1u) * 99u / 100u];
+}
+
+int
+reboot_bench_run(
+   const reboot_bench_variant_t *variants, size_t count, void *state,
+   const reboot_bench_options_t *options, reboot_bench_result_t *results
+) {
+   uint64_t *samples;
+   int       winner = -1;
+   size_t    i;
+
+   if (options->repetitions == 0) {
+      return -1;
+   }
+
+   samples = (uint64_t *) malloc(options->repetitions * sizeof *samples);
+
+   if (samples == NULL) {
+      return -1;
+   }
+
+   for (i = 0; i < count; ++i) {
+      memset(&results[i], 0, sizeof results[i]);
+
+      results[i].name      = variants[i].name;
+      results[i].supported = REBOOT_CPU_HAS(variants[i].mask);
+
+      if (!results[i].supported) {
+         continue;
+      }
+
+      reboot_bench_time_(&variants[i], state, options, samples, &results[i]);
+
+      if (winner < 0 || results[i].median < results[winner].median) {
+         winner = (int) i;
+      }
+   }
+
+   free(samples);
+
+   return winner;
+}
+
+/* <!-- }}} Timing --> */
+
+/* <!-- Reporting {{{ --> */
+
+void
+reboot_bench_report(
+   FILE *stream, const char *benchmark, const reboot_bench_result_t *results,
+   size_t count, int winner, const reboot_bench_options_t *options
+) {
+   const reboot_bench_result_t *baseline = &results[count - 1u];
+   size_t                       i;
+
+   fprintf(
+      stream, "%-20s %-12s %12s %12s %12s %12s %8s\n", benchmark, "variant",
+      "min", "median", "p99", "median/ns", "c/B"
+   );
+
+   for (i = 0; i < count; ++i) {
+      const reboot_bench_result_t *result = &results[i];
+
+      if (!result->supported) {
+         fprintf(
+            stream, "%-20s %-12s %12s\n", "", result->name, "unsupported"
+         );
+         continue;
+      }
+
+      fprintf(
+         stream, "%-20s %-12s %12llu %12llu %12llu %12llu",
+         "", result->name,
+         (unsigned long long) result->min,
+         (unsigned long long) result->median,
+         (unsigned long long) result->p99,
+         (unsigned long long) reboot_timer_nanoseconds(result->median)
+      );
+
+      if (options->bytes != 0) {
+         fprintf(
+            stream, " %8.3f", (double) result->median / (double) options->bytes
+         );
+      }
+
+      fputc('\n', stream);
+   }
+
+   if (winner < 0) {
+      return;
+   }
+
+   fprintf(stream, "%-20s winner : %s", "", results[winner].name);
+
+   if (baseline->supported && results[winner].median != 0) {
+      fprintf(
+         stream, ", %.2fx over %s",
+         (double) baseline->median / (double) results[winner].median,
+         baseline->name
+      );
+   }
+
+   fputc('\n', stream);
+}
+
+/*!
+ * Feature     names     follow    the     flags     of
+ * `preprocessor/environment/cpu.h`, in the same order.
+ */
+static const struct {
+   reboot_cpu_features_t mask;
+   const char           *name;
+} reboot_bench_features_[] = {
+   { REBOOT_CPU_SSE,      "sse"      },
+   { REBOOT_CPU_SSE2,     "sse2"     },
+   { REBOOT_CPU_SSE3,     "sse3"     },
+   { REBOOT_CPU_SSSE3,    "ssse3"    },
+   { REBOOT_CPU_SSE4_1,   "sse4.1"   },
+   { REBOOT_CPU_SSE4_2,   "sse4.2"   },
+   { REBOOT_CPU_POPCNT,   "popcnt"   },
+   { REBOOT_CPU_PCLMUL,   "pclmul"   },
+   { REBOOT_CPU_AVX,      "avx"      },
+   { REBOOT_CPU_AVX2,     "avx2"     },
+   { REBOOT_CPU_FMA,      "fma"      },
+   { REBOOT_CPU_BMI1,     "bmi1"     },
+   { REBOOT_CPU_BMI2,     "bmi2"     },
+   { REBOOT_CPU_LZCNT,    "lzcnt"    },
+   { REBOOT_CPU_AVX512F,  "avx512f"  },
+   { REBOOT_CPU_AVX512BW, "avx512bw" },
+   { REBOOT_CPU_AVX512CD, "avx512cd" },
+   { REBOOT_CPU_AVX512DQ, "avx512dq" },
+   { REBOOT_CPU_AVX512VL, "avx512vl" },
+   { REBOOT_CPU_NEON,     "neon"     },
+   { REBOOT_CPU_AES,      "aes"      },
+   { REBOOT_CPU_PMULL,    "pmull"    },
+   { REBOOT_CPU_CRC32,    "crc32"    },
+   { REBOOT_CPU_SVE,      "sve"      },
+   { REBOOT_CPU_SVE2,     "sve2"     },
+   { REBOOT_CPU_ALTIVEC,  "altivec"  },
+   { REBOOT_CPU_VSX,      "vsx"      },
+   { REBOOT_CPU_RVV,      "rvv"      }
+};
+
+#if defined(REBOOT_TIMER_HAS_COUNTER)
+static const char reboot_bench_counter_[] = "counter";
+#else
+static const char reboot_bench_counter_[] = "clock";
+#endif
+
+void
+reboot_bench_environment(FILE *stream)
+{
+   reboot_cpu_features_t features = reboot_cpu_features();
+   reboot_topology_t     topology;
+   char                  build[256];
+   size_t                i;
+
+   reboot_environment_format(&reboot_environment, build, sizeof build);
+
+   fprintf(stream, "build    : %s\n", build);
+   fprintf(stream, "host     : isa=0x%llx", (unsigned long long) features);
+
+   for (i = 0; i < sizeof reboot_bench_features_
+                 / sizeof reboot_bench_features_[0]; ++i) {
+      if ((features & reboot_bench_features_[i].mask) != 0) {
+         fprintf(stream, " %s", reboot_bench_features_[i].name);
+      }
+   }
+
+   fputc('\n', stream);
+
+   if (reboot_topology_init(&topology) == 0) {
+      fprintf(
+         stream,
+         "topology : cpus=%u cores=%u packages=%u nodes=%u llc=%u x %lu KiB\n",
+         topology.cpu_count, topology.core_count, topology.package_count,
+         topology.node_count, topology.cache_count,
+         (unsigned long) (topology.cache_size >> 10)
+      );
+
+      reboot_topology_destroy(&topology);
+   }
+
+   fprintf(
+      stream, "timer    : %s at %llu Hz\n", reboot_bench_counter_,
+      (unsigned long long) reboot_timer_frequency()
+   );
+}
+
+/* <!-- }}} Reporting --> */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
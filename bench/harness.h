@@ -0,0 +1,139 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+#ifndef __REBOOT_BENCH_HARNESS_H__
+#define __REBOOT_BENCH_HARNESS_H__
+
+/*!
+ * @file  harness.h
+ * @brief Micro-benchmark harness.
+ *
+ * A  benchmark runs every variant of a kernel the host
+ * supports back to back, each one warmed up then timed
+ * over  a number of repetitions of a single call,  and
+ * reports per variant :
+ *
+ * - `median` : Median call latency.
+ * - `p99`    : 99th percentile latency.
+ * - `c/B`    : Median ticks per byte.
+ *
+ * Variants  are the members of a function family built
+ * with `REBOOT_MULTIVERSION_VARIANT`, each listed with
+ * the  features it requires. The individual clones  of
+ * `REBOOT_TARGET_CLONES`  are bound by the loader  and
+ * cannot be called one by one, the family is therefore
+ * the only way to compare them on the same host.
+ *
+ * Ticks are read from `timer.h`, i.e. reference cycles
+ * of the time stamp counter on x86, which keep ticking
+ * at  the nominal frequency whatever the core runs at.
+ * Latencies  are also reported in nanoseconds, so that
+ * the  frequency drop wide vector instructions trigger
+ * on  some  processors shows in the comparison  rather
+ * than being hidden by it.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "preprocessor/environment/cpu.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! <!-- Benchmarks {{{ -->
+ * @addtogroup  bench_harness Benchmarks
+ * @brief Kernel variants and their timings
+ * @{
+ */
+
+/*!
+ * @brief Kernel variant.
+ *
+ * `function` is called with the benchmark `state` once
+ * per  repetition,  and  is skipped  unless  the  host
+ * supports every feature in `mask`.
+ */
+typedef struct reboot_bench_variant {
+   const char            *name;
+   reboot_cpu_features_t  mask;
+   void                 (*function)(void *state);
+} reboot_bench_variant_t;
+
+/*!
+ * @brief Benchmark parameters.
+ *
+ * `bytes`  is  the  number  of  bytes  a  single  call
+ * processes,  `0`  leaving ticks per byte out  of  the
+ * report.
+ */
+typedef struct reboot_bench_options {
+   unsigned warmup;
+   unsigned repetitions;
+   size_t   bytes;
+} reboot_bench_options_t;
+
+/*!
+ * @brief Variant timings, in ticks.
+ */
+typedef struct reboot_bench_result {
+   const char *name;
+   int         supported;
+   uint64_t    min;
+   uint64_t    median;
+   uint64_t    p99;
+} reboot_bench_result_t;
+
+/*!
+ * @brief Benchmark run.
+ *
+ * This   function  times  the  `count`  variants  over
+ * `state` into `results`, and returns the index of the
+ * fastest   one  by  median,  or  `-1`  when  none  is
+ * supported or out of memory.
+ */
+int reboot_bench_run(
+   const reboot_bench_variant_t *variants, size_t count, void *state,
+   const reboot_bench_options_t *options, reboot_bench_result_t *results
+);
+
+/*!
+ * @brief Benchmark report.
+ *
+ * This   function  writes  one  line  per  variant  to
+ * `stream`,  followed  by the winning variant and  its
+ * speedup over the last, baseline, one.
+ */
+void reboot_bench_report(
+   FILE *stream, const char *benchmark, const reboot_bench_result_t *results,
+   size_t count, int winner, const reboot_bench_options_t *options
+);
+
+/*!
+ * @brief Environment report.
+ *
+ * This  function  writes the build environment of  the
+ * harness,  the features of the host, its topology and
+ * the  tick frequency to `stream`, so that results can
+ * be told apart once collected from several machines.
+ */
+void reboot_bench_environment(FILE *stream);
+
+/*! @} <!-- }}} Benchmarks --> */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __REBOOT_BENCH_HARNESS_H__ */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
@@ -0,0 +1,279 @@
+#!/bin/sh
+
+# ***************************************************
+# *                                                 *
+# *     (C) Copyright scheatkode 2021.              *
+# *                                                 *
+# *     Distributed under  the MIT  License. (See   *
+# *     accompanying file LICENSE  at the root of   *
+# *     the project).                               *
+# *                                                 *
+# ***************************************************
+
+# Include cost benchmark.
+#
+# Generates N translation units including a single header each, then
+# times preprocessing (-E) and parsing (-fsyntax-only, /Zs for MSVC)
+# of the whole batch against a batch of empty translation units. The
+# difference, divided by N, is the cost of a single inclusion, taking
+# the median of R runs of each batch. The number of macros the header
+# leaves defined is reported alongside, except with MSVC which cannot
+# list them, "-" standing in for the count.
+#
+# Usage :
+#
+#    bench/include_cost.sh [-n count] [-r runs] [-c compilers]
+#                          [-b baseline] [-t tolerance] [header ...]
+#
+#    -n  Translation units per batch, defaults to 200.
+#    -r  Timed runs per batch, defaults to 5.
+#    -c  Space separated compilers, defaults to "gcc clang cl",
+#        missing ones being skipped.
+#    -b  Baseline to compare against. The run fails when a header
+#        defines more macros than recorded.
+#    -t  Tolerated slowdown of the median against the baseline, in
+#        percent. Timings are only compared when given, being too
+#        noisy on shared machines to gate on by default.
+#
+# Headers are given relative to lib/ and default to every public
+# header, along with standard.h as it stood before the other headers
+# were added, for reference. A header suffixed with @<revision> is
+# taken from that git revision, and skipped outside of a checkout. The
+# output is the baseline format itself, one comment line describing
+# each compiler followed by one line per header, compiler and mode :
+#
+#    <header> <compiler> <mode> <us per include> <macros>
+#
+# The baseline is regenerated as a whole, rather than edited by hand :
+#
+#    bench/include_cost.sh -c gcc > bench/include_cost.baseline
+#
+# Timings rely on GNU date(1) or perl(1) for sub-second resolution.
+
+set -eu
+
+root=$(cd "$(dirname "$0")/.." && pwd)
+
+count=200
+runs=5
+compilers='gcc clang cl'
+baseline=
+tolerance=
+
+while getopts 'n:r:c:b:t:' option; do
+   case $option in
+      n) count=$OPTARG ;;
+      r) runs=$OPTARG ;;
+      c) compilers=$OPTARG ;;
+      b) baseline=$OPTARG ;;
+      t) tolerance=$OPTARG ;;
+      *) sed -n '/^# Usage/,/^# Headers/p' "$0" >&2; exit 2 ;;
+   esac
+done
+
+shift $((OPTIND - 1))
+
+if [ $# -eq 0 ]; then
+   set -- \
+      preprocessor/environment/standard.h \
+      preprocessor/environment/standard.h@a6505a5 \
+      preprocessor/environment/architecture.h \
+      preprocessor/environment/compiler.h \
+      preprocessor/environment/os.h \
+      preprocessor/environment/cpu.h \
+      preprocessor/environment.h \
+      arena.h \
+      bits.h \
+      hash.h \
+      hashmap.h \
+      io/aio.h \
+      load.h \
+      mapped_file.h \
+      percpu.h \
+      pool.h \
+      prefetch.h \
+      ring.h \
+      scheduler.h \
+      simd/bytes.h \
+      timer.h \
+      topology.h
+fi
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT INT TERM
+
+# <!-- Helpers {{{ -->
+
+now_us() {
+   now=$(date +%s%N 2>/dev/null || true)
+
+   case $now in
+      *N|'') perl -MTime::HiRes=time -e 'printf "%d\n", time * 1e6' ;;
+      *)     echo $((now / 1000)) ;;
+   esac
+}
+
+# includes <header>, the include directory of <header>
+includes() {
+   case $1 in
+      *@*)
+         revision=${1#*@}
+
+         if [ ! -d "$work/$revision" ]; then
+            mkdir -p "$work/$revision"
+            git -C "$root" archive "$revision" lib 2> /dev/null \
+               | tar -x -C "$work/$revision" 2> /dev/null || {
+                  rm -rf "$work/$revision"
+                  return 1
+               }
+         fi
+
+         echo "$work/$revision/lib" ;;
+      *)
+         echo "$root/lib" ;;
+   esac
+}
+
+# generate <directory> <header or empty>
+generate() {
+   mkdir -p "$1"
+
+   i=0
+   while [ $i -lt "$count" ]; do
+      if [ -n "$2" ]; then
+         printf '#include "%s"\nint reboot_tu_%d;\n' "${2%@*}" $i \
+            > "$1/tu$i.c"
+      else
+         printf 'int reboot_tu_%d;\n' $i > "$1/tu$i.c"
+      fi
+      i=$((i + 1))
+   done
+}
+
+# run <compiler> <mode> <directory> <include directory>
+run() {
+   case $1:$2 in
+      cl:E)      set -- cl /nologo /EP /I"$4" "$3"/*.c ;;
+      cl:syntax) set -- cl /nologo /Zs /I"$4" "$3"/*.c ;;
+      *:E)       set -- "$1" -E -I"$4" "$3"/*.c ;;
+      *:syntax)  set -- "$1" -fsyntax-only -I"$4" "$3"/*.c ;;
+   esac
+
+   "$@" > /dev/null 2> "$work/stderr" || {
+      cat "$work/stderr" >&2
+      return 1
+   }
+}
+
+# elapsed <compiler> <mode> <directory> <include directory>, median of
+# the timed runs
+elapsed() {
+   : > "$work/timings"
+
+   i=0
+   while [ $i -lt "$runs" ]; do
+      start=$(now_us)
+      run "$@"
+      echo $(($(now_us) - start)) >> "$work/timings"
+      i=$((i + 1))
+   done
+
+   sort -n "$work/timings" | awk '
+      { took[NR] = $1 }
+      END {
+         middle = int((NR + 1) / 2)
+         print NR % 2 ? took[middle] \
+                      : int((took[middle] + took[middle + 1]) / 2)
+      }'
+}
+
+# macros <compiler> <header or empty> <include directory>, "-" when the
+# compiler cannot list them
+macros() {
+   if [ -n "$2" ]; then
+      printf '#include "%s"\n' "${2%@*}" > "$work/macros.c"
+   else
+      : > "$work/macros.c"
+   fi
+
+   case $1 in
+      cl) echo - ;;
+      *)  "$1" -E -dM -I"$3" "$work/macros.c" | wc -l | tr -d ' ' ;;
+   esac
+}
+
+# describe <compiler>, the comment line heading its rows
+describe() {
+   case $1 in
+      cl) version=$(cl 2>&1 | head -n 1) ;;
+      *)  version=$("$1" --version | head -n 1) ;;
+   esac
+
+   echo "# $version, $(uname -m), -n $count, median of $runs"
+}
+
+# <!-- }}} Helpers -->
+
+generate "$work/empty" ''
+
+status=0
+
+for compiler in $compilers; do
+   command -v "$compiler" > /dev/null 2>&1 || continue
+
+   describe "$compiler"
+
+   empty_macros=$(macros "$compiler" '' "$root/lib")
+
+   for mode in E syntax; do
+      empty=$(elapsed "$compiler" "$mode" "$work/empty" "$root/lib")
+
+      for header in "$@"; do
+         directory="$work/$(echo "$header" | tr '/.@' '___')"
+         include=$(includes "$header") || {
+            echo "   $header : no such revision, skipped" >&2
+            continue
+         }
+
+         [ -d "$directory" ] || generate "$directory" "$header"
+
+         took=$(elapsed "$compiler" "$mode" "$directory" "$include")
+         cost=$(((took - empty) / count))
+         defined=$(macros "$compiler" "$header" "$include")
+
+         [ "$defined" = - ] || defined=$((defined - empty_macros))
+         [ $cost -ge 0 ] || cost=0
+
+         echo "$header $compiler $mode $cost $defined"
+
+         [ -n "$baseline" ] || continue
+
+         reference=$(awk -v h="$header" -v c="$compiler" -v m="$mode" \
+            '$1 == h && $2 == c && $3 == m { print $4, $5 }' "$baseline")
+
+         [ -n "$reference" ] || continue
+
+         reference_cost=${reference% *}
+         reference_macros=${reference#* }
+
+         if [ "$defined" != - ] && [ "$reference_macros" != - ] \
+            && [ "$defined" -gt "$reference_macros" ]; then
+            echo "   macros regressed : $reference_macros -> $defined" >&2
+            status=1
+         fi
+
+         [ -n "$tolerance" ] || continue
+
+         # One microsecond of slack keeps near zero costs from flapping.
+         if [ $((cost * 100)) -gt \
+              $((reference_cost * (100 + tolerance) + 100)) ]; then
+            echo "   cost regressed : ${reference_cost}us -> ${cost}us" >&2
+            status=1
+         fi
+      done
+   done
+done
+
+exit $status
+
+# vim: set ft=sh et sw=3 fdm=marker fmr={{{,}}} fdl=0:
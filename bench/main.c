@@ -0,0 +1,396 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+/*!
+ * @file  main.c
+ * @brief Micro-benchmark driver.
+ *
+ * Usage :
+ *
+ * ```sh
+ * reboot_bench [-w warmup] [-r repetitions] [-s bytes] [benchmark ...]
+ * ```
+ *
+ * Every benchmark runs by default, over a buffer of 64
+ * KiB  of pseudo-random bytes, after 100 warmup  calls
+ * and  for  1000 timed calls per variant.  The  driver
+ * pins  itself  to the first processor it may  run  on
+ * beforehand,  so that the variants compared share the
+ * same core and caches.
+ *
+ * Kernels    are    written   once   as   a    generic
+ * `REBOOT_ALWAYS_INLINE` function and specialized with
+ * `REBOOT_MULTIVERSION_VARIANT`,  the  variants  table
+ * listing  them from the most to the least  demanding,
+ * the baseline coming last.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "harness.h"
+#include "hash.h"
+#include "multiversion.h"
+#include "simd/bytes.h"
+#include "topology.h"
+
+/* <!-- Kernels {{{ --> */
+
+typedef struct reboot_bench_buffer_ {
+   unsigned char   *data;
+   size_t           size;
+   volatile size_t  sink;
+} reboot_bench_buffer_;
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86)             \
+ && defined(REBOOT_MULTIVERSION_HAS_TARGET)
+#  define REBOOT_BENCH_HAS_X86_VARIANTS_
+#endif
+
+/*!
+ * Defines  the  benchmark  entry  point  of  `kernel`,
+ * compiled  for  the target of `suffix`, which  stores
+ * the  result  in  the sink so that the  call  is  not
+ * optimized away.
+ */
+#define REBOOT_BENCH_ENTRY_(kernel, suffix)                                   \
+   static void                                                                \
+   kernel##_bench_##suffix(void *state)                                       \
+   {                                                                          \
+      reboot_bench_buffer_ *buffer = (reboot_bench_buffer_ *) state;          \
+      buffer->sink = kernel##_##suffix(buffer->data, buffer->size);           \
+   }
+
+#define REBOOT_BENCH_FAMILY_(kernel)                                          \
+   static size_t                                                              \
+   kernel##_baseline(const unsigned char *data, size_t size)                  \
+   {                                                                          \
+      return kernel##_generic(data, size);                                    \
+   }                                                                          \
+   REBOOT_BENCH_ENTRY_(kernel, baseline)                                      \
+   REBOOT_BENCH_FAMILY_X86_(kernel)
+
+#if defined(REBOOT_BENCH_HAS_X86_VARIANTS_)
+#  define REBOOT_BENCH_FAMILY_X86_(kernel)                                    \
+      REBOOT_MULTIVERSION_VARIANT(                                            \
+         size_t, kernel, avx2, "avx2",                                        \
+         (const unsigned char *data, size_t size), (data, size)               \
+      )                                                                       \
+      REBOOT_MULTIVERSION_VARIANT(                                            \
+         size_t, kernel, avx512, "avx512f,avx512bw",                          \
+         (const unsigned char *data, size_t size), (data, size)               \
+      )                                                                       \
+      REBOOT_BENCH_ENTRY_(kernel, avx2)                                       \
+      REBOOT_BENCH_ENTRY_(kernel, avx512)
+#  define REBOOT_BENCH_VARIANTS_X86_(kernel)                                  \
+      {                                                                       \
+         "avx512", REBOOT_CPU_AVX512F | REBOOT_CPU_AVX512BW,                  \
+         kernel##_bench_avx512                                                \
+      },                                                                      \
+      { "avx2", REBOOT_CPU_AVX2, kernel##_bench_avx2 },
+#else
+#  define REBOOT_BENCH_FAMILY_X86_(kernel)
+#  define REBOOT_BENCH_VARIANTS_X86_(kernel)
+#endif
+
+#define REBOOT_BENCH_VARIANTS_(kernel)                                        \
+   static const reboot_bench_variant_t kernel##_variants[] = {                \
+      REBOOT_BENCH_VARIANTS_X86_(kernel)                                      \
+      { "baseline", 0, kernel##_bench_baseline }                              \
+   };
+
+/*!
+ * @brief Byte sum.
+ */
+static REBOOT_ALWAYS_INLINE size_t
+reboot_bench_sum_generic(const unsigned char *data, size_t size)
+{
+   uint32_t sum = 0;
+   size_t   i;
+
+   for (i = 0; i < size; ++i) {
+      sum += data[i];
+   }
+
+   return sum;
+}
+
+/*!
+ * @brief Newline count.
+ */
+static REBOOT_ALWAYS_INLINE size_t
+reboot_bench_lines_generic(const unsigned char *data, size_t size)
+{
+   size_t count = 0;
+   size_t i;
+
+   for (i = 0; i < size; ++i) {
+      count += data[i] == '\n';
+   }
+
+   return count;
+}
+
+REBOOT_BENCH_FAMILY_(reboot_bench_sum)
+REBOOT_BENCH_FAMILY_(reboot_bench_lines)
+
+REBOOT_BENCH_VARIANTS_(reboot_bench_sum)
+REBOOT_BENCH_VARIANTS_(reboot_bench_lines)
+
+/*!
+ * The  primitives  of `simd/bytes.h` come  with  their
+ * implementations written out per instruction set, and
+ * are  compared as such rather than specialized from a
+ * generic kernel.
+ */
+#define REBOOT_BENCH_BYTES_(kernel, primitive, suffix, arguments)             \
+   static size_t                                                              \
+   kernel##_##suffix(const unsigned char *data, size_t size)                  \
+   {                                                                          \
+      return (size_t) reboot_bytes_##primitive##_##suffix arguments;          \
+   }                                                                          \
+   REBOOT_BENCH_ENTRY_(kernel, suffix)
+
+#if defined(REBOOT_BYTES_HAS_AVX2)
+#  define REBOOT_BENCH_BYTES_AVX2_(kernel, primitive, arguments)              \
+      REBOOT_BENCH_BYTES_(kernel, primitive, avx2, arguments)
+#  define REBOOT_BENCH_BYTES_VARIANTS_AVX2_(kernel)                           \
+      { "avx2", REBOOT_CPU_AVX2, kernel##_bench_avx2 },
+#else
+#  define REBOOT_BENCH_BYTES_AVX2_(kernel, primitive, arguments)
+#  define REBOOT_BENCH_BYTES_VARIANTS_AVX2_(kernel)
+#endif
+
+#if defined(REBOOT_BYTES_HAS_SSE2)
+#  define REBOOT_BENCH_BYTES_SSE2_(kernel, primitive, arguments)              \
+      REBOOT_BENCH_BYTES_(kernel, primitive, sse2, arguments)
+#  define REBOOT_BENCH_BYTES_VARIANTS_SSE2_(kernel)                           \
+      { "sse2", REBOOT_CPU_SSE2, kernel##_bench_sse2 },
+#else
+#  define REBOOT_BENCH_BYTES_SSE2_(kernel, primitive, arguments)
+#  define REBOOT_BENCH_BYTES_VARIANTS_SSE2_(kernel)
+#endif
+
+#if defined(REBOOT_BYTES_HAS_NEON)
+#  define REBOOT_BENCH_BYTES_NEON_(kernel, primitive, arguments)              \
+      REBOOT_BENCH_BYTES_(kernel, primitive, neon, arguments)
+#  define REBOOT_BENCH_BYTES_VARIANTS_NEON_(kernel)                           \
+      { "neon", REBOOT_CPU_NEON, kernel##_bench_neon },
+#else
+#  define REBOOT_BENCH_BYTES_NEON_(kernel, primitive, arguments)
+#  define REBOOT_BENCH_BYTES_VARIANTS_NEON_(kernel)
+#endif
+
+#define REBOOT_BENCH_BYTES_FAMILY_(kernel, primitive, arguments)              \
+   REBOOT_BENCH_BYTES_AVX2_(kernel, primitive, arguments)                     \
+   REBOOT_BENCH_BYTES_SSE2_(kernel, primitive, arguments)                     \
+   REBOOT_BENCH_BYTES_NEON_(kernel, primitive, arguments)                     \
+   REBOOT_BENCH_BYTES_(kernel, primitive, scalar, arguments)                  \
+   static const reboot_bench_variant_t kernel##_variants[] = {                \
+      REBOOT_BENCH_BYTES_VARIANTS_AVX2_(kernel)                               \
+      REBOOT_BENCH_BYTES_VARIANTS_SSE2_(kernel)                               \
+      REBOOT_BENCH_BYTES_VARIANTS_NEON_(kernel)                               \
+      { "scalar", 0, kernel##_bench_scalar }                                  \
+   };
+
+REBOOT_BENCH_BYTES_FAMILY_(
+   reboot_bench_count_byte, count_byte, (data, size, '\n')
+)
+REBOOT_BENCH_BYTES_FAMILY_(
+   reboot_bench_is_ascii, is_ascii, (data, size)
+)
+
+/*!
+ * The  hardware CRC implementations are private to the
+ * library, the dispatched entry point standing for the
+ * best one the host supports.
+ */
+static size_t
+reboot_bench_crc32c_dispatch(const unsigned char *data, size_t size)
+{
+   return reboot_hash_crc32c(0, data, size);
+}
+
+static size_t
+reboot_bench_crc32c_scalar(const unsigned char *data, size_t size)
+{
+   return reboot_hash_crc32c_scalar(0, data, size);
+}
+
+REBOOT_BENCH_ENTRY_(reboot_bench_crc32c, dispatch)
+REBOOT_BENCH_ENTRY_(reboot_bench_crc32c, scalar)
+
+static const reboot_bench_variant_t reboot_bench_crc32c_variants[] = {
+   { "dispatch", 0, reboot_bench_crc32c_bench_dispatch },
+   { "scalar",   0, reboot_bench_crc32c_bench_scalar   }
+};
+
+/* <!-- }}} Kernels --> */
+
+/* <!-- Driver {{{ --> */
+
+#define REBOOT_BENCH_TABLE_(name, kernel)                                     \
+   {                                                                          \
+      name, kernel##_variants,                                                \
+      sizeof kernel##_variants / sizeof *kernel##_variants                    \
+   }
+
+static const struct {
+   const char                   *name;
+   const reboot_bench_variant_t *variants;
+   size_t                        count;
+} reboot_bench_benchmarks_[] = {
+   REBOOT_BENCH_TABLE_("sum",        reboot_bench_sum),
+   REBOOT_BENCH_TABLE_("lines",      reboot_bench_lines),
+   REBOOT_BENCH_TABLE_("count_byte", reboot_bench_count_byte),
+   REBOOT_BENCH_TABLE_("is_ascii",   reboot_bench_is_ascii),
+   REBOOT_BENCH_TABLE_("crc32c",     reboot_bench_crc32c)
+};
+
+#define REBOOT_BENCH_COUNT_                                                   \
+   (sizeof reboot_bench_benchmarks_ / sizeof *reboot_bench_benchmarks_)
+
+#define REBOOT_BENCH_MAX_VARIANTS_ 8
+
+static int
+reboot_bench_usage_(const char *program)
+{
+   size_t i;
+
+   fprintf(
+      stderr,
+      "usage : %s [-w warmup] [-r repetitions] [-s bytes] [benchmark ...]\n"
+      "benchmarks :",
+      program
+   );
+
+   for (i = 0; i < REBOOT_BENCH_COUNT_; ++i) {
+      fprintf(stderr, " %s", reboot_bench_benchmarks_[i].name);
+   }
+
+   fputc('\n', stderr);
+
+   return 2;
+}
+
+static int
+reboot_bench_selected_(const char *name, char **names, int count)
+{
+   int i;
+
+   for (i = 0; i < count; ++i) {
+      if (strcmp(names[i], name) == 0) {
+         return 1;
+      }
+   }
+
+   return count == 0;
+}
+
+static void
+reboot_bench_pin_(void)
+{
+   reboot_topology_t topology;
+
+   if (reboot_topology_init(&topology) != 0) {
+      return;
+   }
+
+   if (topology.cpu_count != 0) {
+      reboot_topology_pin(topology.cpus[0].id);
+   }
+
+   reboot_topology_destroy(&topology);
+}
+
+int
+main(int argc, char **argv)
+{
+   reboot_bench_options_t options;
+   reboot_bench_result_t  results[REBOOT_BENCH_MAX_VARIANTS_];
+   reboot_bench_buffer_   buffer;
+   uint32_t               seed = 0x9E3779B9u;
+   int                    first;
+   size_t                 i;
+
+   options.warmup      = 100;
+   options.repetitions = 1000;
+   options.bytes       = 64u * 1024u;
+
+   for (first = 1; first + 1 < argc && argv[first][0] == '-'; first += 2) {
+      unsigned long value = strtoul(argv[first + 1], NULL, 10);
+
+      if (strcmp(argv[first], "-w") == 0) {
+         options.warmup = (unsigned) value;
+      } else if (strcmp(argv[first], "-r") == 0 && value != 0) {
+         options.repetitions = (unsigned) value;
+      } else if (strcmp(argv[first], "-s") == 0 && value != 0) {
+         options.bytes = (size_t) value;
+      } else {
+         return reboot_bench_usage_(argv[0]);
+      }
+   }
+
+   if (first < argc && argv[first][0] == '-') {
+      return reboot_bench_usage_(argv[0]);
+   }
+
+   buffer.data = (unsigned char *) malloc(options.bytes);
+   buffer.size = options.bytes;
+   buffer.sink = 0;
+
+   if (buffer.data == NULL) {
+      fprintf(stderr, "%s : out of memory\n", argv[0]);
+      return 1;
+   }
+
+   /* xorshift32, any fixed sequence keeps runs comparable. */
+   for (i = 0; i < buffer.size; ++i) {
+      seed ^= seed << 13;
+      seed ^= seed >> 17;
+      seed ^= seed << 5;
+
+      buffer.data[i] = (unsigned char) seed;
+   }
+
+   reboot_bench_pin_();
+   reboot_bench_environment(stdout);
+
+   for (i = 0; i < REBOOT_BENCH_COUNT_; ++i) {
+      size_t count = reboot_bench_benchmarks_[i].count;
+      int    winner;
+
+      if (!reboot_bench_selected_(
+         reboot_bench_benchmarks_[i].name, argv + first, argc - first
+      )) {
+         continue;
+      }
+
+      winner = reboot_bench_run(
+         reboot_bench_benchmarks_[i].variants, count, &buffer, &options,
+         results
+      );
+
+      fputc('\n', stdout);
+      reboot_bench_report(
+         stdout, reboot_bench_benchmarks_[i].name, results, count, winner,
+         &options
+      );
+   }
+
+   free(buffer.data);
+
+   return 0;
+}
+
+/* <!-- }}} Driver --> */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
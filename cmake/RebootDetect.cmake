@@ -0,0 +1,273 @@
+# ***************************************************
+# *                                                 *
+# *     (C) Copyright scheatkode 2021.              *
+# *                                                 *
+# *     Distributed under  the MIT  License. (See   *
+# *     accompanying file LICENSE  at the root of   *
+# *     the project).                               *
+# *                                                 *
+# ***************************************************
+
+# Configure time environment detection.
+#
+# reboot_generate_config(<output> SOURCE_DIR <dir> [TUNE_FOR_HOST <bool>])
+#
+# Runs the preprocessor once per enabled language over the environment
+# headers found in <dir> and writes every REBOOT_* macro they define to
+# <output>, sparing each translation unit from walking the #if ladders
+# again once REBOOT_USE_GENERATED_CONFIG is defined. The definitions
+# are guarded by a fingerprint of every predefined macro the #if lines
+# of these headers test, translation units compiled with other flags
+# falling back to the ladders rather than picking up stale values.
+#
+# TUNE_FOR_HOST additionally bakes in host properties the preprocessor
+# cannot see, namely the actual cache line size, which only makes sense
+# for binaries meant to run on the very host that built them.
+#
+# Only compilers understanding -E -dM are supported, others keep using
+# the ladders.
+
+include_guard(GLOBAL)
+
+set(_REBOOT_DETECT_DIR "${CMAKE_CURRENT_LIST_DIR}")
+
+set(_REBOOT_DETECT_HEADERS
+   preprocessor/environment/standard.h
+   preprocessor/environment/architecture.h
+   preprocessor/environment/compiler.h
+   preprocessor/environment/os.h
+)
+
+# <!-- Helpers {{{ -->
+
+# _reboot_detect_fingerprint(<dir> <result>)
+#
+# Collects every reserved identifier the conditionals of the headers
+# test, i.e. the predefined macros the detection depends on. Arguments
+# of function-like macros such as __has_builtin are builtin or attribute
+# names rather than macros and are left out.
+function(_reboot_detect_fingerprint directory result)
+   set(macros "")
+
+   foreach (header IN LISTS _REBOOT_DETECT_HEADERS)
+      file(READ "${directory}/${header}" text)
+
+      string(REPLACE ";" " " text "${text}")
+      string(REGEX REPLACE "\\\\\n" " " text "${text}")
+      string(REGEX MATCHALL "\n[ \t]*#[ \t]*(if|ifdef|ifndef|elif)[ \t(][^\n]*"
+         lines "${text}")
+
+      foreach (line IN LISTS lines)
+         string(REGEX REPLACE "/\\*([^*]|\\*+[^*/])*\\*+/" "" line "${line}")
+         string(REGEX REPLACE "//.*" "" line "${line}")
+         string(REGEX REPLACE "^\n[ \t]*#[ \t]*[a-z]+" "" line "${line}")
+         string(REGEX REPLACE "defined[ \t]*\\(([A-Za-z0-9_]*)[ \t]*\\)"
+            "defined \\1" line "${line}")
+         string(REGEX REPLACE "[A-Za-z0-9_]+[ \t]*\\([^()]*\\)" "" line
+            "${line}")
+         string(REGEX MATCHALL "[A-Za-z_][A-Za-z0-9_]*" identifiers "${line}")
+
+         foreach (identifier IN LISTS identifiers)
+            if (identifier MATCHES "^_"
+                AND NOT identifier MATCHES "^_*REBOOT_"
+                AND NOT identifier MATCHES "^__has_")
+               list(APPEND macros ${identifier})
+            endif ()
+         endforeach ()
+      endforeach ()
+   endforeach ()
+
+   list(REMOVE_DUPLICATES macros)
+   list(SORT macros)
+
+   set(${result} "${macros}" PARENT_SCOPE)
+endfunction ()
+
+# _reboot_detect_language(<language> <dir> <cache line size> <result>)
+function(_reboot_detect_language language directory cache_line result)
+   set(compiler "${CMAKE_${language}_COMPILER}")
+   set(id       "${CMAKE_${language}_COMPILER_ID}")
+
+   if (NOT id MATCHES "^(GNU|Clang|AppleClang|IntelLLVM)$")
+      message(STATUS
+         "reboot: ${id} ${language} compiler unsupported, keeping the ladders")
+      set(${result} "" PARENT_SCOPE)
+      return()
+   endif ()
+
+   set(flags "${CMAKE_${language}_FLAGS}")
+
+   if (CMAKE_BUILD_TYPE)
+      string(TOUPPER "${CMAKE_BUILD_TYPE}" type)
+      string(APPEND flags " ${CMAKE_${language}_FLAGS_${type}}")
+   endif ()
+
+   if (DEFINED CMAKE_${language}_STANDARD)
+      set(standard ${CMAKE_${language}_STANDARD})
+
+      if (DEFINED CMAKE_${language}_EXTENSIONS
+          AND NOT CMAKE_${language}_EXTENSIONS)
+         string(APPEND flags
+            " ${CMAKE_${language}${standard}_STANDARD_COMPILE_OPTION}")
+      else ()
+         string(APPEND flags
+            " ${CMAKE_${language}${standard}_EXTENSION_COMPILE_OPTION}")
+      endif ()
+   endif ()
+
+   separate_arguments(flags NATIVE_COMMAND "${flags}")
+
+   if (language STREQUAL "CXX")
+      set(probe "${CMAKE_BINARY_DIR}/CMakeFiles/reboot_detect.cpp")
+   else ()
+      set(probe "${CMAKE_BINARY_DIR}/CMakeFiles/reboot_detect.c")
+   endif ()
+
+   set(content "")
+   foreach (header IN LISTS _REBOOT_DETECT_HEADERS)
+      string(APPEND content "#include \"${header}\"\n")
+   endforeach ()
+
+   file(WRITE "${probe}" "${content}")
+
+   execute_process(
+      COMMAND         "${compiler}" ${flags} "-I${directory}" -E -dM "${probe}"
+      OUTPUT_VARIABLE output
+      ERROR_VARIABLE  error
+      RESULT_VARIABLE status
+   )
+
+   if (status EQUAL 0)
+      file(WRITE "${probe}" "")
+
+      execute_process(
+         COMMAND         "${compiler}" ${flags} -E -dM "${probe}"
+         OUTPUT_VARIABLE predefined
+         ERROR_VARIABLE  error
+         RESULT_VARIABLE status
+      )
+   endif ()
+
+   if (NOT status EQUAL 0)
+      message(WARNING
+         "reboot: ${language} detection failed, keeping the ladders\n${error}")
+      set(${result} "" PARENT_SCOPE)
+      return()
+   endif ()
+
+   # Semicolons would otherwise split list elements.
+   string(REPLACE ";" "<reboot-semicolon>" output "${output}")
+   string(REPLACE ";" "<reboot-semicolon>" predefined "${predefined}")
+
+   # Macros only defined by the system headers the probe pulls in are not
+   # yet defined where the configuration is included, and are fixed for
+   # the whole build anyway. Those whose value is neither an integer nor
+   # another macro can only be compared for definedness.
+   _reboot_detect_fingerprint("${directory}" fingerprint)
+
+   set(conditions "")
+   foreach (macro IN LISTS fingerprint)
+      if (predefined MATCHES "#define ${macro} ([^\n]*)")
+         string(STRIP "${CMAKE_MATCH_1}" value)
+
+         if (value MATCHES "^([0-9]+[uUlL]*|[A-Za-z_][A-Za-z0-9_]*)$")
+            list(APPEND conditions
+               "(defined(${macro}) && ${macro} == ${value})")
+         else ()
+            list(APPEND conditions "defined(${macro})")
+         endif ()
+      elseif (NOT output MATCHES "#define ${macro} ")
+         list(APPEND conditions "!defined(${macro})")
+      endif ()
+   endforeach ()
+
+   string(REPLACE ";" " \\\n   && " conditions "${conditions}")
+
+   string(REGEX MATCHALL "#define _*REBOOT_[^\n]*" definitions "${output}")
+   list(SORT definitions)
+
+   set(body "#  if ${conditions}\n\n")
+   string(APPEND body "#     define REBOOT_CONFIG_IN_USE\n")
+
+   foreach (definition IN LISTS definitions)
+      string(REPLACE "<reboot-semicolon>" ";" definition "${definition}")
+      string(REGEX REPLACE "^#define " "" definition "${definition}")
+      string(STRIP "${definition}" definition)
+
+      if (definition MATCHES "^REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_CACHE_LINE_SIZE ")
+         if (cache_line)
+            set(definition
+               "REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_CACHE_LINE_SIZE ${cache_line}")
+         endif ()
+
+         string(APPEND body
+            "#     ifndef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_CACHE_LINE_SIZE\n"
+            "#        define ${definition}\n"
+            "#     endif\n")
+      else ()
+         string(APPEND body "#     define ${definition}\n")
+      endif ()
+   endforeach ()
+
+   string(APPEND body "\n#  endif")
+
+   set(${result} "${body}" PARENT_SCOPE)
+endfunction ()
+
+# _reboot_detect_cache_line(<result>)
+function(_reboot_detect_cache_line result)
+   if (CMAKE_CROSSCOMPILING)
+      message(STATUS "reboot: cross compiling, not probing the cache line")
+      set(${result} "" PARENT_SCOPE)
+      return()
+   endif ()
+
+   try_run(run compiled
+      "${CMAKE_BINARY_DIR}/CMakeFiles/reboot_cache_line"
+      "${_REBOOT_DETECT_DIR}/probe/cache_line.c"
+      RUN_OUTPUT_VARIABLE output
+   )
+
+   if (compiled AND run EQUAL 0 AND output MATCHES "^([0-9]+)")
+      message(STATUS "reboot: host cache line is ${CMAKE_MATCH_1} bytes")
+      set(${result} "${CMAKE_MATCH_1}" PARENT_SCOPE)
+   else ()
+      message(STATUS "reboot: could not probe the host cache line")
+      set(${result} "" PARENT_SCOPE)
+   endif ()
+endfunction ()
+
+# <!-- }}} Helpers -->
+
+function(reboot_generate_config output)
+   cmake_parse_arguments(PARSE_ARGV 1 ARG "" "SOURCE_DIR;TUNE_FOR_HOST" "")
+
+   set(cache_line "")
+
+   if (ARG_TUNE_FOR_HOST)
+      _reboot_detect_cache_line(cache_line)
+   endif ()
+
+   get_property(languages GLOBAL PROPERTY ENABLED_LANGUAGES)
+
+   set(REBOOT_CONFIG_C   "/* C was not enabled at configure time. */")
+   set(REBOOT_CONFIG_CXX "/* C++ was not enabled at configure time. */")
+
+   if ("C" IN_LIST languages)
+      _reboot_detect_language(C "${ARG_SOURCE_DIR}" "${cache_line}" body)
+      if (body)
+         set(REBOOT_CONFIG_C "${body}")
+      endif ()
+   endif ()
+
+   if ("CXX" IN_LIST languages)
+      _reboot_detect_language(CXX "${ARG_SOURCE_DIR}" "${cache_line}" body)
+      if (body)
+         set(REBOOT_CONFIG_CXX "${body}")
+      endif ()
+   endif ()
+
+   configure_file("${_REBOOT_DETECT_DIR}/reboot_config.h.in" "${output}" @ONLY)
+endfunction ()
+
+# vim: set ft=cmake et sw=3 fdm=marker fmr={{{,}}} fdl=0:
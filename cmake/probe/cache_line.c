@@ -0,0 +1,94 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+/*!
+ * @file  cmake/probe/cache_line.c
+ * @brief Host cache line size probe.
+ *
+ * Prints  the  size, in bytes, of the host  level  one
+ * data  cache line and exits with a non-zero status if
+ * it cannot be determined.
+ */
+
+#include <stdio.h>
+
+#if defined(__APPLE__)
+#  include <sys/types.h>
+#  include <sys/sysctl.h>
+#elif defined(_WIN32)
+#  include <stdlib.h>
+#  include <windows.h>
+#else
+#  include <unistd.h>
+#endif
+
+int
+main(void)
+{
+   long size = 0;
+
+#if defined(__APPLE__)
+   size_t length = sizeof size;
+
+   if (sysctlbyname("hw.cachelinesize", &size, &length, NULL, 0) != 0) {
+      size = 0;
+   }
+#elif defined(_WIN32)
+   SYSTEM_LOGICAL_PROCESSOR_INFORMATION *information = NULL;
+   DWORD                                 length      = 0;
+   DWORD                                 i;
+
+   GetLogicalProcessorInformation(NULL, &length);
+   information = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION *) malloc(length);
+
+   if (information && GetLogicalProcessorInformation(information, &length)) {
+      for (i = 0; i < length / sizeof *information; ++i) {
+         if (information[i].Relationship == RelationCache
+          && information[i].Cache.Level == 1) {
+            size = information[i].Cache.LineSize;
+            break;
+         }
+      }
+   }
+
+   free(information);
+#else
+   FILE *file;
+
+#  ifdef _SC_LEVEL1_DCACHE_LINESIZE
+   size = sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+#  endif
+
+   /* Some C libraries report 0 on ARM, ask the kernel instead. */
+   if (size <= 0) {
+      file = fopen(
+         "/sys/devices/system/cpu/cpu0/cache/index0/coherency_line_size", "r"
+      );
+
+      if (file) {
+         if (fscanf(file, "%ld", &size) != 1) {
+            size = 0;
+         }
+
+         fclose(file);
+      }
+   }
+#endif
+
+   if (size <= 0) {
+      return 1;
+   }
+
+   printf("%ld\n", size);
+
+   return 0;
+}
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
@@ -0,0 +1,487 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+/*!
+ * @file  arena.c
+ * @brief Bump allocator chunk management.
+ *
+ * Chunks start with their header, the first allocation
+ * following  it  on  the next cache line.  Chunks  are
+ * linked  from the most recent one backwards, which is
+ * what  lets  a mark designate every  chunk  allocated
+ * after it.
+ */
+
+/* `MAP_ANONYMOUS`, `MAP_HUGETLB` and `madvise` in strict modes. */
+#ifndef _DEFAULT_SOURCE
+#  define _DEFAULT_SOURCE
+#endif
+
+#include <stdlib.h>
+
+#include "arena.h"
+#include "preprocessor/environment/os.h"
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MMAP)
+#  include <sys/mman.h>
+#  include <unistd.h>
+#  if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#     define MAP_ANONYMOUS MAP_ANON
+#  endif
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+#  ifndef WIN32_LEAN_AND_MEAN
+#     define WIN32_LEAN_AND_MEAN
+#  endif
+#  include <windows.h>
+#endif
+
+#if defined(REBOOT_ARENA_HAS_THREAD)
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_UNIX)
+#     include <pthread.h>
+#  endif
+#endif
+
+/*!
+ * Transparent  huge pages are only ever assembled  out
+ * of  naturally  aligned ranges, 2 MiB being the  huge
+ * page   size   with  4  KiB  base  pages   on   every
+ * architecture offering them.
+ */
+#define REBOOT_ARENA_HUGE_PAGE_SIZE_ ((size_t) 2u * 1024u * 1024u)
+
+#define REBOOT_ARENA_ROUND_(value, alignment)                                 \
+   (((value) + ((alignment) - 1u)) & ~((size_t) (alignment) - 1u))
+
+enum {
+   REBOOT_ARENA_BACKING_MMAP_,
+   REBOOT_ARENA_BACKING_VIRTUAL_,
+   REBOOT_ARENA_BACKING_MALLOC_
+};
+
+struct reboot_arena_chunk_ {
+   struct reboot_arena_chunk_ *previous;
+   unsigned char              *limit;
+   size_t                      size;
+   unsigned                    backing;
+};
+
+#define REBOOT_ARENA_HEADER_SIZE_                                             \
+   REBOOT_ARENA_ROUND_(                                                       \
+      sizeof(struct reboot_arena_chunk_),                                     \
+      REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_CACHE_LINE_SIZE            \
+   )
+
+#define REBOOT_ARENA_BASE_(chunk)                                             \
+   ((unsigned char *) (chunk) + REBOOT_ARENA_HEADER_SIZE_)
+
+/* <!-- Chunk backing {{{ --> */
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MMAP)
+
+static void *
+reboot_arena_mmap_(size_t size, int flags)
+{
+   void *memory = mmap(
+      NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags,
+      -1, 0
+   );
+
+   return memory == MAP_FAILED ? NULL : memory;
+}
+
+/*!
+ * Over-allocates  by a huge page and unmaps both  ends
+ * of  the  mapping, leaving a range aligned on a  huge
+ * page boundary for `MADV_HUGEPAGE` to act upon.
+ */
+static void *
+reboot_arena_mmap_aligned_(size_t size)
+{
+   unsigned char *memory;
+   uintptr_t      start;
+   size_t         head;
+   size_t         tail;
+
+   if (size > SIZE_MAX - REBOOT_ARENA_HUGE_PAGE_SIZE_) {
+      return NULL;
+   }
+
+   memory = (unsigned char *) reboot_arena_mmap_(
+      size + REBOOT_ARENA_HUGE_PAGE_SIZE_, 0
+   );
+
+   if (memory == NULL) {
+      return NULL;
+   }
+
+   start = REBOOT_ARENA_ROUND_(
+      (uintptr_t) memory, (uintptr_t) REBOOT_ARENA_HUGE_PAGE_SIZE_
+   );
+   head  = (size_t) (start - (uintptr_t) memory);
+   tail  = REBOOT_ARENA_HUGE_PAGE_SIZE_ - head;
+
+   if (head > 0) {
+      munmap(memory, head);
+   }
+
+   if (tail > 0) {
+      munmap(memory + head + size, tail);
+   }
+
+   return memory + head;
+}
+
+static struct reboot_arena_chunk_ *
+reboot_arena_map_(size_t size, unsigned flags)
+{
+   size_t page   = (size_t) sysconf(_SC_PAGESIZE);
+   void  *memory = NULL;
+
+   if (flags & REBOOT_ARENA_HUGE_PAGES) {
+      size = REBOOT_ARENA_ROUND_(size, REBOOT_ARENA_HUGE_PAGE_SIZE_);
+
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MAP_HUGETLB)
+      memory = reboot_arena_mmap_(size, MAP_HUGETLB);
+#  endif
+
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MADV_HUGEPAGE)
+      if (memory == NULL) {
+         memory = reboot_arena_mmap_aligned_(size);
+
+         if (memory != NULL) {
+            madvise(memory, size, MADV_HUGEPAGE);
+         }
+      }
+#  endif
+   } else {
+      size = REBOOT_ARENA_ROUND_(size, page);
+   }
+
+   if (memory == NULL) {
+      memory = reboot_arena_mmap_(size, 0);
+   }
+
+   if (memory != NULL) {
+      ((struct reboot_arena_chunk_ *) memory)->size    = size;
+      ((struct reboot_arena_chunk_ *) memory)->backing =
+         REBOOT_ARENA_BACKING_MMAP_;
+   }
+
+   return (struct reboot_arena_chunk_ *) memory;
+}
+
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+
+/*!
+ * Large  pages  require  the  `SeLockMemoryPrivilege`,
+ * which  processes  seldom hold, the  allocation  then
+ * failing and falling back to regular pages.
+ */
+static struct reboot_arena_chunk_ *
+reboot_arena_map_(size_t size, unsigned flags)
+{
+   SYSTEM_INFO system;
+   void       *memory = NULL;
+
+   GetSystemInfo(&system);
+
+   if (flags & REBOOT_ARENA_HUGE_PAGES) {
+      size_t large = (size_t) GetLargePageMinimum();
+
+      if (large != 0) {
+         size_t rounded = REBOOT_ARENA_ROUND_(size, large);
+
+         memory = VirtualAlloc(
+            NULL, rounded, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+            PAGE_READWRITE
+         );
+
+         if (memory != NULL) {
+            size = rounded;
+         }
+      }
+   }
+
+   if (memory == NULL) {
+      size   = REBOOT_ARENA_ROUND_(size, (size_t) system.dwPageSize);
+      memory = VirtualAlloc(
+         NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE
+      );
+   }
+
+   if (memory != NULL) {
+      ((struct reboot_arena_chunk_ *) memory)->size    = size;
+      ((struct reboot_arena_chunk_ *) memory)->backing =
+         REBOOT_ARENA_BACKING_VIRTUAL_;
+   }
+
+   return (struct reboot_arena_chunk_ *) memory;
+}
+
+#else
+
+/*!
+ * `malloc`   only  guarantees  the  alignment  of  the
+ * largest  standard  type,  the  first  allocation  is
+ * therefore not cache line aligned on this path.
+ */
+static struct reboot_arena_chunk_ *
+reboot_arena_map_(size_t size, unsigned flags)
+{
+   void *memory = malloc(size);
+
+   (void) flags;
+
+   if (memory != NULL) {
+      ((struct reboot_arena_chunk_ *) memory)->size    = size;
+      ((struct reboot_arena_chunk_ *) memory)->backing =
+         REBOOT_ARENA_BACKING_MALLOC_;
+   }
+
+   return (struct reboot_arena_chunk_ *) memory;
+}
+
+#endif
+
+static void
+reboot_arena_unmap_(struct reboot_arena_chunk_ *chunk)
+{
+   switch (chunk->backing) {
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MMAP)
+      case REBOOT_ARENA_BACKING_MMAP_:
+         munmap(chunk, chunk->size);
+         break;
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+      case REBOOT_ARENA_BACKING_VIRTUAL_:
+         VirtualFree(chunk, 0, MEM_RELEASE);
+         break;
+#endif
+      default:
+         free(chunk);
+         break;
+   }
+}
+
+static void
+reboot_arena_unmap_list_(struct reboot_arena_chunk_ *chunk)
+{
+   while (chunk != NULL) {
+      struct reboot_arena_chunk_ *previous = chunk->previous;
+
+      reboot_arena_unmap_(chunk);
+      chunk = previous;
+   }
+}
+
+/* <!-- }}} Chunk backing --> */
+
+/* <!-- Arena {{{ --> */
+
+void
+reboot_arena_init(reboot_arena_t *arena, size_t chunk_size, unsigned flags)
+{
+   arena->cursor     = NULL;
+   arena->limit      = NULL;
+   arena->chunk      = NULL;
+   arena->spare      = NULL;
+   arena->chunk_size = chunk_size != 0 ? chunk_size : REBOOT_ARENA_CHUNK_SIZE;
+   arena->flags      = flags;
+}
+
+void
+reboot_arena_destroy(reboot_arena_t *arena)
+{
+   reboot_arena_unmap_list_(arena->chunk);
+   reboot_arena_unmap_list_(arena->spare);
+
+   arena->cursor = NULL;
+   arena->limit  = NULL;
+   arena->chunk  = NULL;
+   arena->spare  = NULL;
+}
+
+void
+reboot_arena_trim(reboot_arena_t *arena)
+{
+   reboot_arena_unmap_list_(arena->spare);
+
+   arena->spare = NULL;
+}
+
+/*!
+ * Spares  are  searched first fit, the oldest  rewound
+ * chunk being found first. A new chunk is always large
+ * enough  for the request to be aligned within it, the
+ * retry   through  `reboot_arena_alloc_aligned`   thus
+ * never recursing.
+ */
+void *
+reboot_arena_grow_(reboot_arena_t *arena, size_t size, size_t alignment)
+{
+   struct reboot_arena_chunk_  *chunk;
+   struct reboot_arena_chunk_ **link;
+   size_t                       needed;
+
+   if (size > SIZE_MAX - REBOOT_ARENA_HEADER_SIZE_ - alignment) {
+      return NULL;
+   }
+
+   needed = REBOOT_ARENA_HEADER_SIZE_ + size + alignment;
+
+   for (link = &arena->spare; *link != NULL; link = &(*link)->previous) {
+      if ((size_t) ((*link)->limit - (unsigned char *) *link) >= needed) {
+         break;
+      }
+   }
+
+   if (*link != NULL) {
+      chunk = *link;
+      *link = chunk->previous;
+   } else {
+      chunk = reboot_arena_map_(
+         needed > arena->chunk_size ? needed : arena->chunk_size, arena->flags
+      );
+
+      if (chunk == NULL) {
+         return NULL;
+      }
+
+      chunk->limit = (unsigned char *) chunk + chunk->size;
+   }
+
+   chunk->previous = arena->chunk;
+
+   arena->chunk  = chunk;
+   arena->cursor = REBOOT_ARENA_BASE_(chunk);
+   arena->limit  = chunk->limit;
+
+   return reboot_arena_alloc_aligned(arena, size, alignment);
+}
+
+void
+reboot_arena_release_(reboot_arena_t *arena, reboot_arena_mark_t mark)
+{
+   while (arena->chunk != mark.chunk) {
+      struct reboot_arena_chunk_ *chunk = arena->chunk;
+
+      arena->chunk    = chunk->previous;
+      chunk->previous = arena->spare;
+      arena->spare    = chunk;
+   }
+
+   arena->cursor = mark.cursor;
+   arena->limit  = mark.chunk != NULL ? mark.chunk->limit : NULL;
+}
+
+/* <!-- }}} Arena --> */
+
+/* <!-- Per-thread arena {{{ --> */
+
+#if defined(REBOOT_ARENA_HAS_THREAD)
+
+static REBOOT_THREAD_LOCAL reboot_arena_t reboot_arena_thread_;
+static REBOOT_THREAD_LOCAL int            reboot_arena_thread_ready_;
+
+static void
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+NTAPI
+#  endif
+reboot_arena_thread_exit_(void *arena)
+{
+   reboot_arena_destroy((reboot_arena_t *) arena);
+   reboot_arena_thread_ready_ = 0;
+}
+
+/*!
+ * The  arena is registered with a thread-specific  key
+ * for  the  sole  purpose  of  its  destructor,  which
+ * destroys   it  when  the  thread  exits.   Threading
+ * libraries other than POSIX threads and Windows leave
+ * the chunks of exited threads behind.
+ */
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_UNIX)
+
+static pthread_key_t  reboot_arena_thread_key_;
+static pthread_once_t reboot_arena_thread_once_ = PTHREAD_ONCE_INIT;
+
+static void
+reboot_arena_thread_key_init_(void)
+{
+   pthread_key_create(&reboot_arena_thread_key_, reboot_arena_thread_exit_);
+}
+
+static void
+reboot_arena_thread_register_(reboot_arena_t *arena)
+{
+   pthread_once(&reboot_arena_thread_once_, reboot_arena_thread_key_init_);
+   pthread_setspecific(reboot_arena_thread_key_, arena);
+}
+
+#  elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+
+static DWORD     reboot_arena_thread_key_;
+static INIT_ONCE reboot_arena_thread_once_ = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK
+reboot_arena_thread_key_init_(INIT_ONCE *once, void *parameter, void **context)
+{
+   (void) once;
+   (void) parameter;
+   (void) context;
+
+   reboot_arena_thread_key_ = FlsAlloc(reboot_arena_thread_exit_);
+
+   return TRUE;
+}
+
+static void
+reboot_arena_thread_register_(reboot_arena_t *arena)
+{
+   InitOnceExecuteOnce(
+      &reboot_arena_thread_once_, reboot_arena_thread_key_init_, NULL, NULL
+   );
+   FlsSetValue(reboot_arena_thread_key_, arena);
+}
+
+#  else
+
+static void
+reboot_arena_thread_register_(reboot_arena_t *arena)
+{
+   (void) arena;
+}
+
+#  endif
+
+reboot_arena_t *
+reboot_arena_thread(void)
+{
+   if (REBOOT_UNLIKELY(!reboot_arena_thread_ready_)) {
+      reboot_arena_init(&reboot_arena_thread_, 0, 0);
+      reboot_arena_thread_register_(&reboot_arena_thread_);
+      reboot_arena_thread_ready_ = 1;
+   }
+
+   return &reboot_arena_thread_;
+}
+
+#else
+
+reboot_arena_t *
+reboot_arena_thread(void)
+{
+   return NULL;
+}
+
+#endif
+
+/* <!-- }}} Per-thread arena --> */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
@@ -0,0 +1,324 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+#ifndef __REBOOT_ARENA_H__
+#define __REBOOT_ARENA_H__
+
+/*!
+ * @file  arena.h
+ * @brief Bump allocator.
+ *
+ * This  header  provides an arena, a region  allocator
+ * handing out memory by bumping a cursor through large
+ * chunks  obtained  from  the  operating  system,  and
+ * releasing it all at once rather than piecewise :
+ *
+ * - `reboot_arena_init`          : Initialization.
+ * - `reboot_arena_alloc`         : Allocation.
+ * - `reboot_arena_alloc_aligned` : Aligned allocation.
+ * - `reboot_arena_mark`          : Position capture.
+ * - `reboot_arena_reset`         : Position rewind.
+ * - `reboot_arena_clear`         : Full rewind.
+ * - `reboot_arena_trim`          : Spares release.
+ * - `reboot_arena_destroy`       : Finalization.
+ * - `reboot_arena_thread`        : Per-thread arena.
+ *
+ * Allocation  only takes a handful of instructions  on
+ * the  common path and never touches a lock, an  arena
+ * being meant to be used by a single thread at a time.
+ * Rewinding  keeps  the  chunks around  for  the  next
+ * allocations,  a request-scoped arena thus reaching a
+ * steady  state in which it performs no system call at
+ * all :
+ *
+ * ```c
+ * reboot_arena_t     *arena = reboot_arena_thread();
+ * reboot_arena_mark_t mark  = reboot_arena_mark(arena);
+ *
+ * request_t *request = reboot_arena_alloc(arena, sizeof *request);
+ * ...
+ * reboot_arena_reset(arena, mark);
+ * ```
+ *
+ * Chunks  are  mapped  with `mmap`  or  `VirtualAlloc`
+ * wherever   `preprocessor/environment/os.h`   reports
+ * them,   and  with  `malloc`  otherwise.  The   first
+ * allocation    of    a    chunk   is    aligned    to
+ * `REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_CACHE_LINE_SIZE`,
+ * keeping  the  chunk header out of the line it  lands
+ * in.
+ *
+ * Arenas  created with `REBOOT_ARENA_HUGE_PAGES`  back
+ * their  chunks with huge pages where possible, saving
+ * TLB  misses  on  large working sets.  Explicit  huge
+ * pages  are  tried  first  through  `MAP_HUGETLB`  or
+ * `MEM_LARGE_PAGES`,  falling back to transparent huge
+ * pages  through  `MADV_HUGEPAGE` and then to  regular
+ * pages,  the flag never causing a chunk allocation to
+ * fail.
+ *
+ * These  functions are usable from both C and C++, the
+ * slow paths living in `arena.c`.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "preprocessor/environment/architecture.h"
+#include "preprocessor/environment/compiler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! <!-- Arena {{{ -->
+ * @addtogroup  arena_arena Arena
+ * @brief Arena state and lifetime
+ *
+ * The  arena  is a plain structure, to be embedded  or
+ * declared  on  the  stack at will, whose  fields  are
+ * private.  It  must  be initialized  before  use  and
+ * destroyed  afterwards, which returns every chunk  it
+ * holds, spare ones included, to the operating system.
+ * @{
+ */
+
+/*!
+ * @def   REBOOT_ARENA_HUGE_PAGES
+ * @brief Huge page backing flag.
+ */
+#define REBOOT_ARENA_HUGE_PAGES 1u
+
+/*!
+ * @def   REBOOT_ARENA_CHUNK_SIZE
+ * @brief Default chunk size.
+ *
+ * This  is  the chunk size used when `0` is  given  to
+ * `reboot_arena_init`,  and by the per-thread  arenas.
+ * It  may  be  overridden when building  the  library.
+ * Requests  larger than the chunk size are served from
+ * a dedicated chunk.
+ */
+#ifndef REBOOT_ARENA_CHUNK_SIZE
+#  define REBOOT_ARENA_CHUNK_SIZE (256u * 1024u)
+#endif
+
+/*!
+ * @def   REBOOT_ARENA_ALIGNMENT
+ * @brief Default allocation alignment.
+ *
+ * This    is   the   alignment    `reboot_arena_alloc`
+ * guarantees,  matching  that  of `malloc`  on  64-bit
+ * targets.
+ */
+#define REBOOT_ARENA_ALIGNMENT 16u
+
+struct reboot_arena_chunk_;
+
+/*!
+ * @brief Arena.
+ */
+typedef struct reboot_arena {
+   unsigned char              *cursor;
+   unsigned char              *limit;
+   struct reboot_arena_chunk_ *chunk;
+   struct reboot_arena_chunk_ *spare;
+   size_t                      chunk_size;
+   unsigned                    flags;
+} reboot_arena_t;
+
+/*!
+ * @brief Arena initialization.
+ *
+ * This   function   initializes  an   empty   `arena`,
+ * allocating   chunks   of  `chunk_size`   bytes,   or
+ * `REBOOT_ARENA_CHUNK_SIZE` if `0`, as needed. `flags`
+ * is   either  `0`  or  `REBOOT_ARENA_HUGE_PAGES`.  No
+ * memory is allocated until the first allocation.
+ */
+void
+reboot_arena_init(reboot_arena_t *arena, size_t chunk_size, unsigned flags);
+
+/*!
+ * @brief Arena finalization.
+ *
+ * This  function releases every chunk held by `arena`,
+ * invalidating  every  allocation  made from  it.  The
+ * arena may be initialized again afterwards.
+ */
+void reboot_arena_destroy(reboot_arena_t *arena);
+
+/*!
+ * @brief Spare chunk release.
+ *
+ * This  function  releases the chunks kept  around  by
+ * rewinding    `arena`,   leaving   live   allocations
+ * untouched.
+ */
+void reboot_arena_trim(reboot_arena_t *arena);
+
+/*!
+ * @brief Per-thread arena.
+ *
+ * This  function  returns  an  arena  private  to  the
+ * calling  thread, initialized with the default  chunk
+ * size  on  first  use and destroyed when  the  thread
+ * exits.  Memory allocated from it must therefore  not
+ * outlive  the  thread. It returns `NULL`  on  targets
+ * lacking   thread-local   storage,  in   which   case
+ * `REBOOT_ARENA_HAS_THREAD` is left undefined.
+ */
+reboot_arena_t *reboot_arena_thread(void);
+
+#if defined(REBOOT_HAS_THREAD_LOCAL)
+#  define REBOOT_ARENA_HAS_THREAD
+#endif
+
+/*! @} <!-- }}} Arena --> */
+
+/*! <!-- Allocation {{{ -->
+ * @addtogroup  arena_allocation Allocation
+ * @brief Bump allocation
+ *
+ * Allocations  return `NULL` once the operating system
+ * runs out of memory, and may return `NULL` for a zero
+ * size,   as  `malloc`  does.  They  are  never  freed
+ * individually.
+ * @{
+ */
+
+/*!
+ * @brief Chunk allocation slow path.
+ */
+REBOOT_COLD void *
+reboot_arena_grow_(reboot_arena_t *arena, size_t size, size_t alignment);
+
+/*!
+ * @brief Aligned allocation.
+ *
+ * This  function  allocates  `size` bytes  aligned  to
+ * `alignment`, which must be a power of two.
+ */
+static REBOOT_INLINE void *
+reboot_arena_alloc_aligned(
+   reboot_arena_t *arena, size_t size, size_t alignment
+) {
+   uintptr_t cursor = (uintptr_t) arena->cursor;
+   uintptr_t limit  = (uintptr_t) arena->limit;
+
+   cursor = (cursor + (alignment - 1u)) & ~(uintptr_t) (alignment - 1u);
+
+   if (REBOOT_LIKELY(cursor <= limit && size <= limit - cursor)) {
+      arena->cursor = (unsigned char *) cursor + size;
+      return (void *) cursor;
+   }
+
+   return reboot_arena_grow_(arena, size, alignment);
+}
+
+/*!
+ * @brief Allocation.
+ *
+ * This  function  allocates  `size` bytes  aligned  to
+ * `REBOOT_ARENA_ALIGNMENT`.
+ */
+static REBOOT_INLINE void *
+reboot_arena_alloc(reboot_arena_t *arena, size_t size)
+{
+   return reboot_arena_alloc_aligned(arena, size, REBOOT_ARENA_ALIGNMENT);
+}
+
+/*! @} <!-- }}} Allocation --> */
+
+/*! <!-- Rewinding {{{ -->
+ * @addtogroup  arena_rewinding Rewinding
+ * @brief Mark and reset
+ *
+ * A  mark captures the position of an arena, to  which
+ * `reboot_arena_reset`  later  rewinds  it,  releasing
+ * every  allocation  made  in between at  once.  Marks
+ * nest,  rewinding  to a mark invalidating every  mark
+ * taken  after it. Chunks emptied by a rewind are kept
+ * as   spares   for   subsequent   allocations   until
+ * `reboot_arena_trim` or `reboot_arena_destroy`.
+ * @{
+ */
+
+/*!
+ * @brief Arena position.
+ */
+typedef struct reboot_arena_mark {
+   struct reboot_arena_chunk_ *chunk;
+   unsigned char              *cursor;
+} reboot_arena_mark_t;
+
+/*!
+ * @brief Chunk release slow path.
+ */
+void reboot_arena_release_(reboot_arena_t *arena, reboot_arena_mark_t mark);
+
+/*!
+ * @brief Position capture.
+ */
+static REBOOT_INLINE reboot_arena_mark_t
+reboot_arena_mark(const reboot_arena_t *arena)
+{
+   reboot_arena_mark_t mark;
+
+   mark.chunk  = arena->chunk;
+   mark.cursor = arena->cursor;
+
+   return mark;
+}
+
+/*!
+ * @brief Position rewind.
+ *
+ * This  function rewinds `arena` to `mark`, which must
+ * have   been   taken  from  it  and  not  have   been
+ * invalidated since.
+ */
+static REBOOT_INLINE void
+reboot_arena_reset(reboot_arena_t *arena, reboot_arena_mark_t mark)
+{
+   if (REBOOT_LIKELY(mark.chunk == arena->chunk)) {
+      arena->cursor = mark.cursor;
+      return;
+   }
+
+   reboot_arena_release_(arena, mark);
+}
+
+/*!
+ * @brief Full rewind.
+ *
+ * This  function rewinds `arena` to its initial state,
+ * every chunk it holds becoming a spare.
+ */
+static REBOOT_INLINE void
+reboot_arena_clear(reboot_arena_t *arena)
+{
+   reboot_arena_mark_t mark;
+
+   mark.chunk  = NULL;
+   mark.cursor = NULL;
+
+   reboot_arena_reset(arena, mark);
+}
+
+/*! @} <!-- }}} Rewinding --> */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __REBOOT_ARENA_H__ */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
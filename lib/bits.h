@@ -0,0 +1,449 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+#ifndef __REBOOT_BITS_H__
+#define __REBOOT_BITS_H__
+
+/*!
+ * @file  bits.h
+ * @brief Bit manipulation primitives.
+ *
+ * This   header  provides  portable  bit  manipulation
+ * primitives  on 32-bit and 64-bit unsigned  integers,
+ * each  resolving  to  the best builtin  or  intrinsic
+ * reported   by  `preprocessor/environment/compiler.h`
+ * and  `preprocessor/environment/architecture.h`,  and
+ * to a branch-free fallback otherwise :
+ *
+ * - `clz`      : Leading zero count.
+ * - `ctz`      : Trailing zero count.
+ * - `popcount` : Set bit count.
+ * - `bswap`    : Byte order reversal.
+ * - `rotl`     : Left rotation.
+ * - `rotr`     : Right rotation.
+ * - `pdep`     : Parallel bit deposit.
+ * - `pext`     : Parallel bit extraction.
+ *
+ * Each one is named `reboot_bits_<primitive><width>`,
+ * e.g. `reboot_bits_clz32` or `reboot_bits_bswap16`.
+ *
+ * Unlike   the  builtins  they  are  built  upon,  the
+ * counting  primitives  are defined for a zero  input,
+ * yielding  the width of their operand as the  `lzcnt`
+ * and  `tzcnt`  instructions  do. Compilers  fold  the
+ * extra    test   away   whenever   targeting   either
+ * instruction.
+ *
+ * The  parallel  bit primitives only map to  a  single
+ * instruction  when  BMI2 is available, in which  case
+ * `REBOOT_BITS_HAS_FAST_PDEP`    is   defined.   Their
+ * fallback  loops  over the set bits of the  mask  and
+ * callers  on  a hot path should rather test  for  the
+ * macro  and  pick another algorithm. Beware that  AMD
+ * processors   prior   to   Zen   3   implement   both
+ * instructions  in microcode, making them slower  than
+ * the fallback for dense masks.
+ *
+ * Every  primitive  is  a  `static`  inline  function,
+ * usable from both C and C++.
+ */
+
+#include <stdint.h>
+
+#include "preprocessor/environment/architecture.h"
+#include "preprocessor/environment/compiler.h"
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_INTRINSIC_BITSCAN)
+#  include <intrin.h>
+#  include <stdlib.h>
+#endif
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_BMI2)
+#  include <immintrin.h>
+#  define REBOOT_BITS_HAS_FAST_PDEP
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! <!-- Bit counting {{{ -->
+ * @addtogroup  bits_counting Bit counting
+ * @brief Leading zeros, trailing zeros and set bits
+ *
+ * The builtins operate on `unsigned int` and `unsigned
+ * long  long`, which are assumed to be 32 and 64  bits
+ * wide respectively on every compiler providing them.
+ * @{
+ */
+
+/*!
+ * @brief 32-bit set bit count.
+ */
+static REBOOT_INLINE unsigned
+reboot_bits_popcount32(uint32_t x)
+{
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN_POPCOUNT)
+   return (unsigned) __builtin_popcount(x);
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_INTRINSIC_BITSCAN) \
+   && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_POPCNT)
+   return (unsigned) __popcnt(x);
+#else
+   x = x - ((x >> 1) & UINT32_C(0x55555555));
+   x = (x & UINT32_C(0x33333333)) + ((x >> 2) & UINT32_C(0x33333333));
+   x = (x + (x >> 4)) & UINT32_C(0x0f0f0f0f);
+
+   return (unsigned) ((x * UINT32_C(0x01010101)) >> 24);
+#endif
+}
+
+/*!
+ * @brief 64-bit set bit count.
+ */
+static REBOOT_INLINE unsigned
+reboot_bits_popcount64(uint64_t x)
+{
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN_POPCOUNT)
+   return (unsigned) __builtin_popcountll(x);
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_INTRINSIC_BITSCAN) \
+   && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_POPCNT)        \
+   && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86_64)
+   return (unsigned) __popcnt64(x);
+#else
+   x = x - ((x >> 1) & UINT64_C(0x5555555555555555));
+   x = (x & UINT64_C(0x3333333333333333))
+     + ((x >> 2) & UINT64_C(0x3333333333333333));
+   x = (x + (x >> 4)) & UINT64_C(0x0f0f0f0f0f0f0f0f);
+
+   return (unsigned) ((x * UINT64_C(0x0101010101010101)) >> 56);
+#endif
+}
+
+/*!
+ * @brief 32-bit leading zero count.
+ *
+ * This  function  returns the number of  leading  zero
+ * bits of `x`, or `32` if `x` is zero.
+ */
+static REBOOT_INLINE unsigned
+reboot_bits_clz32(uint32_t x)
+{
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN_CLZ)
+   return x ? (unsigned) __builtin_clz(x) : 32u;
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_INTRINSIC_BITSCAN)
+   unsigned long index;
+
+   return _BitScanReverse(&index, x) ? 31u - (unsigned) index : 32u;
+#else
+   x |= x >>  1;
+   x |= x >>  2;
+   x |= x >>  4;
+   x |= x >>  8;
+   x |= x >> 16;
+
+   return 32u - reboot_bits_popcount32(x);
+#endif
+}
+
+/*!
+ * @brief 64-bit leading zero count.
+ *
+ * This  function  returns the number of  leading  zero
+ * bits of `x`, or `64` if `x` is zero.
+ */
+static REBOOT_INLINE unsigned
+reboot_bits_clz64(uint64_t x)
+{
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN_CLZ)
+   return x ? (unsigned) __builtin_clzll(x) : 64u;
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_INTRINSIC_BITSCAN64)
+   unsigned long index;
+
+   return _BitScanReverse64(&index, x) ? 63u - (unsigned) index : 64u;
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_INTRINSIC_BITSCAN)
+   uint32_t high = (uint32_t) (x >> 32);
+
+   return high ? reboot_bits_clz32(high)
+               : 32u + reboot_bits_clz32((uint32_t) x);
+#else
+   x |= x >>  1;
+   x |= x >>  2;
+   x |= x >>  4;
+   x |= x >>  8;
+   x |= x >> 16;
+   x |= x >> 32;
+
+   return 64u - reboot_bits_popcount64(x);
+#endif
+}
+
+/*!
+ * @brief 32-bit trailing zero count.
+ *
+ * This  function  returns the number of trailing  zero
+ * bits of `x`, or `32` if `x` is zero.
+ */
+static REBOOT_INLINE unsigned
+reboot_bits_ctz32(uint32_t x)
+{
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN_CTZ)
+   return x ? (unsigned) __builtin_ctz(x) : 32u;
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_INTRINSIC_BITSCAN)
+   unsigned long index;
+
+   return _BitScanForward(&index, x) ? (unsigned) index : 32u;
+#else
+   return reboot_bits_popcount32((x & (0u - x)) - 1u);
+#endif
+}
+
+/*!
+ * @brief 64-bit trailing zero count.
+ *
+ * This  function  returns the number of trailing  zero
+ * bits of `x`, or `64` if `x` is zero.
+ */
+static REBOOT_INLINE unsigned
+reboot_bits_ctz64(uint64_t x)
+{
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN_CTZ)
+   return x ? (unsigned) __builtin_ctzll(x) : 64u;
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_INTRINSIC_BITSCAN64)
+   unsigned long index;
+
+   return _BitScanForward64(&index, x) ? (unsigned) index : 64u;
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_INTRINSIC_BITSCAN)
+   uint32_t low = (uint32_t) x;
+
+   return low ? reboot_bits_ctz32(low)
+              : 32u + reboot_bits_ctz32((uint32_t) (x >> 32));
+#else
+   return reboot_bits_popcount64((x & (0u - x)) - 1u);
+#endif
+}
+
+/*! @} <!-- }}} Bit counting --> */
+
+/*! <!-- Byte swapping {{{ -->
+ * @addtogroup  bits_bswap Byte swapping
+ * @brief Byte order reversal
+ *
+ * The  fallbacks are written so that compilers lacking
+ * the  builtins  still recognize them as a byte  swap,
+ * which GCC and Clang do from `-O2`.
+ * @{
+ */
+
+/*!
+ * @brief 16-bit byte order reversal.
+ */
+static REBOOT_INLINE uint16_t
+reboot_bits_bswap16(uint16_t x)
+{
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN_BSWAP16)
+   return __builtin_bswap16(x);
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_INTRINSIC_BYTESWAP)
+   return _byteswap_ushort(x);
+#else
+   return (uint16_t) ((x >> 8) | (x << 8));
+#endif
+}
+
+/*!
+ * @brief 32-bit byte order reversal.
+ */
+static REBOOT_INLINE uint32_t
+reboot_bits_bswap32(uint32_t x)
+{
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN_BSWAP32)
+   return __builtin_bswap32(x);
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_INTRINSIC_BYTESWAP)
+   return _byteswap_ulong(x);
+#else
+   x = ((x & UINT32_C(0x00ff00ff)) << 8) | ((x >> 8) & UINT32_C(0x00ff00ff));
+
+   return (x << 16) | (x >> 16);
+#endif
+}
+
+/*!
+ * @brief 64-bit byte order reversal.
+ */
+static REBOOT_INLINE uint64_t
+reboot_bits_bswap64(uint64_t x)
+{
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN_BSWAP64)
+   return __builtin_bswap64(x);
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_INTRINSIC_BYTESWAP)
+   return _byteswap_uint64(x);
+#else
+   x = ((x & UINT64_C(0x00ff00ff00ff00ff)) <<  8)
+     | ((x >>  8) & UINT64_C(0x00ff00ff00ff00ff));
+   x = ((x & UINT64_C(0x0000ffff0000ffff)) << 16)
+     | ((x >> 16) & UINT64_C(0x0000ffff0000ffff));
+
+   return (x << 32) | (x >> 32);
+#endif
+}
+
+/*! @} <!-- }}} Byte swapping --> */
+
+/*! <!-- Rotation {{{ -->
+ * @addtogroup  bits_rotation Rotation
+ * @brief Bit rotation
+ *
+ * Rotations  are  expressed with masked shift  counts,
+ * which  is  both free of undefined behaviour for  any
+ * count  and the idiom every major compiler turns into
+ * a   single   rotate  instruction,   builtins   being
+ * unnecessary.
+ * @{
+ */
+
+/*!
+ * @brief 32-bit left rotation.
+ */
+static REBOOT_INLINE uint32_t
+reboot_bits_rotl32(uint32_t x, unsigned n)
+{
+   return (x << (n & 31u)) | (x >> ((0u - n) & 31u));
+}
+
+/*!
+ * @brief 64-bit left rotation.
+ */
+static REBOOT_INLINE uint64_t
+reboot_bits_rotl64(uint64_t x, unsigned n)
+{
+   return (x << (n & 63u)) | (x >> ((0u - n) & 63u));
+}
+
+/*!
+ * @brief 32-bit right rotation.
+ */
+static REBOOT_INLINE uint32_t
+reboot_bits_rotr32(uint32_t x, unsigned n)
+{
+   return (x >> (n & 31u)) | (x << ((0u - n) & 31u));
+}
+
+/*!
+ * @brief 64-bit right rotation.
+ */
+static REBOOT_INLINE uint64_t
+reboot_bits_rotr64(uint64_t x, unsigned n)
+{
+   return (x >> (n & 63u)) | (x << ((0u - n) & 63u));
+}
+
+/*! @} <!-- }}} Rotation --> */
+
+/*! <!-- Parallel bit operations {{{ -->
+ * @addtogroup  bits_parallel Parallel bit operations
+ * @brief Parallel bit deposit and extraction
+ *
+ * `pdep`  scatters  the low-order bits of `x`  to  the
+ * positions  of the set bits of `mask`, `pext` gathers
+ * the  bits of `x` at the positions of the set bits of
+ * `mask` into the low-order bits of the result.
+ * @{
+ */
+
+/*!
+ * @brief 32-bit parallel bit deposit.
+ */
+static REBOOT_INLINE uint32_t
+reboot_bits_pdep32(uint32_t x, uint32_t mask)
+{
+#if defined(REBOOT_BITS_HAS_FAST_PDEP)
+   return _pdep_u32(x, mask);
+#else
+   uint32_t result = 0;
+   uint32_t bit;
+
+   for (bit = 1; mask; bit <<= 1, mask &= mask - 1) {
+      result |= (mask & (0u - mask)) & (0u - (uint32_t) ((x & bit) != 0));
+   }
+
+   return result;
+#endif
+}
+
+/*!
+ * @brief 64-bit parallel bit deposit.
+ */
+static REBOOT_INLINE uint64_t
+reboot_bits_pdep64(uint64_t x, uint64_t mask)
+{
+#if defined(REBOOT_BITS_HAS_FAST_PDEP)                                        \
+ && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86_64)
+   return _pdep_u64(x, mask);
+#else
+   uint64_t result = 0;
+   uint64_t bit;
+
+   for (bit = 1; mask; bit <<= 1, mask &= mask - 1) {
+      result |= (mask & (0u - mask)) & (0u - (uint64_t) ((x & bit) != 0));
+   }
+
+   return result;
+#endif
+}
+
+/*!
+ * @brief 32-bit parallel bit extraction.
+ */
+static REBOOT_INLINE uint32_t
+reboot_bits_pext32(uint32_t x, uint32_t mask)
+{
+#if defined(REBOOT_BITS_HAS_FAST_PDEP)
+   return _pext_u32(x, mask);
+#else
+   uint32_t result = 0;
+   uint32_t bit;
+
+   for (bit = 1; mask; bit <<= 1, mask &= mask - 1) {
+      result |= bit & (0u - (uint32_t) ((x & mask & (0u - mask)) != 0));
+   }
+
+   return result;
+#endif
+}
+
+/*!
+ * @brief 64-bit parallel bit extraction.
+ */
+static REBOOT_INLINE uint64_t
+reboot_bits_pext64(uint64_t x, uint64_t mask)
+{
+#if defined(REBOOT_BITS_HAS_FAST_PDEP)                                        \
+ && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86_64)
+   return _pext_u64(x, mask);
+#else
+   uint64_t result = 0;
+   uint64_t bit;
+
+   for (bit = 1; mask; bit <<= 1, mask &= mask - 1) {
+      result |= bit & (0u - (uint64_t) ((x & mask & (0u - mask)) != 0));
+   }
+
+   return result;
+#endif
+}
+
+/*! @} <!-- }}} Parallel bit operations --> */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __REBOOT_BITS_H__ */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
@@ -0,0 +1,280 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+#ifndef __REBOOT_HASH_H__
+#define __REBOOT_HASH_H__
+
+/*!
+ * @file  hash.h
+ * @brief Checksums and non-cryptographic hashing.
+ *
+ * This header provides the following functions :
+ *
+ * - `reboot_hash_crc32c` : CRC-32C (Castagnoli), as
+ *                          used by iSCSI, ext4 or SCTP.
+ * - `reboot_hash_64`     : 64-bit hash of a byte range.
+ * - `reboot_hash_mix64`  : 64-bit hash of an integer.
+ *
+ * The   CRC  is  computed  with  the  SSE4.2   `crc32`
+ * instruction  on  x86  and  the  CRC32  extension  on
+ * AArch64, three independent streams being interleaved
+ * over  large  buffers  to  hide the  latency  of  the
+ * instruction,  then folded together with a carry-less
+ * multiplication  (PCLMUL or PMULL). Instructions  the
+ * build  baseline  guarantees are used  directly,  the
+ * others    are    selected   at    runtime    through
+ * `REBOOT_CPU_DISPATCH`.    A    slicing-by-8    table
+ * implementation serves every other host.
+ *
+ * The  64-bit hash follows the construction of wyhash,
+ * i.e.  a  64  by 64 to 128-bit  multiplication  whose
+ * halves  are  folded together, which passes  SMHasher
+ * and  costs a handful of cycles for short keys. It is
+ * not  meant  to resist collision attacks. Its  values
+ * depend on the byte order of the host.
+ *
+ * Sources :
+ *
+ * - https://www.intel.com/content/dam/www/public/us/en/documents/white-papers/crc-iscsi-polynomial-crc32-instruction-paper.pdf
+ * - https://github.com/wangyi-fudan/wyhash
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "preprocessor/environment/architecture.h"
+#include "preprocessor/environment/compiler.h"
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)                \
+ && (defined(_M_X64) || defined(_M_ARM64))
+#  include <intrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! <!-- CRC32C {{{ -->
+ * @addtogroup  hash_crc32c CRC32C
+ * @brief Castagnoli cyclic redundancy check
+ * @{
+ */
+
+/*!
+ * @brief CRC-32C.
+ *
+ * This function returns the CRC of the `size` bytes at
+ * `data`  appended to a range whose CRC is `crc`,  `0`
+ * starting   a  new  one.  The  usual  pre  and   post
+ * conditioning  is  applied,  so that  the  result  is
+ * directly comparable with other implementations.
+ */
+uint32_t reboot_hash_crc32c(uint32_t crc, const void *data, size_t size);
+
+/*!
+ * @brief Table-driven CRC-32C.
+ *
+ * This    function   computes   the   same   CRC    as
+ * `reboot_hash_crc32c`     without     any     special
+ * instruction, at about a gigabyte per second.
+ */
+uint32_t reboot_hash_crc32c_scalar(
+   uint32_t crc, const void *data, size_t size
+);
+
+/*! @} <!-- }}} CRC32C --> */
+
+/*! <!-- Hashing {{{ -->
+ * @addtogroup  hash_hashing Hashing
+ * @brief Non-cryptographic 64-bit hashing
+ * @{
+ */
+
+#define REBOOT_HASH_SECRET0_ ((uint64_t) 0xA0761D64u << 32 | 0x78BD642Fu)
+#define REBOOT_HASH_SECRET1_ ((uint64_t) 0xE7037ED1u << 32 | 0xA0B428DBu)
+#define REBOOT_HASH_SECRET2_ ((uint64_t) 0x8EBC6AF0u << 32 | 0x9C88C6E3u)
+#define REBOOT_HASH_SECRET3_ ((uint64_t) 0x589965CCu << 32 | 0x75374CC3u)
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)                \
+ && defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 reboot_hash_u128_;
+#endif
+
+/*!
+ * Full  64  by  64-bit product,  the  high  half  into
+ * `*high`.
+ */
+static REBOOT_ALWAYS_INLINE uint64_t
+reboot_hash_multiply_(uint64_t a, uint64_t b, uint64_t *high)
+{
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)                \
+ && defined(__SIZEOF_INT128__)
+   reboot_hash_u128_ product = (reboot_hash_u128_) a * b;
+
+   *high = (uint64_t) (product >> 64);
+   return (uint64_t) product;
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)              \
+   && defined(_M_X64)
+   return _umul128(a, b, high);
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)              \
+   && defined(_M_ARM64)
+   *high = __umulh(a, b);
+   return a * b;
+#else
+   uint64_t lo_lo = (a & 0xFFFFFFFFu) * (b & 0xFFFFFFFFu);
+   uint64_t hi_lo = (a >> 32)         * (b & 0xFFFFFFFFu);
+   uint64_t lo_hi = (a & 0xFFFFFFFFu) * (b >> 32);
+   uint64_t hi_hi = (a >> 32)         * (b >> 32);
+   uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFu) + lo_hi;
+
+   *high = hi_hi + (hi_lo >> 32) + (cross >> 32);
+   return (cross << 32) | (lo_lo & 0xFFFFFFFFu);
+#endif
+}
+
+static REBOOT_ALWAYS_INLINE uint64_t
+reboot_hash_fold_(uint64_t a, uint64_t b)
+{
+   uint64_t high;
+   uint64_t low = reboot_hash_multiply_(a, b, &high);
+
+   return low ^ high;
+}
+
+static REBOOT_ALWAYS_INLINE uint64_t
+reboot_hash_read64_(const unsigned char *p)
+{
+   uint64_t value;
+
+   memcpy(&value, p, sizeof value);
+   return value;
+}
+
+static REBOOT_ALWAYS_INLINE uint64_t
+reboot_hash_read32_(const unsigned char *p)
+{
+   uint32_t value;
+
+   memcpy(&value, p, sizeof value);
+   return value;
+}
+
+/*!
+ * @brief 64-bit hash.
+ *
+ * This  function  hashes  the `size` bytes  at  `data`
+ * under  `seed`.  Keys  of  up to 16  bytes  take  two
+ * multiplications,  longer ones one per 16 bytes, over
+ * three independent lanes past 48 bytes.
+ */
+static REBOOT_INLINE uint64_t
+reboot_hash_64(const void *data, size_t size, uint64_t seed)
+{
+   const unsigned char *p = (const unsigned char *) data;
+   uint64_t             a;
+   uint64_t             b;
+
+   seed ^= reboot_hash_fold_(
+      seed ^ REBOOT_HASH_SECRET0_, REBOOT_HASH_SECRET1_
+   );
+
+   if (size <= 16u) {
+      if (size >= 4u) {
+         size_t middle = (size >> 3) << 2;
+
+         a = reboot_hash_read32_(p) << 32
+           | reboot_hash_read32_(p + middle);
+         b = reboot_hash_read32_(p + size - 4u) << 32
+           | reboot_hash_read32_(p + size - 4u - middle);
+      } else if (size > 0u) {
+         a = (uint64_t) p[0] << 16
+           | (uint64_t) p[size >> 1] << 8
+           | p[size - 1u];
+         b = 0;
+      } else {
+         a = 0;
+         b = 0;
+      }
+   } else {
+      size_t remaining = size;
+
+      if (remaining > 48u) {
+         uint64_t lane1 = seed;
+         uint64_t lane2 = seed;
+
+         do {
+            seed  = reboot_hash_fold_(
+               reboot_hash_read64_(p)      ^ REBOOT_HASH_SECRET1_,
+               reboot_hash_read64_(p + 8)  ^ seed
+            );
+            lane1 = reboot_hash_fold_(
+               reboot_hash_read64_(p + 16) ^ REBOOT_HASH_SECRET2_,
+               reboot_hash_read64_(p + 24) ^ lane1
+            );
+            lane2 = reboot_hash_fold_(
+               reboot_hash_read64_(p + 32) ^ REBOOT_HASH_SECRET3_,
+               reboot_hash_read64_(p + 40) ^ lane2
+            );
+
+            p         += 48;
+            remaining -= 48u;
+         } while (remaining > 48u);
+
+         seed ^= lane1 ^ lane2;
+      }
+
+      while (remaining > 16u) {
+         seed = reboot_hash_fold_(
+            reboot_hash_read64_(p)     ^ REBOOT_HASH_SECRET1_,
+            reboot_hash_read64_(p + 8) ^ seed
+         );
+
+         p         += 16;
+         remaining -= 16u;
+      }
+
+      /* The last 16 bytes, overlapping the previous ones if need be. */
+      a = reboot_hash_read64_(p + remaining - 16u);
+      b = reboot_hash_read64_(p + remaining - 8u);
+   }
+
+   a  = reboot_hash_multiply_(a ^ REBOOT_HASH_SECRET1_, b ^ seed, &b);
+
+   return reboot_hash_fold_(
+      a ^ REBOOT_HASH_SECRET0_ ^ (uint64_t) size, b ^ REBOOT_HASH_SECRET1_
+   );
+}
+
+/*!
+ * @brief 64-bit integer hash.
+ *
+ * This function scrambles `value` so that every bit of
+ * the  result depends on every bit of the input, which
+ * makes  the  low  bits  of hashed  integers  fit  for
+ * indexing power of two tables.
+ */
+static REBOOT_INLINE uint64_t
+reboot_hash_mix64(uint64_t value)
+{
+   return reboot_hash_fold_(
+      value ^ REBOOT_HASH_SECRET0_, REBOOT_HASH_SECRET1_
+   );
+}
+
+/*! @} <!-- }}} Hashing --> */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __REBOOT_HASH_H__ */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
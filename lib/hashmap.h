@@ -0,0 +1,995 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+#ifndef __REBOOT_HASHMAP_H__
+#define __REBOOT_HASHMAP_H__
+
+/*!
+ * @file  hashmap.h
+ * @brief Open-addressing hash map.
+ *
+ * This  header provides a hash map of fixed-size  keys
+ * and values, stored inline in a single flat array :
+ *
+ * - `reboot_hashmap_init`    : Initialization.
+ * - `reboot_hashmap_find`    : Lookup.
+ * - `reboot_hashmap_insert`  : Lookup or insertion.
+ * - `reboot_hashmap_erase`   : Removal.
+ * - `reboot_hashmap_next`    : Iteration.
+ * - `reboot_hashmap_destroy` : Finalization.
+ *
+ * The layout is that of Swiss tables. Every slot has a
+ * control  byte, holding either the low 7 bits of  the
+ * hash  of  its key or a marker for empty and  deleted
+ * slots.  Lookups  compare  a whole group  of  control
+ * bytes  against  the  7  bits  of  the  hash  of  the
+ * requested key at once, and only ever touch the slots
+ * whose   byte  matches,  i.e.  one  in  128  of   the
+ * non-matching  ones.  Groups are 16 bytes  wide  with
+ * SSE2  or NEON, and 8 bytes wide otherwise,  compared
+ * through  carry-free  arithmetic  on a  64-bit  word.
+ * Probing   moves  from  one  group  to  the  next  by
+ * increasing  strides,  which visits every group  once
+ * when the capacity is a power of two.
+ *
+ * The  control  bytes of the first group are  mirrored
+ * past  the  end of the array, which lets a  group  be
+ * loaded  from  any slot on without  wrapping  around.
+ * Removed  keys  leave a tombstone behind,  the  table
+ * being  rehashed  into  a  fresh array  of  the  same
+ * capacity  instead  of growing once they account  for
+ * more than half of the occupied slots.
+ *
+ * Keys  and values are copied in and out byte-wise and
+ * must  therefore  be  trivially  copyable.  Keys  are
+ * hashed   with  `reboot_hash_64`  and  compared  with
+ * `memcmp`  unless hashing and equality functions  are
+ * given,  as keys with padding or indirection require.
+ * Pointers  returned by the map are invalidated by any
+ * insertion.
+ *
+ * A C++11 wrapper, `reboot::hashmap`, is provided when
+ * the header is included from C++.
+ *
+ * Sources :
+ *
+ * - https://abseil.io/about/design/swisstables
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bits.h"
+#include "hash.h"
+#include "load.h"
+#include "preprocessor/environment/architecture.h"
+#include "preprocessor/environment/compiler.h"
+#include "preprocessor/environment/standard.h"
+
+/*!
+ * @def   REBOOT_HASHMAP_FORCE_SWAR
+ * @brief Portable group flag.
+ *
+ * When  defined,  groups  are 8 bytes wide and matched
+ * through  64-bit  arithmetic  even where SSE2 or NEON
+ * are available, e.g. to exercise that implementation.
+ * The group width determines the layout of the control
+ * bytes,  every  translation unit sharing a map having
+ * to agree on it.
+ */
+#if defined(REBOOT_HASHMAP_FORCE_SWAR)
+#  define REBOOT_HASHMAP_GROUP 8u
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SSE2)
+#  include <emmintrin.h>
+#  define REBOOT_HASHMAP_SSE2_
+#  define REBOOT_HASHMAP_GROUP 16u
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_NEON)
+#  include <arm_neon.h>
+#  define REBOOT_HASHMAP_NEON_
+#  define REBOOT_HASHMAP_GROUP 16u
+#else
+#  define REBOOT_HASHMAP_GROUP 8u
+#endif
+
+#define REBOOT_HASHMAP_EMPTY_   0x80u
+#define REBOOT_HASHMAP_DELETED_ 0xFEu
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! <!-- Groups {{{ -->
+ * @addtogroup  hashmap_groups Groups
+ * @brief Control byte group matching
+ *
+ * Matches  are returned as masks holding a single  bit
+ * per  control byte, `1 << REBOOT_HASHMAP_SHIFT_` bits
+ * apart.
+ * @{
+ */
+
+#if defined(REBOOT_HASHMAP_SSE2_)
+
+#  define REBOOT_HASHMAP_SHIFT_ 0
+
+typedef __m128i reboot_hashmap_group_;
+
+static REBOOT_ALWAYS_INLINE reboot_hashmap_group_
+reboot_hashmap_load_(const unsigned char *control)
+{
+   return _mm_loadu_si128((const __m128i *) (const void *) control);
+}
+
+static REBOOT_ALWAYS_INLINE uint64_t
+reboot_hashmap_match_(reboot_hashmap_group_ group, unsigned char tag)
+{
+   return (uint64_t) (unsigned) _mm_movemask_epi8(
+      _mm_cmpeq_epi8(group, _mm_set1_epi8((char) tag))
+   );
+}
+
+static REBOOT_ALWAYS_INLINE uint64_t
+reboot_hashmap_empty_(reboot_hashmap_group_ group)
+{
+   return reboot_hashmap_match_(group, REBOOT_HASHMAP_EMPTY_);
+}
+
+/* Empty and deleted slots alone have their high bit set. */
+static REBOOT_ALWAYS_INLINE uint64_t
+reboot_hashmap_free_(reboot_hashmap_group_ group)
+{
+   return (uint64_t) (unsigned) _mm_movemask_epi8(group);
+}
+
+static REBOOT_ALWAYS_INLINE uint64_t
+reboot_hashmap_full_(reboot_hashmap_group_ group)
+{
+   return reboot_hashmap_free_(group) ^ 0xFFFFu;
+}
+
+#elif defined(REBOOT_HASHMAP_NEON_)
+
+/*!
+ * Comparison  results  are narrowed to four  bits  per
+ * byte, of which only the highest is kept.
+ */
+#  define REBOOT_HASHMAP_SHIFT_ 2
+#  define REBOOT_HASHMAP_LANES_ ((uint64_t) 0x88888888u << 32 | 0x88888888u)
+
+typedef uint8x16_t reboot_hashmap_group_;
+
+static REBOOT_ALWAYS_INLINE reboot_hashmap_group_
+reboot_hashmap_load_(const unsigned char *control)
+{
+   return vld1q_u8(control);
+}
+
+static REBOOT_ALWAYS_INLINE uint64_t
+reboot_hashmap_mask_(uint8x16_t lanes)
+{
+   uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(lanes), 4);
+
+   return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0)
+        & REBOOT_HASHMAP_LANES_;
+}
+
+static REBOOT_ALWAYS_INLINE uint64_t
+reboot_hashmap_match_(reboot_hashmap_group_ group, unsigned char tag)
+{
+   return reboot_hashmap_mask_(vceqq_u8(group, vdupq_n_u8(tag)));
+}
+
+static REBOOT_ALWAYS_INLINE uint64_t
+reboot_hashmap_empty_(reboot_hashmap_group_ group)
+{
+   return reboot_hashmap_match_(group, REBOOT_HASHMAP_EMPTY_);
+}
+
+static REBOOT_ALWAYS_INLINE uint64_t
+reboot_hashmap_free_(reboot_hashmap_group_ group)
+{
+   return reboot_hashmap_mask_(vtstq_u8(group, vdupq_n_u8(0x80u)));
+}
+
+static REBOOT_ALWAYS_INLINE uint64_t
+reboot_hashmap_full_(reboot_hashmap_group_ group)
+{
+   return reboot_hashmap_free_(group) ^ REBOOT_HASHMAP_LANES_;
+}
+
+#else
+
+/*!
+ * Bytes  are  tested in place within  a  little-endian
+ * 64-bit  word, the high bit of each byte holding  the
+ * result.  `match` may also report the byte  following
+ * an  actual  match  when it equals the tag  with  its
+ * lowest  bit  flipped, the borrow of the  subtraction
+ * propagating, which merely costs a key comparison.
+ */
+#  define REBOOT_HASHMAP_SHIFT_ 3
+#  define REBOOT_HASHMAP_LOWS_  ((uint64_t) 0x01010101u << 32 | 0x01010101u)
+#  define REBOOT_HASHMAP_HIGHS_ ((uint64_t) 0x80808080u << 32 | 0x80808080u)
+
+typedef uint64_t reboot_hashmap_group_;
+
+static REBOOT_ALWAYS_INLINE reboot_hashmap_group_
+reboot_hashmap_load_(const unsigned char *control)
+{
+   return reboot_load_le64(control);
+}
+
+static REBOOT_ALWAYS_INLINE uint64_t
+reboot_hashmap_match_(reboot_hashmap_group_ group, unsigned char tag)
+{
+   uint64_t bytes = group ^ (REBOOT_HASHMAP_LOWS_ * tag);
+
+   return (bytes - REBOOT_HASHMAP_LOWS_) & ~bytes & REBOOT_HASHMAP_HIGHS_;
+}
+
+/* `EMPTY` is the only marker whose bit 1 is clear. */
+static REBOOT_ALWAYS_INLINE uint64_t
+reboot_hashmap_empty_(reboot_hashmap_group_ group)
+{
+   return group & ~(group << 6) & REBOOT_HASHMAP_HIGHS_;
+}
+
+static REBOOT_ALWAYS_INLINE uint64_t
+reboot_hashmap_free_(reboot_hashmap_group_ group)
+{
+   return group & REBOOT_HASHMAP_HIGHS_;
+}
+
+static REBOOT_ALWAYS_INLINE uint64_t
+reboot_hashmap_full_(reboot_hashmap_group_ group)
+{
+   return ~group & REBOOT_HASHMAP_HIGHS_;
+}
+
+#endif
+
+static REBOOT_ALWAYS_INLINE size_t
+reboot_hashmap_lowest_(uint64_t mask)
+{
+   return (size_t) (reboot_bits_ctz64(mask) >> REBOOT_HASHMAP_SHIFT_);
+}
+
+/*! @} <!-- }}} Groups --> */
+
+/*! <!-- Map {{{ -->
+ * @addtogroup  hashmap_map Map
+ * @brief Map state and lifetime
+ * @{
+ */
+
+/*!
+ * @brief Key hashing function.
+ */
+typedef uint64_t (*reboot_hashmap_hash_t)(const void *key, size_t size);
+
+/*!
+ * @brief Key equality function, non-zero when equal.
+ */
+typedef int (*reboot_hashmap_equal_t)(
+   const void *left, const void *right, size_t size
+);
+
+/*!
+ * @brief Hash map.
+ *
+ * Slots   hold  the  key  followed  by  the  value  at
+ * `value_offset`, each aligned after the largest power
+ * of two dividing its size, up to 16.
+ */
+typedef struct reboot_hashmap {
+   unsigned char          *control;
+   unsigned char          *slots;
+   size_t                  capacity;
+   size_t                  size;
+   size_t                  growth;
+   size_t                  key_size;
+   size_t                  value_size;
+   size_t                  value_offset;
+   size_t                  slot_size;
+   reboot_hashmap_hash_t   hash;
+   reboot_hashmap_equal_t  equal;
+} reboot_hashmap_t;
+
+static REBOOT_ALWAYS_INLINE size_t
+reboot_hashmap_alignment_(size_t size)
+{
+   size_t alignment = size & (~size + 1u);
+
+   if (alignment == 0) {
+      return 1u;
+   }
+
+   return alignment > 16u ? 16u : alignment;
+}
+
+static REBOOT_ALWAYS_INLINE size_t
+reboot_hashmap_round_(size_t value, size_t alignment)
+{
+   return (value + (alignment - 1u)) & ~(alignment - 1u);
+}
+
+/*!
+ * @brief Map initialization.
+ *
+ * This   function   initializes  an  empty  `map`   of
+ * `key_size`  bytes keys to `value_size` bytes values,
+ * `0`  making a set. `hash` and `equal` may be  `NULL`
+ * for  keys  to be hashed and compared  byte-wise.  No
+ * memory is allocated until the first insertion.
+ */
+static REBOOT_INLINE void
+reboot_hashmap_init(
+   reboot_hashmap_t *map, size_t key_size, size_t value_size,
+   reboot_hashmap_hash_t hash, reboot_hashmap_equal_t equal
+) {
+   size_t key_alignment   = reboot_hashmap_alignment_(key_size);
+   size_t value_alignment = reboot_hashmap_alignment_(value_size);
+   size_t alignment       = key_alignment > value_alignment
+                          ? key_alignment : value_alignment;
+
+   map->control      = NULL;
+   map->slots        = NULL;
+   map->capacity     = 0;
+   map->size         = 0;
+   map->growth       = 0;
+   map->key_size     = key_size;
+   map->value_size   = value_size;
+   map->value_offset = reboot_hashmap_round_(key_size, value_alignment);
+   map->slot_size    = reboot_hashmap_round_(
+      map->value_offset + value_size, alignment
+   );
+   map->hash         = hash;
+   map->equal        = equal;
+}
+
+/*!
+ * @brief Map finalization.
+ */
+static REBOOT_INLINE void
+reboot_hashmap_destroy(reboot_hashmap_t *map)
+{
+   free(map->control);
+
+   map->control  = NULL;
+   map->slots    = NULL;
+   map->capacity = 0;
+   map->size     = 0;
+   map->growth   = 0;
+}
+
+/*!
+ * @brief Map reset.
+ *
+ * This   function  removes  every  entry  from  `map`,
+ * keeping its memory.
+ */
+static REBOOT_INLINE void
+reboot_hashmap_clear(reboot_hashmap_t *map)
+{
+   if (map->capacity == 0) {
+      return;
+   }
+
+   memset(
+      map->control, REBOOT_HASHMAP_EMPTY_,
+      map->capacity + REBOOT_HASHMAP_GROUP
+   );
+
+   map->size   = 0;
+   map->growth = map->capacity - map->capacity / 8u;
+}
+
+/*! @} <!-- }}} Map --> */
+
+/*! <!-- Probing {{{ -->
+ * @addtogroup  hashmap_probing Probing
+ * @brief Slot lookup
+ * @{
+ */
+
+static REBOOT_ALWAYS_INLINE uint64_t
+reboot_hashmap_hash_(const reboot_hashmap_t *map, const void *key)
+{
+   return map->hash != NULL
+      ? map->hash(key, map->key_size)
+      : reboot_hash_64(key, map->key_size, 0);
+}
+
+static REBOOT_ALWAYS_INLINE int
+reboot_hashmap_equal_(
+   const reboot_hashmap_t *map, const void *left, const void *right
+) {
+   return map->equal != NULL
+      ? map->equal(left, right, map->key_size)
+      : memcmp(left, right, map->key_size) == 0;
+}
+
+/*!
+ * Writes  the  control byte of slot `index`,  and  its
+ * mirror  when  the slot is part of the  first  group.
+ * Other  slots write the same byte twice, which spares
+ * a branch.
+ */
+static REBOOT_ALWAYS_INLINE void
+reboot_hashmap_set_(reboot_hashmap_t *map, size_t index, unsigned char tag)
+{
+   size_t mask = map->capacity - 1u;
+
+   map->control[index] = tag;
+   map->control[((index - REBOOT_HASHMAP_GROUP) & mask)
+              + REBOOT_HASHMAP_GROUP] = tag;
+}
+
+/*!
+ * Returns  the  slot  holding  `key`,  whose  hash  is
+ * `hash`, or `NULL`.
+ */
+static REBOOT_ALWAYS_INLINE unsigned char *
+reboot_hashmap_lookup_(
+   const reboot_hashmap_t *map, const void *key, uint64_t hash
+) {
+   size_t        mask     = map->capacity - 1u;
+   size_t        position = (size_t) (hash >> 7) & mask;
+   size_t        stride   = 0;
+   unsigned char tag      = (unsigned char) (hash & 0x7Fu);
+
+   for (;;) {
+      reboot_hashmap_group_ group =
+         reboot_hashmap_load_(map->control + position);
+      uint64_t              match = reboot_hashmap_match_(group, tag);
+
+      for (; match != 0; match &= match - 1u) {
+         size_t         index = (position + reboot_hashmap_lowest_(match))
+                              & mask;
+         unsigned char *slot  = map->slots + index * map->slot_size;
+
+         if (REBOOT_LIKELY(reboot_hashmap_equal_(map, slot, key))) {
+            return slot;
+         }
+      }
+
+      if (REBOOT_LIKELY(reboot_hashmap_empty_(group) != 0)) {
+         return NULL;
+      }
+
+      stride   += REBOOT_HASHMAP_GROUP;
+      position  = (position + stride) & mask;
+   }
+}
+
+/*!
+ * Returns the index of the first empty or deleted slot
+ * on  the  probe  sequence of `hash`, which  the  load
+ * factor guarantees to exist.
+ */
+static REBOOT_ALWAYS_INLINE size_t
+reboot_hashmap_vacant_(const reboot_hashmap_t *map, uint64_t hash)
+{
+   size_t mask     = map->capacity - 1u;
+   size_t position = (size_t) (hash >> 7) & mask;
+   size_t stride   = 0;
+
+   for (;;) {
+      uint64_t vacant = reboot_hashmap_free_(
+         reboot_hashmap_load_(map->control + position)
+      );
+
+      if (REBOOT_LIKELY(vacant != 0)) {
+         return (position + reboot_hashmap_lowest_(vacant)) & mask;
+      }
+
+      stride   += REBOOT_HASHMAP_GROUP;
+      position  = (position + stride) & mask;
+   }
+}
+
+/*! @} <!-- }}} Probing --> */
+
+/*! <!-- Resizing {{{ -->
+ * @addtogroup  hashmap_resizing Resizing
+ * @brief Capacity management
+ * @{
+ */
+
+/*!
+ * Moves  every  entry into a new array  of  `capacity`
+ * slots,  a  power  of two no smaller  than  a  group.
+ * Returns  `-1`, leaving `map` untouched, when out  of
+ * memory.
+ */
+static REBOOT_INLINE REBOOT_COLD int
+reboot_hashmap_rehash_(reboot_hashmap_t *map, size_t capacity)
+{
+   reboot_hashmap_t previous = *map;
+   size_t           control  = reboot_hashmap_round_(
+      capacity + REBOOT_HASHMAP_GROUP, 16u
+   );
+   size_t           i;
+
+   if (capacity > ((size_t) -1 - control) / map->slot_size) {
+      return -1;
+   }
+
+   map->control = (unsigned char *) malloc(
+      control + capacity * map->slot_size
+   );
+
+   if (map->control == NULL) {
+      *map = previous;
+      return -1;
+   }
+
+   memset(
+      map->control, REBOOT_HASHMAP_EMPTY_, capacity + REBOOT_HASHMAP_GROUP
+   );
+
+   map->slots    = map->control + control;
+   map->capacity = capacity;
+   map->growth   = capacity - capacity / 8u - previous.size;
+
+   for (i = 0; i < previous.capacity; ++i) {
+      const unsigned char *slot;
+      uint64_t             hash;
+      size_t               index;
+
+      if (previous.control[i] & 0x80u) {
+         continue;
+      }
+
+      slot  = previous.slots + i * previous.slot_size;
+      hash  = reboot_hashmap_hash_(map, slot);
+      index = reboot_hashmap_vacant_(map, hash);
+
+      reboot_hashmap_set_(map, index, (unsigned char) (hash & 0x7Fu));
+      memcpy(map->slots + index * map->slot_size, slot, map->slot_size);
+   }
+
+   free(previous.control);
+
+   return 0;
+}
+
+/*!
+ * @brief Capacity reservation.
+ *
+ * This  function  makes  room for `count`  entries  in
+ * `map`, so that inserting as many does not rehash. It
+ * returns `-1` when out of memory.
+ */
+static REBOOT_INLINE int
+reboot_hashmap_reserve(reboot_hashmap_t *map, size_t count)
+{
+   size_t capacity = REBOOT_HASHMAP_GROUP;
+
+   while (capacity - capacity / 8u < count) {
+      if (capacity > (size_t) -1 / 2u) {
+         return -1;
+      }
+
+      capacity *= 2u;
+   }
+
+   if (capacity <= map->capacity) {
+      return 0;
+   }
+
+   return reboot_hashmap_rehash_(map, capacity);
+}
+
+/*!
+ * Called  once  no empty slot may be  claimed  without
+ * breaking  the load factor. The capacity is kept when
+ * tombstones account for at least half of the occupied
+ * slots, rehashing then clearing them.
+ */
+static REBOOT_INLINE REBOOT_COLD int
+reboot_hashmap_grow_(reboot_hashmap_t *map)
+{
+   size_t capacity = map->capacity;
+
+   if (capacity == 0) {
+      return reboot_hashmap_rehash_(map, REBOOT_HASHMAP_GROUP);
+   }
+
+   if (map->size * 2u > capacity - capacity / 8u) {
+      if (capacity > (size_t) -1 / 2u) {
+         return -1;
+      }
+
+      capacity *= 2u;
+   }
+
+   return reboot_hashmap_rehash_(map, capacity);
+}
+
+/*! @} <!-- }}} Resizing --> */
+
+/*! <!-- Operations {{{ -->
+ * @addtogroup  hashmap_operations Operations
+ * @brief Lookup, insertion, removal and iteration
+ * @{
+ */
+
+/*!
+ * @brief Lookup.
+ *
+ * This  function  returns  a pointer to the  value  of
+ * `key` in `map`, or `NULL` when absent.
+ */
+static REBOOT_INLINE void *
+reboot_hashmap_find(const reboot_hashmap_t *map, const void *key)
+{
+   unsigned char *slot;
+
+   if (map->size == 0) {
+      return NULL;
+   }
+
+   slot = reboot_hashmap_lookup_(map, key, reboot_hashmap_hash_(map, key));
+
+   return slot != NULL ? slot + map->value_offset : NULL;
+}
+
+/*!
+ * @brief Lookup or insertion.
+ *
+ * This  function  returns  a pointer to the  value  of
+ * `key` in `map`, inserting the key first when absent,
+ * in  which  case the value is left uninitialized  and
+ * `*inserted`,  if not `NULL`, is set to non-zero.  It
+ * returns `NULL` when out of memory.
+ */
+static REBOOT_INLINE void *
+reboot_hashmap_insert(reboot_hashmap_t *map, const void *key, int *inserted)
+{
+   uint64_t       hash = reboot_hashmap_hash_(map, key);
+   unsigned char *slot;
+   size_t         index;
+
+   if (inserted != NULL) {
+      *inserted = 0;
+   }
+
+   if (map->size != 0) {
+      slot = reboot_hashmap_lookup_(map, key, hash);
+
+      if (slot != NULL) {
+         return slot + map->value_offset;
+      }
+   }
+
+   if (REBOOT_UNLIKELY(map->growth == 0) && reboot_hashmap_grow_(map) != 0) {
+      return NULL;
+   }
+
+   index = reboot_hashmap_vacant_(map, hash);
+
+   /* Reusing a tombstone leaves the load factor unchanged. */
+   map->growth -= map->control[index] == REBOOT_HASHMAP_EMPTY_;
+   map->size   += 1u;
+
+   reboot_hashmap_set_(map, index, (unsigned char) (hash & 0x7Fu));
+
+   slot = map->slots + index * map->slot_size;
+   memcpy(slot, key, map->key_size);
+
+   if (inserted != NULL) {
+      *inserted = 1;
+   }
+
+   return slot + map->value_offset;
+}
+
+/*!
+ * @brief Removal.
+ *
+ * This  function removes `key` from `map`, and returns
+ * non-zero if it was present.
+ */
+static REBOOT_INLINE int
+reboot_hashmap_erase(reboot_hashmap_t *map, const void *key)
+{
+   unsigned char *slot;
+
+   if (map->size == 0) {
+      return 0;
+   }
+
+   slot = reboot_hashmap_lookup_(map, key, reboot_hashmap_hash_(map, key));
+
+   if (slot == NULL) {
+      return 0;
+   }
+
+   reboot_hashmap_set_(
+      map, (size_t) (slot - map->slots) / map->slot_size,
+      REBOOT_HASHMAP_DELETED_
+   );
+
+   map->size -= 1u;
+
+   return 1;
+}
+
+/*!
+ * @brief Iteration.
+ *
+ * This  function stores pointers to the key and  value
+ * of  the  first entry of `map` at or after  `*cursor`
+ * into  `*key`  and `*value`, either of which  may  be
+ * `NULL`,  and moves `*cursor` past it. It returns `0`
+ * once  every entry has been visited. `*cursor` starts
+ * at  `0`  and  is invalidated by insertions,  not  by
+ * removals of visited entries.
+ */
+static REBOOT_INLINE int
+reboot_hashmap_next(
+   const reboot_hashmap_t *map, size_t *cursor, void **key, void **value
+) {
+   size_t position;
+
+   for (position = *cursor; position < map->capacity;
+        position += REBOOT_HASHMAP_GROUP) {
+      uint64_t       full;
+      size_t         index;
+      unsigned char *slot;
+
+      full = reboot_hashmap_full_(
+         reboot_hashmap_load_(map->control + position)
+      );
+
+      if (full == 0) {
+         continue;
+      }
+
+      /* The mirrored bytes past the end are not entries of their own. */
+      index = position + reboot_hashmap_lowest_(full);
+
+      if (index >= map->capacity) {
+         break;
+      }
+
+      slot    = map->slots + index * map->slot_size;
+      *cursor = index + 1u;
+
+      if (key != NULL) {
+         *key = slot;
+      }
+
+      if (value != NULL) {
+         *value = slot + map->value_offset;
+      }
+
+      return 1;
+   }
+
+   *cursor = map->capacity;
+
+   return 0;
+}
+
+/*! @} <!-- }}} Operations --> */
+
+#ifdef __cplusplus
+}
+#endif
+
+/*! <!-- C++ {{{ -->
+ * @addtogroup  hashmap_cpp C++
+ * @brief Typed C++11 wrapper
+ *
+ * `reboot::hashmap<Key, Value, Hash, Equal>` binds the
+ * C  map  to  a key and value type. `Hash` and `Equal`
+ * are  stateless  function objects, both defaulting to
+ * byte-wise comparisons, and are reached through plain
+ * functions  so  that  the map itself stays the C one.
+ * Keys  whose `operator==` differs from byte equality,
+ * such as padded structures or floating point numbers,
+ * need both to be provided.
+ *
+ * ```cpp
+ * reboot::hashmap<uint64_t, uint32_t> counts;
+ *
+ * counts[id] += 1;
+ *
+ * counts.for_each([](const uint64_t &id, uint32_t &count) {
+ *    ...
+ * });
+ * ```
+ * @{
+ */
+#if defined(__cplusplus)                                                      \
+ && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP11)
+
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace reboot {
+
+/*!
+ * @brief Byte-wise key hash.
+ */
+template <typename Key>
+struct hashmap_hash {
+   uint64_t operator()(const Key &key) const
+   {
+      return reboot_hash_64(&key, sizeof key, 0);
+   }
+};
+
+/*!
+ * @brief Byte-wise key equality.
+ *
+ * Keys   equal   under   `operator==`   yet  differing
+ * byte-wise, e.g. through padding or `-0.0` and `0.0`,
+ * hash   apart   under   `hashmap_hash`,   which  this
+ * predicate  agrees  with  where `std::equal_to` would
+ * not.
+ */
+template <typename Key>
+struct hashmap_equal {
+   bool operator()(const Key &left, const Key &right) const
+   {
+      return memcmp(&left, &right, sizeof left) == 0;
+   }
+};
+
+template <
+   typename Key, typename Value,
+   typename Hash  = hashmap_hash<Key>,
+   typename Equal = hashmap_equal<Key>
+>
+class hashmap {
+   static_assert(
+      std::is_trivially_copyable<Key>::value
+   && std::is_trivially_copyable<Value>::value,
+      "hashmap entries are moved around byte-wise"
+   );
+
+public:
+   hashmap()
+   {
+      reboot_hashmap_init(&map_, sizeof(Key), sizeof(Value), hash_, equal_);
+   }
+
+   ~hashmap()
+   {
+      reboot_hashmap_destroy(&map_);
+   }
+
+   hashmap(const hashmap &) = delete;
+   hashmap &operator=(const hashmap &) = delete;
+
+   hashmap(hashmap &&other) noexcept : map_(other.map_)
+   {
+      other.map_.control  = NULL;
+      other.map_.slots    = NULL;
+      other.map_.capacity = 0;
+      other.map_.size     = 0;
+      other.map_.growth   = 0;
+   }
+
+   hashmap &operator=(hashmap &&other) noexcept
+   {
+      std::swap(map_, other.map_);
+      return *this;
+   }
+
+   size_t size()  const { return map_.size; }
+   bool   empty() const { return map_.size == 0; }
+
+   void clear() { reboot_hashmap_clear(&map_); }
+
+   bool reserve(size_t count)
+   {
+      return reboot_hashmap_reserve(&map_, count) == 0;
+   }
+
+   Value *find(const Key &key)
+   {
+      return static_cast<Value *>(reboot_hashmap_find(&map_, &key));
+   }
+
+   const Value *find(const Key &key) const
+   {
+      return static_cast<const Value *>(reboot_hashmap_find(&map_, &key));
+   }
+
+   /*!
+    * Returns  the  value  of  `key` and  whether  it  was
+    * inserted,  with `value`, or a null pointer when  out
+    * of memory.
+    */
+   std::pair<Value *, bool> insert(const Key &key, const Value &value)
+   {
+      int   inserted = 0;
+      void *slot     = reboot_hashmap_insert(&map_, &key, &inserted);
+
+      if (slot != NULL && inserted) {
+         ::new (slot) Value(value);
+      }
+
+      return std::pair<Value *, bool>(
+         static_cast<Value *>(slot), inserted != 0
+      );
+   }
+
+   /*!
+    * Value-initializes    absent    keys,   and    throws
+    * `std::bad_alloc` when out of memory.
+    */
+   Value &operator[](const Key &key)
+   {
+      int   inserted = 0;
+      void *slot     = reboot_hashmap_insert(&map_, &key, &inserted);
+
+      if (slot == NULL) {
+         throw std::bad_alloc();
+      }
+
+      if (inserted) {
+         ::new (slot) Value();
+      }
+
+      return *static_cast<Value *>(slot);
+   }
+
+   bool erase(const Key &key)
+   {
+      return reboot_hashmap_erase(&map_, &key) != 0;
+   }
+
+   template <typename Function>
+   void for_each(Function function)
+   {
+      size_t  cursor = 0;
+      void   *key;
+      void   *value;
+
+      while (reboot_hashmap_next(&map_, &cursor, &key, &value)) {
+         function(
+            *static_cast<const Key *>(key), *static_cast<Value *>(value)
+         );
+      }
+   }
+
+private:
+   static uint64_t hash_(const void *key, size_t)
+   {
+      return Hash()(*static_cast<const Key *>(key));
+   }
+
+   static int equal_(const void *left, const void *right, size_t)
+   {
+      return Equal()(
+         *static_cast<const Key *>(left), *static_cast<const Key *>(right)
+      );
+   }
+
+   reboot_hashmap_t map_;
+};
+
+} /* namespace reboot */
+
+#endif
+
+/*! @} <!-- }}} C++ --> */
+
+#endif /* __REBOOT_HASHMAP_H__ */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
@@ -0,0 +1,1567 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+/*!
+ * @file  io/aio.c
+ * @brief Completion-based asynchronous file input/output engines.
+ *
+ * Every  engine  keeps  its state behind  the  backend
+ * pointer  of  the  engine structure,  which  `engine`
+ * tells  the  type of, and guarantees nothing but  the
+ * request  accounting of the generic functions,  which
+ * never  let  more than `entries` requests into it  at
+ * once.  Engines  lacking a submission queue of  their
+ * own   stage   prepared  requests  until   the   next
+ * submission.
+ */
+
+/* `pread`, `pwrite` and `MAP_POPULATE` in strict modes. */
+#ifndef _DEFAULT_SOURCE
+#  define _DEFAULT_SOURCE
+#endif
+
+/* Offsets past 2 GiB on 32-bit targets. */
+#ifndef _FILE_OFFSET_BITS
+#  define _FILE_OFFSET_BITS 64
+#endif
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "io/aio.h"
+#include "preprocessor/environment/compiler.h"
+
+#if defined(REBOOT_AIO_HAS_IO_URING)
+#  include <linux/io_uring.h>
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  include <sys/uio.h>
+#  include <unistd.h>
+#  if defined(IORING_SETUP_CLAMP) && defined(__NR_io_uring_setup)
+#     define REBOOT_AIO_URING_
+#  endif
+#endif
+
+#if defined(REBOOT_AIO_HAS_KQUEUE)
+#  include <aio.h>
+#  include <fcntl.h>
+#  include <limits.h>
+#  include <sys/event.h>
+#  include <sys/time.h>
+#  include <unistd.h>
+#  if defined(AIO_LISTIO_MAX)
+#     define REBOOT_AIO_LISTIO_MAX_ AIO_LISTIO_MAX
+#  else
+#     define REBOOT_AIO_LISTIO_MAX_ _POSIX_AIO_LISTIO_MAX
+#  endif
+#endif
+
+#if defined(REBOOT_AIO_HAS_IOCP)
+#  ifndef WIN32_LEAN_AND_MEAN
+#     define WIN32_LEAN_AND_MEAN
+#  endif
+#  include <windows.h>
+#endif
+
+#if defined(REBOOT_AIO_HAS_THREADS)
+#  include <pthread.h>
+#  include <unistd.h>
+#endif
+
+/*!
+ * Linux  caps  every transfer to this size, the  other
+ * engines following suit for consistency and for their
+ * 32-bit lengths.
+ */
+#define REBOOT_AIO_MAX_TRANSFER_ ((size_t) 0x7FFFF000u)
+
+/* <!-- io_uring {{{ --> */
+
+#if defined(REBOOT_AIO_URING_)
+
+struct reboot_aio_uring_ {
+   unsigned            *sq_tail;
+   unsigned            *sq_array;
+   unsigned             sq_mask;
+   unsigned             sq_local;
+   struct io_uring_sqe *sqes;
+   unsigned            *cq_head;
+   unsigned            *cq_tail;
+   unsigned             cq_mask;
+   struct io_uring_cqe *cqes;
+   void                *sq_ring;
+   void                *cq_ring;
+   size_t               sq_ring_size;
+   size_t               cq_ring_size;
+   size_t               sqes_size;
+   int                  descriptor;
+   int                  registered;
+};
+
+static int
+reboot_aio_uring_enter_(
+   int descriptor, unsigned submit, unsigned wait, unsigned flags
+) {
+   return (int) syscall(
+      __NR_io_uring_enter, descriptor, submit, wait, flags, NULL, 0
+   );
+}
+
+static int
+reboot_aio_uring_register_(
+   int descriptor, unsigned opcode, void *argument, unsigned count
+) {
+   return (int) syscall(
+      __NR_io_uring_register, descriptor, opcode, argument, count
+   );
+}
+
+/*!
+ * Kernels older than 5.6 lack the plain read and write
+ * operations, and the probe telling them apart.
+ */
+static int
+reboot_aio_uring_probe_(int descriptor)
+{
+   struct io_uring_probe *probe;
+   int                    supported = 0;
+
+   probe = (struct io_uring_probe *) calloc(
+      1, sizeof *probe + 256u * sizeof(struct io_uring_probe_op)
+   );
+
+   if (probe == NULL) {
+      return 0;
+   }
+
+   if (reboot_aio_uring_register_(
+      descriptor, IORING_REGISTER_PROBE, probe, 256u
+   ) == 0 && probe->last_op >= IORING_OP_WRITE) {
+      supported = (probe->ops[IORING_OP_READ].flags  & IO_URING_OP_SUPPORTED)
+               && (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED);
+   }
+
+   free(probe);
+   return supported;
+}
+
+static void
+reboot_aio_uring_release_(struct reboot_aio_uring_ *ring)
+{
+   if (ring->sqes != NULL) {
+      munmap(ring->sqes, ring->sqes_size);
+   }
+
+   if (ring->cq_ring != NULL && ring->cq_ring != ring->sq_ring) {
+      munmap(ring->cq_ring, ring->cq_ring_size);
+   }
+
+   if (ring->sq_ring != NULL) {
+      munmap(ring->sq_ring, ring->sq_ring_size);
+   }
+
+   close(ring->descriptor);
+   free(ring);
+}
+
+static void *
+reboot_aio_uring_map_(int descriptor, size_t size, off_t offset)
+{
+   void *memory = mmap(
+      NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+      descriptor, offset
+   );
+
+   return memory == MAP_FAILED ? NULL : memory;
+}
+
+/*!
+ * The  submission  queue indirection array  is  filled
+ * with  the  identity once and for all, entries  being
+ * consumed  in order. The completion queue being twice
+ * the  size  of  the  submission  queue,  capping  the
+ * requests  in  flight  to the latter  rules  out  any
+ * overflow.
+ */
+static int
+reboot_aio_uring_init_(reboot_aio_t *aio, unsigned entries)
+{
+   struct reboot_aio_uring_ *ring;
+   struct io_uring_params    params;
+   unsigned char            *sq;
+   unsigned char            *cq;
+   unsigned                  i;
+
+   ring = (struct reboot_aio_uring_ *) calloc(1, sizeof *ring);
+
+   if (ring == NULL) {
+      return -1;
+   }
+
+   memset(&params, 0, sizeof params);
+   params.flags = IORING_SETUP_CLAMP;
+
+   ring->descriptor = (int) syscall(__NR_io_uring_setup, entries, &params);
+
+   if (ring->descriptor < 0) {
+      free(ring);
+      return -1;
+   }
+
+   ring->sq_ring_size = params.sq_off.array
+                      + params.sq_entries * sizeof(unsigned);
+   ring->cq_ring_size = params.cq_off.cqes
+                      + params.cq_entries * sizeof(struct io_uring_cqe);
+   ring->sqes_size    = params.sq_entries * sizeof(struct io_uring_sqe);
+
+   if (params.features & IORING_FEAT_SINGLE_MMAP) {
+      if (ring->cq_ring_size > ring->sq_ring_size) {
+         ring->sq_ring_size = ring->cq_ring_size;
+      }
+
+      ring->cq_ring_size = ring->sq_ring_size;
+   }
+
+   if (!reboot_aio_uring_probe_(ring->descriptor)) {
+      reboot_aio_uring_release_(ring);
+      return -1;
+   }
+
+   ring->sq_ring = reboot_aio_uring_map_(
+      ring->descriptor, ring->sq_ring_size, IORING_OFF_SQ_RING
+   );
+
+   if (ring->sq_ring != NULL && (params.features & IORING_FEAT_SINGLE_MMAP)) {
+      ring->cq_ring = ring->sq_ring;
+   } else if (ring->sq_ring != NULL) {
+      ring->cq_ring = reboot_aio_uring_map_(
+         ring->descriptor, ring->cq_ring_size, IORING_OFF_CQ_RING
+      );
+   }
+
+   if (ring->cq_ring != NULL) {
+      ring->sqes = (struct io_uring_sqe *) reboot_aio_uring_map_(
+         ring->descriptor, ring->sqes_size, IORING_OFF_SQES
+      );
+   }
+
+   if (ring->sqes == NULL) {
+      reboot_aio_uring_release_(ring);
+      return -1;
+   }
+
+   sq = (unsigned char *) ring->sq_ring;
+   cq = (unsigned char *) ring->cq_ring;
+
+   ring->sq_tail  = (unsigned *) (sq + params.sq_off.tail);
+   ring->sq_array = (unsigned *) (sq + params.sq_off.array);
+   ring->sq_mask  = *(unsigned *) (sq + params.sq_off.ring_mask);
+   ring->sq_local = *ring->sq_tail;
+   ring->cq_head  = (unsigned *) (cq + params.cq_off.head);
+   ring->cq_tail  = (unsigned *) (cq + params.cq_off.tail);
+   ring->cq_mask  = *(unsigned *) (cq + params.cq_off.ring_mask);
+   ring->cqes     = (struct io_uring_cqe *) (cq + params.cq_off.cqes);
+
+   for (i = 0; i < params.sq_entries; ++i) {
+      ring->sq_array[i] = i;
+   }
+
+   aio->backend = (struct reboot_aio_backend_ *) ring;
+   aio->engine  = REBOOT_AIO_ENGINE_IO_URING;
+   aio->entries = entries < params.sq_entries ? entries : params.sq_entries;
+
+   return 0;
+}
+
+static void
+reboot_aio_uring_destroy_(reboot_aio_t *aio)
+{
+   reboot_aio_uring_release_((struct reboot_aio_uring_ *) aio->backend);
+}
+
+static int
+reboot_aio_uring_register_buffers_(
+   reboot_aio_t *aio, const reboot_aio_buffer_t *buffers, unsigned count
+) {
+   struct reboot_aio_uring_ *ring = (struct reboot_aio_uring_ *) aio->backend;
+   struct iovec             *vectors;
+   unsigned                  i;
+   int                       result;
+
+   if (ring->registered) {
+      reboot_aio_uring_register_(
+         ring->descriptor, IORING_UNREGISTER_BUFFERS, NULL, 0
+      );
+      ring->registered = 0;
+   }
+
+   if (count == 0) {
+      return 0;
+   }
+
+   vectors = (struct iovec *) malloc(count * sizeof *vectors);
+
+   if (vectors == NULL) {
+      return -1;
+   }
+
+   for (i = 0; i < count; ++i) {
+      vectors[i].iov_base = buffers[i].data;
+      vectors[i].iov_len  = buffers[i].size;
+   }
+
+   result = reboot_aio_uring_register_(
+      ring->descriptor, IORING_REGISTER_BUFFERS, vectors, count
+   );
+
+   free(vectors);
+
+   if (result < 0) {
+      return -1;
+   }
+
+   ring->registered = 1;
+   return 0;
+}
+
+/*!
+ * Entries  are written ahead of the shared tail, which
+ * only  moves  on  submission, the kernel  thus  never
+ * seeing a batch before it is complete.
+ */
+static void
+reboot_aio_uring_prepare_(
+   reboot_aio_t *aio, const reboot_aio_request_t *request
+) {
+   static const unsigned char opcodes[2][3] = {
+      { IORING_OP_READ,       IORING_OP_WRITE,       IORING_OP_FSYNC },
+      { IORING_OP_READ_FIXED, IORING_OP_WRITE_FIXED, IORING_OP_FSYNC }
+   };
+
+   struct reboot_aio_uring_ *ring = (struct reboot_aio_uring_ *) aio->backend;
+   struct io_uring_sqe      *sqe;
+
+   sqe = &ring->sqes[ring->sq_local & ring->sq_mask];
+
+   memset(sqe, 0, sizeof *sqe);
+
+   sqe->opcode    = opcodes[request->buffer >= 0][request->opcode];
+   sqe->fd        = request->file;
+   sqe->user_data = (uint64_t) (uintptr_t) request->user;
+
+   if (request->opcode != REBOOT_AIO_FSYNC) {
+      sqe->off  = request->offset;
+      sqe->addr = (uint64_t) (uintptr_t) request->data;
+      sqe->len  = (uint32_t) request->size;
+
+      /* The kernel rejects an fsync carrying a buffer index. */
+      if (request->buffer >= 0) {
+         sqe->buf_index = (uint16_t) request->buffer;
+      }
+   }
+
+   ++ring->sq_local;
+}
+
+static int
+reboot_aio_uring_submit_(reboot_aio_t *aio)
+{
+   struct reboot_aio_uring_ *ring = (struct reboot_aio_uring_ *) aio->backend;
+   int                       submitted;
+
+   __atomic_store_n(ring->sq_tail, ring->sq_local, __ATOMIC_RELEASE);
+
+   do {
+      submitted = reboot_aio_uring_enter_(
+         ring->descriptor, aio->pending, 0, 0
+      );
+   } while (submitted < 0 && errno == EINTR);
+
+   return submitted;
+}
+
+static int
+reboot_aio_uring_poll_(
+   reboot_aio_t            *aio,
+   reboot_aio_completion_t *completions,
+   unsigned                 count,
+   unsigned                 minimum
+) {
+   struct reboot_aio_uring_ *ring = (struct reboot_aio_uring_ *) aio->backend;
+   unsigned                  reaped = 0;
+
+   for (;;) {
+      unsigned head = *ring->cq_head;
+      unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+
+      while (head != tail && reaped < count) {
+         const struct io_uring_cqe *cqe = &ring->cqes[head & ring->cq_mask];
+
+         completions[reaped].user   = (void *) (uintptr_t) cqe->user_data;
+         completions[reaped].result = cqe->res;
+
+         ++head;
+         ++reaped;
+      }
+
+      __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+      if (reaped >= minimum) {
+         break;
+      }
+
+      if (reboot_aio_uring_enter_(
+         ring->descriptor, 0, minimum - reaped, IORING_ENTER_GETEVENTS
+      ) < 0 && errno != EINTR) {
+         if (reaped == 0) {
+            return -1;
+         }
+
+         break;
+      }
+   }
+
+   return (int) reaped;
+}
+
+#endif
+
+/* <!-- }}} io_uring --> */
+
+/* <!-- kqueue {{{ --> */
+
+#if defined(REBOOT_AIO_HAS_KQUEUE)
+
+struct reboot_aio_kqueue_slot_ {
+   struct aiocb control;
+   void        *user;
+   unsigned     next;
+};
+
+struct reboot_aio_kqueue_ {
+   struct reboot_aio_kqueue_slot_ *slots;
+   struct aiocb                  **staged;
+   reboot_aio_completion_t        *ready;
+   struct kevent                  *events;
+   unsigned                        free;
+   unsigned                        listio_max;
+   unsigned                        ready_count;
+   int                             queue;
+};
+
+static void
+reboot_aio_kqueue_release_(
+   struct reboot_aio_kqueue_      *engine,
+   struct reboot_aio_kqueue_slot_ *slot
+) {
+   slot->next   = engine->free;
+   engine->free = (unsigned) (slot - engine->slots);
+}
+
+static void
+reboot_aio_kqueue_fail_(
+   struct reboot_aio_kqueue_      *engine,
+   struct reboot_aio_kqueue_slot_ *slot,
+   int                             error
+) {
+   engine->ready[engine->ready_count].user   = slot->user;
+   engine->ready[engine->ready_count].result = -(ptrdiff_t) error;
+
+   ++engine->ready_count;
+   reboot_aio_kqueue_release_(engine, slot);
+}
+
+static int
+reboot_aio_kqueue_init_(reboot_aio_t *aio, unsigned entries)
+{
+   struct reboot_aio_kqueue_ *engine;
+   long                       limit;
+   unsigned                   i;
+
+   engine = (struct reboot_aio_kqueue_ *) calloc(1, sizeof *engine);
+
+   if (engine == NULL) {
+      return -1;
+   }
+
+   engine->slots  = (struct reboot_aio_kqueue_slot_ *) calloc(
+      entries, sizeof *engine->slots
+   );
+   engine->staged = (struct aiocb **) calloc(entries, sizeof *engine->staged);
+   engine->ready  = (reboot_aio_completion_t *) calloc(
+      entries, sizeof *engine->ready
+   );
+   engine->events = (struct kevent *) calloc(entries, sizeof *engine->events);
+   engine->queue  = -1;
+
+   if (engine->slots != NULL && engine->staged != NULL
+    && engine->ready != NULL && engine->events != NULL) {
+      engine->queue = kqueue();
+   }
+
+   if (engine->queue < 0) {
+      free(engine->slots);
+      free(engine->staged);
+      free(engine->ready);
+      free(engine->events);
+      free(engine);
+      return -1;
+   }
+
+   for (i = 0; i < entries; ++i) {
+      engine->slots[i].next = i + 1u;
+   }
+
+   limit = sysconf(_SC_AIO_LISTIO_MAX);
+
+   if (limit <= 0) {
+      limit = REBOOT_AIO_LISTIO_MAX_;
+   }
+
+   engine->listio_max = limit < (long) entries ? (unsigned) limit : entries;
+
+   aio->backend = (struct reboot_aio_backend_ *) engine;
+   aio->engine  = REBOOT_AIO_ENGINE_KQUEUE;
+
+   return 0;
+}
+
+static void
+reboot_aio_kqueue_destroy_(reboot_aio_t *aio)
+{
+   struct reboot_aio_kqueue_ *engine =
+      (struct reboot_aio_kqueue_ *) aio->backend;
+
+   close(engine->queue);
+   free(engine->slots);
+   free(engine->staged);
+   free(engine->ready);
+   free(engine->events);
+   free(engine);
+}
+
+static void
+reboot_aio_kqueue_prepare_(
+   reboot_aio_t *aio, const reboot_aio_request_t *request
+) {
+   static const int opcodes[] = { LIO_READ, LIO_WRITE, LIO_NOP };
+
+   struct reboot_aio_kqueue_ *engine =
+      (struct reboot_aio_kqueue_ *) aio->backend;
+   struct reboot_aio_kqueue_slot_ *slot = &engine->slots[engine->free];
+
+   engine->free = slot->next;
+
+   memset(&slot->control, 0, sizeof slot->control);
+
+   slot->control.aio_fildes     = request->file;
+   slot->control.aio_buf        = request->data;
+   slot->control.aio_nbytes     = request->size;
+   slot->control.aio_offset     = (off_t) request->offset;
+   slot->control.aio_lio_opcode = opcodes[request->opcode];
+
+   slot->control.aio_sigevent.sigev_notify          = SIGEV_KEVENT;
+   slot->control.aio_sigevent.sigev_notify_kqueue   = engine->queue;
+   slot->control.aio_sigevent.sigev_value.sival_ptr = slot;
+
+   slot->user = request->user;
+
+   engine->staged[aio->pending] = &slot->control;
+}
+
+/*!
+ * A  failing  `lio_listio` may have queued part of its
+ * list,   the   others   being  told  apart  by  their
+ * `aio_error`,  which  is  `EAGAIN` for those left out
+ * for  lack of resources and fails altogether on those
+ * the  kernel  never  heard  of.  These remain staged,
+ * moved  to  `kept`  onwards  along  with  the flushes
+ * `aio_fsync` turned down likewise, and their count is
+ * returned.  Requests failing on their own by then are
+ * reaped  right  away,  their  kernel  event vanishing
+ * along  with them, and complete with their own error.
+ * `*queued`  counts the requests of `list` handed over
+ * or completed.
+ */
+static unsigned
+reboot_aio_kqueue_recover_(
+   struct reboot_aio_kqueue_ *engine, struct aiocb **list, unsigned count,
+   int listed, struct aiocb **kept, unsigned *queued
+) {
+   unsigned left = 0;
+   unsigned i;
+
+   for (i = 0; i < count; ++i) {
+      struct aiocb *control = list[i];
+      int           error;
+
+      if (control == NULL) {
+         continue;
+      }
+
+      if (control->aio_lio_opcode == LIO_NOP) {
+         kept[left++] = control;
+         continue;
+      }
+
+      if (listed) {
+         ++*queued;
+         continue;
+      }
+
+      error = aio_error(control);
+
+      if (error == EINPROGRESS || error == 0) {
+         ++*queued;
+      } else if (error < 0 || error == EAGAIN) {
+         kept[left++] = control;
+      } else {
+         (void) aio_return(control);
+
+         reboot_aio_kqueue_fail_(
+            engine,
+            (struct reboot_aio_kqueue_slot_ *)
+               control->aio_sigevent.sigev_value.sival_ptr,
+            error
+         );
+
+         ++*queued;
+      }
+   }
+
+   return left;
+}
+
+/*!
+ * Flushes are not batchable and go through `aio_fsync`
+ * on  their  own, their entries being cleared from the
+ * list,  `lio_listio` ignoring null entries as well as
+ * the  flushes left staged. The list is handed over in
+ * chunks  of at most `_SC_AIO_LISTIO_MAX` entries, the
+ * kernel  rejecting  longer  ones altogether. Requests
+ * left staged are moved back to the front of the list,
+ * ahead of the next chunk, the submission failing with
+ * the  error  of the last failing call when none could
+ * be handed over.
+ */
+static int
+reboot_aio_kqueue_submit_(reboot_aio_t *aio)
+{
+   struct reboot_aio_kqueue_ *engine =
+      (struct reboot_aio_kqueue_ *) aio->backend;
+   unsigned                   queued = 0;
+   unsigned                   kept   = 0;
+   int                        error  = 0;
+   unsigned                   i;
+
+   for (i = 0; i < aio->pending; ++i) {
+      struct aiocb *control = engine->staged[i];
+
+      if (control->aio_lio_opcode != LIO_NOP) {
+         continue;
+      }
+
+      if (aio_fsync(O_SYNC, control) == 0) {
+         engine->staged[i] = NULL;
+         ++queued;
+      } else if (errno == EAGAIN) {
+         error = errno;
+      } else {
+         reboot_aio_kqueue_fail_(
+            engine,
+            (struct reboot_aio_kqueue_slot_ *)
+               control->aio_sigevent.sigev_value.sival_ptr,
+            errno
+         );
+
+         engine->staged[i] = NULL;
+         ++queued;
+      }
+   }
+
+   for (i = 0; i < aio->pending; i += engine->listio_max) {
+      struct aiocb **list   = engine->staged + i;
+      unsigned       count  = aio->pending - i;
+      int            listed;
+
+      if (count > engine->listio_max) {
+         count = engine->listio_max;
+      }
+
+      listed = lio_listio(LIO_NOWAIT, list, (int) count, NULL) == 0;
+
+      if (!listed) {
+         error = errno;
+      }
+
+      kept += reboot_aio_kqueue_recover_(
+         engine, list, count, listed, engine->staged + kept, &queued
+      );
+   }
+
+   if (queued == 0 && error != 0) {
+      errno = error;
+      return -1;
+   }
+
+   return (int) queued;
+}
+
+static int
+reboot_aio_kqueue_poll_(
+   reboot_aio_t            *aio,
+   reboot_aio_completion_t *completions,
+   unsigned                 count,
+   unsigned                 minimum
+) {
+   struct reboot_aio_kqueue_ *engine =
+      (struct reboot_aio_kqueue_ *) aio->backend;
+   struct timespec            zero   = { 0, 0 };
+   unsigned                   reaped = 0;
+
+   while (engine->ready_count > 0 && reaped < count) {
+      completions[reaped++] = engine->ready[--engine->ready_count];
+   }
+
+   while (reaped < count) {
+      unsigned wanted = count - reaped;
+      int      events;
+      int      i;
+
+      if (wanted > aio->entries) {
+         wanted = aio->entries;
+      }
+
+      events = kevent(
+         engine->queue, NULL, 0, engine->events, (int) wanted,
+         reaped >= minimum ? &zero : NULL
+      );
+
+      if (events < 0) {
+         if (errno == EINTR) {
+            continue;
+         }
+
+         if (reaped == 0) {
+            return -1;
+         }
+
+         break;
+      }
+
+      for (i = 0; i < events; ++i) {
+         struct reboot_aio_kqueue_slot_ *slot =
+            (struct reboot_aio_kqueue_slot_ *) engine->events[i].udata;
+         int     error  = aio_error(&slot->control);
+         ssize_t result = aio_return(&slot->control);
+
+         completions[reaped].user   = slot->user;
+         completions[reaped].result = error != 0
+            ? -(ptrdiff_t) error : (ptrdiff_t) result;
+
+         ++reaped;
+         reboot_aio_kqueue_release_(engine, slot);
+      }
+
+      if (reaped >= minimum) {
+         break;
+      }
+   }
+
+   return (int) reaped;
+}
+
+#endif
+
+/* <!-- }}} kqueue --> */
+
+/* <!-- IOCP {{{ --> */
+
+#if defined(REBOOT_AIO_HAS_IOCP)
+
+struct reboot_aio_iocp_slot_ {
+   OVERLAPPED           overlapped;
+   reboot_aio_request_t request;
+   DWORD                error;
+   unsigned             next;
+};
+
+struct reboot_aio_iocp_ {
+   HANDLE                        port;
+   struct reboot_aio_iocp_slot_ *slots;
+   unsigned                     *staged;
+   OVERLAPPED_ENTRY             *entries;
+   unsigned                      free;
+};
+
+static int
+reboot_aio_iocp_init_(reboot_aio_t *aio, unsigned entries)
+{
+   struct reboot_aio_iocp_ *engine;
+   unsigned                 i;
+
+   engine = (struct reboot_aio_iocp_ *) calloc(1, sizeof *engine);
+
+   if (engine == NULL) {
+      return -1;
+   }
+
+   engine->slots   = (struct reboot_aio_iocp_slot_ *) calloc(
+      entries, sizeof *engine->slots
+   );
+   engine->staged  = (unsigned *) calloc(entries, sizeof *engine->staged);
+   engine->entries = (OVERLAPPED_ENTRY *) calloc(
+      entries, sizeof *engine->entries
+   );
+
+   if (engine->slots != NULL && engine->staged != NULL
+    && engine->entries != NULL) {
+      engine->port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 0);
+   }
+
+   if (engine->port == NULL) {
+      free(engine->slots);
+      free(engine->staged);
+      free(engine->entries);
+      free(engine);
+      return -1;
+   }
+
+   for (i = 0; i < entries; ++i) {
+      engine->slots[i].next = i + 1u;
+   }
+
+   aio->backend = (struct reboot_aio_backend_ *) engine;
+   aio->engine  = REBOOT_AIO_ENGINE_IOCP;
+
+   return 0;
+}
+
+static void
+reboot_aio_iocp_destroy_(reboot_aio_t *aio)
+{
+   struct reboot_aio_iocp_ *engine = (struct reboot_aio_iocp_ *) aio->backend;
+
+   CloseHandle(engine->port);
+   free(engine->slots);
+   free(engine->staged);
+   free(engine->entries);
+   free(engine);
+}
+
+static void
+reboot_aio_iocp_prepare_(
+   reboot_aio_t *aio, const reboot_aio_request_t *request
+) {
+   struct reboot_aio_iocp_ *engine = (struct reboot_aio_iocp_ *) aio->backend;
+   unsigned                 index  = engine->free;
+
+   engine->free                 = engine->slots[index].next;
+   engine->slots[index].request = *request;
+   engine->staged[aio->pending] = index;
+}
+
+/*!
+ * Requests  failing on submission, and flushes,  which
+ * `FlushFileBuffers`  carries out synchronously,  post
+ * their  completion  packet  themselves,  their  error
+ * being kept in their slot.
+ */
+static int
+reboot_aio_iocp_submit_(reboot_aio_t *aio)
+{
+   struct reboot_aio_iocp_ *engine = (struct reboot_aio_iocp_ *) aio->backend;
+   unsigned                 i;
+
+   for (i = 0; i < aio->pending; ++i) {
+      struct reboot_aio_iocp_slot_ *slot = &engine->slots[engine->staged[i]];
+      HANDLE                        file = (HANDLE) slot->request.file;
+      DWORD                         size = (DWORD) slot->request.size;
+      BOOL                          started;
+
+      memset(&slot->overlapped, 0, sizeof slot->overlapped);
+
+      slot->overlapped.Offset     = (DWORD) slot->request.offset;
+      slot->overlapped.OffsetHigh = (DWORD) (slot->request.offset >> 32);
+      slot->error                 = 0;
+
+      switch (slot->request.opcode) {
+         case REBOOT_AIO_READ:
+            started = ReadFile(
+               file, slot->request.data, size, NULL, &slot->overlapped
+            );
+            break;
+         case REBOOT_AIO_WRITE:
+            started = WriteFile(
+               file, slot->request.data, size, NULL, &slot->overlapped
+            );
+            break;
+         default:
+            if (!FlushFileBuffers(file)) {
+               slot->error = GetLastError();
+            }
+
+            PostQueuedCompletionStatus(engine->port, 0, 0, &slot->overlapped);
+            continue;
+      }
+
+      if (!started && GetLastError() != ERROR_IO_PENDING) {
+         slot->error = GetLastError();
+         PostQueuedCompletionStatus(engine->port, 0, 0, &slot->overlapped);
+      }
+   }
+
+   return (int) aio->pending;
+}
+
+static int
+reboot_aio_iocp_poll_(
+   reboot_aio_t            *aio,
+   reboot_aio_completion_t *completions,
+   unsigned                 count,
+   unsigned                 minimum
+) {
+   struct reboot_aio_iocp_ *engine = (struct reboot_aio_iocp_ *) aio->backend;
+   unsigned                 reaped = 0;
+
+   while (reaped < count) {
+      ULONG wanted = (ULONG) (count - reaped);
+      ULONG removed;
+      ULONG i;
+
+      if (wanted > aio->entries) {
+         wanted = (ULONG) aio->entries;
+      }
+
+      if (!GetQueuedCompletionStatusEx(
+         engine->port, engine->entries, wanted, &removed,
+         reaped >= minimum ? 0 : INFINITE, FALSE
+      )) {
+         if (GetLastError() != WAIT_TIMEOUT && reaped == 0) {
+            return -1;
+         }
+
+         break;
+      }
+
+      for (i = 0; i < removed; ++i) {
+         struct reboot_aio_iocp_slot_ *slot = CONTAINING_RECORD(
+            engine->entries[i].lpOverlapped,
+            struct reboot_aio_iocp_slot_, overlapped
+         );
+         DWORD bytes = 0;
+         DWORD error = slot->error;
+
+         if (error == 0 && !GetOverlappedResult(
+            (HANDLE) slot->request.file, &slot->overlapped, &bytes, FALSE
+         )) {
+            error = GetLastError();
+         }
+
+         completions[reaped].user   = slot->request.user;
+         completions[reaped].result = error == 0 || error == ERROR_HANDLE_EOF
+            ? (ptrdiff_t) bytes : -(ptrdiff_t) error;
+
+         ++reaped;
+
+         slot->next   = engine->free;
+         engine->free = (unsigned) (slot - engine->slots);
+      }
+
+      if (reaped >= minimum) {
+         break;
+      }
+   }
+
+   return (int) reaped;
+}
+
+#endif
+
+/* <!-- }}} IOCP --> */
+
+/* <!-- Threads {{{ --> */
+
+#if defined(REBOOT_AIO_HAS_THREADS)
+
+/*!
+ * Requests   and  completions  go  through  two  rings
+ * guarded  by a single lock, workers picking  requests
+ * one  at  a time and only holding the lock to do  so,
+ * the blocking call happening outside of it.
+ */
+struct reboot_aio_threads_ {
+   pthread_mutex_t          lock;
+   pthread_cond_t           work;
+   pthread_cond_t           done;
+   reboot_aio_request_t    *staged;
+   reboot_aio_request_t    *queue;
+   reboot_aio_completion_t *completions;
+   unsigned                 capacity;
+   unsigned                 queue_head;
+   unsigned                 queue_count;
+   unsigned                 completion_head;
+   unsigned                 completion_count;
+   unsigned                 thread_count;
+   int                      stopping;
+   pthread_t                threads[REBOOT_AIO_THREADS];
+};
+
+#define REBOOT_AIO_WRAP_(index, capacity)                                     \
+   ((index) >= (capacity) ? (index) - (capacity) : (index))
+
+static ptrdiff_t
+reboot_aio_threads_execute_(const reboot_aio_request_t *request)
+{
+   ssize_t result;
+
+   do {
+      switch (request->opcode) {
+         case REBOOT_AIO_READ:
+            result = pread(
+               request->file, request->data, request->size,
+               (off_t) request->offset
+            );
+            break;
+         case REBOOT_AIO_WRITE:
+            result = pwrite(
+               request->file, request->data, request->size,
+               (off_t) request->offset
+            );
+            break;
+         default:
+            result = fsync(request->file);
+            break;
+      }
+   } while (result < 0 && errno == EINTR);
+
+   return result < 0 ? -(ptrdiff_t) errno : (ptrdiff_t) result;
+}
+
+static void *
+reboot_aio_threads_worker_(void *argument)
+{
+   struct reboot_aio_threads_ *pool = (struct reboot_aio_threads_ *) argument;
+
+   pthread_mutex_lock(&pool->lock);
+
+   for (;;) {
+      reboot_aio_request_t    request;
+      reboot_aio_completion_t completion;
+      unsigned                index;
+
+      while (pool->queue_count == 0 && !pool->stopping) {
+         pthread_cond_wait(&pool->work, &pool->lock);
+      }
+
+      if (pool->queue_count == 0) {
+         break;
+      }
+
+      request          = pool->queue[pool->queue_head];
+      pool->queue_head = REBOOT_AIO_WRAP_(
+         pool->queue_head + 1u, pool->capacity
+      );
+
+      --pool->queue_count;
+
+      pthread_mutex_unlock(&pool->lock);
+
+      completion.user   = request.user;
+      completion.result = reboot_aio_threads_execute_(&request);
+
+      pthread_mutex_lock(&pool->lock);
+
+      index = REBOOT_AIO_WRAP_(
+         pool->completion_head + pool->completion_count, pool->capacity
+      );
+
+      pool->completions[index] = completion;
+
+      ++pool->completion_count;
+
+      pthread_cond_signal(&pool->done);
+   }
+
+   pthread_mutex_unlock(&pool->lock);
+
+   return NULL;
+}
+
+static void
+reboot_aio_threads_release_(struct reboot_aio_threads_ *pool)
+{
+   unsigned i;
+
+   pthread_mutex_lock(&pool->lock);
+   pool->stopping = 1;
+   pthread_mutex_unlock(&pool->lock);
+   pthread_cond_broadcast(&pool->work);
+
+   for (i = 0; i < pool->thread_count; ++i) {
+      pthread_join(pool->threads[i], NULL);
+   }
+
+   pthread_cond_destroy(&pool->done);
+   pthread_cond_destroy(&pool->work);
+   pthread_mutex_destroy(&pool->lock);
+
+   free(pool->staged);
+   free(pool->queue);
+   free(pool->completions);
+   free(pool);
+}
+
+static int
+reboot_aio_threads_init_(reboot_aio_t *aio, unsigned entries)
+{
+   struct reboot_aio_threads_ *pool;
+
+   pool = (struct reboot_aio_threads_ *) calloc(1, sizeof *pool);
+
+   if (pool == NULL) {
+      return -1;
+   }
+
+   pool->capacity    = entries;
+   pool->staged      = (reboot_aio_request_t *) calloc(
+      entries, sizeof *pool->staged
+   );
+   pool->queue       = (reboot_aio_request_t *) calloc(
+      entries, sizeof *pool->queue
+   );
+   pool->completions = (reboot_aio_completion_t *) calloc(
+      entries, sizeof *pool->completions
+   );
+
+   if (pool->staged == NULL || pool->queue == NULL
+    || pool->completions == NULL) {
+      free(pool->staged);
+      free(pool->queue);
+      free(pool->completions);
+      free(pool);
+      errno = ENOMEM;
+      return -1;
+   }
+
+   pthread_mutex_init(&pool->lock, NULL);
+   pthread_cond_init(&pool->work, NULL);
+   pthread_cond_init(&pool->done, NULL);
+
+   while (pool->thread_count < REBOOT_AIO_THREADS
+       && pthread_create(
+             &pool->threads[pool->thread_count], NULL,
+             reboot_aio_threads_worker_, pool
+          ) == 0) {
+      ++pool->thread_count;
+   }
+
+   if (pool->thread_count == 0) {
+      reboot_aio_threads_release_(pool);
+      errno = EAGAIN;
+      return -1;
+   }
+
+   aio->backend = (struct reboot_aio_backend_ *) pool;
+   aio->engine  = REBOOT_AIO_ENGINE_THREADS;
+
+   return 0;
+}
+
+static void
+reboot_aio_threads_destroy_(reboot_aio_t *aio)
+{
+   reboot_aio_threads_release_((struct reboot_aio_threads_ *) aio->backend);
+}
+
+static void
+reboot_aio_threads_prepare_(
+   reboot_aio_t *aio, const reboot_aio_request_t *request
+) {
+   struct reboot_aio_threads_ *pool =
+      (struct reboot_aio_threads_ *) aio->backend;
+
+   pool->staged[aio->pending] = *request;
+}
+
+static int
+reboot_aio_threads_submit_(reboot_aio_t *aio)
+{
+   struct reboot_aio_threads_ *pool =
+      (struct reboot_aio_threads_ *) aio->backend;
+   unsigned                    i;
+
+   pthread_mutex_lock(&pool->lock);
+
+   for (i = 0; i < aio->pending; ++i) {
+      unsigned index = REBOOT_AIO_WRAP_(
+         pool->queue_head + pool->queue_count, pool->capacity
+      );
+
+      pool->queue[index] = pool->staged[i];
+      ++pool->queue_count;
+   }
+
+   pthread_mutex_unlock(&pool->lock);
+
+   if (aio->pending > 1u) {
+      pthread_cond_broadcast(&pool->work);
+   } else {
+      pthread_cond_signal(&pool->work);
+   }
+
+   return (int) aio->pending;
+}
+
+static int
+reboot_aio_threads_poll_(
+   reboot_aio_t            *aio,
+   reboot_aio_completion_t *completions,
+   unsigned                 count,
+   unsigned                 minimum
+) {
+   struct reboot_aio_threads_ *pool =
+      (struct reboot_aio_threads_ *) aio->backend;
+   unsigned                    reaped = 0;
+
+   pthread_mutex_lock(&pool->lock);
+
+   while (pool->completion_count < minimum) {
+      pthread_cond_wait(&pool->done, &pool->lock);
+   }
+
+   while (pool->completion_count > 0 && reaped < count) {
+      completions[reaped++] = pool->completions[pool->completion_head];
+
+      pool->completion_head = REBOOT_AIO_WRAP_(
+         pool->completion_head + 1u, pool->capacity
+      );
+
+      --pool->completion_count;
+   }
+
+   pthread_mutex_unlock(&pool->lock);
+
+   return (int) reaped;
+}
+
+#endif
+
+/* <!-- }}} Threads --> */
+
+/* <!-- Engine {{{ --> */
+
+/*!
+ * The  native  engine is tried first, the thread  pool
+ * taking  over when it fails to initialize, `io_uring`
+ * being commonly disabled or forbidden.
+ */
+int
+reboot_aio_init(reboot_aio_t *aio, unsigned entries, unsigned flags)
+{
+   aio->backend      = NULL;
+   aio->buffers      = NULL;
+   aio->buffer_count = 0;
+   aio->entries      = entries;
+   aio->pending      = 0;
+   aio->inflight     = 0;
+   aio->engine       = REBOOT_AIO_ENGINE_NONE;
+
+   if (entries == 0) {
+      errno = EINVAL;
+      return -1;
+   }
+
+#if defined(REBOOT_AIO_URING_)
+   if (!(flags & REBOOT_AIO_FORCE_THREADS)
+    && reboot_aio_uring_init_(aio, entries) == 0) {
+      return 0;
+   }
+#elif defined(REBOOT_AIO_HAS_KQUEUE)
+   if (!(flags & REBOOT_AIO_FORCE_THREADS)
+    && reboot_aio_kqueue_init_(aio, entries) == 0) {
+      return 0;
+   }
+#elif defined(REBOOT_AIO_HAS_IOCP)
+   (void) flags;
+
+   return reboot_aio_iocp_init_(aio, entries);
+#endif
+
+#if defined(REBOOT_AIO_HAS_THREADS)
+   (void) flags;
+
+   return reboot_aio_threads_init_(aio, entries);
+#elif !defined(REBOOT_AIO_HAS_IOCP)
+   (void) flags;
+
+   errno = ENOSYS;
+   return -1;
+#endif
+}
+
+void
+reboot_aio_destroy(reboot_aio_t *aio)
+{
+   reboot_aio_completion_t discarded[64];
+
+   aio->inflight -= aio->pending;
+   aio->pending   = 0;
+
+   while (aio->inflight > 0) {
+      if (reboot_aio_poll(aio, discarded, 64, 1) < 0) {
+         break;
+      }
+   }
+
+   switch (aio->engine) {
+#if defined(REBOOT_AIO_URING_)
+      case REBOOT_AIO_ENGINE_IO_URING:
+         reboot_aio_uring_destroy_(aio);
+         break;
+#endif
+#if defined(REBOOT_AIO_HAS_KQUEUE)
+      case REBOOT_AIO_ENGINE_KQUEUE:
+         reboot_aio_kqueue_destroy_(aio);
+         break;
+#endif
+#if defined(REBOOT_AIO_HAS_IOCP)
+      case REBOOT_AIO_ENGINE_IOCP:
+         reboot_aio_iocp_destroy_(aio);
+         break;
+#endif
+#if defined(REBOOT_AIO_HAS_THREADS)
+      case REBOOT_AIO_ENGINE_THREADS:
+         reboot_aio_threads_destroy_(aio);
+         break;
+#endif
+      default:
+         break;
+   }
+
+   free(aio->buffers);
+
+   aio->backend      = NULL;
+   aio->buffers      = NULL;
+   aio->buffer_count = 0;
+   aio->engine       = REBOOT_AIO_ENGINE_NONE;
+}
+
+int
+reboot_aio_register_buffers(
+   reboot_aio_t *aio, const reboot_aio_buffer_t *buffers, unsigned count
+) {
+   reboot_aio_buffer_t *copy = NULL;
+
+   if (count > 0) {
+      copy = (reboot_aio_buffer_t *) malloc(count * sizeof *copy);
+
+      if (copy == NULL) {
+         return -1;
+      }
+
+      memcpy(copy, buffers, count * sizeof *copy);
+   }
+
+   free(aio->buffers);
+
+   aio->buffers      = copy;
+   aio->buffer_count = count;
+
+#if defined(REBOOT_AIO_URING_)
+   if (aio->engine == REBOOT_AIO_ENGINE_IO_URING
+    && reboot_aio_uring_register_buffers_(aio, buffers, count) != 0) {
+      free(aio->buffers);
+
+      aio->buffers      = NULL;
+      aio->buffer_count = 0;
+
+      return -1;
+   }
+#endif
+
+   return 0;
+}
+
+int
+reboot_aio_attach(reboot_aio_t *aio, reboot_aio_file_t file)
+{
+#if defined(REBOOT_AIO_HAS_IOCP)
+   struct reboot_aio_iocp_ *engine = (struct reboot_aio_iocp_ *) aio->backend;
+
+   return CreateIoCompletionPort((HANDLE) file, engine->port, 0, 0) != NULL
+      ? 0 : -1;
+#else
+   (void) aio;
+   (void) file;
+
+   return 0;
+#endif
+}
+
+/* <!-- }}} Engine --> */
+
+/* <!-- Requests {{{ --> */
+
+int
+reboot_aio_prepare(reboot_aio_t *aio, const reboot_aio_request_t *request)
+{
+   reboot_aio_request_t copy = *request;
+
+   if (REBOOT_UNLIKELY(aio->inflight >= aio->entries)) {
+      errno = EBUSY;
+      return -1;
+   }
+
+   if (REBOOT_UNLIKELY(
+      copy.buffer < -1 || (copy.buffer >= 0
+                        && (unsigned) copy.buffer >= aio->buffer_count)
+   )) {
+      errno = EINVAL;
+      return -1;
+   }
+
+   if (copy.size > REBOOT_AIO_MAX_TRANSFER_) {
+      copy.size = REBOOT_AIO_MAX_TRANSFER_;
+   }
+
+   switch (aio->engine) {
+#if defined(REBOOT_AIO_URING_)
+      case REBOOT_AIO_ENGINE_IO_URING:
+         reboot_aio_uring_prepare_(aio, &copy);
+         break;
+#endif
+#if defined(REBOOT_AIO_HAS_KQUEUE)
+      case REBOOT_AIO_ENGINE_KQUEUE:
+         reboot_aio_kqueue_prepare_(aio, &copy);
+         break;
+#endif
+#if defined(REBOOT_AIO_HAS_IOCP)
+      case REBOOT_AIO_ENGINE_IOCP:
+         reboot_aio_iocp_prepare_(aio, &copy);
+         break;
+#endif
+#if defined(REBOOT_AIO_HAS_THREADS)
+      case REBOOT_AIO_ENGINE_THREADS:
+         reboot_aio_threads_prepare_(aio, &copy);
+         break;
+#endif
+      default:
+         errno = EINVAL;
+         return -1;
+   }
+
+   ++aio->pending;
+   ++aio->inflight;
+
+   return 0;
+}
+
+int
+reboot_aio_submit(reboot_aio_t *aio)
+{
+   int submitted;
+
+   if (aio->pending == 0) {
+      return 0;
+   }
+
+   switch (aio->engine) {
+#if defined(REBOOT_AIO_URING_)
+      case REBOOT_AIO_ENGINE_IO_URING:
+         submitted = reboot_aio_uring_submit_(aio);
+         break;
+#endif
+#if defined(REBOOT_AIO_HAS_KQUEUE)
+      case REBOOT_AIO_ENGINE_KQUEUE:
+         submitted = reboot_aio_kqueue_submit_(aio);
+         break;
+#endif
+#if defined(REBOOT_AIO_HAS_IOCP)
+      case REBOOT_AIO_ENGINE_IOCP:
+         submitted = reboot_aio_iocp_submit_(aio);
+         break;
+#endif
+#if defined(REBOOT_AIO_HAS_THREADS)
+      case REBOOT_AIO_ENGINE_THREADS:
+         submitted = reboot_aio_threads_submit_(aio);
+         break;
+#endif
+      default:
+         errno = EINVAL;
+         return -1;
+   }
+
+   if (submitted > 0) {
+      aio->pending -= (unsigned) submitted;
+   }
+
+   return submitted;
+}
+
+int
+reboot_aio_poll(
+   reboot_aio_t            *aio,
+   reboot_aio_completion_t *completions,
+   unsigned                 count,
+   unsigned                 minimum
+) {
+   unsigned submitted = aio->inflight - aio->pending;
+   int      reaped;
+
+   if (minimum > submitted) {
+      minimum = submitted;
+   }
+
+   if (minimum > count) {
+      minimum = count;
+   }
+
+   if (count == 0 || submitted == 0) {
+      return 0;
+   }
+
+   switch (aio->engine) {
+#if defined(REBOOT_AIO_URING_)
+      case REBOOT_AIO_ENGINE_IO_URING:
+         reaped = reboot_aio_uring_poll_(aio, completions, count, minimum);
+         break;
+#endif
+#if defined(REBOOT_AIO_HAS_KQUEUE)
+      case REBOOT_AIO_ENGINE_KQUEUE:
+         reaped = reboot_aio_kqueue_poll_(aio, completions, count, minimum);
+         break;
+#endif
+#if defined(REBOOT_AIO_HAS_IOCP)
+      case REBOOT_AIO_ENGINE_IOCP:
+         reaped = reboot_aio_iocp_poll_(aio, completions, count, minimum);
+         break;
+#endif
+#if defined(REBOOT_AIO_HAS_THREADS)
+      case REBOOT_AIO_ENGINE_THREADS:
+         reaped = reboot_aio_threads_poll_(aio, completions, count, minimum);
+         break;
+#endif
+      default:
+         errno = EINVAL;
+         return -1;
+   }
+
+   if (reaped > 0) {
+      aio->inflight -= (unsigned) reaped;
+   }
+
+   return reaped;
+}
+
+/* <!-- }}} Requests --> */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
@@ -0,0 +1,501 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+#ifndef __REBOOT_IO_AIO_H__
+#define __REBOOT_IO_AIO_H__
+
+/*!
+ * @file  io/aio.h
+ * @brief Completion-based asynchronous file input/output.
+ *
+ * This header provides an engine submitting positioned
+ * reads,  writes and flushes in batches and  reporting
+ * their  completions,  over  whichever  interface  the
+ * operating system offers :
+ *
+ * - `reboot_aio_init`             : Initialization.
+ * - `reboot_aio_register_buffers` : Registration.
+ * - `reboot_aio_attach`           : File association.
+ * - `reboot_aio_prepare`          : Request queueing.
+ * - `reboot_aio_submit`           : Batch submission.
+ * - `reboot_aio_poll`             : Reaping.
+ * - `reboot_aio_destroy`          : Finalization.
+ *
+ * Requests are queued locally by `reboot_aio_prepare`,
+ * at  no  cost,  and  handed over  to  the  kernel  by
+ * `reboot_aio_submit`,   a  single  system  call  then
+ * carrying thousands of them under `io_uring` :
+ *
+ * ```c
+ * reboot_aio_t            aio;
+ * reboot_aio_request_t    request;
+ * reboot_aio_completion_t completions[64];
+ *
+ * reboot_aio_init(&aio, 256, 0);
+ *
+ * for (i = 0; i < count; ++i) {
+ *    request.file   = file;
+ *    request.opcode = REBOOT_AIO_READ;
+ *    request.buffer = -1;
+ *    request.data   = blocks[i];
+ *    request.size   = block_size;
+ *    request.offset = (uint64_t) i * block_size;
+ *    request.user   = blocks[i];
+ *
+ *    reboot_aio_prepare(&aio, &request);
+ * }
+ *
+ * reboot_aio_submit(&aio);
+ *
+ * while (remaining > 0) {
+ *    int reaped = reboot_aio_poll(&aio, completions, 64, 1);
+ *    ...
+ * }
+ * ```
+ *
+ * The engines, in order of preference, are :
+ *
+ * - `io_uring` : Linux,   through  its  system   calls
+ *                directly,  the  headers of Linux  5.6
+ *                being   required.   The  kernel   may
+ *                nonetheless  lack it or forbid it, as
+ *                container  runtimes commonly do,  the
+ *                thread   pool  then  taking  over  at
+ *                initialization.
+ * - `kqueue`   : FreeBSD,   POSIX   asynchronous   I/O
+ *                notifying  its  completions through a
+ *                kernel queue, `lio_listio` submitting
+ *                batches   in   chunks   of   at  most
+ *                `_SC_AIO_LISTIO_MAX`   requests.  The
+ *                other  systems offering `kqueue` lack
+ *                this  notification and use the thread
+ *                pool.
+ * - `IOCP`     : Windows,  overlapped  I/O on  handles
+ *                associated with a completion port and
+ *                opened with `FILE_FLAG_OVERLAPPED`.
+ * - Threads    : Every           other           Unix,
+ *                `REBOOT_AIO_THREADS`  worker  threads
+ *                blocking  in  `pread`,  `pwrite`  and
+ *                `fsync`.
+ *
+ * The header lives under `io/`, an `aio.h` next to the
+ * others   shadowing  the  POSIX  `<aio.h>`  of  every
+ * program  adding the installed headers to its include
+ * path.  These  functions are usable from both  C  and
+ * C++,  and  live  in  `io/aio.c`.  Under  C++20  with
+ * coroutines,          `reboot::aio_read`          and
+ * `reboot::aio_write` additionally return awaitables.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "preprocessor/environment/os.h"
+#include "preprocessor/environment/standard.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! <!-- Engine {{{ -->
+ * @addtogroup  aio_engine Engine
+ * @brief Engine state and lifetime
+ *
+ * The  engine is a plain structure whose `engine`  and
+ * `entries`  fields  may  be read freely,  the  others
+ * being  private. An engine is meant to be driven by a
+ * single thread at a time.
+ * @{
+ */
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_IO_URING)
+#  define REBOOT_AIO_HAS_IO_URING
+#endif
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_KQUEUE)                    \
+ && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_FREEBSD)
+#  define REBOOT_AIO_HAS_KQUEUE
+#endif
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_IOCP)
+#  define REBOOT_AIO_HAS_IOCP
+#endif
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_UNIX)                      \
+ && !defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WASI)
+#  define REBOOT_AIO_HAS_THREADS
+#endif
+
+/*!
+ * @def   REBOOT_AIO_THREADS
+ * @brief Thread pool size.
+ *
+ * This  is the number of worker threads of the  thread
+ * pool  engine,  and  thus the number of  requests  it
+ * carries  out  at  once. It may  be  overridden  when
+ * building the library.
+ */
+#ifndef REBOOT_AIO_THREADS
+#  define REBOOT_AIO_THREADS 4u
+#endif
+
+/*!
+ * @def   REBOOT_AIO_FORCE_THREADS
+ * @brief Thread pool flag.
+ *
+ * The  thread pool engine is used even though a native
+ * one is available. Windows has no thread pool engine,
+ * I/O  completion  ports being used regardless of this
+ * flag.
+ */
+#define REBOOT_AIO_FORCE_THREADS 1u
+
+/*!
+ * @brief Engines.
+ */
+enum {
+   REBOOT_AIO_ENGINE_NONE,
+   REBOOT_AIO_ENGINE_IO_URING,
+   REBOOT_AIO_ENGINE_KQUEUE,
+   REBOOT_AIO_ENGINE_IOCP,
+   REBOOT_AIO_ENGINE_THREADS
+};
+
+/*!
+ * @brief File designation, a handle on Windows and a descriptor elsewhere.
+ */
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+typedef void *reboot_aio_file_t;
+#else
+typedef int reboot_aio_file_t;
+#endif
+
+/*!
+ * @brief Registered buffer.
+ */
+typedef struct reboot_aio_buffer {
+   void  *data;
+   size_t size;
+} reboot_aio_buffer_t;
+
+struct reboot_aio_backend_;
+
+/*!
+ * @brief Engine.
+ */
+typedef struct reboot_aio {
+   struct reboot_aio_backend_ *backend;
+   reboot_aio_buffer_t        *buffers;
+   unsigned                    buffer_count;
+   unsigned                    entries;
+   unsigned                    pending;
+   unsigned                    inflight;
+   unsigned                    engine;
+} reboot_aio_t;
+
+/*!
+ * @brief Engine initialization.
+ *
+ * This  function initializes `aio` for up to `entries`
+ * requests  in flight, counting those prepared but not
+ * submitted  yet, the engine possibly lowering it, and
+ * selects  the  engine,  `flags` being either  `0`  or
+ * `REBOOT_AIO_FORCE_THREADS`.   It   returns  `0`   on
+ * success  and  `-1` on failure, `errno` being set  to
+ * `ENOSYS` on targets offering no engine at all.
+ */
+int reboot_aio_init(reboot_aio_t *aio, unsigned entries, unsigned flags);
+
+/*!
+ * @brief Engine finalization.
+ *
+ * This  function  waits for the requests in flight  to
+ * complete, discarding their completions, and releases
+ * `aio`. Prepared requests are discarded without being
+ * submitted.
+ */
+void reboot_aio_destroy(reboot_aio_t *aio);
+
+/*!
+ * @brief Buffer registration.
+ *
+ * This  function  registers  the  `count`  buffers  at
+ * `buffers`   with   `aio`,  replacing  any   previous
+ * registration,  which must not be in use by  requests
+ * in  flight.  `io_uring` pins them once and for  all,
+ * sparing   every  request  naming  them  through  its
+ * `buffer`  field the mapping of its pages, the  other
+ * engines  accepting registrations for portability. It
+ * returns   `0`  on  success  and  `-1`  on   failure,
+ * typically   because  pinning  the  buffers   exceeds
+ * `RLIMIT_MEMLOCK`.
+ */
+int reboot_aio_register_buffers(
+   reboot_aio_t *aio, const reboot_aio_buffer_t *buffers, unsigned count
+);
+
+/*!
+ * @brief File association.
+ *
+ * This  function associates `file` with `aio` ahead of
+ * its  first  request, which `IOCP` requires  and  the
+ * other  engines ignore. The file must then have  been
+ * opened  with  `FILE_FLAG_OVERLAPPED`, and cannot  be
+ * associated  with  another engine. It returns `0`  on
+ * success and `-1` on failure.
+ */
+int reboot_aio_attach(reboot_aio_t *aio, reboot_aio_file_t file);
+
+/*! @} <!-- }}} Engine --> */
+
+/*! <!-- Requests {{{ -->
+ * @addtogroup  aio_requests Requests
+ * @brief Request preparation and submission
+ *
+ * Transfers   may  be  short,  as  with  `pread`   and
+ * `pwrite`,  and  are  capped to 2 GiB minus  a  page.
+ * Reads at the end of a file complete with a result of
+ * `0`.
+ * @{
+ */
+
+/*!
+ * @brief Operations.
+ */
+enum {
+   REBOOT_AIO_READ,
+   REBOOT_AIO_WRITE,
+   REBOOT_AIO_FSYNC
+};
+
+/*!
+ * @brief Request.
+ *
+ * `buffer`  is  the  index  of  the  registered buffer
+ * `data`  lies  within, or `-1`. `buffer` and `offset`
+ * are  ignored  by flushes. `user` is handed back with
+ * the completion of the request.
+ */
+typedef struct reboot_aio_request {
+   reboot_aio_file_t file;
+   unsigned          opcode;
+   int               buffer;
+   void             *data;
+   size_t            size;
+   uint64_t          offset;
+   void             *user;
+} reboot_aio_request_t;
+
+/*!
+ * @brief Completion.
+ *
+ * `result`  is the number of bytes transferred, or the
+ * negated  error code of the request, an `errno` value
+ * on Unix and a Windows error code on Windows.
+ */
+typedef struct reboot_aio_completion {
+   void     *user;
+   ptrdiff_t result;
+} reboot_aio_completion_t;
+
+/*!
+ * @brief Request queueing.
+ *
+ * This  function  queues a copy of `request`  for  the
+ * next submission. It returns `0` on success and `-1`,
+ * without   queueing   it,  when  `aio`  already   has
+ * `entries`   requests  in  flight  or  when  `buffer`
+ * designates no registered buffer.
+ */
+int reboot_aio_prepare(reboot_aio_t *aio, const reboot_aio_request_t *request);
+
+/*!
+ * @brief Batch submission.
+ *
+ * This function submits every request queued since the
+ * last  submission,  in  as  few  system  calls as the
+ * engine  allows.  It  returns  the number of requests
+ * submitted, which may be less than the number queued,
+ * or  `-1`  if  none could be, `errno` then being set.
+ * Those  not  submitted  remain  queued  for  the next
+ * submission.  Requests  failing on their own complete
+ * with an error instead.
+ */
+int reboot_aio_submit(reboot_aio_t *aio);
+
+/*!
+ * @brief Completion reaping.
+ *
+ * This  function stores up to `count` completions into
+ * `completions`,  waiting  for at least  `minimum`  of
+ * them, lowered to the number of submitted requests in
+ * flight. It returns the number of completions stored,
+ * or `-1` on failure.
+ */
+int reboot_aio_poll(
+   reboot_aio_t            *aio,
+   reboot_aio_completion_t *completions,
+   unsigned                 count,
+   unsigned                 minimum
+);
+
+/*! @} <!-- }}} Requests --> */
+
+#ifdef __cplusplus
+}
+#endif
+
+/*! <!-- Coroutines {{{ -->
+ * @addtogroup  aio_coroutines Coroutines
+ * @brief C++20 awaitable requests
+ *
+ * `reboot::aio_read` and `reboot::aio_write` return an
+ * awaitable  request,  which  queues itself  when  its
+ * coroutine suspends and resumes it with the result of
+ * the request. Submission and reaping remain up to the
+ * caller,   `reboot::aio_run`  submitting  the  queued
+ * requests   and  resuming  the  coroutines  of  those
+ * completing.  Every request of an engine driven  this
+ * way must be an awaitable one :
+ *
+ * ```cpp
+ * task copy(reboot_aio_t &aio, int in, int out, char *block)
+ * {
+ *    ptrdiff_t size = co_await reboot::aio_read(aio, in, block, 4096, 0);
+ *
+ *    if (size > 0) {
+ *       co_await reboot::aio_write(aio, out, block, size, 0);
+ *    }
+ * }
+ * ```
+ *
+ * `task`  stands for any coroutine type of the caller,
+ * the header providing none.
+ * @{
+ */
+#if defined(__cplusplus)                                                      \
+ && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_COROUTINES)
+
+#include <cerrno>
+#include <coroutine>
+
+namespace reboot {
+
+/*!
+ * @brief Awaitable request.
+ *
+ * A  request  failing  to  queue resumes its coroutine
+ * right    away    with   the   negated   `errno`   of
+ * `reboot_aio_prepare`,  that  is  `-EBUSY`  when  the
+ * engine  is  full  and  `-EINVAL`  when  the  request
+ * designates no registered buffer.
+ */
+class aio_awaitable {
+public:
+   aio_awaitable(reboot_aio_t &aio, const reboot_aio_request_t &request)
+      : aio_(&aio), request_(request), result_(0)
+   {
+   }
+
+   bool await_ready() const noexcept { return false; }
+
+   bool await_suspend(std::coroutine_handle<> handle) noexcept
+   {
+      handle_        = handle;
+      request_.user  = this;
+
+      if (reboot_aio_prepare(aio_, &request_) != 0) {
+         result_ = -static_cast<ptrdiff_t>(errno);
+         return false;
+      }
+
+      return true;
+   }
+
+   ptrdiff_t await_resume() const noexcept { return result_; }
+
+   /*!
+    * @brief Completion, resuming the awaiting coroutine.
+    */
+   void complete(ptrdiff_t result)
+   {
+      result_ = result;
+      handle_.resume();
+   }
+
+private:
+   reboot_aio_t           *aio_;
+   reboot_aio_request_t    request_;
+   ptrdiff_t               result_;
+   std::coroutine_handle<> handle_;
+};
+
+inline aio_awaitable
+aio_read(
+   reboot_aio_t &aio, reboot_aio_file_t file, void *data, size_t size,
+   uint64_t offset, int buffer = -1
+) {
+   reboot_aio_request_t request = {
+      file, REBOOT_AIO_READ, buffer, data, size, offset, NULL
+   };
+
+   return aio_awaitable(aio, request);
+}
+
+inline aio_awaitable
+aio_write(
+   reboot_aio_t &aio, reboot_aio_file_t file, const void *data, size_t size,
+   uint64_t offset, int buffer = -1
+) {
+   reboot_aio_request_t request = {
+      file, REBOOT_AIO_WRITE, buffer, const_cast<void *>(data), size, offset,
+      NULL
+   };
+
+   return aio_awaitable(aio, request);
+}
+
+/*!
+ * @brief Event loop iteration.
+ *
+ * This  function submits the queued requests of `aio`,
+ * then  reaps the completions of at least `minimum` of
+ * them  and resumes their coroutines, which may  queue
+ * further   requests.   It  returns  the   number   of
+ * coroutines resumed, or `-1` on failure.
+ */
+inline int
+aio_run(reboot_aio_t &aio, unsigned minimum = 1)
+{
+   reboot_aio_completion_t completions[64];
+   int                     count;
+
+   if (reboot_aio_submit(&aio) < 0) {
+      return -1;
+   }
+
+   count = reboot_aio_poll(&aio, completions, 64, minimum);
+
+   for (int i = 0; i < count; ++i) {
+      static_cast<aio_awaitable *>(completions[i].user)->complete(
+         completions[i].result
+      );
+   }
+
+   return count;
+}
+
+} /* namespace reboot */
+
+#endif /*! @} <!-- }}} Coroutines --> */
+
+#endif /* __REBOOT_IO_AIO_H__ */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
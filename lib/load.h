@@ -0,0 +1,348 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+#ifndef __REBOOT_LOAD_H__
+#define __REBOOT_LOAD_H__
+
+/*!
+ * @file  load.h
+ * @brief Unaligned fixed byte order loads and stores.
+ *
+ * This  header  reads  and writes 16-bit,  32-bit  and
+ * 64-bit  unsigned  integers of a given byte order  at
+ * any address, such as the fields of a binary protocol
+ * straight within the buffer it was received in :
+ *
+ * - `reboot_load_le<width>`  : Little-endian load.
+ * - `reboot_load_be<width>`  : Big-endian load.
+ * - `reboot_store_le<width>` : Little-endian store.
+ * - `reboot_store_be<width>` : Big-endian store.
+ *
+ * ```c
+ * length   = reboot_load_be32(packet + 4);
+ * sequence = reboot_load_be64(packet + 8);
+ *
+ * reboot_store_be32(reply + 4, length);
+ * ```
+ *
+ * Wherever   `preprocessor/environment/architecture.h`
+ * reports the byte order of the target, the integer is
+ * copied  with  `memcpy` and its bytes  reversed  with
+ * `reboot_bits_bswap<width>`  when the orders  differ.
+ * Compilers  lower  such  a copy to a single  load  or
+ * store on targets allowing unaligned accesses, a byte
+ * order  reversal  then  adding a  single  `bswap`  or
+ * `rev`,  or  folding  into `movbe`  where  available.
+ * Targets requiring aligned accesses get an equivalent
+ * sequence  of  narrower  accesses instead,  the  copy
+ * never   dereferencing   a  misaligned  pointer   nor
+ * breaking  strict aliasing, unlike a cast. Targets of
+ * unknown  byte  order  assemble the integer  byte  by
+ * byte,  which GCC and Clang still recognize as a load
+ * and a byte swap.
+ *
+ * Every function is a `static` inline function, usable
+ * from both C and C++.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "bits.h"
+#include "preprocessor/environment/architecture.h"
+#include "preprocessor/environment/compiler.h"
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ENDIAN_LITTLE)
+#  define REBOOT_LOAD_LE_(width, x) (x)
+#  define REBOOT_LOAD_BE_(width, x) reboot_bits_bswap##width(x)
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ENDIAN_BIG)
+#  define REBOOT_LOAD_LE_(width, x) reboot_bits_bswap##width(x)
+#  define REBOOT_LOAD_BE_(width, x) (x)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! <!-- Loads {{{ -->
+ * @addtogroup  load_loads Loads
+ * @brief Unaligned loads
+ *
+ * These  functions  return the integer stored  in  the
+ * given byte order at `p`, which need not be aligned.
+ * @{
+ */
+
+/*!
+ * @brief 16-bit little-endian load.
+ */
+static REBOOT_INLINE uint16_t
+reboot_load_le16(const void *p)
+{
+#if defined(REBOOT_LOAD_LE_)
+   uint16_t x;
+
+   memcpy(&x, p, sizeof x);
+
+   return REBOOT_LOAD_LE_(16, x);
+#else
+   const unsigned char *b = (const unsigned char *) p;
+
+   return (uint16_t) ((uint16_t) b[0] | (uint16_t) b[1] << 8);
+#endif
+}
+
+/*!
+ * @brief 32-bit little-endian load.
+ */
+static REBOOT_INLINE uint32_t
+reboot_load_le32(const void *p)
+{
+#if defined(REBOOT_LOAD_LE_)
+   uint32_t x;
+
+   memcpy(&x, p, sizeof x);
+
+   return REBOOT_LOAD_LE_(32, x);
+#else
+   const unsigned char *b = (const unsigned char *) p;
+
+   return (uint32_t) b[0]       | (uint32_t) b[1] << 8
+        | (uint32_t) b[2] << 16 | (uint32_t) b[3] << 24;
+#endif
+}
+
+/*!
+ * @brief 64-bit little-endian load.
+ */
+static REBOOT_INLINE uint64_t
+reboot_load_le64(const void *p)
+{
+#if defined(REBOOT_LOAD_LE_)
+   uint64_t x;
+
+   memcpy(&x, p, sizeof x);
+
+   return REBOOT_LOAD_LE_(64, x);
+#else
+   const unsigned char *b = (const unsigned char *) p;
+
+   return (uint64_t) b[0]       | (uint64_t) b[1] << 8
+        | (uint64_t) b[2] << 16 | (uint64_t) b[3] << 24
+        | (uint64_t) b[4] << 32 | (uint64_t) b[5] << 40
+        | (uint64_t) b[6] << 48 | (uint64_t) b[7] << 56;
+#endif
+}
+
+/*!
+ * @brief 16-bit big-endian load.
+ */
+static REBOOT_INLINE uint16_t
+reboot_load_be16(const void *p)
+{
+#if defined(REBOOT_LOAD_BE_)
+   uint16_t x;
+
+   memcpy(&x, p, sizeof x);
+
+   return REBOOT_LOAD_BE_(16, x);
+#else
+   const unsigned char *b = (const unsigned char *) p;
+
+   return (uint16_t) ((uint16_t) b[0] << 8 | (uint16_t) b[1]);
+#endif
+}
+
+/*!
+ * @brief 32-bit big-endian load.
+ */
+static REBOOT_INLINE uint32_t
+reboot_load_be32(const void *p)
+{
+#if defined(REBOOT_LOAD_BE_)
+   uint32_t x;
+
+   memcpy(&x, p, sizeof x);
+
+   return REBOOT_LOAD_BE_(32, x);
+#else
+   const unsigned char *b = (const unsigned char *) p;
+
+   return (uint32_t) b[0] << 24 | (uint32_t) b[1] << 16
+        | (uint32_t) b[2] << 8  | (uint32_t) b[3];
+#endif
+}
+
+/*!
+ * @brief 64-bit big-endian load.
+ */
+static REBOOT_INLINE uint64_t
+reboot_load_be64(const void *p)
+{
+#if defined(REBOOT_LOAD_BE_)
+   uint64_t x;
+
+   memcpy(&x, p, sizeof x);
+
+   return REBOOT_LOAD_BE_(64, x);
+#else
+   const unsigned char *b = (const unsigned char *) p;
+
+   return (uint64_t) b[0] << 56 | (uint64_t) b[1] << 48
+        | (uint64_t) b[2] << 40 | (uint64_t) b[3] << 32
+        | (uint64_t) b[4] << 24 | (uint64_t) b[5] << 16
+        | (uint64_t) b[6] << 8  | (uint64_t) b[7];
+#endif
+}
+
+/*! @} <!-- }}} Loads --> */
+
+/*! <!-- Stores {{{ -->
+ * @addtogroup  load_stores Stores
+ * @brief Unaligned stores
+ *
+ * These functions store `x` in the given byte order at
+ * `p`, which need not be aligned.
+ * @{
+ */
+
+/*!
+ * @brief 16-bit little-endian store.
+ */
+static REBOOT_INLINE void
+reboot_store_le16(void *p, uint16_t x)
+{
+#if defined(REBOOT_LOAD_LE_)
+   x = REBOOT_LOAD_LE_(16, x);
+
+   memcpy(p, &x, sizeof x);
+#else
+   unsigned char *b = (unsigned char *) p;
+
+   b[0] = (unsigned char) x;
+   b[1] = (unsigned char) (x >> 8);
+#endif
+}
+
+/*!
+ * @brief 32-bit little-endian store.
+ */
+static REBOOT_INLINE void
+reboot_store_le32(void *p, uint32_t x)
+{
+#if defined(REBOOT_LOAD_LE_)
+   x = REBOOT_LOAD_LE_(32, x);
+
+   memcpy(p, &x, sizeof x);
+#else
+   unsigned char *b = (unsigned char *) p;
+
+   b[0] = (unsigned char) x;
+   b[1] = (unsigned char) (x >> 8);
+   b[2] = (unsigned char) (x >> 16);
+   b[3] = (unsigned char) (x >> 24);
+#endif
+}
+
+/*!
+ * @brief 64-bit little-endian store.
+ */
+static REBOOT_INLINE void
+reboot_store_le64(void *p, uint64_t x)
+{
+#if defined(REBOOT_LOAD_LE_)
+   x = REBOOT_LOAD_LE_(64, x);
+
+   memcpy(p, &x, sizeof x);
+#else
+   unsigned char *b = (unsigned char *) p;
+
+   b[0] = (unsigned char) x;
+   b[1] = (unsigned char) (x >> 8);
+   b[2] = (unsigned char) (x >> 16);
+   b[3] = (unsigned char) (x >> 24);
+   b[4] = (unsigned char) (x >> 32);
+   b[5] = (unsigned char) (x >> 40);
+   b[6] = (unsigned char) (x >> 48);
+   b[7] = (unsigned char) (x >> 56);
+#endif
+}
+
+/*!
+ * @brief 16-bit big-endian store.
+ */
+static REBOOT_INLINE void
+reboot_store_be16(void *p, uint16_t x)
+{
+#if defined(REBOOT_LOAD_BE_)
+   x = REBOOT_LOAD_BE_(16, x);
+
+   memcpy(p, &x, sizeof x);
+#else
+   unsigned char *b = (unsigned char *) p;
+
+   b[0] = (unsigned char) (x >> 8);
+   b[1] = (unsigned char) x;
+#endif
+}
+
+/*!
+ * @brief 32-bit big-endian store.
+ */
+static REBOOT_INLINE void
+reboot_store_be32(void *p, uint32_t x)
+{
+#if defined(REBOOT_LOAD_BE_)
+   x = REBOOT_LOAD_BE_(32, x);
+
+   memcpy(p, &x, sizeof x);
+#else
+   unsigned char *b = (unsigned char *) p;
+
+   b[0] = (unsigned char) (x >> 24);
+   b[1] = (unsigned char) (x >> 16);
+   b[2] = (unsigned char) (x >> 8);
+   b[3] = (unsigned char) x;
+#endif
+}
+
+/*!
+ * @brief 64-bit big-endian store.
+ */
+static REBOOT_INLINE void
+reboot_store_be64(void *p, uint64_t x)
+{
+#if defined(REBOOT_LOAD_BE_)
+   x = REBOOT_LOAD_BE_(64, x);
+
+   memcpy(p, &x, sizeof x);
+#else
+   unsigned char *b = (unsigned char *) p;
+
+   b[0] = (unsigned char) (x >> 56);
+   b[1] = (unsigned char) (x >> 48);
+   b[2] = (unsigned char) (x >> 40);
+   b[3] = (unsigned char) (x >> 32);
+   b[4] = (unsigned char) (x >> 24);
+   b[5] = (unsigned char) (x >> 16);
+   b[6] = (unsigned char) (x >> 8);
+   b[7] = (unsigned char) x;
+#endif
+}
+
+/*! @} <!-- }}} Stores --> */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __REBOOT_LOAD_H__ */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
@@ -0,0 +1,634 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+/*!
+ * @file  mapped_file.c
+ * @brief Read-only memory-mapped files.
+ *
+ * Mapped  files  only keep their mapping  around,  the
+ * descriptor  or  handle they were mapped  from  being
+ * closed  right  away. Streamed files instead keep  it
+ * along  with  their  buffer, whose presence  is  what
+ * tells  both  kinds apart. Empty files are  streamed,
+ * `mmap`   and   `CreateFileMapping`   both   refusing
+ * zero-sized mappings, and the pseudo files of `/proc`
+ * and `/sys` reporting a zero size regardless of their
+ * contents.
+ */
+
+/* `madvise` and `MADV_HUGEPAGE` in strict modes. */
+#ifndef _DEFAULT_SOURCE
+#  define _DEFAULT_SOURCE
+#endif
+
+/* Files larger than 2 GiB on 32-bit targets. */
+#ifndef _FILE_OFFSET_BITS
+#  define _FILE_OFFSET_BITS 64
+#endif
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mapped_file.h"
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MMAP)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#  ifndef O_CLOEXEC
+#     define O_CLOEXEC 0
+#  endif
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+#  ifndef WIN32_LEAN_AND_MEAN
+#     define WIN32_LEAN_AND_MEAN
+#  endif
+#  include <windows.h>
+#endif
+
+static void
+reboot_mapped_file_reset_(reboot_mapped_file_t *file, unsigned flags)
+{
+   file->data       = NULL;
+   file->size       = 0;
+   file->cursor     = 0;
+   file->buffer     = NULL;
+   file->handle     = NULL;
+   file->descriptor = -1;
+   file->flags      = flags;
+}
+
+static int
+reboot_mapped_file_buffer_(reboot_mapped_file_t *file)
+{
+   file->buffer = (unsigned char *) malloc(REBOOT_MAPPED_FILE_CHUNK_SIZE);
+
+   if (file->buffer == NULL) {
+      errno = ENOMEM;
+      return -1;
+   }
+
+   return 0;
+}
+
+/* <!-- Backing {{{ --> */
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MMAP)
+
+/*!
+ * `posix_madvise`  only  accepts page aligned  ranges,
+ * the  start of the range is therefore rounded down to
+ * its  page,  the  mapping itself starting on  a  page
+ * boundary.
+ */
+static int
+reboot_mapped_file_map_advise_(
+   reboot_mapped_file_t       *file,
+   size_t                      offset,
+   size_t                      size,
+   reboot_mapped_file_advice_t advice
+) {
+   static const int advices[] = {
+      POSIX_MADV_NORMAL,
+      POSIX_MADV_SEQUENTIAL,
+      POSIX_MADV_RANDOM,
+      POSIX_MADV_WILLNEED,
+      POSIX_MADV_DONTNEED
+   };
+
+   size_t page  = (size_t) sysconf(_SC_PAGESIZE);
+   size_t start = offset & ~(page - 1u);
+   int    error = posix_madvise(
+      (void *) (file->data + start), size + (offset - start), advices[advice]
+   );
+
+   if (error != 0) {
+      errno = error;
+      return -1;
+   }
+
+   return 0;
+}
+
+/*!
+ * A  length of `0` extends `posix_fadvise` to the  end
+ * of  the  file, which is what a range too  large  for
+ * `off_t` intends.
+ */
+static int
+reboot_mapped_file_stream_advise_(
+   reboot_mapped_file_t       *file,
+   size_t                      offset,
+   size_t                      size,
+   reboot_mapped_file_advice_t advice
+) {
+#  if defined(POSIX_FADV_SEQUENTIAL)
+   static const int advices[] = {
+      POSIX_FADV_NORMAL,
+      POSIX_FADV_SEQUENTIAL,
+      POSIX_FADV_RANDOM,
+      POSIX_FADV_WILLNEED,
+      POSIX_FADV_DONTNEED
+   };
+
+   int error;
+
+   if (offset > (size_t) PTRDIFF_MAX) {
+      return 0;
+   }
+
+   if (size > (size_t) PTRDIFF_MAX - offset) {
+      size = 0;
+   }
+
+   error = posix_fadvise(
+      file->descriptor, (off_t) offset, (off_t) size, advices[advice]
+   );
+
+   /* Pipes and sockets have no page cache to advise. */
+   if (error != 0 && error != ESPIPE) {
+      errno = error;
+      return -1;
+   }
+#  else
+   (void) file;
+   (void) offset;
+   (void) size;
+   (void) advice;
+#  endif
+
+   return 0;
+}
+
+static int
+reboot_mapped_file_map_(
+   reboot_mapped_file_t *file, int descriptor, size_t size
+) {
+   int   populate = 0;
+   void *data;
+
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MAP_POPULATE)
+   if (file->flags & REBOOT_MAPPED_FILE_POPULATE) {
+      populate = MAP_POPULATE;
+   }
+#  endif
+
+   data = mmap(NULL, size, PROT_READ, MAP_PRIVATE | populate, descriptor, 0);
+
+   if (data == MAP_FAILED) {
+      return -1;
+   }
+
+   file->data = (const unsigned char *) data;
+   file->size = size;
+
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MADV_HUGEPAGE)
+   if (file->flags & REBOOT_MAPPED_FILE_HUGE_PAGES) {
+      madvise(data, size, MADV_HUGEPAGE);
+   }
+#  endif
+
+   if (file->flags & REBOOT_MAPPED_FILE_SEQUENTIAL) {
+      reboot_mapped_file_map_advise_(
+         file, 0, size, REBOOT_MAPPED_FILE_ADVICE_SEQUENTIAL
+      );
+   } else if (file->flags & REBOOT_MAPPED_FILE_RANDOM) {
+      reboot_mapped_file_map_advise_(
+         file, 0, size, REBOOT_MAPPED_FILE_ADVICE_RANDOM
+      );
+   }
+
+#  if !defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MAP_POPULATE)
+   if (file->flags & REBOOT_MAPPED_FILE_POPULATE) {
+      reboot_mapped_file_map_advise_(
+         file, 0, size, REBOOT_MAPPED_FILE_ADVICE_WILLNEED
+      );
+   }
+#  endif
+
+   return 0;
+}
+
+static int
+reboot_mapped_file_stream_(reboot_mapped_file_t *file, int descriptor)
+{
+   if (reboot_mapped_file_buffer_(file) != 0) {
+      close(descriptor);
+      return -1;
+   }
+
+   file->descriptor = descriptor;
+
+   if (file->flags & REBOOT_MAPPED_FILE_SEQUENTIAL) {
+      reboot_mapped_file_stream_advise_(
+         file, 0, 0, REBOOT_MAPPED_FILE_ADVICE_SEQUENTIAL
+      );
+   } else if (file->flags & REBOOT_MAPPED_FILE_RANDOM) {
+      reboot_mapped_file_stream_advise_(
+         file, 0, 0, REBOOT_MAPPED_FILE_ADVICE_RANDOM
+      );
+   }
+
+   return 0;
+}
+
+static int
+reboot_mapped_file_read_(reboot_mapped_file_t *file, size_t *size)
+{
+   ssize_t count;
+
+   do {
+      count = read(
+         file->descriptor, file->buffer, REBOOT_MAPPED_FILE_CHUNK_SIZE
+      );
+   } while (count < 0 && errno == EINTR);
+
+   if (count < 0) {
+      return -1;
+   }
+
+   *size = (size_t) count;
+   return 0;
+}
+
+int
+reboot_mapped_file_open(
+   reboot_mapped_file_t *file, const char *path, unsigned flags
+) {
+   struct stat status;
+   int         descriptor;
+
+   reboot_mapped_file_reset_(file, flags);
+
+   descriptor = open(path, O_RDONLY | O_CLOEXEC);
+
+   if (descriptor < 0) {
+      return -1;
+   }
+
+   if (fstat(descriptor, &status) != 0) {
+      close(descriptor);
+      return -1;
+   }
+
+   if (!(flags & REBOOT_MAPPED_FILE_STREAM)
+    && S_ISREG(status.st_mode)
+    && status.st_size > 0
+    && (off_t) (size_t) status.st_size == status.st_size) {
+      if (reboot_mapped_file_map_(file, descriptor, (size_t) status.st_size)
+          == 0) {
+         close(descriptor);
+         return 0;
+      }
+   }
+
+   return reboot_mapped_file_stream_(file, descriptor);
+}
+
+void
+reboot_mapped_file_close(reboot_mapped_file_t *file)
+{
+   if (file->buffer != NULL) {
+      free(file->buffer);
+      close(file->descriptor);
+   } else if (file->data != NULL) {
+      munmap((void *) file->data, file->size);
+   }
+
+   reboot_mapped_file_reset_(file, 0);
+}
+
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+
+/*!
+ * The  memory manager takes no access pattern hint for
+ * mappings, the sequential and random ones being given
+ * to  `CreateFile`  instead, which they still  benefit
+ * through  the cache manager.  `PrefetchVirtualMemory`
+ * appeared with Windows 8.
+ */
+static int
+reboot_mapped_file_map_advise_(
+   reboot_mapped_file_t       *file,
+   size_t                      offset,
+   size_t                      size,
+   reboot_mapped_file_advice_t advice
+) {
+#  if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0602
+   if (advice == REBOOT_MAPPED_FILE_ADVICE_WILLNEED) {
+      WIN32_MEMORY_RANGE_ENTRY range;
+
+      range.VirtualAddress = (void *) (file->data + offset);
+      range.NumberOfBytes  = size;
+
+      return PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0)
+         ? 0 : -1;
+   }
+#  else
+   (void) file;
+   (void) offset;
+   (void) size;
+#  endif
+
+   (void) advice;
+   return 0;
+}
+
+static int
+reboot_mapped_file_stream_advise_(
+   reboot_mapped_file_t       *file,
+   size_t                      offset,
+   size_t                      size,
+   reboot_mapped_file_advice_t advice
+) {
+   (void) file;
+   (void) offset;
+   (void) size;
+   (void) advice;
+
+   return 0;
+}
+
+static int
+reboot_mapped_file_map_(
+   reboot_mapped_file_t *file, HANDLE handle, size_t size
+) {
+   HANDLE mapping;
+   void  *data;
+
+   mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+
+   if (mapping == NULL) {
+      return -1;
+   }
+
+   data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+   /* The view keeps the section alive. */
+   CloseHandle(mapping);
+
+   if (data == NULL) {
+      return -1;
+   }
+
+   file->data = (const unsigned char *) data;
+   file->size = size;
+
+   if (file->flags & REBOOT_MAPPED_FILE_POPULATE) {
+      reboot_mapped_file_map_advise_(
+         file, 0, size, REBOOT_MAPPED_FILE_ADVICE_WILLNEED
+      );
+   }
+
+   return 0;
+}
+
+static int
+reboot_mapped_file_read_(reboot_mapped_file_t *file, size_t *size)
+{
+   DWORD count;
+
+   if (!ReadFile(
+      (HANDLE) file->handle, file->buffer, REBOOT_MAPPED_FILE_CHUNK_SIZE,
+      &count, NULL
+   )) {
+      /* The write end of a pipe was closed. */
+      if (GetLastError() == ERROR_BROKEN_PIPE) {
+         *size = 0;
+         return 0;
+      }
+
+      return -1;
+   }
+
+   *size = (size_t) count;
+   return 0;
+}
+
+int
+reboot_mapped_file_open(
+   reboot_mapped_file_t *file, const char *path, unsigned flags
+) {
+   HANDLE        handle;
+   LARGE_INTEGER size;
+   DWORD         hint = 0;
+
+   reboot_mapped_file_reset_(file, flags);
+
+   if (flags & REBOOT_MAPPED_FILE_SEQUENTIAL) {
+      hint = FILE_FLAG_SEQUENTIAL_SCAN;
+   } else if (flags & REBOOT_MAPPED_FILE_RANDOM) {
+      hint = FILE_FLAG_RANDOM_ACCESS;
+   }
+
+   handle = CreateFileA(
+      path, GENERIC_READ,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | hint, NULL
+   );
+
+   if (handle == INVALID_HANDLE_VALUE) {
+      return -1;
+   }
+
+   if (!(flags & REBOOT_MAPPED_FILE_STREAM)
+    && GetFileType(handle) == FILE_TYPE_DISK
+    && GetFileSizeEx(handle, &size)
+    && size.QuadPart > 0
+    && (ULONGLONG) (size_t) size.QuadPart == (ULONGLONG) size.QuadPart) {
+      if (reboot_mapped_file_map_(file, handle, (size_t) size.QuadPart) == 0) {
+         CloseHandle(handle);
+         return 0;
+      }
+   }
+
+   if (reboot_mapped_file_buffer_(file) != 0) {
+      CloseHandle(handle);
+      return -1;
+   }
+
+   file->handle = (void *) handle;
+   return 0;
+}
+
+void
+reboot_mapped_file_close(reboot_mapped_file_t *file)
+{
+   if (file->buffer != NULL) {
+      free(file->buffer);
+      CloseHandle((HANDLE) file->handle);
+   } else if (file->data != NULL) {
+      UnmapViewOfFile(file->data);
+   }
+
+   reboot_mapped_file_reset_(file, 0);
+}
+
+#else
+
+static int
+reboot_mapped_file_map_advise_(
+   reboot_mapped_file_t       *file,
+   size_t                      offset,
+   size_t                      size,
+   reboot_mapped_file_advice_t advice
+) {
+   (void) file;
+   (void) offset;
+   (void) size;
+   (void) advice;
+
+   return 0;
+}
+
+static int
+reboot_mapped_file_stream_advise_(
+   reboot_mapped_file_t       *file,
+   size_t                      offset,
+   size_t                      size,
+   reboot_mapped_file_advice_t advice
+) {
+   (void) file;
+   (void) offset;
+   (void) size;
+   (void) advice;
+
+   return 0;
+}
+
+static int
+reboot_mapped_file_read_(reboot_mapped_file_t *file, size_t *size)
+{
+   *size = fread(
+      file->buffer, 1, REBOOT_MAPPED_FILE_CHUNK_SIZE, (FILE *) file->handle
+   );
+
+   return *size == 0 && ferror((FILE *) file->handle) ? -1 : 0;
+}
+
+/*!
+ * Streams  are  left unbuffered, reads going  straight
+ * into the buffer of the file rather than through that
+ * of `stdio` first.
+ */
+int
+reboot_mapped_file_open(
+   reboot_mapped_file_t *file, const char *path, unsigned flags
+) {
+   FILE *stream;
+
+   reboot_mapped_file_reset_(file, flags);
+
+   stream = fopen(path, "rb");
+
+   if (stream == NULL) {
+      return -1;
+   }
+
+   setvbuf(stream, NULL, _IONBF, 0);
+
+   if (reboot_mapped_file_buffer_(file) != 0) {
+      fclose(stream);
+      return -1;
+   }
+
+   file->handle = (void *) stream;
+   return 0;
+}
+
+void
+reboot_mapped_file_close(reboot_mapped_file_t *file)
+{
+   if (file->buffer != NULL) {
+      free(file->buffer);
+      fclose((FILE *) file->handle);
+   }
+
+   reboot_mapped_file_reset_(file, 0);
+}
+
+#endif
+
+/* <!-- }}} Backing --> */
+
+/* <!-- Mapped file {{{ --> */
+
+/*!
+ * Sequential  iteration  over a mapping asks  for  the
+ * chunk  following  the one it returns to be read  in,
+ * overlapping  the  disk  and the  processing  of  the
+ * current  chunk.  Kernels reading ahead on their  own
+ * turn the request into a cheap no-op.
+ */
+int
+reboot_mapped_file_next(
+   reboot_mapped_file_t *file, const unsigned char **chunk, size_t *size
+) {
+   size_t remaining;
+
+   if (file->buffer != NULL) {
+      if (reboot_mapped_file_read_(file, size) != 0) {
+         return -1;
+      }
+
+      *chunk = file->buffer;
+      return *size != 0;
+   }
+
+   remaining = file->size - file->cursor;
+
+   if (remaining == 0) {
+      return 0;
+   }
+
+   *chunk = file->data + file->cursor;
+   *size  = remaining < REBOOT_MAPPED_FILE_CHUNK_SIZE
+      ? remaining : REBOOT_MAPPED_FILE_CHUNK_SIZE;
+
+   file->cursor += *size;
+
+   if ((file->flags & REBOOT_MAPPED_FILE_SEQUENTIAL)
+    && file->cursor < file->size) {
+      reboot_mapped_file_advise(
+         file, file->cursor, REBOOT_MAPPED_FILE_CHUNK_SIZE,
+         REBOOT_MAPPED_FILE_ADVICE_WILLNEED
+      );
+   }
+
+   return 1;
+}
+
+int
+reboot_mapped_file_advise(
+   reboot_mapped_file_t       *file,
+   size_t                      offset,
+   size_t                      size,
+   reboot_mapped_file_advice_t advice
+) {
+   if (file->buffer != NULL) {
+      return reboot_mapped_file_stream_advise_(file, offset, size, advice);
+   }
+
+   if (offset >= file->size) {
+      return 0;
+   }
+
+   if (size > file->size - offset) {
+      size = file->size - offset;
+   }
+
+   return reboot_mapped_file_map_advise_(file, offset, size, advice);
+}
+
+/* <!-- }}} Mapped file --> */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
@@ -0,0 +1,278 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+#ifndef __REBOOT_MAPPED_FILE_H__
+#define __REBOOT_MAPPED_FILE_H__
+
+/*!
+ * @file  mapped_file.h
+ * @brief Read-only memory-mapped files.
+ *
+ * This   header  maps  files  read-only  into  memory,
+ * exposing  their contents as a span of bytes  without
+ * copying them out of the page cache :
+ *
+ * - `reboot_mapped_file_open`   : Opening.
+ * - `reboot_mapped_file_next`   : Chunked iteration.
+ * - `reboot_mapped_file_advise` : Access pattern hint.
+ * - `reboot_mapped_file_close`  : Closing.
+ *
+ * Files  are  mapped  with `mmap`  or  `MapViewOfFile`
+ * wherever   `preprocessor/environment/os.h`   reports
+ * them.  Files  which cannot be mapped, be it  because
+ * the  target lacks both, because they are not regular
+ * files,  such as pipes, because they report no  size,
+ * or  because  they  exceed  the  address  space,  are
+ * streamed     instead    through    a    buffer    of
+ * `REBOOT_MAPPED_FILE_CHUNK_SIZE` bytes, which costs a
+ * copy    but    keeps    it   within    the    cache.
+ * `reboot_mapped_file_next`   walks  either  kind   in
+ * chunks, so that a single loop serves both :
+ *
+ * ```c
+ * reboot_mapped_file_t file;
+ * const unsigned char *chunk;
+ * size_t               size;
+ *
+ * if (reboot_mapped_file_open(&file, path, REBOOT_MAPPED_FILE_SEQUENTIAL)) {
+ *    return -1;
+ * }
+ *
+ * while (reboot_mapped_file_next(&file, &chunk, &size) > 0) {
+ *    lines += reboot_bytes_count_byte(chunk, size, '\n');
+ * }
+ *
+ * reboot_mapped_file_close(&file);
+ * ```
+ *
+ * Mapped  files  are  read  lazily,  each  page  being
+ * faulted  in from the page cache on first access. The
+ * hints     given     at    opening     or     through
+ * `reboot_mapped_file_advise`  tune  the readahead  of
+ * the     kernel     with     `posix_madvise`,     and
+ * `PrefetchVirtualMemory`  on  Windows,  whose  memory
+ * manager  otherwise  lacks access pattern  hints  for
+ * mappings. Sequential iteration additionally requests
+ * the  chunk following the one it returns, keeping the
+ * disk busy while the current one is being processed.
+ *
+ * A  file  truncated while mapped raises  `SIGBUS`  on
+ * access to its vanished pages, files being written to
+ * concurrently are therefore better streamed.
+ *
+ * These  functions are usable from both C and C++, and
+ * live in `mapped_file.c`.
+ */
+
+#include <stddef.h>
+
+#include "preprocessor/environment/os.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! <!-- Mapped file {{{ -->
+ * @addtogroup  mapped_file_mapped_file Mapped file
+ * @brief File state and lifetime
+ *
+ * The  mapped  file is a plain structure whose  `data`
+ * and  `size`  fields may be read freely,  the  others
+ * being  private. `data` points to the `size` bytes of
+ * a  mapped  file,  and  is `NULL` when  the  file  is
+ * streamed, `size` then being `0`.
+ * @{
+ */
+
+/*!
+ * @def   REBOOT_MAPPED_FILE_SEQUENTIAL
+ * @brief Sequential access flag.
+ *
+ * The  file is to be read once from start to end,  the
+ * kernel reading ahead aggressively and evicting pages
+ * soon after they have been read.
+ */
+#define REBOOT_MAPPED_FILE_SEQUENTIAL 1u
+
+/*!
+ * @def   REBOOT_MAPPED_FILE_RANDOM
+ * @brief Random access flag.
+ *
+ * The  file is to be accessed in no particular  order,
+ * the  kernel  then reading no more than the  faulting
+ * page.
+ */
+#define REBOOT_MAPPED_FILE_RANDOM 2u
+
+/*!
+ * @def   REBOOT_MAPPED_FILE_POPULATE
+ * @brief Prefaulting flag.
+ *
+ * The   whole  file  is  read  in  at  opening,   with
+ * `MAP_POPULATE`                                 where
+ * `REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MAP_POPULATE`
+ * is   defined  and  with  an  asynchronous   prefetch
+ * otherwise, sparing later accesses their page faults.
+ */
+#define REBOOT_MAPPED_FILE_POPULATE 4u
+
+/*!
+ * @def   REBOOT_MAPPED_FILE_HUGE_PAGES
+ * @brief Huge page backing flag.
+ *
+ * The  mapping is advised to be backed by  transparent
+ * huge                   pages                   where
+ * `REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MADV_HUGEPAGE`
+ * is  defined,  which  only takes  effect  on  kernels
+ * supporting  huge  pages  for the page cache  of  the
+ * underlying   file   system.  The  flag  is   ignored
+ * elsewhere.
+ */
+#define REBOOT_MAPPED_FILE_HUGE_PAGES 8u
+
+/*!
+ * @def   REBOOT_MAPPED_FILE_STREAM
+ * @brief Streaming flag.
+ *
+ * The file is streamed even though it could be mapped.
+ */
+#define REBOOT_MAPPED_FILE_STREAM 16u
+
+/*!
+ * @def   REBOOT_MAPPED_FILE_CHUNK_SIZE
+ * @brief Chunk size.
+ *
+ * This     is     the    size    of     the     chunks
+ * `reboot_mapped_file_next` returns, and of the buffer
+ * of   streamed  files.  It  may  be  overridden  when
+ * building  the  library, and is best kept within  the
+ * second level cache.
+ */
+#ifndef REBOOT_MAPPED_FILE_CHUNK_SIZE
+#  define REBOOT_MAPPED_FILE_CHUNK_SIZE (1024u * 1024u)
+#endif
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MMAP)                      \
+ || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+#  define REBOOT_MAPPED_FILE_HAS_MAP
+#endif
+
+/*!
+ * @brief Mapped file.
+ */
+typedef struct reboot_mapped_file {
+   const unsigned char *data;
+   size_t               size;
+   size_t               cursor;
+   unsigned char       *buffer;
+   void                *handle;
+   int                  descriptor;
+   unsigned             flags;
+} reboot_mapped_file_t;
+
+/*!
+ * @brief File opening.
+ *
+ * This  function opens the file at `path` into `file`,
+ * mapping  it  unless  `REBOOT_MAPPED_FILE_STREAM`  is
+ * given  or  the file cannot be mapped. `flags`  is  a
+ * combination  of the `REBOOT_MAPPED_FILE_*` flags, of
+ * which at most one of `REBOOT_MAPPED_FILE_SEQUENTIAL`
+ * and  `REBOOT_MAPPED_FILE_RANDOM`. It returns `0`  on
+ * success  and `-1` on failure, leaving `errno` or the
+ * last Windows error set.
+ */
+int reboot_mapped_file_open(
+   reboot_mapped_file_t *file, const char *path, unsigned flags
+);
+
+/*!
+ * @brief File closing.
+ *
+ * This  function unmaps or closes `file`, invalidating
+ * every chunk obtained from it.
+ */
+void reboot_mapped_file_close(reboot_mapped_file_t *file);
+
+/*! @} <!-- }}} Mapped file --> */
+
+/*! <!-- Iteration {{{ -->
+ * @addtogroup  mapped_file_iteration Iteration
+ * @brief Chunked sequential reading
+ * @{
+ */
+
+/*!
+ * @brief Chunked iteration.
+ *
+ * This  function stores into `*chunk` and `*size`  the
+ * next     chunk    of    `file`,    of    at     most
+ * `REBOOT_MAPPED_FILE_CHUNK_SIZE`   bytes.  Chunks  of
+ * mapped files point into the mapping and remain valid
+ * until  the  file is closed, those of streamed  files
+ * into  the  buffer and only until the next  call.  It
+ * returns  `1`  when a chunk is available, `0` at  the
+ * end of the file and `-1` on a read error.
+ */
+int reboot_mapped_file_next(
+   reboot_mapped_file_t *file, const unsigned char **chunk, size_t *size
+);
+
+/*! @} <!-- }}} Iteration --> */
+
+/*! <!-- Advice {{{ -->
+ * @addtogroup  mapped_file_advice Advice
+ * @brief Access pattern hints
+ *
+ * Advice  only  ever  affects performance,  never  the
+ * contents  of the file, and is silently ignored where
+ * the operating system offers no equivalent.
+ * @{
+ */
+
+/*!
+ * @brief Access patterns.
+ */
+typedef enum reboot_mapped_file_advice {
+   REBOOT_MAPPED_FILE_ADVICE_NORMAL,
+   REBOOT_MAPPED_FILE_ADVICE_SEQUENTIAL,
+   REBOOT_MAPPED_FILE_ADVICE_RANDOM,
+   REBOOT_MAPPED_FILE_ADVICE_WILLNEED,
+   REBOOT_MAPPED_FILE_ADVICE_DONTNEED
+} reboot_mapped_file_advice_t;
+
+/*!
+ * @brief Access pattern hint.
+ *
+ * This  function advises the operating system that the
+ * `size`  bytes of `file` at `offset` are about to  be
+ * accessed             following             `advice`,
+ * `REBOOT_MAPPED_FILE_ADVICE_WILLNEED`   starting   to
+ * read       them      in      asynchronously      and
+ * `REBOOT_MAPPED_FILE_ADVICE_DONTNEED`   letting  them
+ * go. The range is clamped to the file. It returns `0`
+ * on success and `-1` on failure.
+ */
+int reboot_mapped_file_advise(
+   reboot_mapped_file_t       *file,
+   size_t                      offset,
+   size_t                      size,
+   reboot_mapped_file_advice_t advice
+);
+
+/*! @} <!-- }}} Advice --> */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __REBOOT_MAPPED_FILE_H__ */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
@@ -0,0 +1,181 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+#ifndef __REBOOT_MULTIVERSION_H__
+#define __REBOOT_MULTIVERSION_H__
+
+/*!
+ * @file  multiversion.h
+ * @brief Per-function instruction set specialization.
+ *
+ * This   header  provides  the  attributes  needed  to
+ * compile  individual functions for an instruction set
+ * beyond  the baseline of the translation unit, and to
+ * select the best of them at runtime :
+ *
+ * - `REBOOT_TARGET`               : Single target.
+ * - `REBOOT_TARGET_CLONES`        : Loader selection.
+ * - `REBOOT_MULTIVERSION_VARIANT` : Family member.
+ *
+ * Targets  are  spelled as the compiler expects  them,
+ * e.g.  `"avx2,bmi2"` on x86 or `"+sve"` on 64-bit ARM
+ * with  GCC. A function compiled for a target may only
+ * be called once the host was found to support it, see
+ * `preprocessor/environment/cpu.h`.
+ *
+ * `REBOOT_MULTIVERSION_HAS_TARGET`                 and
+ * `REBOOT_MULTIVERSION_HAS_TARGET_CLONES`  are defined
+ * when  the  respective  attribute is  honoured.  Both
+ * otherwise  expand to nothing, leaving every function
+ * compiled  for the baseline, which is always  correct
+ * albeit slower.
+ */
+
+#include "preprocessor/environment/compiler.h"
+#include "preprocessor/environment/os.h"
+#include "preprocessor/environment/cpu.h"
+
+/*! <!-- Target attributes {{{ -->
+ * @addtogroup  multiversion_target Target attributes
+ * @brief Per-function instruction set selection
+ *
+ * MSVC  has  no such attribute and lets  any  function
+ * make  use of any intrinsic instead, code  generation
+ * for plain C remaining bound to `/arch`.
+ *
+ * `target_clones`  relies on indirect functions, which
+ * are resolved by the dynamic loader and are therefore
+ * only   available   on  ELF  targets   whose   loader
+ * implements  them, namely glibc and FreeBSD. musl and
+ * bionic  notably  lack them. GCC supports it  on  x86
+ * from  version  6, on other architectures  only  from
+ * version   14   onwards,   both  being   covered   by
+ * `__has_attribute` from GCC 10.
+ * @{
+ */
+
+/*!
+ * @def   REBOOT_TARGET
+ * @brief Target attribute.
+ */
+#if REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_ATTRIBUTE(__target__)        \
+ || (   defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GCC)             \
+     && REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_GCC >= 40900)
+#  define REBOOT_MULTIVERSION_HAS_TARGET
+#  define REBOOT_TARGET(s) __attribute__((__target__(s)))
+#else
+#  define REBOOT_TARGET(s)
+#endif
+
+#if defined(__ELF__)                                                          \
+ && (   defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_GLIBC)                 \
+     || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_FREEBSD))
+#  if REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_ATTRIBUTE(__target_clones__)
+#     define REBOOT_MULTIVERSION_HAS_TARGET_CLONES
+#  elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GCC)             \
+     && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86)         \
+     && REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_GCC >= 60000
+#     define REBOOT_MULTIVERSION_HAS_TARGET_CLONES
+#  endif
+#endif
+
+/*!
+ * @def   REBOOT_TARGET_CLONES
+ * @brief Target clones attribute.
+ *
+ * This  macro  compiles the function it is applied  to
+ * once  per  listed  target,  one  of  which  must  be
+ * `"default"`,  and binds calls to the best clone  the
+ * host supports when the program is loaded. It is only
+ * defined  from C99 and C++11 onwards, variadic macros
+ * being unavailable before.
+ */
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_AT_LEAST_C99)        \
+ || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP11)
+#  if defined(REBOOT_MULTIVERSION_HAS_TARGET_CLONES)
+#     define REBOOT_TARGET_CLONES(...)                                        \
+         __attribute__((__target_clones__(__VA_ARGS__)))
+#  else
+#     define REBOOT_TARGET_CLONES(...)
+#  endif
+#endif
+
+/*! @} <!-- }}} Target attributes --> */
+
+/*! <!-- Function families {{{ -->
+ * @addtogroup  multiversion_family Function families
+ * @brief Multiversioned function family scaffold
+ *
+ * Where  `target_clones`  is unavailable, or when  the
+ * selection must honour features the loader is unaware
+ * of,  a  family  is  built out of  a  single  generic
+ * implementation, marked `REBOOT_ALWAYS_INLINE`, which
+ * `REBOOT_MULTIVERSION_VARIANT`    inlines   into    a
+ * function  compiled  for a given target, so that  the
+ * very   same   source   benefits   from   the   wider
+ * instructions.  The  variants are then tied  together
+ * with `REBOOT_CPU_DISPATCH` :
+ *
+ * ```c
+ * static REBOOT_ALWAYS_INLINE uint32_t
+ * checksum_generic(const unsigned char *data, size_t size)
+ * {
+ *    ...
+ * }
+ *
+ * REBOOT_MULTIVERSION_VARIANT(
+ *    uint32_t, checksum, avx512, "avx512f,avx512bw",
+ *    (const unsigned char *data, size_t size), (data, size)
+ * )
+ *
+ * REBOOT_MULTIVERSION_VARIANT(
+ *    uint32_t, checksum, avx2, "avx2,bmi2",
+ *    (const unsigned char *data, size_t size), (data, size)
+ * )
+ *
+ * REBOOT_CPU_DISPATCH(
+ *    uint32_t, checksum,
+ *    (const unsigned char *data, size_t size), (data, size),
+ *    REBOOT_CPU_DISPATCH_ENTRY(
+ *       REBOOT_CPU_AVX512F | REBOOT_CPU_AVX512BW, checksum_avx512
+ *    ),
+ *    REBOOT_CPU_DISPATCH_ENTRY(
+ *       REBOOT_CPU_AVX2 | REBOOT_CPU_BMI2, checksum_avx2
+ *    ),
+ *    REBOOT_CPU_DISPATCH_ENTRY(0, checksum_generic)
+ * )
+ * ```
+ *
+ * The  masks must cover every extension listed in  the
+ * target  string, nothing preventing the compiler from
+ * emitting any of them.
+ * @{
+ */
+
+/*!
+ * @def   REBOOT_MULTIVERSION_VARIANT
+ * @brief Multiversioned function variant.
+ *
+ * This  macro defines `name##_##suffix`, compiled  for
+ * `target`, as a forwarder to `name##_generic`.
+ */
+#define REBOOT_MULTIVERSION_VARIANT(                                          \
+   type, name, suffix, target, parameters, arguments                          \
+)                                                                             \
+   REBOOT_TARGET(target) static type name##_##suffix parameters               \
+   {                                                                          \
+      return name##_generic arguments;                                        \
+   }
+
+/*! @} <!-- }}} Function families --> */
+
+#endif /* __REBOOT_MULTIVERSION_H__ */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
@@ -0,0 +1,169 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+#ifndef __REBOOT_PERCPU_H__
+#define __REBOOT_PERCPU_H__
+
+/*!
+ * @file  percpu.h
+ * @brief Per-processor data.
+ *
+ * This header shards data by the processor the calling
+ * thread   runs   on,  threads  running  on   distinct
+ * processors  then  working  on distinct  cache  lines
+ * instead of bouncing a shared one :
+ *
+ * - `REBOOT_PERCPU(type)` : Slot type.
+ * - `reboot_percpu_slot`  : Slot index.
+ *
+ * ```c
+ * static REBOOT_PERCPU(uint64_t) hits[REBOOT_PERCPU_SLOTS];
+ *
+ * __atomic_fetch_add(
+ *    &hits[reboot_percpu_slot()].value, 1, __ATOMIC_RELAXED
+ * );
+ *
+ * for (i = 0; i < REBOOT_PERCPU_SLOTS; ++i) {
+ *    total += __atomic_load_n(&hits[i].value, __ATOMIC_RELAXED);
+ * }
+ * ```
+ *
+ * The  processor  number is read from the  restartable
+ * sequence     area    of    the    thread    wherever
+ * `REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_RSEQ`     is
+ * defined and the compiler exposes the thread pointer,
+ * at     the     cost     of     a     plain     load,
+ * `REBOOT_PERCPU_HAS_RSEQ`  then being defined. It  is
+ * otherwise  asked  from the operating system  through
+ * `reboot_topology_current`,    which   Linux   serves
+ * through  `getcpu` from its vDSO without entering the
+ * kernel.  Where  neither tells, slots are  spread  by
+ * thread    instead,    from   the   address   of    a
+ * `REBOOT_THREAD_LOCAL`  variable,  which still  keeps
+ * concurrent threads apart on the whole.
+ *
+ * A  thread may migrate between reading its slot index
+ * and   updating  the  slot,  and  processors   beyond
+ * `REBOOT_PERCPU_SLOTS`   share  slots,  updates  thus
+ * still  having  to  be atomic. They  are  uncontended
+ * however,  the  cache line staying put in the  common
+ * case,  which makes a relaxed atomic increment  about
+ * as cheap as a plain one.
+ */
+
+#include <stdint.h>
+
+#include "preprocessor/environment/architecture.h"
+#include "preprocessor/environment/compiler.h"
+#include "preprocessor/environment/os.h"
+#include "topology.h"
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_RSEQ)                      \
+ && REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN(                     \
+       __builtin_thread_pointer                                               \
+    )
+#  include <sys/rseq.h>
+#  define REBOOT_PERCPU_HAS_RSEQ
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! <!-- Slots {{{ -->
+ * @addtogroup  percpu_slots Slots
+ * @brief Cache line sized shards
+ * @{
+ */
+
+/*!
+ * @def   REBOOT_PERCPU_SLOTS
+ * @brief Slot count.
+ *
+ * This  is  the number of  slots  `reboot_percpu_slot`
+ * spreads  over, a power of two. It may be overridden,
+ * consistently across the translation units sharing an
+ * array.
+ */
+#ifndef REBOOT_PERCPU_SLOTS
+#  define REBOOT_PERCPU_SLOTS 256u
+#endif
+
+/*!
+ * @def   REBOOT_PERCPU
+ * @brief Slot type.
+ *
+ * This  macro  expands to a union holding a `type`  as
+ * its  `value`  member, aligned and padded to a  cache
+ * line  so  that consecutive slots of an  array  never
+ * share one.
+ */
+#define REBOOT_PERCPU(type)                                                   \
+   union {                                                                    \
+      REBOOT_CACHE_ALIGNED type value;                                        \
+      unsigned char             padding[                                      \
+         REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_CACHE_LINE_SIZE         \
+      ];                                                                      \
+   }
+
+/*!
+ * @brief Slot index.
+ *
+ * This  function returns the index of the slot of  the
+ * calling thread, below `REBOOT_PERCPU_SLOTS`.
+ */
+static REBOOT_INLINE unsigned
+reboot_percpu_slot(void)
+{
+   int cpu;
+
+#if defined(REBOOT_PERCPU_HAS_RSEQ)
+   if (REBOOT_LIKELY(__rseq_size != 0)) {
+      const volatile struct rseq *area = (const volatile struct rseq *) (
+         (const char *) __builtin_thread_pointer() + __rseq_offset
+      );
+
+      cpu = (int) area->cpu_id;
+
+      if (REBOOT_LIKELY(cpu >= 0)) {
+         return (unsigned) cpu & (REBOOT_PERCPU_SLOTS - 1u);
+      }
+   }
+#endif
+
+   cpu = reboot_topology_current();
+
+   if (cpu >= 0) {
+      return (unsigned) cpu & (REBOOT_PERCPU_SLOTS - 1u);
+   }
+
+#if defined(REBOOT_HAS_THREAD_LOCAL)
+   {
+      static REBOOT_THREAD_LOCAL unsigned char anchor;
+
+      /* Thread areas lie pages apart, mixed into the upper bits. */
+      return (unsigned) (
+         ((uint32_t) ((uintptr_t) &anchor >> 12) * 2654435761u) >> 16
+      ) & (REBOOT_PERCPU_SLOTS - 1u);
+   }
+#else
+   return 0;
+#endif
+}
+
+/*! @} <!-- }}} Slots --> */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __REBOOT_PERCPU_H__ */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
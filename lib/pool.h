@@ -0,0 +1,614 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+#ifndef __REBOOT_POOL_H__
+#define __REBOOT_POOL_H__
+
+/*!
+ * @file  pool.h
+ * @brief Fixed-size object pool.
+ *
+ * This  header provides a pool of fixed-size  objects,
+ * carved out of `arena.h` slabs and recycled through a
+ * freelist shared by every thread :
+ *
+ * - `reboot_pool_init`    : Initialization.
+ * - `reboot_pool_alloc`   : Allocation.
+ * - `reboot_pool_free`    : Deallocation.
+ * - `reboot_pool_destroy` : Finalization.
+ *
+ * The  freelist  implementation  is chosen  after  the
+ * lock-free         atomics        reported         by
+ * `preprocessor/environment/architecture.h`,  by order
+ * of preference :
+ *
+ * - `DWCAS`  : Pointer and tag, double-width swap.
+ * - `TAGGED` : Pointer and tag packed in 64 bits.
+ * - `LOCKED` : Spinlock or mutex.
+ *
+ * Both  lock-free  variants are Treiber  stacks  whose
+ * head  carries  a  tag  bumped by  every  pop,  which
+ * defeats  the  ABA problem of an object being  popped
+ * and pushed back between the read of the head and its
+ * swap.     `DWCAS`     requires    a     double-width
+ * compare-and-swap,  i.e. `-mcx16` on x86-64 with GCC,
+ * and  carries  a full word of tag. `TAGGED`  packs  a
+ * 16-bit  tag  in the upper bits of x86-64 and  64-bit
+ * ARM  user  space  pointers, which  never  exceed  48
+ * significant  bits,  or a 32-bit tag next  to  32-bit
+ * pointers, and only requires 64-bit atomics. A 16-bit
+ * tag  may  in  theory wrap around while a  thread  is
+ * preempted in between, which would take 65536 pops of
+ * the very same object.
+ *
+ * `REBOOT_POOL_HAS_LOCK_FREE`  is defined when  either
+ * lock-free  variant  is in use. `LOCKED` relies on  a
+ * spinlock wherever atomic exchanges are available and
+ * on   a   POSIX  mutex  otherwise,  the  pool   being
+ * restricted  to  a single thread on  targets  lacking
+ * both.
+ *
+ * Slabs      are     only     ever     released     by
+ * `reboot_pool_destroy`,  the freelist reading through
+ * objects  concurrently  handed out to  other  threads
+ * being  harmless as a result. Every translation  unit
+ * sharing  a pool must be compiled with the same flags
+ * since they determine the freelist variant.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "arena.h"
+#include "preprocessor/environment/architecture.h"
+#include "preprocessor/environment/compiler.h"
+#include "preprocessor/environment/os.h"
+
+#if UINTPTR_MAX > 0xffffffffu                                                 \
+ && REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_128_LOCK_FREE == 2
+#  define REBOOT_POOL_HAS_LOCK_FREE
+#  define REBOOT_POOL_DWCAS_
+#elif REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_64_LOCK_FREE == 2   \
+   && (   UINTPTR_MAX == 0xffffffffu                                          \
+       || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86_64)    \
+       || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM64))
+#  define REBOOT_POOL_HAS_LOCK_FREE
+#  define REBOOT_POOL_TAGGED_
+#endif
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)
+#  define REBOOT_POOL_SPINLOCK_
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)
+#  include <intrin.h>
+#  define REBOOT_POOL_SPINLOCK_
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_UNIX)
+#  include <pthread.h>
+#  define REBOOT_POOL_MUTEX_
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! <!-- Pool {{{ -->
+ * @addtogroup  pool_pool Pool
+ * @brief Pool state and lifetime
+ *
+ * The  freelist head and the lock live on cache  lines
+ * of their own, keeping the threads contending for the
+ * former  from invalidating the fields every operation
+ * reads.
+ * @{
+ */
+
+/*!
+ * @def   REBOOT_POOL_SLAB_SIZE
+ * @brief Slab size.
+ *
+ * This  is  the  amount of memory, in  bytes,  a  pool
+ * carves  out of its arena whenever its freelist  runs
+ * dry.
+ */
+#ifndef REBOOT_POOL_SLAB_SIZE
+#  define REBOOT_POOL_SLAB_SIZE (64u * 1024u)
+#endif
+
+typedef struct reboot_pool_node_ {
+   struct reboot_pool_node_ *next;
+} reboot_pool_node_;
+
+#if defined(REBOOT_POOL_DWCAS_)
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)
+__extension__ typedef unsigned __int128 reboot_pool_head_;
+#  else
+typedef struct reboot_pool_head_ {
+   __int64 words[2];
+} reboot_pool_head_;
+#  endif
+#elif defined(REBOOT_POOL_TAGGED_)
+typedef uint64_t reboot_pool_head_;
+#else
+typedef reboot_pool_node_ *reboot_pool_head_;
+#endif
+
+/*!
+ * @brief Pool.
+ */
+typedef struct reboot_pool {
+   REBOOT_CACHE_ALIGNED volatile reboot_pool_head_ head;
+#if defined(REBOOT_POOL_MUTEX_)
+   REBOOT_CACHE_ALIGNED pthread_mutex_t            lock;
+#else
+   REBOOT_CACHE_ALIGNED volatile long              lock;
+#endif
+   reboot_arena_t                                  arena;
+   size_t                                          object_size;
+   size_t                                          alignment;
+} reboot_pool_t;
+
+/*!
+ * @brief Pool initialization.
+ *
+ * This function initializes an empty `pool` of objects
+ * of `object_size` bytes aligned to `alignment`, which
+ * must    be   a   power   of   two,   or   `0`    for
+ * `REBOOT_ARENA_ALIGNMENT`.  `flags` is handed over to
+ * `reboot_arena_init`.
+ */
+static REBOOT_INLINE void
+reboot_pool_init(
+   reboot_pool_t *pool, size_t object_size, size_t alignment, unsigned flags
+) {
+   if (alignment == 0) {
+      alignment = REBOOT_ARENA_ALIGNMENT;
+   }
+
+   if (alignment < sizeof(reboot_pool_node_)) {
+      alignment = sizeof(reboot_pool_node_);
+   }
+
+   if (object_size < sizeof(reboot_pool_node_)) {
+      object_size = sizeof(reboot_pool_node_);
+   }
+
+   pool->object_size = (object_size + (alignment - 1u)) & ~(alignment - 1u);
+   pool->alignment   = alignment;
+
+#if defined(REBOOT_POOL_DWCAS_)                                               \
+ && !defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)
+   pool->head.words[0] = 0;
+   pool->head.words[1] = 0;
+#else
+   pool->head = 0;
+#endif
+
+#if defined(REBOOT_POOL_MUTEX_)
+   pthread_mutex_init(&pool->lock, NULL);
+#else
+   pool->lock = 0;
+#endif
+
+   reboot_arena_init(&pool->arena, 0, flags);
+}
+
+/*!
+ * @brief Pool finalization.
+ *
+ * This   function  releases  every  slab  of   `pool`,
+ * invalidating every object allocated from it, whether
+ * freed or not.
+ */
+static REBOOT_INLINE void
+reboot_pool_destroy(reboot_pool_t *pool)
+{
+   reboot_arena_destroy(&pool->arena);
+
+#if defined(REBOOT_POOL_MUTEX_)
+   pthread_mutex_destroy(&pool->lock);
+#endif
+}
+
+/*! @} <!-- }}} Pool --> */
+
+/*! <!-- Locking {{{ -->
+ * @addtogroup  pool_locking Locking
+ * @brief Freelist and slab locking
+ *
+ * The  lock guards the arena in every variant, and the
+ * freelist  as well in the `LOCKED` one. The  spinlock
+ * is  a test-and-test-and-set, spinning on plain loads
+ * rather  than on the exchange so as to keep the cache
+ * line shared while it is held.
+ * @{
+ */
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86)             \
+ && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)
+#  define REBOOT_POOL_PAUSE_() __builtin_ia32_pause()
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86)           \
+   && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)
+#  define REBOOT_POOL_PAUSE_() _mm_pause()
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM)           \
+   && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)
+#  define REBOOT_POOL_PAUSE_() __asm__ volatile ("yield" ::: "memory")
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM)           \
+   && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)
+#  define REBOOT_POOL_PAUSE_() __yield()
+#else
+#  define REBOOT_POOL_PAUSE_() ((void) 0)
+#endif
+
+static REBOOT_INLINE void
+reboot_pool_lock_(reboot_pool_t *pool)
+{
+#if defined(REBOOT_POOL_SPINLOCK_)
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)
+   while (__sync_lock_test_and_set(&pool->lock, 1)) {
+#  else
+   while (_InterlockedExchange(&pool->lock, 1)) {
+#  endif
+      while (pool->lock) {
+         REBOOT_POOL_PAUSE_();
+      }
+   }
+#elif defined(REBOOT_POOL_MUTEX_)
+   pthread_mutex_lock(&pool->lock);
+#else
+   (void) pool;
+#endif
+}
+
+static REBOOT_INLINE void
+reboot_pool_unlock_(reboot_pool_t *pool)
+{
+#if defined(REBOOT_POOL_SPINLOCK_)
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)
+   __sync_lock_release(&pool->lock);
+#  else
+   _InterlockedExchange(&pool->lock, 0);
+#  endif
+#elif defined(REBOOT_POOL_MUTEX_)
+   pthread_mutex_unlock(&pool->lock);
+#else
+   (void) pool;
+#endif
+}
+
+/*! @} <!-- }}} Locking --> */
+
+/*! <!-- Freelist {{{ -->
+ * @addtogroup  pool_freelist Freelist
+ * @brief Freelist push and pop
+ *
+ * Pushes link a chain of objects at once, which lets a
+ * fresh  slab  be published with a single swap.  Heads
+ * are read without atomicity in the `DWCAS` variant, a
+ * torn read merely failing the subsequent swap.
+ * @{
+ */
+
+#if defined(REBOOT_POOL_DWCAS_)
+
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)
+
+#     define REBOOT_POOL_NODE_(head)                                          \
+         ((reboot_pool_node_ *) (uintptr_t) (uint64_t) (head))
+
+static REBOOT_INLINE void *
+reboot_pool_pop_(reboot_pool_t *pool)
+{
+   reboot_pool_head_ head = pool->head;
+
+   for (;;) {
+      reboot_pool_node_ *node = REBOOT_POOL_NODE_(head);
+      reboot_pool_head_  next;
+      reboot_pool_head_  seen;
+
+      if (node == NULL) {
+         return NULL;
+      }
+
+      next = ((head >> 64) + 1u) << 64 | (uintptr_t) node->next;
+      seen = __sync_val_compare_and_swap(&pool->head, head, next);
+
+      if (seen == head) {
+         return node;
+      }
+
+      head = seen;
+   }
+}
+
+static REBOOT_INLINE void
+reboot_pool_push_(
+   reboot_pool_t *pool, reboot_pool_node_ *first, reboot_pool_node_ *last
+) {
+   reboot_pool_head_ head = pool->head;
+
+   for (;;) {
+      reboot_pool_head_ seen;
+
+      last->next = REBOOT_POOL_NODE_(head);
+      seen       = __sync_val_compare_and_swap(
+         &pool->head, head, (head >> 64) << 64 | (uintptr_t) first
+      );
+
+      if (seen == head) {
+         return;
+      }
+
+      head = seen;
+   }
+}
+
+#  else
+
+static REBOOT_INLINE void *
+reboot_pool_pop_(reboot_pool_t *pool)
+{
+   __int64 head[2];
+
+   head[0] = pool->head.words[0];
+   head[1] = pool->head.words[1];
+
+   for (;;) {
+      reboot_pool_node_ *node = (reboot_pool_node_ *) head[0];
+
+      if (node == NULL) {
+         return NULL;
+      }
+
+      if (_InterlockedCompareExchange128(
+         pool->head.words, head[1] + 1, (__int64) node->next, head
+      )) {
+         return node;
+      }
+   }
+}
+
+static REBOOT_INLINE void
+reboot_pool_push_(
+   reboot_pool_t *pool, reboot_pool_node_ *first, reboot_pool_node_ *last
+) {
+   __int64 head[2];
+
+   head[0] = pool->head.words[0];
+   head[1] = pool->head.words[1];
+
+   do {
+      last->next = (reboot_pool_node_ *) head[0];
+   } while (!_InterlockedCompareExchange128(
+      pool->head.words, head[1], (__int64) first, head
+   ));
+}
+
+#  endif
+
+#elif defined(REBOOT_POOL_TAGGED_)
+
+#  if UINTPTR_MAX == 0xffffffffu
+#     define REBOOT_POOL_TAG_SHIFT_ 32
+#  else
+#     define REBOOT_POOL_TAG_SHIFT_ 48
+#  endif
+
+#  define REBOOT_POOL_TAG_ONE_  ((uint64_t) 1u << REBOOT_POOL_TAG_SHIFT_)
+#  define REBOOT_POOL_TAG_MASK_ (~(REBOOT_POOL_TAG_ONE_ - 1u))
+#  define REBOOT_POOL_TAG_(head) ((head) & REBOOT_POOL_TAG_MASK_)
+#  define REBOOT_POOL_NODE_(head)                                             \
+      ((reboot_pool_node_ *) (uintptr_t) ((head) & ~REBOOT_POOL_TAG_MASK_))
+
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)
+#     define REBOOT_POOL_LOAD_(head)                                          \
+         __atomic_load_n((head), __ATOMIC_ACQUIRE)
+#     define REBOOT_POOL_SWAP_(head, expected, desired, order)                \
+         __atomic_compare_exchange_n(                                         \
+            (head), (expected), (desired), 1, (order), __ATOMIC_ACQUIRE       \
+         )
+#  else
+#     define REBOOT_POOL_LOAD_(head) (*(head))
+#     define REBOOT_POOL_SWAP_(head, expected, desired, order)                \
+         reboot_pool_swap64_((head), (expected), (desired))
+
+static REBOOT_INLINE int
+reboot_pool_swap64_(
+   volatile uint64_t *head, uint64_t *expected, uint64_t desired
+) {
+   uint64_t seen = (uint64_t) _InterlockedCompareExchange64(
+      (volatile __int64 *) head, (__int64) desired, (__int64) *expected
+   );
+
+   if (seen == *expected) {
+      return 1;
+   }
+
+   *expected = seen;
+
+   return 0;
+}
+#  endif
+
+static REBOOT_INLINE void *
+reboot_pool_pop_(reboot_pool_t *pool)
+{
+   uint64_t head = REBOOT_POOL_LOAD_(&pool->head);
+
+   for (;;) {
+      reboot_pool_node_ *node = REBOOT_POOL_NODE_(head);
+      uint64_t           next;
+
+      if (node == NULL) {
+         return NULL;
+      }
+
+      next = (REBOOT_POOL_TAG_(head) + REBOOT_POOL_TAG_ONE_)
+           | (uintptr_t) node->next;
+
+      if (REBOOT_POOL_SWAP_(&pool->head, &head, next, __ATOMIC_ACQUIRE)) {
+         return node;
+      }
+   }
+}
+
+static REBOOT_INLINE void
+reboot_pool_push_(
+   reboot_pool_t *pool, reboot_pool_node_ *first, reboot_pool_node_ *last
+) {
+   uint64_t head = REBOOT_POOL_LOAD_(&pool->head);
+
+   do {
+      last->next = REBOOT_POOL_NODE_(head);
+   } while (!REBOOT_POOL_SWAP_(
+      &pool->head, &head, REBOOT_POOL_TAG_(head) | (uintptr_t) first,
+      __ATOMIC_RELEASE
+   ));
+}
+
+#else
+
+static REBOOT_INLINE void *
+reboot_pool_pop_(reboot_pool_t *pool)
+{
+   reboot_pool_node_ *node;
+
+   reboot_pool_lock_(pool);
+
+   node = pool->head;
+
+   if (node != NULL) {
+      pool->head = node->next;
+   }
+
+   reboot_pool_unlock_(pool);
+
+   return node;
+}
+
+static REBOOT_INLINE void
+reboot_pool_push_(
+   reboot_pool_t *pool, reboot_pool_node_ *first, reboot_pool_node_ *last
+) {
+   reboot_pool_lock_(pool);
+
+   last->next = pool->head;
+   pool->head = first;
+
+   reboot_pool_unlock_(pool);
+}
+
+#endif
+
+/*! @} <!-- }}} Freelist --> */
+
+/*! <!-- Allocation {{{ -->
+ * @addtogroup  pool_allocation Allocation
+ * @brief Object allocation and deallocation
+ *
+ * Allocations  return `NULL` once the operating system
+ * runs  out  of  memory. Objects may be freed  by  any
+ * thread, not only by the one that allocated them.
+ * @{
+ */
+
+/*!
+ * @brief Slab allocation slow path.
+ *
+ * Another  thread may have refilled the freelist while
+ * this  one was waiting for the lock, which is checked
+ * for  before carving a new slab. The first object  of
+ * the  slab is kept for the caller and the others  are
+ * pushed at once.
+ */
+static REBOOT_INLINE REBOOT_COLD void *
+reboot_pool_grow_(reboot_pool_t *pool)
+{
+   unsigned char *slab;
+   size_t         count = REBOOT_POOL_SLAB_SIZE / pool->object_size;
+   size_t         i;
+
+   if (count == 0) {
+      count = 1;
+   }
+
+   reboot_pool_lock_(pool);
+
+#if defined(REBOOT_POOL_HAS_LOCK_FREE)
+   slab = (unsigned char *) reboot_pool_pop_(pool);
+
+   if (slab != NULL) {
+      reboot_pool_unlock_(pool);
+      return slab;
+   }
+#endif
+
+   slab = (unsigned char *) reboot_arena_alloc_aligned(
+      &pool->arena, pool->object_size * count, pool->alignment
+   );
+
+   reboot_pool_unlock_(pool);
+
+   if (slab == NULL) {
+      return NULL;
+   }
+
+   for (i = 1; i + 1 < count; ++i) {
+      ((reboot_pool_node_ *) (slab + i * pool->object_size))->next =
+         (reboot_pool_node_ *) (slab + (i + 1) * pool->object_size);
+   }
+
+   if (count > 1) {
+      reboot_pool_push_(
+         pool,
+         (reboot_pool_node_ *) (slab + pool->object_size),
+         (reboot_pool_node_ *) (slab + (count - 1) * pool->object_size)
+      );
+   }
+
+   return slab;
+}
+
+/*!
+ * @brief Object allocation.
+ */
+static REBOOT_INLINE void *
+reboot_pool_alloc(reboot_pool_t *pool)
+{
+   void *object = reboot_pool_pop_(pool);
+
+   if (REBOOT_LIKELY(object != NULL)) {
+      return object;
+   }
+
+   return reboot_pool_grow_(pool);
+}
+
+/*!
+ * @brief Object deallocation.
+ *
+ * This function returns `object`, which must have been
+ * allocated from `pool`, to the freelist.
+ */
+static REBOOT_INLINE void
+reboot_pool_free(reboot_pool_t *pool, void *object)
+{
+   reboot_pool_push_(
+      pool, (reboot_pool_node_ *) object, (reboot_pool_node_ *) object
+   );
+}
+
+/*! @} <!-- }}} Allocation --> */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __REBOOT_POOL_H__ */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
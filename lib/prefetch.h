@@ -0,0 +1,224 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+#ifndef __REBOOT_PREFETCH_H__
+#define __REBOOT_PREFETCH_H__
+
+/*!
+ * @file  prefetch.h
+ * @brief Software prefetching and non-temporal stores.
+ *
+ * This  header provides cache control hints mapped  to
+ * whatever       the      target      detected      by
+ * `preprocessor/environment/architecture.h` offers :
+ *
+ * - `REBOOT_PREFETCH_READ(p, locality)`
+ * - `REBOOT_PREFETCH_WRITE(p, locality)`
+ * - `REBOOT_STREAM_STORE(destination, source)`
+ * - `REBOOT_STREAM_FENCE()`
+ * - `reboot_stream_copy(destination, source, size)`
+ *
+ * Each  of  them  compiles to nothing, or to  a  plain
+ * store,  on  targets offering no such hint. They  are
+ * hints only and never change the observable behaviour
+ * of a correct program, prefetching an invalid address
+ * being harmless.
+ *
+ * `locality`    follows    the    `__builtin_prefetch`
+ * convention  and must be an integer constant  between
+ * `0`,  no  temporal locality, and `3`, high  temporal
+ * locality.  On  x86,  these respectively map  to  the
+ * `NTA` and `T0` hints.
+ *
+ * Non-temporal   stores   write   around   the   cache
+ * hierarchy,  which keeps large sequential writes that
+ * will not be read back soon from evicting the working
+ * set  out  of the last level cache. They  are  weakly
+ * ordered   with   respect   to   other   stores   and
+ * `REBOOT_STREAM_FENCE`    must   be   issued   before
+ * publishing the written data to another thread.
+ *
+ * `REBOOT_STREAM_HAS_NONTEMPORAL`  is defined whenever
+ * `REBOOT_STREAM_STORE` actually bypasses the cache.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "preprocessor/environment/architecture.h"
+#include "preprocessor/environment/compiler.h"
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SSE2)
+#  include <emmintrin.h>
+#  define REBOOT_STREAM_HAS_NONTEMPORAL
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM64)         \
+   && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)
+#  define REBOOT_STREAM_HAS_NONTEMPORAL
+#endif
+
+#if !defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN_PREFETCH)   \
+ &&  defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86)
+#     include <xmmintrin.h>
+#  elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM)
+#     include <intrin.h>
+#  endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! <!-- Prefetching {{{ -->
+ * @addtogroup  prefetch_hints Prefetching
+ * @brief Software prefetch hints
+ *
+ * `__builtin_prefetch` is preferred wherever available
+ * since  it  lowers  to `prefetcht0`,  `prefetchw`  or
+ * `prfm`  as  appropriate for the target. MSVC has  no
+ * write  prefetch  intrinsic usable  without  `PRFCHW`
+ * support  on x86, in which case write prefetches  are
+ * issued  as  read prefetches, which still brings  the
+ * line in.
+ * @{
+ */
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN_PREFETCH)
+#  define REBOOT_PREFETCH_READ(p, locality)                                   \
+      __builtin_prefetch((p), 0, (locality))
+#  define REBOOT_PREFETCH_WRITE(p, locality)                                  \
+      __builtin_prefetch((p), 1, (locality))
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)              \
+   && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86)
+#  define REBOOT_PREFETCH_HINT_(locality)                                     \
+      ((locality) >= 3 ? _MM_HINT_T0                                          \
+    :  (locality) == 2 ? _MM_HINT_T1                                          \
+    :  (locality) == 1 ? _MM_HINT_T2                                          \
+    :                    _MM_HINT_NTA)
+#  define REBOOT_PREFETCH_READ(p, locality)                                   \
+      _mm_prefetch((const char *) (p), REBOOT_PREFETCH_HINT_(locality))
+#  define REBOOT_PREFETCH_WRITE(p, locality)                                  \
+      REBOOT_PREFETCH_READ(p, locality)
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)              \
+   && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM)
+#  define REBOOT_PREFETCH_READ(p, locality)                                   \
+      ((void) (locality), __prefetch((const void *) (p)))
+#  define REBOOT_PREFETCH_WRITE(p, locality)                                  \
+      REBOOT_PREFETCH_READ(p, locality)
+#else
+#  define REBOOT_PREFETCH_READ(p, locality)  ((void) (p), (void) (locality))
+#  define REBOOT_PREFETCH_WRITE(p, locality) ((void) (p), (void) (locality))
+#endif
+
+/*! @} <!-- }}} Prefetching --> */
+
+/*! <!-- Non-temporal stores {{{ -->
+ * @addtogroup  prefetch_stream Non-temporal stores
+ * @brief Cache bypassing stores
+ *
+ * `REBOOT_STREAM_STORE`  writes 16 bytes from `source`
+ * to  `destination`,  which must be  16-byte  aligned.
+ * `source`  carries no alignment requirement. It  maps
+ * to `movntdq` on x86 and to `stnp` on 64-bit ARM, the
+ * latter  only being a hint which implementations  are
+ * free to ignore.
+ * @{
+ */
+
+/*!
+ * @brief 16-byte non-temporal store.
+ */
+static REBOOT_INLINE void
+reboot_stream_store16_(void *destination, const void *source)
+{
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SSE2)
+   _mm_stream_si128(
+      (__m128i *) destination, _mm_loadu_si128((const __m128i *) source)
+   );
+#elif defined(REBOOT_STREAM_HAS_NONTEMPORAL)
+   uint64_t low;
+   uint64_t high;
+
+   memcpy(&low,  source,                     sizeof low);
+   memcpy(&high, (const char *) source + 8u, sizeof high);
+
+   __asm__ volatile (
+      "stnp %x1, %x2, [%x0]"
+      :
+      : "r" (destination), "r" (low), "r" (high)
+      : "memory"
+   );
+#else
+   memcpy(destination, source, 16u);
+#endif
+}
+
+#define REBOOT_STREAM_STORE(destination, source)                              \
+   reboot_stream_store16_((destination), (source))
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SSE2)
+#  define REBOOT_STREAM_FENCE() _mm_sfence()
+#elif defined(REBOOT_STREAM_HAS_NONTEMPORAL)
+#  define REBOOT_STREAM_FENCE() __asm__ volatile ("dmb ishst" ::: "memory")
+#else
+#  define REBOOT_STREAM_FENCE() ((void) 0)
+#endif
+
+/*!
+ * @brief Non-temporal memory copy.
+ *
+ * This  function copies `size` bytes from `source`  to
+ * `destination`,    the   regions   not   overlapping,
+ * streaming   every  16-byte  aligned  chunk  of   the
+ * destination  and copying the unaligned head and tail
+ * through      the     cache.     It     ends     with
+ * `REBOOT_STREAM_FENCE`,   the  copy  being   globally
+ * visible once it returns.
+ *
+ * It  is  only  worth it for copies exceeding  a  fair
+ * share  of  the last level cache, smaller ones  being
+ * better served by `memcpy`.
+ */
+static REBOOT_INLINE void
+reboot_stream_copy(void *destination, const void *source, size_t size)
+{
+   unsigned char       *to   = (unsigned char *) destination;
+   const unsigned char *from = (const unsigned char *) source;
+   size_t               head = (size_t) (0u - (uintptr_t) to) & 15u;
+
+   if (head > size) {
+      head = size;
+   }
+
+   memcpy(to, from, head);
+
+   to   += head;
+   from += head;
+   size -= head;
+
+   for (; size >= 16u; to += 16, from += 16, size -= 16u) {
+      REBOOT_STREAM_STORE(to, from);
+   }
+
+   memcpy(to, from, size);
+
+   REBOOT_STREAM_FENCE();
+}
+
+/*! @} <!-- }}} Non-temporal stores --> */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __REBOOT_PREFETCH_H__ */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
@@ -0,0 +1,212 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+/*!
+ * @file  preprocessor/environment.cppm
+ * @brief Build environment module interface.
+ *
+ * This         module        interface         exposes
+ * `preprocessor/environment.h`          as         the
+ * `reboot.environment`  C++20  module. Macros  do  not
+ * cross  named module boundaries, every value detected
+ * by  the environment headers is therefore exported as
+ * a     `constexpr`    equivalent    instead,    under
+ * `reboot::environment` :
+ *
+ * - `standard`     : `cpp`,  the `cpp*` version  flags
+ *                    and the optional features.
+ * - `compiler`     : `name` and `version`.
+ * - `architecture` : `name`,    `isa`,   `simd_width`,
+ *                    `cache_line_size`             and
+ *                    `atomic_lock_free`.
+ * - `os`           : `name`.
+ * - `snapshot`     : The        `reboot_environment_t`
+ *                    snapshot itself.
+ * - `features`     : `reboot_cpu_features`,        the
+ *                    runtime probe.
+ *
+ * Importing  the  module  rather  than  including  the
+ * header  spares each translation unit from lexing the
+ * whole  environment again. Code relying on the macros
+ * themselves keeps including the header, or imports it
+ * as a header unit, which does export them :
+ *
+ *     import "preprocessor/environment.h";
+ *
+ * The  values  reflect the flags the module  interface
+ * was  compiled with, which must therefore match those
+ * of  its importers, as compilers already require  for
+ * the interface to be importable at all.
+ */
+
+module;
+
+#include "preprocessor/environment.h"
+
+export module reboot.environment;
+
+export namespace reboot::environment {
+
+/*! <!-- Standard {{{ -->
+ * @addtogroup  environment_module_standard Standard
+ * @brief `REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_*` equivalents
+ * @{
+ */
+namespace standard {
+
+inline constexpr long cpp = REBOOT_ENVIRONMENT_CPP_;
+
+inline constexpr bool cpp11 =
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP11
+   true;
+#else
+   false;
+#endif
+
+inline constexpr bool cpp14 =
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP14
+   true;
+#else
+   false;
+#endif
+
+inline constexpr bool cpp17 =
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP17
+   true;
+#else
+   false;
+#endif
+
+inline constexpr bool cpp20 =
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP20
+   true;
+#else
+   false;
+#endif
+
+inline constexpr bool cpp23 =
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP23
+   true;
+#else
+   false;
+#endif
+
+inline constexpr bool has_atomics =
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_ATOMICS
+   true;
+#else
+   false;
+#endif
+
+inline constexpr bool has_threads =
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_THREADS
+   true;
+#else
+   false;
+#endif
+
+inline constexpr bool has_consteval =
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_CONSTEVAL
+   true;
+#else
+   false;
+#endif
+
+inline constexpr bool has_coroutines =
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_COROUTINES
+   true;
+#else
+   false;
+#endif
+
+inline constexpr bool has_assume_aligned =
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_ASSUME_ALIGNED
+   true;
+#else
+   false;
+#endif
+
+inline constexpr bool has_no_unique_address =
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_NO_UNIQUE_ADDRESS
+   true;
+#else
+   false;
+#endif
+
+} /*! @} <!-- }}} Standard --> */
+
+/*! <!-- Compiler {{{ -->
+ * @addtogroup  environment_module_compiler Compiler
+ * @brief `REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_*` equivalents
+ * @{
+ */
+namespace compiler {
+
+inline constexpr const char *name    = REBOOT_ENVIRONMENT_COMPILER_;
+inline constexpr long        version = REBOOT_ENVIRONMENT_COMPILER_VERSION_;
+
+} /*! @} <!-- }}} Compiler --> */
+
+/*! <!-- Architecture {{{ -->
+ * @addtogroup  environment_module_architecture Architecture
+ * @brief `REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_*` equivalents
+ * @{
+ */
+namespace architecture {
+
+inline constexpr const char           *name = REBOOT_ENVIRONMENT_ARCHITECTURE_;
+inline constexpr reboot_cpu_features_t isa  = REBOOT_CPU_BASELINE;
+
+inline constexpr unsigned simd_width
+   = REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_SIMD_WIDTH;
+inline constexpr unsigned cache_line_size
+   = REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_CACHE_LINE_SIZE;
+
+inline constexpr unsigned char atomic_lock_free[5] = {
+   REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_8_LOCK_FREE,
+   REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_16_LOCK_FREE,
+   REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_32_LOCK_FREE,
+   REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_64_LOCK_FREE,
+   REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_128_LOCK_FREE,
+};
+
+} /*! @} <!-- }}} Architecture --> */
+
+/*! <!-- Operating system {{{ -->
+ * @addtogroup  environment_module_os Operating system
+ * @brief `REBOOT_PREPROCESSOR_ENVIRONMENT_OS_*` equivalents
+ * @{
+ */
+namespace os {
+
+inline constexpr const char *name = REBOOT_ENVIRONMENT_OS_;
+
+} /*! @} <!-- }}} Operating system --> */
+
+/*!
+ * The  snapshot is rebuilt from its initializer  since
+ * `reboot_environment`  has internal linkage, which an
+ * exported declaration cannot expose.
+ */
+using snapshot_t = ::reboot_environment_t;
+
+inline constexpr snapshot_t snapshot = REBOOT_ENVIRONMENT_INITIALIZER;
+
+using features_t = ::reboot_cpu_features_t;
+
+inline features_t
+features() noexcept
+{
+   return ::reboot_cpu_features();
+}
+
+}
+
+/* vim: set ft=cpp et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
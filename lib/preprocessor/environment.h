@@ -0,0 +1,282 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+#ifndef __REBOOT_PREPROCESSOR_ENVIRONMENT_H__
+#define __REBOOT_PREPROCESSOR_ENVIRONMENT_H__
+
+/*!
+ * @file  preprocessor/environment.h
+ * @brief Build environment snapshot.
+ *
+ * This          header         includes          every
+ * `preprocessor/environment/`  header  and folds  what
+ * they  detected  into a  single  `reboot_environment`
+ * object,   which   saves  runtime   dispatchers   and
+ * telemetry  from  expanding  the very  same  `#ifdef`
+ * chains over and over :
+ *
+ * - `c`                : `STANDARD_C`, `0` in C++.
+ * - `cpp`              : `STANDARD_CPP`, `0` in C.
+ * - `compiler`         : Compiler name.
+ * - `compiler_version` : Compiler  version, encoded as
+ *                        `MMmmpp`   except  for   MSVC
+ *                        which reports `_MSC_VER`.
+ * - `architecture`     : Architecture name.
+ * - `os`               : Operating system name.
+ * - `isa`              : `REBOOT_CPU_BASELINE`.
+ * - `simd_width`       : `SIMD_WIDTH`.
+ * - `cache_line_size`  : `CACHE_LINE_SIZE`.
+ * - `atomic_lock_free` : `ATOMIC_8_LOCK_FREE`  through
+ *                        `ATOMIC_128_LOCK_FREE`,    in
+ *                        that order.
+ *
+ * The  object  is  `static  const` in  C  and  `static
+ * constexpr` in C++, each translation unit holding its
+ * own  copy describing the flags it was compiled with.
+ * Comparing   `isa`  against   `reboot_cpu_features()`
+ * tells how much of the host goes unused by the build.
+ *
+ * `reboot_environment_format`  renders the object on a
+ * single  line meant to be logged at startup, so  that
+ * performance  regressions  can be tied to  the  build
+ * environment that produced them.
+ *
+ * This  header  is  also  fit to  be  precompiled.  It
+ * depends   on  nothing  but  predefined  macros   and
+ * `REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_CACHE_LINE_SIZE`,
+ * which  must  then be overridden on the command  line
+ * rather than in the source.
+ *
+ * C++20  builds  may import  the  `reboot.environment`
+ * module          instead,         built          from
+ * `preprocessor/environment.cppm`,  which exports  the
+ * very same values as `constexpr` variables.
+ */
+
+#include <stddef.h>
+
+#include "preprocessor/environment/standard.h"
+#include "preprocessor/environment/architecture.h"
+#include "preprocessor/environment/compiler.h"
+#include "preprocessor/environment/os.h"
+#include "preprocessor/environment/cpu.h"
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_AT_LEAST_C99)        \
+ || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP11)
+#  include <stdio.h>
+#  define REBOOT_ENVIRONMENT_HAS_FORMAT_
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! <!-- Names {{{ -->
+ * @addtogroup  environment_names Names
+ * @brief Human readable names of the detected environment
+ * @{
+ */
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_C
+#  define REBOOT_ENVIRONMENT_C_ REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_C
+#else
+#  define REBOOT_ENVIRONMENT_C_ 0L
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP
+#  define REBOOT_ENVIRONMENT_CPP_ REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP
+#else
+#  define REBOOT_ENVIRONMENT_CPP_ 0L
+#endif
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_CLANG)
+#  define REBOOT_ENVIRONMENT_COMPILER_ "clang"
+#  define REBOOT_ENVIRONMENT_COMPILER_VERSION_                                \
+      REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_CLANG
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_INTEL)
+#  define REBOOT_ENVIRONMENT_COMPILER_ "intel"
+#  define REBOOT_ENVIRONMENT_COMPILER_VERSION_                                \
+      REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_INTEL
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)
+#  define REBOOT_ENVIRONMENT_COMPILER_ "msvc"
+#  define REBOOT_ENVIRONMENT_COMPILER_VERSION_                                \
+      REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_MSVC
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GCC)
+#  define REBOOT_ENVIRONMENT_COMPILER_ "gcc"
+#  define REBOOT_ENVIRONMENT_COMPILER_VERSION_                                \
+      REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_GCC
+#else
+#  define REBOOT_ENVIRONMENT_COMPILER_ "unknown"
+#  define REBOOT_ENVIRONMENT_COMPILER_VERSION_ 0
+#endif
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86_64)
+#  define REBOOT_ENVIRONMENT_ARCHITECTURE_ "x86_64"
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86_32)
+#  define REBOOT_ENVIRONMENT_ARCHITECTURE_ "x86"
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM64)
+#  define REBOOT_ENVIRONMENT_ARCHITECTURE_ "arm64"
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM32)
+#  define REBOOT_ENVIRONMENT_ARCHITECTURE_ "arm"
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_POWERPC64)
+#  define REBOOT_ENVIRONMENT_ARCHITECTURE_ "ppc64"
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_POWERPC)
+#  define REBOOT_ENVIRONMENT_ARCHITECTURE_ "ppc"
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_S390X)
+#  define REBOOT_ENVIRONMENT_ARCHITECTURE_ "s390x"
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_S390)
+#  define REBOOT_ENVIRONMENT_ARCHITECTURE_ "s390"
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_RISCV64)
+#  define REBOOT_ENVIRONMENT_ARCHITECTURE_ "riscv64"
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_RISCV)
+#  define REBOOT_ENVIRONMENT_ARCHITECTURE_ "riscv"
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_MIPS64)
+#  define REBOOT_ENVIRONMENT_ARCHITECTURE_ "mips64"
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_MIPS)
+#  define REBOOT_ENVIRONMENT_ARCHITECTURE_ "mips"
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_WASM)
+#  define REBOOT_ENVIRONMENT_ARCHITECTURE_ "wasm"
+#else
+#  define REBOOT_ENVIRONMENT_ARCHITECTURE_ "unknown"
+#endif
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_ANDROID)
+#  define REBOOT_ENVIRONMENT_OS_ "android"
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_LINUX)
+#  define REBOOT_ENVIRONMENT_OS_ "linux"
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_IOS)
+#  define REBOOT_ENVIRONMENT_OS_ "ios"
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MACOS)
+#  define REBOOT_ENVIRONMENT_OS_ "macos"
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_FREEBSD)
+#  define REBOOT_ENVIRONMENT_OS_ "freebsd"
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_NETBSD)
+#  define REBOOT_ENVIRONMENT_OS_ "netbsd"
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_OPENBSD)
+#  define REBOOT_ENVIRONMENT_OS_ "openbsd"
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_DRAGONFLY)
+#  define REBOOT_ENVIRONMENT_OS_ "dragonfly"
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_SOLARIS)
+#  define REBOOT_ENVIRONMENT_OS_ "solaris"
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_CYGWIN)
+#  define REBOOT_ENVIRONMENT_OS_ "cygwin"
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+#  define REBOOT_ENVIRONMENT_OS_ "windows"
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WASI)
+#  define REBOOT_ENVIRONMENT_OS_ "wasi"
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_UNIX)
+#  define REBOOT_ENVIRONMENT_OS_ "unix"
+#else
+#  define REBOOT_ENVIRONMENT_OS_ "unknown"
+#endif
+
+/*! @} <!-- }}} Names --> */
+
+/*! <!-- Snapshot {{{ -->
+ * @addtogroup  environment_snapshot Snapshot
+ * @brief Build environment snapshot object
+ *
+ * GCC  warns about unused `static const` objects in C,
+ * hence   the   attribute,  whereas  namespace   scope
+ * `constexpr` objects are exempt in C++.
+ * @{
+ */
+
+typedef struct reboot_environment {
+   long                  c;
+   long                  cpp;
+   const char           *compiler;
+   long                  compiler_version;
+   const char           *architecture;
+   const char           *os;
+   reboot_cpu_features_t isa;
+   unsigned              simd_width;
+   unsigned              cache_line_size;
+   unsigned char         atomic_lock_free[5];
+} reboot_environment_t;
+
+#define REBOOT_ENVIRONMENT_INITIALIZER                                        \
+   {                                                                          \
+      REBOOT_ENVIRONMENT_C_,                                                  \
+      REBOOT_ENVIRONMENT_CPP_,                                                \
+      REBOOT_ENVIRONMENT_COMPILER_,                                           \
+      REBOOT_ENVIRONMENT_COMPILER_VERSION_,                                   \
+      REBOOT_ENVIRONMENT_ARCHITECTURE_,                                       \
+      REBOOT_ENVIRONMENT_OS_,                                                 \
+      REBOOT_CPU_BASELINE,                                                    \
+      REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_SIMD_WIDTH,                \
+      REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_CACHE_LINE_SIZE,           \
+      {                                                                       \
+         REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_8_LOCK_FREE,     \
+         REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_16_LOCK_FREE,    \
+         REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_32_LOCK_FREE,    \
+         REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_64_LOCK_FREE,    \
+         REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_128_LOCK_FREE    \
+      }                                                                       \
+   }
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP11)
+static constexpr reboot_environment_t reboot_environment
+   = REBOOT_ENVIRONMENT_INITIALIZER;
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)
+static const reboot_environment_t reboot_environment __attribute__((__unused__))
+   = REBOOT_ENVIRONMENT_INITIALIZER;
+#else
+static const reboot_environment_t reboot_environment
+   = REBOOT_ENVIRONMENT_INITIALIZER;
+#endif
+
+/*! @} <!-- }}} Snapshot --> */
+
+#if defined(REBOOT_ENVIRONMENT_HAS_FORMAT_)
+
+/*!
+ * @brief Build environment rendering.
+ *
+ * This function renders `environment` into `buffer` as
+ * a  single line of space separated `key=value` pairs,
+ * truncated  to `size` bytes including the terminating
+ * null  character. It returns the length the  complete
+ * line would have had, as `snprintf` does.
+ */
+static REBOOT_INLINE int
+reboot_environment_format(
+   const reboot_environment_t *environment, char *buffer, size_t size
+) {
+   return snprintf(
+      buffer, size,
+      "c=%ld cpp=%ld compiler=%s-%ld architecture=%s os=%s isa=0x%llx"
+      " simd=%u cache_line=%u lock_free=%u,%u,%u,%u,%u",
+      environment->c,
+      environment->cpp,
+      environment->compiler,
+      environment->compiler_version,
+      environment->architecture,
+      environment->os,
+      (unsigned long long) environment->isa,
+      environment->simd_width,
+      environment->cache_line_size,
+      (unsigned) environment->atomic_lock_free[0],
+      (unsigned) environment->atomic_lock_free[1],
+      (unsigned) environment->atomic_lock_free[2],
+      (unsigned) environment->atomic_lock_free[3],
+      (unsigned) environment->atomic_lock_free[4]
+   );
+}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __REBOOT_PREPROCESSOR_ENVIRONMENT_H__ */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
@@ -0,0 +1,630 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+#ifdef REBOOT_USE_GENERATED_CONFIG
+#  include "reboot_config.h"
+#endif
+
+#ifndef __REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_H__
+#define __REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_H__
+
+/*!
+ * @file  preprocessor/environment/architecture.h
+ * @brief Target architecture preprocessor directives.
+ *
+ * This  header  provides preprocessor  directives  for
+ * dealing  with  predefined macros pertaining  to  the
+ * targeted  processor architecture and the instruction
+ * set  extensions the compiler was allowed to emit. In
+ * short,  including  this  file answers  the  question
+ * “What are we compiling for ?”. As with its siblings,
+ * this is a best effort at reconciling the many vendor
+ * specific spellings into a single, readily usable set
+ * of macros.
+ *
+ * These  preprocessor directives are listed hereafter,
+ * assuming  the  following prefix local to  this  file
+ * `REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_` :
+ *
+ * - `HAS_X86`     : x86 family, either `HAS_X86_32` or
+ *                   `HAS_X86_64`.
+ * - `HAS_ARM`     : ARM  family, either `HAS_ARM32` or
+ *                   `HAS_ARM64`.
+ * - `HAS_POWERPC` : POWER  family, `HAS_POWERPC64`  if
+ *                   64-bit.
+ * - `HAS_S390`    : z/Architecture,   `HAS_S390X`   if
+ *                   64-bit.
+ * - `HAS_RISCV`   : RISC-V  family,  `HAS_RISCV64`  if
+ *                   64-bit.
+ * - `HAS_MIPS`    : MIPS   family,   `HAS_MIPS64`   if
+ *                   64-bit.
+ * - `HAS_WASM`    : WebAssembly.
+ *
+ * `ENDIAN_LITTLE`  and `ENDIAN_BIG` describe the  byte
+ * order  of  the  target, at most one  of  them  being
+ * defined and neither on mixed-endian ones.
+ *
+ * If  defined,  the following means the  compiler  was
+ * allowed  to  emit instructions from  the  respective
+ * extension,   either  through  an  explicit  flag  or
+ * because  the  extension is mandated by the  targeted
+ * baseline :
+ *
+ * - x86     : `HAS_SSE`,    `HAS_SSE2`,    `HAS_SSE3`,
+ *             `HAS_SSSE3`, `HAS_SSE4_1`, `HAS_SSE4_2`,
+ *             `HAS_AVX`,   `HAS_AVX2`,  `HAS_AVX512F`,
+ *             `HAS_AVX512BW`,          `HAS_AVX512CD`,
+ *             `HAS_AVX512DQ`,          `HAS_AVX512VL`,
+ *             `HAS_POPCNT`,  `HAS_LZCNT`,  `HAS_BMI1`,
+ *             `HAS_BMI2`, `HAS_FMA`, `HAS_PCLMUL`
+ * - ARM     : `HAS_NEON`,    `HAS_SVE`,    `HAS_SVE2`,
+ *             `HAS_CRC32`, `HAS_PMULL`
+ * - POWER   : `HAS_ALTIVEC`, `HAS_VSX`
+ * - s390x   : `HAS_ZVECTOR`
+ * - RISC-V  : `HAS_RVV`
+ * - Wasm    : `HAS_SIMD128`
+ *
+ * Every  extension  implies the ones it is a  superset
+ * of,   e.g.  `HAS_AVX2`  implies  `HAS_AVX`  down  to
+ * `HAS_SSE`,   regardless  of  whether  the   compiler
+ * bothered  to  define  the  corresponding  predefined
+ * macro.  This is notably not the case for MSVC, which
+ * only  ever reports the `/arch` level it was  invoked
+ * with.
+ *
+ * `SIMD_WIDTH`  holds  the  width, in  bytes,  of  the
+ * widest  vector  register available for  the  current
+ * target, or `0` if there is none.
+ *
+ * `CACHE_LINE_SIZE`  holds the size, in bytes, of  the
+ * coherency  unit  to pad shared data to in  order  to
+ * avoid false sharing.
+ *
+ * Finally,         `ATOMIC_8_LOCK_FREE`        through
+ * `ATOMIC_128_LOCK_FREE`   describe   whether   atomic
+ * operations  on  objects of the respective width,  in
+ * bits, are lock-free, following the convention of the
+ * standard `ATOMIC_*_LOCK_FREE` macros.
+ *
+ * Keep  in  mind that these macros only describe  what
+ * the  build flags allow and not what the host running
+ * the      resulting     binary     supports.      See
+ * `preprocessor/environment/cpu.h` for the latter.
+ *
+ * Sources :
+ *
+ * - https://sourceforge.net/p/predef/wiki/Architectures/
+ * - https://docs.microsoft.com/en-us/cpp/preprocessor/predefined-macros
+ * - https://docs.microsoft.com/en-us/cpp/build/reference/arch-x86
+ * - https://docs.microsoft.com/en-us/cpp/build/reference/arch-x64
+ * - https://developer.arm.com/documentation/101028/latest/
+ * - https://github.com/riscv-non-isa/riscv-c-api-doc
+ * - https://gcc.gnu.org/onlinedocs/gcc/x86-Options.html
+ * - https://gcc.gnu.org/onlinedocs/gcc/RS_002f6000-and-PowerPC-Options.html
+ * - https://gcc.gnu.org/onlinedocs/gcc/S_002f390-and-zSeries-Options.html
+ * - https://gcc.gnu.org/onlinedocs/gcc/_005f_005fsync-Builtins.html
+ * - https://docs.microsoft.com/en-us/cpp/intrinsics/interlockedcompareexchange128
+ * - Extensive compiler flag testing
+ */
+
+/*! <!-- Architecture family {{{ -->
+ * @addtogroup  architecture_family Architecture family
+ * @brief Target architecture family detection macros
+ *
+ * This   section  identifies  the  targeted  processor
+ * family.  At  most one family is ever defined,  along
+ * with its bitness specific variant.
+ * @{
+ */
+
+#if defined(__x86_64__) || defined(__x86_64) || defined(__amd64__)            \
+ || defined(__amd64)    || ((defined(_M_X64) || defined(_M_AMD64))            \
+                            && !defined(_M_ARM64EC))
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86_64
+
+#elif defined(__i386__) || defined(__i386) || defined(_M_IX86)                \
+   || defined(__X86__)  || defined(_X86_)  || defined(__I86__)                \
+   || defined(__THW_INTEL__) || defined(__INTEL__) || defined(__386)
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86_32
+
+/*!
+ * ARM64EC   is   an   ABI  allowing  ARM64   code   to
+ * interoperate  with  emulated x64 code. The  compiler
+ * defines  `_M_X64` for source compatibility but emits
+ * ARM64 instructions, hence the exclusion above.
+ */
+#elif defined(__aarch64__) || defined(__arm64__) || defined(__arm64)          \
+   || defined(_M_ARM64)    || defined(_M_ARM64EC)
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM64
+
+#elif defined(__arm__) || defined(__arm) || defined(__thumb__)                \
+   || defined(_M_ARM)  || defined(_ARM)
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM32
+
+#elif defined(__powerpc64__) || defined(__ppc64__) || defined(__PPC64__)      \
+   || defined(_ARCH_PPC64)
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_POWERPC
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_POWERPC64
+
+#elif defined(__powerpc__) || defined(__powerpc) || defined(__ppc__)          \
+   || defined(__PPC__)     || defined(_ARCH_PPC) || defined(_M_PPC)
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_POWERPC
+
+#elif defined(__s390x__)
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_S390
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_S390X
+
+#elif defined(__s390__)
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_S390
+
+#elif defined(__riscv)
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_RISCV
+
+#  if defined(__riscv_xlen) && (__riscv_xlen == 64)
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_RISCV64
+#  endif
+
+#elif defined(__mips__) || defined(__mips) || defined(_M_MRX000)
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_MIPS
+
+#  if defined(__mips64) || defined(_MIPS_ARCH_MIPS64)
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_MIPS64
+#  endif
+
+#elif defined(__wasm__) || defined(__wasm32__) || defined(__wasm64__)
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_WASM
+
+#else
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_UNKNOWN
+
+#endif /*! @} <!-- }}} Architecture family --> */
+
+/*! <!-- Byte order {{{ -->
+ * @addtogroup  architecture_endian Byte order
+ * @brief Target byte order detection macros
+ *
+ * This  section  identifies  the order  in  which  the
+ * target  stores the bytes of multi-byte integers. GCC
+ * and  Clang report it through `__BYTE_ORDER__`, which
+ * is trusted whenever defined. The remaining compilers
+ * are recognized from their family specific spellings,
+ * MSVC  only  ever targeting little-endian  processors
+ * but   for  the  Xbox  360,  which  is  reported   as
+ * big-endian.
+ *
+ * Either  macro may be defined beforehand for  targets
+ * none of these spellings account for.
+ * @{
+ */
+
+#if !defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ENDIAN_LITTLE)      \
+ && !defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ENDIAN_BIG)
+
+#  if defined(__BYTE_ORDER__)
+
+#     if defined(__ORDER_LITTLE_ENDIAN__)                                     \
+      && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#        define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ENDIAN_LITTLE
+#     elif defined(__ORDER_BIG_ENDIAN__)                                      \
+        && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#        define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ENDIAN_BIG
+#     endif
+
+#  elif defined(__LITTLE_ENDIAN__) || defined(__ARMEL__)                      \
+     || defined(__THUMBEL__)     || defined(__AARCH64EL__)                    \
+     || defined(__MIPSEL__)      || defined(_MIPSEL)                          \
+     || defined(_M_ARM)          || defined(_M_ARM64)                         \
+     || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86)         \
+     || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_WASM)
+
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ENDIAN_LITTLE
+
+#  elif defined(__BIG_ENDIAN__) || defined(__ARMEB__)                         \
+     || defined(__THUMBEB__)  || defined(__AARCH64EB__)                       \
+     || defined(__MIPSEB__)   || defined(_MIPSEB)                             \
+     || defined(_M_PPC)                                                       \
+     || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_S390)
+
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ENDIAN_BIG
+
+#  endif
+
+#endif /*! @} <!-- }}} Byte order --> */
+
+/*! <!-- x86 extensions {{{ -->
+ * @addtogroup  architecture_x86 x86 extensions
+ * @brief x86 instruction set extension detection macros
+ *
+ * GCC,  Clang  and  ICC  define a  macro  per  enabled
+ * extension  and  imply the lower  levels  themselves.
+ * MSVC,  on  the other hand, only  defines  `__AVX__`,
+ * `__AVX2__`  and  the  `__AVX512*__`  family  through
+ * `/arch`, and otherwise exposes the SSE level through
+ * `_M_IX86_FP`  on 32-bit targets only, x64  mandating
+ * SSE2.  The extensions are therefore walked from  the
+ * highest  down so that each level can imply the  ones
+ * below it.
+ * @{
+ */
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86
+
+#  ifdef __AVX512BW__
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX512BW
+#  endif
+
+#  ifdef __AVX512CD__
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX512CD
+#  endif
+
+#  ifdef __AVX512DQ__
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX512DQ
+#  endif
+
+#  ifdef __AVX512VL__
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX512VL
+#  endif
+
+/*!
+ * Every  AVX-512  subset is an extension  of  AVX-512F
+ * and requires it.
+ */
+#  if defined(__AVX512F__)                                                    \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX512BW)      \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX512CD)      \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX512DQ)      \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX512VL)
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX512F
+#  endif
+
+#  if defined(__AVX2__)                                                       \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX512F)
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX2
+#  endif
+
+#  if defined(__AVX__)                                                        \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX2)
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX
+#  endif
+
+#  if defined(__SSE4_2__)                                                     \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX)
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SSE4_2
+#  endif
+
+/*!
+ * The  bit manipulation extensions are not part of the
+ * SSE/AVX  lineage  and are only implied  where  every
+ * known  implementation  provides them :  POPCNT  with
+ * SSE4.2  and, on MSVC, BMI1, BMI2, LZCNT and FMA with
+ * `/arch:AVX2` as documented.
+ */
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX2)          \
+   && defined(_MSC_VER) && !defined(__clang__)
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_BMI1
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_BMI2
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_LZCNT
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_FMA
+#  endif
+
+#  ifdef __BMI__
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_BMI1
+#  endif
+
+#  ifdef __BMI2__
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_BMI2
+#  endif
+
+#  ifdef __LZCNT__
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_LZCNT
+#  endif
+
+#  ifdef __FMA__
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_FMA
+#  endif
+
+/*!
+ * Carry-less multiplication is not implied either, and
+ * MSVC has no way of reporting it.
+ */
+#  ifdef __PCLMUL__
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_PCLMUL
+#  endif
+
+#  if defined(__POPCNT__)                                                     \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SSE4_2)
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_POPCNT
+#  endif
+
+#  if defined(__SSE4_1__)                                                     \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SSE4_2)
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SSE4_1
+#  endif
+
+#  if defined(__SSSE3__)                                                      \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SSE4_1)
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SSSE3
+#  endif
+
+#  if defined(__SSE3__)                                                       \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SSSE3)
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SSE3
+#  endif
+
+#  if defined(__SSE2__)                                                       \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SSE3)          \
+   || (defined(_M_X64) || defined(_M_AMD64))                                  \
+   || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SSE2
+#  endif
+
+#  if defined(__SSE__)                                                        \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SSE2)          \
+   || (defined(_M_IX86_FP) && (_M_IX86_FP >= 1))
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SSE
+#  endif
+
+#endif /*! @} <!-- }}} x86 extensions --> */
+
+/*! <!-- ARM extensions {{{ -->
+ * @addtogroup  architecture_arm ARM extensions
+ * @brief ARM instruction set extension detection macros
+ *
+ * Advanced  SIMD is mandatory on AArch64 but may still
+ * be  disabled by the likes of  `-mgeneral-regs-only`,
+ * in which case `__ARM_NEON` is left undefined and the
+ * intrinsics   are  unusable.  It  is  therefore  only
+ * assumed  on  MSVC,  which  has no  such  switch  and
+ * requires NEON on every Windows on ARM target.
+ * @{
+ */
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM
+
+#  ifdef __ARM_FEATURE_SVE2
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SVE2
+#  endif
+
+#  if defined(__ARM_FEATURE_SVE)                                              \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SVE2)
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SVE
+#  endif
+
+#  if defined(__ARM_NEON) || defined(__ARM_NEON__)                            \
+   || defined(_M_ARM64)   || defined(_M_ARM64EC) || defined(_M_ARM)
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_NEON
+#  endif
+
+/*!
+ * The  CRC32 instructions are optional in ARMv8.0  and
+ * mandatory  from  ARMv8.1  on, which Windows  on  ARM
+ * requires.  The  64-bit polynomial multiplication  of
+ * PMULL   comes  with  the  cryptographic   extension,
+ * reported  as `__ARM_FEATURE_AES` by recent compilers
+ * and as part of `__ARM_FEATURE_CRYPTO` before.
+ */
+#  if defined(__ARM_FEATURE_CRC32) || defined(_M_ARM64)                       \
+   || defined(_M_ARM64EC)
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_CRC32
+#  endif
+
+#  if (defined(__ARM_FEATURE_AES) || defined(__ARM_FEATURE_CRYPTO))           \
+   && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_NEON)
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_PMULL
+#  endif
+
+#endif /*! @} <!-- }}} ARM extensions --> */
+
+/*! <!-- Other extensions {{{ -->
+ * @addtogroup  architecture_other Other extensions
+ * @brief Remaining vector extension detection macros
+ *
+ * RISC-V  vector support used to be advertised through
+ * `__riscv_vector`   before  the  C  API  settled   on
+ * `__riscv_v`, which holds the version of the ratified
+ * extension. Both are accepted.
+ * @{
+ */
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_POWERPC
+
+#  ifdef __VSX__
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_VSX
+#  endif
+
+#  if defined(__ALTIVEC__)                                                    \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_VSX)
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ALTIVEC
+#  endif
+
+#endif
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_S390)            \
+ && defined(__VX__)
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ZVECTOR
+#endif
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_RISCV)           \
+ && (defined(__riscv_v) || defined(__riscv_vector))
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_RVV
+#endif
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_WASM)            \
+ && defined(__wasm_simd128__)
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SIMD128
+#endif
+
+/*! @} <!-- }}} Other extensions --> */
+
+/*! <!-- SIMD width {{{ -->
+ *
+ * @def   REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_SIMD_WIDTH
+ * @brief Widest vector register width, in bytes.
+ *
+ * This  macro holds the width of the widest fixed-size
+ * vector  register  the compiler was allowed  to  use.
+ * Scalable  extensions  such  as SVE and RVV  have  no
+ * compile-time  width  and are accounted  for  through
+ * their fixed-size counterpart, if any.
+ */
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX512F)
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_SIMD_WIDTH 64
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX)
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_SIMD_WIDTH 32
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SSE)           \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_NEON)          \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ALTIVEC)       \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ZVECTOR)       \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SIMD128)
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_SIMD_WIDTH 16
+#else
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_SIMD_WIDTH 0
+#endif /* <!-- }}} SIMD width --> */
+
+/*! <!-- Cache line size {{{ -->
+ *
+ * @def   REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_CACHE_LINE_SIZE
+ * @brief Cache line size, in bytes.
+ *
+ * This  macro  holds  the size of the unit  the  cache
+ * coherency protocol operates on, i.e. the granularity
+ * at  which  writes from distinct cores  contend  with
+ * each   other.  It  is  meant  to  size  padding  and
+ * alignment of data shared between threads.
+ *
+ * The values hereafter are the largest found among the
+ * implementations of each family since the actual host
+ * is  unknown  at compile time, overestimating  merely
+ * wasting    a   few   bytes   where   underestimating
+ * reintroduces false sharing :
+ *
+ * - x86     : 64 bytes.
+ * - AArch64 : 128  bytes,  Apple  M-series  cores  use
+ *             128-byte  lines and Neoverse cores fetch
+ *             64-byte lines in pairs.
+ * - ARM     : 64 bytes.
+ * - POWER   : 128 bytes.
+ * - s390x   : 256 bytes, starting with the z10.
+ * - Others  : 64 bytes.
+ *
+ * The  value  may be overridden by defining the  macro
+ * beforehand,  e.g.  from a value probed at  configure
+ * time.
+ */
+#ifndef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_CACHE_LINE_SIZE
+
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM64)         \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_POWERPC)
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_CACHE_LINE_SIZE 128
+#  elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_S390)
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_CACHE_LINE_SIZE 256
+#  else
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_CACHE_LINE_SIZE 64
+#  endif
+
+#endif /* <!-- }}} Cache line size --> */
+
+/*! <!-- Lock-free atomics {{{ -->
+ * @addtogroup  architecture_atomics Lock-free atomics
+ * @brief Lock-free atomic operation widths
+ *
+ * The           `ATOMIC_8_LOCK_FREE`           through
+ * `ATOMIC_128_LOCK_FREE`  macros hold `0` when  atomic
+ * operations   of  the  respective  width  are   never
+ * lock-free, `1` when they sometimes are, depending on
+ * the host, and `2` when they always are.
+ *
+ * They are derived from the `__GCC_ATOMIC_*_LOCK_FREE`
+ * macros predefined by GNU compatible compilers, which
+ * hold  the very values `<stdatomic.h>` and `<atomic>`
+ * report,   thus  sparing  the  inclusion  of  either.
+ * `char`,  `short`, `int` and `long long` are  assumed
+ * to be respectively 8, 16, 32 and 64 bits wide.
+ *
+ * There    is    no    standard    128-bit    integer,
+ * `ATOMIC_128_LOCK_FREE`  therefore reports whether  a
+ * native  double-width  compare-and-swap is  available
+ * instead,  i.e. `cmpxchg16b` on x86-64 or `casp`  and
+ * `ldxp`/`stxp`  on  AArch64. It is reachable  through
+ * the          `__sync`         builtins          when
+ * `__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16`   is  defined,
+ * e.g.       with      `-mcx16`,      and      through
+ * `_InterlockedCompareExchange128` on MSVC.
+ *
+ * Compilers providing none of the above are assumed to
+ * provide no lock-free atomics at all.
+ * @{
+ */
+
+#if defined(__GCC_ATOMIC_INT_LOCK_FREE)
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_8_LOCK_FREE     \
+      __GCC_ATOMIC_CHAR_LOCK_FREE
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_16_LOCK_FREE    \
+      __GCC_ATOMIC_SHORT_LOCK_FREE
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_32_LOCK_FREE    \
+      __GCC_ATOMIC_INT_LOCK_FREE
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_64_LOCK_FREE    \
+      __GCC_ATOMIC_LLONG_LOCK_FREE
+
+#  ifdef __GCC_HAVE_SYNC_COMPARE_AND_SWAP_16
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_128_LOCK_FREE 2
+#  else
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_128_LOCK_FREE 0
+#  endif
+
+/*!
+ * Windows  requires `cmpxchg16b` on x64 since  Windows
+ * 8.1,  and  ARMv8 mandates exclusive  pair  accesses,
+ * hence   the   compare  exchange   intrinsics   being
+ * unconditionally lock-free there.
+ */
+#elif defined(_MSC_VER)                                                       \
+   && (  defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86)        \
+      || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM))
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_8_LOCK_FREE  2
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_16_LOCK_FREE 2
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_32_LOCK_FREE 2
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_64_LOCK_FREE 2
+
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86_64)        \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM64)
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_128_LOCK_FREE 2
+#  else
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_128_LOCK_FREE 0
+#  endif
+
+#else
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_8_LOCK_FREE   0
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_16_LOCK_FREE  0
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_32_LOCK_FREE  0
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_64_LOCK_FREE  0
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_ATOMIC_128_LOCK_FREE 0
+
+#endif /*! @} <!-- }}} Lock-free atomics --> */
+
+#endif /* __REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_H__ */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
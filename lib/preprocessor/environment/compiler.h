@@ -0,0 +1,710 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+#ifdef REBOOT_USE_GENERATED_CONFIG
+#  include "reboot_config.h"
+#endif
+
+#ifndef __REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_H__
+#define __REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_H__
+
+/*!
+ * @file  preprocessor/environment/compiler.h
+ * @brief Compiler preprocessor directives.
+ *
+ * This  header  provides preprocessor  directives  for
+ * dealing  with  predefined macros pertaining  to  the
+ * compiler  in  use, along with portable spellings  of
+ * the  vendor specific extensions built upon them.  In
+ * short, including this file answers the question “Who
+ * is compiling us and what can they do ?”.
+ *
+ * These  preprocessor directives are listed hereafter,
+ * assuming  the  following prefix local to  this  file
+ * `REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_` :
+ *
+ * - `HAS_GNUC`  : GNU    C    compatible    front-end,
+ *                 including   Clang   and  the   Intel
+ *                 compilers. `GNUC` holds the emulated
+ *                 GCC version.
+ * - `HAS_GCC`   : Genuine   GCC,   `GCC`   holds   its
+ *                 version.
+ * - `HAS_CLANG` : Clang, `CLANG` holds its version.
+ * - `HAS_INTEL` : Intel  C/C++  compilers, classic  or
+ *                 LLVM   based.   `INTEL`  holds   the
+ *                 version   of  the  classic  compiler
+ *                 only.
+ * - `HAS_MSVC`  : Genuine Microsoft Visual C++, `MSVC`
+ *                 holds  the value of `_MSC_VER`. Note
+ *                 that   `clang-cl`  is  reported   as
+ *                 `HAS_CLANG`.
+ *
+ * Capabilities   are  probed  through  the   following
+ * function-like  macros, which safely evaluate to  `0`
+ * on compilers lacking the underlying operator :
+ *
+ * - `HAS_BUILTIN(x)`       : `__has_builtin`.
+ * - `HAS_ATTRIBUTE(x)`     : `__has_attribute`.
+ * - `HAS_C_ATTRIBUTE(x)`   : `__has_c_attribute`.
+ * - `HAS_CPP_ATTRIBUTE(x)` : `__has_cpp_attribute`.
+ *
+ * The builtins and intrinsics the library depends upon
+ * are  then resolved once and for all, falling back to
+ * the first GCC version known to provide them :
+ *
+ * - `HAS_BUILTIN_EXPECT`
+ * - `HAS_BUILTIN_CLZ`, `HAS_BUILTIN_CTZ`
+ * - `HAS_BUILTIN_POPCOUNT`
+ * - `HAS_BUILTIN_BSWAP16`, `HAS_BUILTIN_BSWAP32`, `HAS_BUILTIN_BSWAP64`
+ * - `HAS_BUILTIN_PREFETCH`
+ * - `HAS_BUILTIN_UNREACHABLE`
+ * - `HAS_BUILTIN_ASSUME_ALIGNED`
+ * - `HAS_INTRINSIC_BITSCAN`, `HAS_INTRINSIC_BITSCAN64`
+ * - `HAS_INTRINSIC_BYTESWAP`
+ *
+ * Versions  are encoded as `MMmmpp`, i.e. major, minor
+ * and  patch  levels, except for MSVC keeping its  own
+ * `MMmm`  encoding.  Beware that Apple ships  its  own
+ * Clang  versioning scheme, unrelated to the  upstream
+ * one.
+ *
+ * The portable extensions are exposed with the shorter
+ * `REBOOT_`  prefix since they are meant to be spelled
+ * out in user code :
+ *
+ * - `REBOOT_ALIGNED(n)`      : Aligns to `n` bytes.
+ * - `REBOOT_CACHE_ALIGNED`   : Aligns to a cache line.
+ * - `REBOOT_LIKELY(x)`       : Likely condition hint.
+ * - `REBOOT_UNLIKELY(x)`     : Unlikely condition hint.
+ * - `REBOOT_LIKELY_BRANCH`   : Likely statement hint.
+ * - `REBOOT_UNLIKELY_BRANCH` : Unlikely statement hint.
+ * - `REBOOT_HOT`             : Hot function hint.
+ * - `REBOOT_COLD`            : Cold function hint.
+ * - `REBOOT_FLATTEN`         : Inlines every callee.
+ * - `REBOOT_NOINLINE`        : Prevents inlining.
+ * - `REBOOT_INLINE`          : Inline function specifier.
+ * - `REBOOT_ALWAYS_INLINE`   : Forced inline specifier.
+ * - `REBOOT_RESTRICT`        : Non-aliasing pointer.
+ * - `REBOOT_ASSUME(c)`       : Assumes `c` holds.
+ * - `REBOOT_ASSUME_ALIGNED`  : Assumes a pointer alignment.
+ * - `REBOOT_THREAD_LOCAL`    : Thread-local storage class.
+ *
+ * Sources :
+ *
+ * - https://sourceforge.net/p/predef/wiki/Compilers/
+ * - https://docs.microsoft.com/en-us/cpp/preprocessor/predefined-macros
+ * - https://gcc.gnu.org/onlinedocs/cpp/Common-Predefined-Macros.html
+ * - https://gcc.gnu.org/onlinedocs/gcc/Common-Variable-Attributes.html
+ * - https://clang.llvm.org/docs/LanguageExtensions.html
+ * - https://docs.microsoft.com/en-us/cpp/cpp/align-cpp
+ * - https://gcc.gnu.org/onlinedocs/gcc/Common-Function-Attributes.html
+ * - https://gcc.gnu.org/onlinedocs/gcc/Other-Builtins.html
+ * - https://gcc.gnu.org/onlinedocs/cpp/_005f_005fhas_005fbuiltin.html
+ * - https://docs.microsoft.com/en-us/cpp/intrinsics/bitscanforward-bitscanforward64
+ * - https://docs.microsoft.com/en-us/cpp/c-runtime-library/reference/byteswap-uint64-byteswap-ulong-byteswap-ushort
+ * - https://en.cppreference.com/w/cpp/language/attributes/likely
+ * - https://en.cppreference.com/w/c/language/restrict
+ * - https://docs.microsoft.com/en-us/cpp/intrinsics/assume
+ * - https://clang.llvm.org/docs/LanguageExtensions.html#builtin-assume
+ * - https://en.cppreference.com/w/cpp/language/attributes/assume
+ * - https://gcc.gnu.org/onlinedocs/gcc/Thread-Local.html
+ * - https://docs.microsoft.com/en-us/cpp/cpp/thread
+ */
+
+#include "preprocessor/environment/standard.h"
+#include "preprocessor/environment/architecture.h"
+
+/*! <!-- Compiler identification {{{ -->
+ * @addtogroup  compiler_identification Compiler identification
+ * @brief Compiler detection macros
+ *
+ * Most  compilers masquerade as another one, Clang and
+ * ICC  defining  `__GNUC__`  and  `clang-cl`  defining
+ * `_MSC_VER`.   The   most  specific   compilers   are
+ * therefore identified first.
+ * @{
+ */
+
+#define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_VERSION_(x, y, z)            \
+   ((x) * 10000 + (y) * 100 + (z))
+
+#ifdef __GNUC__
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC
+
+#  ifdef __GNUC_PATCHLEVEL__
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_GNUC                    \
+         REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_VERSION_(                   \
+            __GNUC__, __GNUC_MINOR__, __GNUC_PATCHLEVEL__                     \
+         )
+#  else
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_GNUC                    \
+         REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_VERSION_(                   \
+            __GNUC__, __GNUC_MINOR__, 0                                       \
+         )
+#  endif
+
+#endif
+
+#if defined(__INTEL_COMPILER) || defined(__ICC) || defined(__ICL)             \
+ || defined(__INTEL_LLVM_COMPILER)
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_INTEL
+
+#  ifdef __INTEL_COMPILER
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_INTEL                   \
+         REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_VERSION_(                   \
+            __INTEL_COMPILER / 100, __INTEL_COMPILER % 100, 0                 \
+         )
+#  endif
+
+#endif
+
+#if defined(__clang__)
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_CLANG
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_CLANG                      \
+      REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_VERSION_(                      \
+         __clang_major__, __clang_minor__, __clang_patchlevel__               \
+      )
+
+#elif defined(_MSC_VER)                                                       \
+   && !defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_INTEL)
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_MSVC _MSC_VER
+
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)              \
+   && !defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_INTEL)
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GCC
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_GCC                        \
+      REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_GNUC
+
+#endif
+
+/*! @} <!-- }}} Compiler identification --> */
+
+/*! <!-- Capability probing {{{ -->
+ * @addtogroup  compiler_probing Capability probing
+ * @brief Builtin, attribute and intrinsic detection macros
+ *
+ * The   `__has_*`  operators  cannot  be  tested   for
+ * existence  and  invoked  within the  same  directive
+ * since  a preprocessor unaware of them fails to parse
+ * the  invocation, hence the wrappers below which  are
+ * safe to use anywhere.
+ *
+ * Beware  that  GCC only gained  `__has_builtin`  with
+ * version 10, older versions needing the version based
+ * fallbacks hereafter.
+ * @{
+ */
+
+#ifdef __has_builtin
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN(x)             \
+      __has_builtin(x)
+#else
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN(x) 0
+#endif
+
+#ifdef __has_attribute
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_ATTRIBUTE(x)           \
+      __has_attribute(x)
+#else
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_ATTRIBUTE(x) 0
+#endif
+
+#ifdef __has_c_attribute
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_C_ATTRIBUTE(x)         \
+      __has_c_attribute(x)
+#else
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_C_ATTRIBUTE(x) 0
+#endif
+
+#if defined(__cplusplus) && defined(__has_cpp_attribute)
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_CPP_ATTRIBUTE(x)       \
+      __has_cpp_attribute(x)
+#else
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_CPP_ATTRIBUTE(x) 0
+#endif
+
+/*!
+ * `REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_GNUC_AT_LEAST_`
+ * is  internal  to this file and evaluates to  `0`  on
+ * compilers not emulating GCC.
+ */
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_GNUC_AT_LEAST_(x, y)       \
+      (REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_GNUC                          \
+         >= REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_VERSION_(x, y, 0))
+#else
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_GNUC_AT_LEAST_(x, y) 0
+#endif
+
+#if REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN(__builtin_expect)    \
+ || REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_GNUC_AT_LEAST_(3, 0)
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN_EXPECT
+#endif
+
+#if REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN(__builtin_clz)       \
+ || REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_GNUC_AT_LEAST_(3, 4)
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN_CLZ
+#endif
+
+#if REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN(__builtin_ctz)       \
+ || REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_GNUC_AT_LEAST_(3, 4)
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN_CTZ
+#endif
+
+#if REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN(__builtin_popcount)  \
+ || REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_GNUC_AT_LEAST_(3, 4)
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN_POPCOUNT
+#endif
+
+#if REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN(__builtin_bswap16)   \
+ || REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_GNUC_AT_LEAST_(4, 8)
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN_BSWAP16
+#endif
+
+#if REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN(__builtin_bswap32)   \
+ || REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_GNUC_AT_LEAST_(4, 3)
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN_BSWAP32
+#endif
+
+#if REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN(__builtin_bswap64)   \
+ || REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_GNUC_AT_LEAST_(4, 3)
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN_BSWAP64
+#endif
+
+#if REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN(__builtin_prefetch)  \
+ || REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_GNUC_AT_LEAST_(3, 1)
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN_PREFETCH
+#endif
+
+#if REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN(__builtin_unreachable) \
+ || REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_GNUC_AT_LEAST_(4, 5)
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN_UNREACHABLE
+#endif
+
+#if REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN(__builtin_assume_aligned) \
+ || REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_GNUC_AT_LEAST_(4, 7)
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN_ASSUME_ALIGNED
+#endif
+
+/*!
+ * The  MSVC  intrinsics are declared by  `<intrin.h>`,
+ * which  is  left  for the user to  include,  and  are
+ * available  on  every target but for the  64-bit  bit
+ * scans,  restricted to 64-bit targets. `__popcnt`  is
+ * deliberately  left  out since it  requires  hardware
+ * support            on            x86,            see
+ * `preprocessor/environment/architecture.h` instead.
+ */
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_INTRINSIC_BITSCAN
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_INTRINSIC_BYTESWAP
+
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86_64)        \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM64)
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_INTRINSIC_BITSCAN64
+#  endif
+
+#endif
+
+/*! @} <!-- }}} Capability probing --> */
+
+/*! <!-- Alignment {{{ -->
+ * @addtogroup  compiler_alignment Alignment
+ * @brief Declaration alignment attributes
+ *
+ * Vendor  attributes are preferred over their standard
+ * counterparts  since they are available regardless of
+ * the selected standard and accept the same placement,
+ * i.e. in front of a variable or member declaration :
+ *
+ * ```c
+ * struct counters {
+ *    REBOOT_CACHE_ALIGNED uint64_t hits;
+ *    REBOOT_CACHE_ALIGNED uint64_t misses;
+ * };
+ * ```
+ *
+ * MSVC    only    accepts    integer    literals    as
+ * `__declspec(align)`         arguments,         which
+ * `REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_CACHE_LINE_SIZE`
+ * is guaranteed to expand to.
+ * @{
+ */
+
+/*!
+ * @def   REBOOT_ALIGNED
+ * @brief Declaration alignment attribute.
+ *
+ * This  macro aligns the subsequent declaration to `n`
+ * bytes,  `n`  being  a power of two.  It  expands  to
+ * nothing  on compilers lacking any form of  alignment
+ * control.
+ */
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)
+#  define REBOOT_ALIGNED(n) __attribute__((__aligned__(n)))
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)              \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_INTEL)
+#  define REBOOT_ALIGNED(n) __declspec(align(n))
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP11)
+#  define REBOOT_ALIGNED(n) alignas(n)
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_AT_LEAST_C11)
+#  define REBOOT_ALIGNED(n) _Alignas(n)
+#else
+#  define REBOOT_ALIGNED(n)
+#endif
+
+/*!
+ * @def   REBOOT_CACHE_ALIGNED
+ * @brief Cache line alignment attribute.
+ *
+ * This  macro  aligns  the subsequent  declaration  to
+ * `REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_CACHE_LINE_SIZE`,
+ * which also pads its enclosing structure accordingly.
+ */
+#define REBOOT_CACHE_ALIGNED                                                  \
+   REBOOT_ALIGNED(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_CACHE_LINE_SIZE)
+
+/*! @} <!-- }}} Alignment --> */
+
+/*! <!-- Branch prediction {{{ -->
+ * @addtogroup  compiler_branch Branch prediction
+ * @brief Branch prediction hints
+ *
+ * These  hints drive the block layout rather than  the
+ * hardware  predictor : the unlikely side of a  branch
+ * is  moved out of the fall-through path, keeping  the
+ * likely one dense in the instruction cache.
+ *
+ * `__builtin_expect`  applies  to expressions  and  is
+ * therefore   usable  in  any  condition.  The   C++20
+ * `[[likely]]` and `[[unlikely]]` attributes, however,
+ * apply  to statements and are exposed separately  for
+ * compilers  lacking  the former, so that both may  be
+ * combined :
+ *
+ * ```c
+ * if (REBOOT_UNLIKELY(error != 0)) REBOOT_UNLIKELY_BRANCH {
+ *    return handle(error);
+ * }
+ * ```
+ * @{
+ */
+
+/*!
+ * @def   REBOOT_LIKELY
+ * @brief Likely condition hint.
+ *
+ * This  macro hints that the condition `x` is expected
+ * to  be true. It evaluates to `x` converted to either
+ * `0` or `1`.
+ */
+
+/*!
+ * @def   REBOOT_UNLIKELY
+ * @brief Unlikely condition hint.
+ *
+ * This  macro hints that the condition `x` is expected
+ * to be false. It evaluates to `x` converted to either
+ * `0` or `1`.
+ */
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN_EXPECT)
+#  define REBOOT_LIKELY(x)   __builtin_expect(!!(x), 1)
+#  define REBOOT_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#  define REBOOT_LIKELY(x)   (!!(x))
+#  define REBOOT_UNLIKELY(x) (!!(x))
+#endif
+
+/*!
+ * @def   REBOOT_LIKELY_BRANCH
+ * @brief Likely statement hint.
+ *
+ * This  macro hints that the statement it precedes  is
+ * expected  to  be  executed. It  expands  to  nothing
+ * outside  of  C++20 and when `REBOOT_LIKELY`  already
+ * carries the hint.
+ */
+
+/*!
+ * @def   REBOOT_UNLIKELY_BRANCH
+ * @brief Unlikely statement hint.
+ *
+ * This  macro hints that the statement it precedes  is
+ * not  expected to be executed. It expands to  nothing
+ * outside  of C++20 and when `REBOOT_UNLIKELY` already
+ * carries the hint.
+ */
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP20)                   \
+ && !defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN_EXPECT)
+#  define REBOOT_LIKELY_BRANCH   [[likely]]
+#  define REBOOT_UNLIKELY_BRANCH [[unlikely]]
+#else
+#  define REBOOT_LIKELY_BRANCH
+#  define REBOOT_UNLIKELY_BRANCH
+#endif
+
+/*! @} <!-- }}} Branch prediction --> */
+
+/*! <!-- Function hints {{{ -->
+ * @addtogroup  compiler_function Function hints
+ * @brief Function layout and inlining hints
+ *
+ * These  attributes are placed in front of a  function
+ * declaration  or definition and expand to nothing  on
+ * compilers  lacking  them,  all of  them  being  pure
+ * optimization hints with no semantic effect.
+ *
+ * Functions  marked  `REBOOT_COLD` are  optimized  for
+ * size and grouped in a separate text subsection along
+ * with the paths leading to them, which is where error
+ * handling  belongs. Functions marked `REBOOT_HOT` are
+ * optimized more aggressively and grouped together.
+ * @{
+ */
+
+/*!
+ * @def   REBOOT_HOT
+ * @brief Hot function attribute.
+ */
+
+/*!
+ * @def   REBOOT_COLD
+ * @brief Cold function attribute.
+ */
+#if REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_ATTRIBUTE(__hot__)           \
+ || REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_GNUC_AT_LEAST_(4, 3)
+#  define REBOOT_HOT  __attribute__((__hot__))
+#  define REBOOT_COLD __attribute__((__cold__))
+#else
+#  define REBOOT_HOT
+#  define REBOOT_COLD
+#endif
+
+/*!
+ * @def   REBOOT_FLATTEN
+ * @brief Flatten function attribute.
+ *
+ * This  macro requests every call inside the  function
+ * it  is applied to be inlined, recursively,  whenever
+ * possible.
+ */
+#if REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_ATTRIBUTE(__flatten__)       \
+ || REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_GNUC_AT_LEAST_(4, 1)
+#  define REBOOT_FLATTEN __attribute__((__flatten__))
+#else
+#  define REBOOT_FLATTEN
+#endif
+
+/*!
+ * @def   REBOOT_NOINLINE
+ * @brief No inline function attribute.
+ *
+ * This  macro  prevents the function it is applied  to
+ * from being inlined, e.g. to keep a rarely taken path
+ * out of its callers.
+ */
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)
+#  define REBOOT_NOINLINE __attribute__((__noinline__))
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)              \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_INTEL)
+#  define REBOOT_NOINLINE __declspec(noinline)
+#else
+#  define REBOOT_NOINLINE
+#endif
+
+/*!
+ * @def   REBOOT_INLINE
+ * @brief Inline function specifier.
+ *
+ * This  macro  expands  to `inline` from C99  and  C++
+ * onwards,   and  to  the  equivalent  vendor  keyword
+ * otherwise  so that `static REBOOT_INLINE`  functions
+ * may be defined in headers regardless of the selected
+ * standard. It expands to nothing on compilers lacking
+ * any, leaving unused static functions behind.
+ */
+#if defined(__cplusplus)                                                      \
+ || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_AT_LEAST_C99)
+#  define REBOOT_INLINE inline
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)
+#  define REBOOT_INLINE __inline__
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)              \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_INTEL)
+#  define REBOOT_INLINE __inline
+#else
+#  define REBOOT_INLINE
+#endif
+
+/*!
+ * @def   REBOOT_ALWAYS_INLINE
+ * @brief Forced inline function specifier.
+ *
+ * This   macro  stands  in  for  `REBOOT_INLINE`   and
+ * additionally  requests  the function to  be  inlined
+ * regardless of the optimizer heuristics, including in
+ * unoptimized   builds.  Unlike  `REBOOT_FLATTEN`,  it
+ * applies to the callee rather than to the caller.
+ */
+#if REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_ATTRIBUTE(__always_inline__) \
+ || REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_GNUC_AT_LEAST_(3, 1)
+#  define REBOOT_ALWAYS_INLINE REBOOT_INLINE __attribute__((__always_inline__))
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)              \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_INTEL)
+#  define REBOOT_ALWAYS_INLINE __forceinline
+#else
+#  define REBOOT_ALWAYS_INLINE REBOOT_INLINE
+#endif
+
+/*! @} <!-- }}} Function hints --> */
+
+/*! <!-- Optimizer assumptions {{{ -->
+ * @addtogroup  compiler_assumptions Optimizer assumptions
+ * @brief Aliasing, value and alignment assumptions
+ *
+ * These macros convey facts the optimizer is unable to
+ * prove  on its own, mostly to enable vectorization of
+ * loops  over  pointers. They are promises :  breaking
+ * one is undefined behaviour, not a diagnostic.
+ * @{
+ */
+
+/*!
+ * @def   REBOOT_RESTRICT
+ * @brief Non-aliasing pointer qualifier.
+ *
+ * This  macro qualifies a pointer as the only means of
+ * accessing  the object it points to for its lifetime.
+ * `restrict`  is a C99 keyword that C++ never adopted,
+ * the major C++ compilers providing it as `__restrict`
+ * instead,  which  this macro resolves to so that  the
+ * same kernels can be shared by both languages.
+ */
+#if !defined(__cplusplus)                                                     \
+ && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_AT_LEAST_C99)
+#  define REBOOT_RESTRICT restrict
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)
+#  define REBOOT_RESTRICT __restrict__
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)              \
+   || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_INTEL)
+#  define REBOOT_RESTRICT __restrict
+#else
+#  define REBOOT_RESTRICT
+#endif
+
+/*!
+ * @def   REBOOT_ASSUME
+ * @brief Optimizer assumption.
+ *
+ * This  macro lets the optimizer assume the  condition
+ * `c`  holds, e.g. a loop trip count being a  multiple
+ * of the vector width, and is used as a statement. `c`
+ * must  be  free of side effects since whether  it  is
+ * evaluated  is  unspecified, the GCC  fallback  going
+ * through `__builtin_unreachable`.
+ */
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_CLANG)
+#  define REBOOT_ASSUME(c) __builtin_assume(c)
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)              \
+   || (  defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_INTEL)          \
+      && !defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC))
+#  define REBOOT_ASSUME(c) __assume(c)
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP23)
+#  define REBOOT_ASSUME(c) [[assume(c)]]
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN_UNREACHABLE)
+#  define REBOOT_ASSUME(c) ((c) ? (void) 0 : __builtin_unreachable())
+#else
+#  define REBOOT_ASSUME(c) ((void) 0)
+#endif
+
+/*!
+ * @def   REBOOT_ASSUME_ALIGNED
+ * @brief Pointer alignment assumption.
+ *
+ * This  macro evaluates to `p`, of the same type,  and
+ * lets  the  optimizer  assume it is  aligned  to  `n`
+ * bytes,  `n` being a power of two. Only the  returned
+ * pointer   carries   the  assumption,  which   should
+ * therefore replace `p` :
+ *
+ * ```c
+ * float *a = REBOOT_ASSUME_ALIGNED(input, 32);
+ * ```
+ *
+ * GCC-compatible  compilers  go through their builtin,
+ * C++20 ones through `std::assume_aligned`, `n` having
+ * to  be a constant expression there, and MSVC through
+ * an `__assume` of the low address bits.
+ */
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_BUILTIN_ASSUME_ALIGNED) \
+ && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)
+#  define REBOOT_ASSUME_ALIGNED(p, n)                                         \
+      ((__typeof__(p)) __builtin_assume_aligned((p), (n)))
+#elif defined(__cplusplus)                                                    \
+   && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_ASSUME_ALIGNED)
+#  include <memory>
+#  define REBOOT_ASSUME_ALIGNED(p, n) std::assume_aligned<(n)>(p)
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)
+#  include <stdint.h>
+#  define REBOOT_ASSUME_ALIGNED(p, n)                                         \
+      (__assume((((uintptr_t) (p)) & ((n) - 1)) == 0), (p))
+#else
+#  define REBOOT_ASSUME_ALIGNED(p, n) (p)
+#endif
+
+/*! @} <!-- }}} Optimizer assumptions --> */
+
+/*! <!-- Storage {{{ -->
+ * @addtogroup  compiler_storage Storage
+ * @brief Thread-local storage
+ * @{
+ */
+
+/*!
+ * @def   REBOOT_THREAD_LOCAL
+ * @brief Thread-local storage class specifier.
+ *
+ * This  macro  gives the subsequent declaration  of  a
+ * variable of static storage duration one instance per
+ * thread. It resolves to the `thread_local` keyword of
+ * C++11, to the `_Thread_local` one of C11, and to the
+ * `__thread`   and   `__declspec(thread)`   extensions
+ * otherwise,  which  are available in every mode,  C89
+ * included,  and are the only ones MSVC honours in  C.
+ * `REBOOT_HAS_THREAD_LOCAL` is defined whenever any of
+ * them is, the macro being left undefined otherwise.
+ * Initializers must be constant expressions in C.
+ */
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP11)
+#  define REBOOT_THREAD_LOCAL thread_local
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)
+#  define REBOOT_THREAD_LOCAL __declspec(thread)
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_AT_LEAST_C11)      \
+   && !defined(__cplusplus)
+#  define REBOOT_THREAD_LOCAL _Thread_local
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)
+#  define REBOOT_THREAD_LOCAL __thread
+#endif
+
+#if defined(REBOOT_THREAD_LOCAL)
+#  define REBOOT_HAS_THREAD_LOCAL
+#endif
+
+/*! @} <!-- }}} Storage --> */
+
+#endif /* __REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_H__ */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
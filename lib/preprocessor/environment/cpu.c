@@ -0,0 +1,303 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+/*!
+ * @file  preprocessor/environment/cpu.c
+ * @brief Runtime processor feature detection.
+ *
+ * The  probe itself is split per architecture  family,
+ * each  returning the features it found on top of  the
+ * compile-time  baseline.  Families without a  runtime
+ * probe simply report their baseline.
+ */
+
+#include "preprocessor/environment/cpu.h"
+#include "preprocessor/environment/compiler.h"
+#include "preprocessor/environment/os.h"
+#include "preprocessor/environment/standard.h"
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86)
+#  if defined(_MSC_VER) && !defined(__clang__)
+#     include <intrin.h>
+#  elif defined(__GNUC__) || defined(__clang__)
+#     include <cpuid.h>
+#  endif
+#endif
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_LINUX)                     \
+ && (  defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM)          \
+    || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_POWERPC)      \
+    || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_RISCV))
+#  include <sys/auxv.h>
+#  define REBOOT_CPU_HAS_AUXV_
+#endif
+
+/*!
+ * Zero  is never a valid probe result once initialized
+ * since  the probe always records `REBOOT_CPU_PROBED_`
+ * alongside   the   detected  features,  leaving   the
+ * sentinel free to mean “not probed yet”.
+ */
+#define REBOOT_CPU_PROBED_ (UINT64_C(1) << 63)
+
+/*!
+ * The  cache  is  filled  lazily wherever no load-time
+ * constructor runs the probe, concurrent first callers
+ * racing  to  publish  the  same  value.  It  is hence
+ * published and read atomically so that a reader never
+ * observes   the  sentinel  without  the  features  it
+ * guards, which a torn 64-bit access on 32-bit targets
+ * would otherwise allow.
+ */
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_ATOMICS)
+#  include <stdatomic.h>
+static _Atomic(reboot_cpu_features_t) reboot_cpu_features_;
+#  define REBOOT_CPU_LOAD_()                                                  \
+      atomic_load_explicit(&reboot_cpu_features_, memory_order_acquire)
+#  define REBOOT_CPU_STORE_(value)                                            \
+      atomic_store_explicit(                                                  \
+         &reboot_cpu_features_, (value), memory_order_release                 \
+      )
+#elif defined(__ATOMIC_ACQUIRE)
+static reboot_cpu_features_t reboot_cpu_features_;
+#  define REBOOT_CPU_LOAD_()                                                  \
+      __atomic_load_n(&reboot_cpu_features_, __ATOMIC_ACQUIRE)
+#  define REBOOT_CPU_STORE_(value)                                            \
+      __atomic_store_n(&reboot_cpu_features_, (value), __ATOMIC_RELEASE)
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)
+#  include <intrin.h>
+static volatile __int64 reboot_cpu_features_;
+/*
+ * 32-bit  targets lack a plain 64-bit interlocked load
+ * and  store, a compare-and-swap standing in for both.
+ * Every  writer  publishes  the  same value, the store
+ * only ever replacing the sentinel.
+ */
+#  define REBOOT_CPU_LOAD_()                                                  \
+      ((reboot_cpu_features_t) _InterlockedCompareExchange64(                 \
+         &reboot_cpu_features_, 0, 0                                          \
+      ))
+#  define REBOOT_CPU_STORE_(value)                                            \
+      ((void) _InterlockedCompareExchange64(                                  \
+         &reboot_cpu_features_, (__int64) (value), 0                          \
+      ))
+#else
+static volatile reboot_cpu_features_t reboot_cpu_features_;
+#  define REBOOT_CPU_LOAD_()       (reboot_cpu_features_)
+#  define REBOOT_CPU_STORE_(value) ((void) (reboot_cpu_features_ = (value)))
+#endif
+
+/* <!-- x86 {{{ --> */
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86)
+
+static void
+reboot_cpu_cpuid_(
+   uint32_t leaf, uint32_t subleaf, uint32_t registers[4]
+) {
+#  if defined(_MSC_VER) && !defined(__clang__)
+   int values[4];
+
+   __cpuidex(values, (int) leaf, (int) subleaf);
+
+   registers[0] = (uint32_t) values[0];
+   registers[1] = (uint32_t) values[1];
+   registers[2] = (uint32_t) values[2];
+   registers[3] = (uint32_t) values[3];
+#  else
+   __cpuid_count(
+      leaf, subleaf, registers[0], registers[1], registers[2], registers[3]
+   );
+#  endif
+}
+
+/*!
+ * `xgetbv`  is  spelled out as an opcode  since  older
+ * assemblers  do not know about the mnemonic. It  must
+ * only be executed once `cpuid` reported `OSXSAVE`.
+ */
+static uint64_t
+reboot_cpu_xgetbv_(void)
+{
+#  if defined(_MSC_VER) && !defined(__clang__)
+   return (uint64_t) _xgetbv(0);
+#  else
+   uint32_t low;
+   uint32_t high;
+
+   __asm__ volatile (
+      ".byte 0x0f, 0x01, 0xd0" : "=a" (low), "=d" (high) : "c" (0)
+   );
+
+   return ((uint64_t) high << 32) | low;
+#  endif
+}
+
+#  define REBOOT_CPU_BIT_(value, bit) (((value) >> (bit)) & 1u)
+
+static reboot_cpu_features_t
+reboot_cpu_probe_(void)
+{
+   reboot_cpu_features_t features = 0;
+   uint32_t              registers[4];
+   uint32_t              maximum;
+   uint64_t              xcr0 = 0;
+
+   reboot_cpu_cpuid_(0, 0, registers);
+   maximum = registers[0];
+
+   if (maximum < 1) {
+      return features;
+   }
+
+   reboot_cpu_cpuid_(1, 0, registers);
+
+   if (REBOOT_CPU_BIT_(registers[3], 25)) features |= REBOOT_CPU_SSE;
+   if (REBOOT_CPU_BIT_(registers[3], 26)) features |= REBOOT_CPU_SSE2;
+   if (REBOOT_CPU_BIT_(registers[2],  0)) features |= REBOOT_CPU_SSE3;
+   if (REBOOT_CPU_BIT_(registers[2],  1)) features |= REBOOT_CPU_PCLMUL;
+   if (REBOOT_CPU_BIT_(registers[2],  9)) features |= REBOOT_CPU_SSSE3;
+   if (REBOOT_CPU_BIT_(registers[2], 19)) features |= REBOOT_CPU_SSE4_1;
+   if (REBOOT_CPU_BIT_(registers[2], 20)) features |= REBOOT_CPU_SSE4_2;
+   if (REBOOT_CPU_BIT_(registers[2], 23)) features |= REBOOT_CPU_POPCNT;
+
+   /* OSXSAVE, the operating system manages the extended state. */
+   if (REBOOT_CPU_BIT_(registers[2], 27)) {
+      xcr0 = reboot_cpu_xgetbv_();
+   }
+
+   /* XMM and YMM state. */
+   if ((xcr0 & 0x06) == 0x06) {
+      if (REBOOT_CPU_BIT_(registers[2], 28)) features |= REBOOT_CPU_AVX;
+      if (REBOOT_CPU_BIT_(registers[2], 12)) features |= REBOOT_CPU_FMA;
+   }
+
+   if (maximum >= 7) {
+      reboot_cpu_cpuid_(7, 0, registers);
+
+      if (REBOOT_CPU_BIT_(registers[1], 3)) features |= REBOOT_CPU_BMI1;
+      if (REBOOT_CPU_BIT_(registers[1], 8)) features |= REBOOT_CPU_BMI2;
+
+      if (features & REBOOT_CPU_AVX) {
+         if (REBOOT_CPU_BIT_(registers[1], 5)) features |= REBOOT_CPU_AVX2;
+      }
+
+      /* Opmask, upper ZMM and high ZMM state. */
+      if ((features & REBOOT_CPU_AVX) && (xcr0 & 0xe0) == 0xe0) {
+         if (REBOOT_CPU_BIT_(registers[1], 16)) features |= REBOOT_CPU_AVX512F;
+         if (REBOOT_CPU_BIT_(registers[1], 17)) features |= REBOOT_CPU_AVX512DQ;
+         if (REBOOT_CPU_BIT_(registers[1], 28)) features |= REBOOT_CPU_AVX512CD;
+         if (REBOOT_CPU_BIT_(registers[1], 30)) features |= REBOOT_CPU_AVX512BW;
+         if (REBOOT_CPU_BIT_(registers[1], 31)) features |= REBOOT_CPU_AVX512VL;
+      }
+   }
+
+   reboot_cpu_cpuid_(0x80000000u, 0, registers);
+
+   if (registers[0] >= 0x80000001u) {
+      reboot_cpu_cpuid_(0x80000001u, 0, registers);
+
+      if (REBOOT_CPU_BIT_(registers[2], 5)) features |= REBOOT_CPU_LZCNT;
+   }
+
+   return features;
+}
+
+/* <!-- }}} x86 --> */
+/* <!-- Auxiliary vector {{{ --> */
+#elif defined(REBOOT_CPU_HAS_AUXV_)
+
+/*!
+ * The  hardware capability bits are part of the kernel
+ * ABI  and are therefore spelled out here rather  than
+ * relying  on `<asm/hwcap.h>`, which older C libraries
+ * fail to ship.
+ */
+static reboot_cpu_features_t
+reboot_cpu_probe_(void)
+{
+   reboot_cpu_features_t features = 0;
+   unsigned long         hwcap    = getauxval(AT_HWCAP);
+   unsigned long         hwcap2   = 0;
+
+#  ifdef AT_HWCAP2
+   hwcap2 = getauxval(AT_HWCAP2);
+#  endif
+
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM64)
+   if (hwcap  & (1ul <<  1)) features |= REBOOT_CPU_NEON;
+   if (hwcap  & (1ul <<  3)) features |= REBOOT_CPU_AES;
+   if (hwcap  & (1ul <<  4)) features |= REBOOT_CPU_PMULL;
+   if (hwcap  & (1ul <<  7)) features |= REBOOT_CPU_CRC32;
+   if (hwcap  & (1ul << 22)) features |= REBOOT_CPU_SVE;
+   if (hwcap2 & (1ul <<  1)) features |= REBOOT_CPU_SVE2;
+#  elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM32)
+   if (hwcap  & (1ul << 12)) features |= REBOOT_CPU_NEON;
+   if (hwcap2 & (1ul <<  0)) features |= REBOOT_CPU_AES;
+   if (hwcap2 & (1ul <<  1)) features |= REBOOT_CPU_PMULL;
+   if (hwcap2 & (1ul <<  4)) features |= REBOOT_CPU_CRC32;
+#  elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_POWERPC)
+   if (hwcap  & (1ul << 28)) features |= REBOOT_CPU_ALTIVEC;
+   if (hwcap  & (1ul <<  7)) features |= REBOOT_CPU_VSX;
+#  elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_RISCV)
+   if (hwcap  & (1ul << ('V' - 'A'))) features |= REBOOT_CPU_RVV;
+#  endif
+
+   (void) hwcap2;
+
+   return features;
+}
+
+/* <!-- }}} Auxiliary vector --> */
+#else
+
+static reboot_cpu_features_t
+reboot_cpu_probe_(void)
+{
+   return 0;
+}
+
+#endif
+
+void
+reboot_cpu_init(void)
+{
+   REBOOT_CPU_STORE_(
+      reboot_cpu_probe_() | REBOOT_CPU_BASELINE | REBOOT_CPU_PROBED_
+   );
+}
+
+reboot_cpu_features_t
+reboot_cpu_features(void)
+{
+   reboot_cpu_features_t features = REBOOT_CPU_LOAD_();
+
+   if (features == 0) {
+      reboot_cpu_init();
+      features = REBOOT_CPU_LOAD_();
+   }
+
+   return features & ~REBOOT_CPU_PROBED_;
+}
+
+/*!
+ * Probing at load time keeps the first dispatched call
+ * free  of the `cpuid` latency, which is in the  order
+ * of   a  hundred  cycles  and  serializing  on   most
+ * implementations.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((constructor)) static void
+reboot_cpu_constructor_(void)
+{
+   reboot_cpu_init();
+}
+#endif
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
@@ -0,0 +1,442 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+#ifndef __REBOOT_PREPROCESSOR_ENVIRONMENT_CPU_H__
+#define __REBOOT_PREPROCESSOR_ENVIRONMENT_CPU_H__
+
+/*!
+ * @file  preprocessor/environment/cpu.h
+ * @brief Runtime processor feature detection.
+ *
+ * This    header   is   the   runtime   companion   of
+ * `preprocessor/environment/architecture.h`. Where the
+ * latter answers the question “What were we allowed to
+ * emit  ?”,  including this file answers the  question
+ * “What  does  the  host we are  running  on  actually
+ * support ?”.
+ *
+ * The  host  is  probed once, either at load  time  on
+ * compilers  supporting constructors or upon the first
+ * query  otherwise,  through  `cpuid` on x86  and  the
+ * auxiliary vector on Linux. The result is cached as a
+ * bitmask of the following `REBOOT_CPU_*` flags :
+ *
+ * - x86   : `SSE`,  `SSE2`, `SSE3`, `SSSE3`, `SSE4_1`,
+ *           `SSE4_2`,   `POPCNT`,   `PCLMUL`,   `AVX`,
+ *           `AVX2`,  `FMA`,  `BMI1`, `BMI2`,  `LZCNT`,
+ *           `AVX512F`,     `AVX512BW`,     `AVX512CD`,
+ *           `AVX512DQ`, `AVX512VL`
+ * - ARM   : `NEON`,  `AES`,  `PMULL`, `CRC32`,  `SVE`,
+ *           `SVE2`
+ * - POWER : `ALTIVEC`, `VSX`
+ * - RISCV : `RVV`
+ *
+ * Extensions  requiring  operating system support  for
+ * their  register  state, namely the AVX  and  AVX-512
+ * families,  are  only  reported  when  the  operating
+ * system saves said state across context switches.
+ *
+ * Features  the  compiler was already allowed to  emit
+ * are  folded  into `REBOOT_CPU_BASELINE`, which  lets
+ * `REBOOT_CPU_HAS`  resolve  at compile time  whenever
+ * the  build  flags  already guarantee  the  requested
+ * features.
+ *
+ * Finally, `REBOOT_CPU_DISPATCH` builds an ifunc-style
+ * dispatched  function out of a table of feature masks
+ * and  implementations. The table is walked once, upon
+ * the first call, after which every call goes straight
+ * through a function pointer.
+ *
+ * Sources :
+ *
+ * - https://www.intel.com/content/www/us/en/developer/articles/technical/intel-sdm.html
+ * - https://docs.microsoft.com/en-us/cpp/intrinsics/cpuid-cpuidex
+ * - https://www.kernel.org/doc/html/latest/arm64/elf_hwcaps.html
+ * - https://man7.org/linux/man-pages/man3/getauxval.3.html
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "preprocessor/environment/architecture.h"
+#include "preprocessor/environment/standard.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! <!-- Feature flags {{{ -->
+ * @addtogroup  cpu_features Feature flags
+ * @brief Runtime processor feature flags
+ *
+ * Flags  are architecture specific and share the  same
+ * bit  space. Only the flags pertaining to the current
+ * target can ever be set.
+ * @{
+ */
+
+/*!
+ * @brief Processor feature bitmask.
+ */
+typedef uint64_t reboot_cpu_features_t;
+
+#define REBOOT_CPU_SSE       (UINT64_C(1) <<  0)
+#define REBOOT_CPU_SSE2      (UINT64_C(1) <<  1)
+#define REBOOT_CPU_SSE3      (UINT64_C(1) <<  2)
+#define REBOOT_CPU_SSSE3     (UINT64_C(1) <<  3)
+#define REBOOT_CPU_SSE4_1    (UINT64_C(1) <<  4)
+#define REBOOT_CPU_SSE4_2    (UINT64_C(1) <<  5)
+#define REBOOT_CPU_POPCNT    (UINT64_C(1) <<  6)
+#define REBOOT_CPU_PCLMUL    (UINT64_C(1) <<  7)
+#define REBOOT_CPU_AVX       (UINT64_C(1) <<  8)
+#define REBOOT_CPU_AVX2      (UINT64_C(1) <<  9)
+#define REBOOT_CPU_FMA       (UINT64_C(1) << 10)
+#define REBOOT_CPU_BMI1      (UINT64_C(1) << 11)
+#define REBOOT_CPU_BMI2      (UINT64_C(1) << 12)
+#define REBOOT_CPU_LZCNT     (UINT64_C(1) << 13)
+#define REBOOT_CPU_AVX512F   (UINT64_C(1) << 14)
+#define REBOOT_CPU_AVX512BW  (UINT64_C(1) << 15)
+#define REBOOT_CPU_AVX512CD  (UINT64_C(1) << 16)
+#define REBOOT_CPU_AVX512DQ  (UINT64_C(1) << 17)
+#define REBOOT_CPU_AVX512VL  (UINT64_C(1) << 18)
+
+#define REBOOT_CPU_NEON      (UINT64_C(1) << 32)
+#define REBOOT_CPU_AES       (UINT64_C(1) << 33)
+#define REBOOT_CPU_PMULL     (UINT64_C(1) << 34)
+#define REBOOT_CPU_CRC32     (UINT64_C(1) << 35)
+#define REBOOT_CPU_SVE       (UINT64_C(1) << 36)
+#define REBOOT_CPU_SVE2      (UINT64_C(1) << 37)
+
+#define REBOOT_CPU_ALTIVEC   (UINT64_C(1) << 48)
+#define REBOOT_CPU_VSX       (UINT64_C(1) << 49)
+
+#define REBOOT_CPU_RVV       (UINT64_C(1) << 56)
+
+/*! @} <!-- }}} Feature flags --> */
+
+/*! <!-- Baseline {{{ -->
+ *
+ * @def   REBOOT_CPU_BASELINE
+ * @brief Compile-time guaranteed feature flags.
+ *
+ * This  macro  holds  the features  the  compiler  was
+ * allowed      to     emit,     as     reported     by
+ * `preprocessor/environment/architecture.h`. They are,
+ * by definition, supported by any host able to run the
+ * resulting binary.
+ */
+
+#define REBOOT_CPU_BASELINE (                                                 \
+     REBOOT_CPU_BASELINE_SSE_ | REBOOT_CPU_BASELINE_SSE2_                     \
+   | REBOOT_CPU_BASELINE_SSE3_ | REBOOT_CPU_BASELINE_SSSE3_                   \
+   | REBOOT_CPU_BASELINE_SSE4_1_ | REBOOT_CPU_BASELINE_SSE4_2_                \
+   | REBOOT_CPU_BASELINE_POPCNT_ | REBOOT_CPU_BASELINE_AVX_                   \
+   | REBOOT_CPU_BASELINE_AVX2_ | REBOOT_CPU_BASELINE_FMA_                     \
+   | REBOOT_CPU_BASELINE_BMI1_ | REBOOT_CPU_BASELINE_BMI2_                    \
+   | REBOOT_CPU_BASELINE_LZCNT_ | REBOOT_CPU_BASELINE_AVX512F_                \
+   | REBOOT_CPU_BASELINE_AVX512BW_ | REBOOT_CPU_BASELINE_AVX512CD_            \
+   | REBOOT_CPU_BASELINE_AVX512DQ_ | REBOOT_CPU_BASELINE_AVX512VL_            \
+   | REBOOT_CPU_BASELINE_NEON_ | REBOOT_CPU_BASELINE_SVE_                     \
+   | REBOOT_CPU_BASELINE_SVE2_ | REBOOT_CPU_BASELINE_ALTIVEC_                 \
+   | REBOOT_CPU_BASELINE_VSX_ | REBOOT_CPU_BASELINE_RVV_                      \
+   | REBOOT_CPU_BASELINE_PCLMUL_ | REBOOT_CPU_BASELINE_PMULL_                 \
+   | REBOOT_CPU_BASELINE_CRC32_                                               \
+)
+
+/*!
+ * Each   flag   is   resolved   on   its   own   since
+ * `preprocessor/environment/architecture.h`    already
+ * takes care of the implied extensions.
+ */
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SSE
+#  define REBOOT_CPU_BASELINE_SSE_ REBOOT_CPU_SSE
+#else
+#  define REBOOT_CPU_BASELINE_SSE_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SSE2
+#  define REBOOT_CPU_BASELINE_SSE2_ REBOOT_CPU_SSE2
+#else
+#  define REBOOT_CPU_BASELINE_SSE2_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SSE3
+#  define REBOOT_CPU_BASELINE_SSE3_ REBOOT_CPU_SSE3
+#else
+#  define REBOOT_CPU_BASELINE_SSE3_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SSSE3
+#  define REBOOT_CPU_BASELINE_SSSE3_ REBOOT_CPU_SSSE3
+#else
+#  define REBOOT_CPU_BASELINE_SSSE3_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SSE4_1
+#  define REBOOT_CPU_BASELINE_SSE4_1_ REBOOT_CPU_SSE4_1
+#else
+#  define REBOOT_CPU_BASELINE_SSE4_1_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SSE4_2
+#  define REBOOT_CPU_BASELINE_SSE4_2_ REBOOT_CPU_SSE4_2
+#else
+#  define REBOOT_CPU_BASELINE_SSE4_2_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_POPCNT
+#  define REBOOT_CPU_BASELINE_POPCNT_ REBOOT_CPU_POPCNT
+#else
+#  define REBOOT_CPU_BASELINE_POPCNT_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX
+#  define REBOOT_CPU_BASELINE_AVX_ REBOOT_CPU_AVX
+#else
+#  define REBOOT_CPU_BASELINE_AVX_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX2
+#  define REBOOT_CPU_BASELINE_AVX2_ REBOOT_CPU_AVX2
+#else
+#  define REBOOT_CPU_BASELINE_AVX2_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_FMA
+#  define REBOOT_CPU_BASELINE_FMA_ REBOOT_CPU_FMA
+#else
+#  define REBOOT_CPU_BASELINE_FMA_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_BMI1
+#  define REBOOT_CPU_BASELINE_BMI1_ REBOOT_CPU_BMI1
+#else
+#  define REBOOT_CPU_BASELINE_BMI1_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_BMI2
+#  define REBOOT_CPU_BASELINE_BMI2_ REBOOT_CPU_BMI2
+#else
+#  define REBOOT_CPU_BASELINE_BMI2_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_LZCNT
+#  define REBOOT_CPU_BASELINE_LZCNT_ REBOOT_CPU_LZCNT
+#else
+#  define REBOOT_CPU_BASELINE_LZCNT_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_PCLMUL
+#  define REBOOT_CPU_BASELINE_PCLMUL_ REBOOT_CPU_PCLMUL
+#else
+#  define REBOOT_CPU_BASELINE_PCLMUL_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX512F
+#  define REBOOT_CPU_BASELINE_AVX512F_ REBOOT_CPU_AVX512F
+#else
+#  define REBOOT_CPU_BASELINE_AVX512F_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX512BW
+#  define REBOOT_CPU_BASELINE_AVX512BW_ REBOOT_CPU_AVX512BW
+#else
+#  define REBOOT_CPU_BASELINE_AVX512BW_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX512CD
+#  define REBOOT_CPU_BASELINE_AVX512CD_ REBOOT_CPU_AVX512CD
+#else
+#  define REBOOT_CPU_BASELINE_AVX512CD_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX512DQ
+#  define REBOOT_CPU_BASELINE_AVX512DQ_ REBOOT_CPU_AVX512DQ
+#else
+#  define REBOOT_CPU_BASELINE_AVX512DQ_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX512VL
+#  define REBOOT_CPU_BASELINE_AVX512VL_ REBOOT_CPU_AVX512VL
+#else
+#  define REBOOT_CPU_BASELINE_AVX512VL_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_NEON
+#  define REBOOT_CPU_BASELINE_NEON_ REBOOT_CPU_NEON
+#else
+#  define REBOOT_CPU_BASELINE_NEON_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_CRC32
+#  define REBOOT_CPU_BASELINE_CRC32_ REBOOT_CPU_CRC32
+#else
+#  define REBOOT_CPU_BASELINE_CRC32_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_PMULL
+#  define REBOOT_CPU_BASELINE_PMULL_ REBOOT_CPU_PMULL
+#else
+#  define REBOOT_CPU_BASELINE_PMULL_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SVE
+#  define REBOOT_CPU_BASELINE_SVE_ REBOOT_CPU_SVE
+#else
+#  define REBOOT_CPU_BASELINE_SVE_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SVE2
+#  define REBOOT_CPU_BASELINE_SVE2_ REBOOT_CPU_SVE2
+#else
+#  define REBOOT_CPU_BASELINE_SVE2_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ALTIVEC
+#  define REBOOT_CPU_BASELINE_ALTIVEC_ REBOOT_CPU_ALTIVEC
+#else
+#  define REBOOT_CPU_BASELINE_ALTIVEC_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_VSX
+#  define REBOOT_CPU_BASELINE_VSX_ REBOOT_CPU_VSX
+#else
+#  define REBOOT_CPU_BASELINE_VSX_ 0
+#endif
+
+#ifdef REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_RVV
+#  define REBOOT_CPU_BASELINE_RVV_ REBOOT_CPU_RVV
+#else
+#  define REBOOT_CPU_BASELINE_RVV_ 0
+#endif
+
+/* <!-- }}} Baseline --> */
+
+/*! <!-- Queries {{{ -->
+ * @addtogroup  cpu_queries Queries
+ * @brief Runtime processor feature queries
+ * @{
+ */
+
+/*!
+ * @brief Probe the host processor.
+ *
+ * This function probes the host and caches the result.
+ * It  is  called  automatically and only needs  to  be
+ * called explicitly to move the probe out of a latency
+ * sensitive  path  on  compilers  lacking  constructor
+ * support. Calling it more than once is harmless.
+ */
+void reboot_cpu_init(void);
+
+/*!
+ * @brief Cached host processor features.
+ *
+ * This  function  returns the bitmask of the  features
+ * supported    by    the   host,   always    including
+ * `REBOOT_CPU_BASELINE`.
+ */
+reboot_cpu_features_t reboot_cpu_features(void);
+
+/*!
+ * @def   REBOOT_CPU_HAS
+ * @brief Host feature test.
+ *
+ * This  macro evaluates to non-zero when every feature
+ * in  `mask`  is  supported by the host.  The  runtime
+ * query   is  elided  altogether  when  the  requested
+ * features are part of the baseline.
+ */
+#define REBOOT_CPU_HAS(mask)                                                  \
+   (  ((REBOOT_CPU_BASELINE & (mask)) == (mask))                              \
+   || ((reboot_cpu_features() & (mask)) == (mask)))
+
+/*! @} <!-- }}} Queries --> */
+
+/*! <!-- Dispatch {{{ -->
+ * @addtogroup  cpu_dispatch Dispatch
+ * @brief Ifunc-style dispatch table scaffold
+ *
+ * `REBOOT_CPU_DISPATCH`   defines  a  function  `name`
+ * forwarding  to the first implementation of the table
+ * whose  required  features are all supported  by  the
+ * host.  Entries are listed from the most to the least
+ * demanding,  the last one requiring no feature at all
+ * :
+ *
+ * ```c
+ * REBOOT_CPU_DISPATCH(
+ *    uint32_t, checksum, (const void *data, size_t size), (data, size),
+ *    REBOOT_CPU_DISPATCH_ENTRY(REBOOT_CPU_AVX512BW, checksum_avx512),
+ *    REBOOT_CPU_DISPATCH_ENTRY(REBOOT_CPU_AVX2,     checksum_avx2),
+ *    REBOOT_CPU_DISPATCH_ENTRY(0,                   checksum_scalar)
+ * )
+ * ```
+ *
+ * The  function  pointer initially targets a  resolver
+ * which  selects  the  implementation, stores  it  and
+ * forwards the call. Concurrent first calls resolve to
+ * the same implementation, the pointer store being the
+ * only shared write.
+ *
+ * The table being variadic, the dispatch macro is only
+ * defined   from   C99  and  C++11  onwards,  or  when
+ * compiling  with  MSVC  which  has supported variadic
+ * macros  ever  since, `REBOOT_CPU_HAS_DISPATCH` being
+ * defined  along with it. Older dialects still get the
+ * queries above and warning-free headers.
+ * @{
+ */
+
+#define REBOOT_CPU_DISPATCH_ENTRY(mask, function) { (mask), (function) }
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_AT_LEAST_C99)        \
+ || (defined(__cplusplus)                                                     \
+     && REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP >= 201103L)              \
+ || defined(_MSC_VER)
+
+#define REBOOT_CPU_HAS_DISPATCH
+
+#define REBOOT_CPU_DISPATCH(type, name, parameters, arguments, ...)           \
+   static type name##_reboot_resolve_ parameters;                             \
+   static type (*volatile name##_reboot_target_) parameters =                 \
+      name##_reboot_resolve_;                                                 \
+   static type name##_reboot_resolve_ parameters                              \
+   {                                                                          \
+      static const struct {                                                   \
+         reboot_cpu_features_t mask;                                          \
+         type (*function) parameters;                                         \
+      } table[] = { __VA_ARGS__ };                                            \
+      reboot_cpu_features_t features = reboot_cpu_features();                 \
+      size_t i = 0;                                                           \
+      while (i + 1 < sizeof(table) / sizeof(table[0])                         \
+            && (features & table[i].mask) != table[i].mask) {                 \
+         ++i;                                                                 \
+      }                                                                       \
+      name##_reboot_target_ = table[i].function;                              \
+      return table[i].function arguments;                                     \
+   }                                                                          \
+   type name parameters                                                       \
+   {                                                                          \
+      return name##_reboot_target_ arguments;                                 \
+   }
+
+#endif
+
+/*! @} <!-- }}} Dispatch --> */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __REBOOT_PREPROCESSOR_ENVIRONMENT_CPU_H__ */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
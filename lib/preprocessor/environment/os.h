@@ -0,0 +1,358 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+#ifdef REBOOT_USE_GENERATED_CONFIG
+#  include "reboot_config.h"
+#endif
+
+#ifndef __REBOOT_PREPROCESSOR_ENVIRONMENT_OS_H__
+#define __REBOOT_PREPROCESSOR_ENVIRONMENT_OS_H__
+
+/*!
+ * @file  preprocessor/environment/os.h
+ * @brief Target operating system preprocessor directives.
+ *
+ * This  header  provides preprocessor  directives  for
+ * dealing  with  predefined macros pertaining  to  the
+ * targeted  operating  system, its C library  and  the
+ * system  interfaces they expose. In short,  including
+ * this  file answers the question “What are we running
+ * on top of ?”.
+ *
+ * These  preprocessor directives are listed hereafter,
+ * assuming  the  following prefix local to  this  file
+ * `REBOOT_PREPROCESSOR_ENVIRONMENT_OS_` :
+ *
+ * - `HAS_LINUX`     : Linux, including Android.
+ * - `HAS_ANDROID`   : Android.
+ * - `HAS_DARWIN`    : Darwin,  either  `HAS_MACOS`  or
+ *                     `HAS_IOS`.
+ * - `HAS_BSD`       : BSD family.
+ * - `HAS_FREEBSD`   : FreeBSD.
+ * - `HAS_NETBSD`    : NetBSD.
+ * - `HAS_OPENBSD`   : OpenBSD.
+ * - `HAS_DRAGONFLY` : DragonFly BSD.
+ * - `HAS_SOLARIS`   : Solaris and illumos.
+ * - `HAS_WINDOWS`   : Windows, `HAS_WIN64` if 64-bit.
+ * - `HAS_CYGWIN`    : Cygwin.
+ * - `HAS_WASI`      : WebAssembly System Interface.
+ * - `HAS_UNIX`      : Any of the Unix-like above.
+ *
+ * `HAS_GLIBC`  is  defined  when targeting the  GNU  C
+ * library, `GLIBC` then holding its version encoded as
+ * `MMmm00`,   and  `HAS_BIONIC`  when  targeting   the
+ * Android C library.
+ *
+ * If  defined,  the  following  means  the  respective
+ * interface is declared by the system headers :
+ *
+ * - `HAS_MMAP`          : `mmap`.
+ * - `HAS_MAP_POPULATE`  : `MAP_POPULATE`.
+ * - `HAS_MAP_HUGETLB`   : `MAP_HUGETLB`.
+ * - `HAS_MADV_HUGEPAGE` : `MADV_HUGEPAGE`.
+ * - `HAS_MEMFD_CREATE`  : `memfd_create`.
+ * - `HAS_SENDFILE`      : `sendfile`.
+ * - `HAS_SPLICE`        : `splice`.
+ * - `HAS_EPOLL`         : `epoll`.
+ * - `HAS_IO_URING`      : `io_uring`.
+ * - `HAS_LIBURING`      : `liburing`.
+ * - `HAS_KQUEUE`        : `kqueue`.
+ * - `HAS_IOCP`          : I/O completion ports.
+ * - `HAS_RSEQ`          : Restartable sequences.
+ *
+ * These  are  compile  time guarantees  only  and  say
+ * nothing about the kernel the program eventually runs
+ * on, which may predate the interface or forbid it, as
+ * seccomp  policies and container runtimes commonly do
+ * for  `io_uring`. Callers must still handle `ENOSYS`,
+ * `EINVAL`  and  `EPERM`  at  runtime  and  fall  back
+ * accordingly.
+ *
+ * The  Linux specific interfaces are furthermore  only
+ * declared  by  the C library under  `_GNU_SOURCE`  or
+ * `_DEFAULT_SOURCE`,  which  translation units  making
+ * use  of them must define before including any system
+ * header.
+ *
+ * `sendfile`  is  not  portable either,  the  BSD  and
+ * Darwin  flavours  sending a file to a  socket  only,
+ * with a different signature.
+ *
+ * Sources :
+ *
+ * - https://sourceforge.net/p/predef/wiki/OperatingSystems/
+ * - https://sourceforge.net/p/predef/wiki/Libraries/
+ * - https://man7.org/linux/man-pages/man2/mmap.2.html
+ * - https://man7.org/linux/man-pages/man2/madvise.2.html
+ * - https://man7.org/linux/man-pages/man2/memfd_create.2.html
+ * - https://man7.org/linux/man-pages/man7/io_uring.7.html
+ * - https://man.freebsd.org/cgi/man.cgi?query=kqueue
+ * - https://docs.microsoft.com/en-us/windows/win32/fileio/i-o-completion-ports
+ */
+
+#include "preprocessor/environment/standard.h"
+
+/*! <!-- Operating system identification {{{ -->
+ * @addtogroup  os_identification Operating system identification
+ * @brief Operating system detection macros
+ *
+ * Darwin  only  tells  macOS apart from  its  embedded
+ * siblings  through `<TargetConditionals.h>`, which is
+ * therefore included when targeting it.
+ * @{
+ */
+
+#if defined(__linux__) || defined(__linux) || defined(__gnu_linux__)
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_LINUX
+#endif
+
+#ifdef __ANDROID__
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_ANDROID
+#endif
+
+#if defined(__APPLE__) && defined(__MACH__)
+
+#  include <TargetConditionals.h>
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_DARWIN
+
+#  if defined(TARGET_OS_OSX) && TARGET_OS_OSX
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MACOS
+#  elif defined(TARGET_OS_IPHONE) && TARGET_OS_IPHONE
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_IOS
+#  else
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MACOS
+#  endif
+
+#endif
+
+#ifdef __FreeBSD__
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_FREEBSD
+#endif
+
+#ifdef __NetBSD__
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_NETBSD
+#endif
+
+#ifdef __OpenBSD__
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_OPENBSD
+#endif
+
+#ifdef __DragonFly__
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_DRAGONFLY
+#endif
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_FREEBSD)                   \
+ || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_NETBSD)                    \
+ || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_OPENBSD)                   \
+ || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_DRAGONFLY)
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_BSD
+#endif
+
+#if defined(__sun) && (defined(__SVR4) || defined(__svr4__))
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_SOLARIS
+#endif
+
+#ifdef _WIN32
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS
+
+#  ifdef _WIN64
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WIN64
+#  endif
+
+#endif
+
+#ifdef __CYGWIN__
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_CYGWIN
+#endif
+
+#ifdef __wasi__
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WASI
+#endif
+
+#if defined(__unix__) || defined(__unix)                                      \
+ || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_LINUX)                     \
+ || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_DARWIN)
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_UNIX
+#endif
+
+/*! @} <!-- }}} Operating system identification --> */
+
+/*! <!-- C library identification {{{ -->
+ * @addtogroup  os_libc C library identification
+ * @brief C library detection macros
+ *
+ * C    libraries    advertise    themselves    through
+ * `<features.h>`  and  `<sys/cdefs.h>`, neither  being
+ * standard.  `<limits.h>` is included instead since it
+ * pulls  the  former in on glibc and the latter in  on
+ * bionic,  at  no noticeable cost.  musl  deliberately
+ * provides no identification macro and is thus assumed
+ * by elimination where needed.
+ *
+ * glibc  only shipped `<threads.h>` with version  2.28
+ * while    claiming    C11   support   long    before,
+ * `REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_THREADS`
+ * is therefore withdrawn against older versions.
+ * @{
+ */
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_UNIX)
+#  include <limits.h>
+#endif
+
+#if defined(__GLIBC__) && !defined(__UCLIBC__)
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_GLIBC
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_GLIBC                            \
+      (__GLIBC__ * 10000 + __GLIBC_MINOR__ * 100)
+
+#  if !defined(__cplusplus)                                                   \
+   && REBOOT_PREPROCESSOR_ENVIRONMENT_OS_GLIBC < 22800
+#     undef REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_THREADS
+#  endif
+
+#endif
+
+#ifdef __BIONIC__
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_BIONIC
+#endif
+
+/*! @} <!-- }}} C library identification --> */
+
+/*! <!-- Memory mapping {{{ -->
+ * @addtogroup  os_memory Memory mapping
+ * @brief Virtual memory interface detection macros
+ *
+ * `MAP_POPULATE`,  `MAP_HUGETLB`  and  `MADV_HUGEPAGE`
+ * have  been  part of Linux since 2.5.46,  2.6.32  and
+ * 2.6.38 respectively, which every supported C library
+ * requires,  and  are therefore  assumed.  Transparent
+ * huge  pages may nonetheless be disabled system wide,
+ * turning `madvise` into a no-op.
+ *
+ * `memfd_create`  predates its C library wrappers by a
+ * few  years,  which  only appeared with  glibc  2.27,
+ * bionic for API level 30, musl 1.1.20 and FreeBSD 13.
+ * @{
+ */
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_UNIX)                      \
+ && !defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_CYGWIN)
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MMAP
+#endif
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_LINUX)
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MAP_POPULATE
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MAP_HUGETLB
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MADV_HUGEPAGE
+
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_GLIBC)
+#     if REBOOT_PREPROCESSOR_ENVIRONMENT_OS_GLIBC >= 22700
+#        define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MEMFD_CREATE
+#     endif
+#  elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_BIONIC)
+#     if defined(__ANDROID_API__) && __ANDROID_API__ >= 30
+#        define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MEMFD_CREATE
+#     endif
+#  else
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MEMFD_CREATE
+#  endif
+
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_FREEBSD)
+
+#  if __FreeBSD__ >= 13
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MEMFD_CREATE
+#  endif
+
+#endif
+
+/*! @} <!-- }}} Memory mapping --> */
+
+/*! <!-- Input/output {{{ -->
+ * @addtogroup  os_io Input/output
+ * @brief Event notification and zero-copy interface detection macros
+ *
+ * `io_uring`  is detected through the presence of  its
+ * kernel  header, which ships with the kernel  headers
+ * since  Linux  5.1,  rather than through  the  kernel
+ * version alone since distributions routinely backport
+ * it.  Android  is ruled out since its seccomp  policy
+ * forbids  it to applications. A preprocessor  lacking
+ * `__has_include`   conservatively   reports   neither
+ * `io_uring` nor `liburing`.
+ * @{
+ */
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_LINUX)
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_SENDFILE
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_SPLICE
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_EPOLL
+
+#  if !defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_ANDROID)                \
+   &&  defined(__has_include)
+#     if __has_include(<linux/io_uring.h>)
+#        define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_IO_URING
+#     endif
+#     if __has_include(<liburing.h>)
+#        define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_LIBURING
+#     endif
+#  endif
+
+#endif
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_FREEBSD)                   \
+ || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_DRAGONFLY)                 \
+ || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_DARWIN)                    \
+ || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_SOLARIS)
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_SENDFILE
+#endif
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_BSD)                       \
+ || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_DARWIN)
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_KQUEUE
+#endif
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_IOCP
+#endif
+
+/*! @} <!-- }}} Input/output --> */
+
+/*! <!-- Scheduling {{{ -->
+ * @addtogroup  os_scheduling Scheduling
+ * @brief Restartable sequences detection macros
+ *
+ * The  GNU C library registers a restartable  sequence
+ * area  for  every  thread since 2.35,  declaring  its
+ * location  in  `<sys/rseq.h>`,  in which  the  kernel
+ * keeps the number of the processor the thread runs on
+ * up  to  date. Registration only happens at  runtime,
+ * and  is  skipped on kernels older than 4.18 or  when
+ * the   `glibc.pthread.rseq`   tunable  disables   it,
+ * `__rseq_size` then being `0`.
+ * @{
+ */
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_LINUX)                     \
+ && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_GLIBC)
+#  if REBOOT_PREPROCESSOR_ENVIRONMENT_OS_GLIBC >= 23500
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_RSEQ
+#  endif
+#endif
+
+/*! @} <!-- }}} Scheduling --> */
+
+#endif /* __REBOOT_PREPROCESSOR_ENVIRONMENT_OS_H__ */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
@@ -8,6 +8,16 @@
  *                                                   *
  *************************************************** */
 
+/*!
+ * The  configuration generated at configure time, see
+ * `cmake/RebootDetect.cmake`, defines every macro  of
+ * the  environment  headers, include guards  included,
+ * which then skip their ladders altogether.
+ */
+#ifdef REBOOT_USE_GENERATED_CONFIG
+#  include "reboot_config.h"
+#endif
+
 #ifndef __REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_H__
 #define __REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_H__
 
@@ -42,13 +52,24 @@
  * - `C99`           : C99     / ISO/IEC 9899:1999
  * - `C11`           : C11     / ISO/IEC 9899:2011
  * - `C17`,  `C18`   : C18     / ISO/IEC 9899:2018
+ * - `C23`           : C23     / ISO/IEC 9899:2024
  * - `CPP97`,`CPP98` : C++98   / ISO/IEC 14882:1998
  * - `CPP11`         : C++11   / ISO/IEC 14882:2011
  * - `CPP14`         : C++14   / ISO/IEC 14882:2014
  * - `CPP17`         : C++17   / ISO/IEC 14882:2017
+ * - `CPP20`         : C++20   / ISO/IEC 14882:2020
+ * - `CPP23`         : C++23   / ISO/IEC 14882:2024
  * - `CPP_CLI`       : C++/CLI / ECMA-372
  * - `CPP_EMB`       : Embedded C++
  *
+ * If  defined,  the  following  means  the  respective
+ * optional part of the standard library is available :
+ *
+ * - `HAS_ATOMICS` : `<stdatomic.h>`  in C,  `<atomic>`
+ *                   in C++.
+ * - `HAS_THREADS` : `<threads.h>`  in C, `<thread>` in
+ *                   C++.
+ *
  * The many architectures  and compiler implementations
  * have  created much  inconsistencies  over time  and,
  * pertaining to  this file  only, the  provided macros
@@ -188,9 +209,46 @@
  */
 #  ifdef __STDC_VERSION__
 
-/* TODO(scheatkode): Add C2X preprocessor once finalized. */
+#     if (__STDC_VERSION__ >= 202311L)
 
-#     if (__STDC_VERSION__ >= 201710L)
+/*!
+ * @def   REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_C23
+ * @brief C23 detection macro.
+ *
+ * This  macro  is defined when the  ISO/IEC  9899:2024
+ * standard   of   the  C  language  was   successfully
+ * detected.   It  should  be  safe  to  test  for  the
+ * existance of this macro for C23 exclusive features.
+ */
+
+#        define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_C 202311L
+#        define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_C23
+
+/*!
+ * @def   REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_AT_LEAST_C23
+ * @brief C23 minimum version detection macro.
+ *
+ * This  macro is defined when **at least** the ISO/IEC
+ * 9899:2024   standard   of   the   C   language   was
+ * successfully detected. It should be safe to test for
+ * the  existance  of  this  macro  for  C23  exclusive
+ * features.
+ */
+
+#        define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_AT_LEAST_C23
+#        define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_AT_LEAST_C17
+#        define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_AT_LEAST_C11
+#        define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_AT_LEAST_C99
+#        define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_AT_LEAST_C94
+#        define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_AT_LEAST_C89
+
+/*!
+ * Drafts  of  the  C23 standard,  a.k.a.  C2X,  report
+ * intermediate   values  such  as  `202000L`  and  are
+ * therefore detected as C17, which they are a superset
+ * of.
+ */
+#     elif (__STDC_VERSION__ >= 201710L)
 
 /*!
  * @def   REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_C17
@@ -206,8 +264,18 @@
 #        define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_C17
 #        define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_C18
 
+/*!
+ * @def   REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_AT_LEAST_C17
+ * @brief C17 minimum version detection macro.
+ *
+ * This  macro is defined when **at least** the ISO/IEC
+ * 9899:2018   standard   of   the   C   language   was
+ * successfully detected. It should be safe to test for
+ * the  existance  of  this  macro  for  C17  exclusive
+ * features.
+ */
 
-
+#        define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_AT_LEAST_C17
 #        define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_AT_LEAST_C11
 #        define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_AT_LEAST_C99
 #        define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_AT_LEAST_C94
@@ -346,7 +414,18 @@
  */
 #ifdef __cplusplus
 
-#  if (__cplusplus >= 199707L) /*!< HP aC++ uses 199707L instead of 199711L */
+/*!
+ * MSVC keeps `__cplusplus` at `199711L` unless invoked
+ * with   `/Zc:__cplusplus`,  the  actual  value  being
+ * exposed through `_MSVC_LANG` instead.
+ */
+#  if defined(_MSVC_LANG) && (_MSVC_LANG > __cplusplus)
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPLUSPLUS_ _MSVC_LANG
+#  else
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPLUSPLUS_ __cplusplus
+#  endif
+
+#  if (REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPLUSPLUS_ >= 199707L) /*!< HP aC++ uses 199707L instead of 199711L */
 #     undef  REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP
 #     define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP 199711L
 #     define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP98
@@ -359,24 +438,36 @@
  * specifically.
  */
 
-#  if (__cplusplus >= 201103L)
+#  if (REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPLUSPLUS_ >= 201103L)
 #     undef  REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP
 #     define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP 201103L
 #     define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP11
 #  endif
 
-#  if (__cplusplus >= 201402L)
+#  if (REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPLUSPLUS_ >= 201402L)
 #     undef  REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP
 #     define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP 201402L
 #     define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP14
 #  endif
 
-#  if (__cplusplus >= 201703L)
+#  if (REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPLUSPLUS_ >= 201703L)
 #     undef  REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP
 #     define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP 201703L
 #     define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP17
 #  endif
 
+#  if (REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPLUSPLUS_ >= 202002L)
+#     undef  REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP 202002L
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP20
+#  endif
+
+#  if (REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPLUSPLUS_ >= 202302L)
+#     undef  REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP 202302L
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP23
+#  endif
+
 #  ifndef REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP
 #  endif
 
@@ -433,6 +524,123 @@
 #endif /* <!-- Embedded C++ }}} --> */
 /* <!-- C++ }}} --> */
 
+/*! <!-- Optional features {{{ -->
+ * @addtogroup  standard_optional Optional features
+ * @brief Optional standard library detection macros
+ *
+ * C11   made   atomics   and  threads   optional,   an
+ * implementation  lacking  either  being  required  to
+ * define            `__STDC_NO_ATOMICS__`           or
+ * `__STDC_NO_THREADS__`  respectively.  C++11, on  the
+ * other     hand,    mandates    both    for    hosted
+ * implementations.
+ *
+ * Some  C  libraries  are known to claim  C11  support
+ * without    shipping   `<threads.h>`   nor   defining
+ * `__STDC_NO_THREADS__`,  namely glibc prior to  2.28.
+ * Including `preprocessor/environment/os.h` is advised
+ * to rule these out.
+ * @{
+ */
+
+/*!
+ * @def   REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_ATOMICS
+ * @brief Standard atomics detection macro.
+ *
+ * This  macro  is  defined when  the  standard  atomic
+ * operations     library     is    available,     i.e.
+ * `<stdatomic.h>` when compiling C and `<atomic>` when
+ * compiling C++.
+ */
+
+/*!
+ * @def   REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_THREADS
+ * @brief Standard threads detection macro.
+ *
+ * This  macro  is  defined when  the  standard  thread
+ * support  library  is available,  i.e.  `<threads.h>`
+ * when compiling C and `<thread>` when compiling C++.
+ */
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP11)
+
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_ATOMICS
+#  define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_THREADS
+
+#elif !defined(__cplusplus)                                                   \
+   && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_AT_LEAST_C11)
+
+#  ifndef __STDC_NO_ATOMICS__
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_ATOMICS
+#  endif
+
+#  ifndef __STDC_NO_THREADS__
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_THREADS
+#  endif
+
+#endif /*! @} <!-- }}} Optional features --> */
+
+/*! <!-- C++ feature tests {{{ -->
+ * @addtogroup  standard_cpp_features C++ feature tests
+ * @brief C++ feature-test macro wrappers
+ *
+ * C++20   standardized   the  `__cpp_*`   feature-test
+ * macros,  which compilers had already been  providing
+ * for  a while and which describe the availability  of
+ * individual   features   more  accurately  than   the
+ * standard   version   alone,  implementations   often
+ * lagging behind for some of them.
+ *
+ * The  language  macros  are  predefined  whereas  the
+ * library  ones,  `__cpp_lib_*`,  are defined  by  the
+ * standard  headers, all of which include `<version>`.
+ * The  latter  is therefore included  beforehand  when
+ * available  as  it  is cheap enough  to  be  included
+ * everywhere.
+ *
+ * `__has_cpp_attribute` is tested for existence on its
+ * own  since  a  preprocessor unaware of it  fails  to
+ * evaluate  its  invocation, even on  the  unevaluated
+ * side of a logical operator.
+ * @{
+ */
+#ifdef __cplusplus
+
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_CPP20)
+#     include <version>
+#  elif defined(__has_include)
+#     if __has_include(<version>)
+#        include <version>
+#     endif
+#  endif
+
+#  if defined(__cpp_consteval) && (__cpp_consteval >= 201811L)
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_CONSTEVAL
+#  endif
+
+#  if defined(__cpp_impl_coroutine) && (__cpp_impl_coroutine >= 201902L)      \
+   && defined(__cpp_lib_coroutine)  && (__cpp_lib_coroutine  >= 201902L)
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_COROUTINES
+#  endif
+
+#  if defined(__cpp_lib_assume_aligned)                                       \
+   && (__cpp_lib_assume_aligned >= 201811L)
+#     define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_ASSUME_ALIGNED
+#  endif
+
+/*!
+ * MSVC    accepts   `[[no_unique_address]]`    without
+ * honoring  it for ABI compatibility reasons, honoring
+ * `[[msvc::no_unique_address]]`   instead,  hence  its
+ * exclusion.
+ */
+#  if defined(__has_cpp_attribute) && !defined(_MSC_VER)
+#     if __has_cpp_attribute(no_unique_address) >= 201803L
+#        define REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_NO_UNIQUE_ADDRESS
+#     endif
+#  endif
+
+#endif /*! @} <!-- }}} C++ feature tests --> */
+
 #endif /* __REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_H__ */
 
 /* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
@@ -0,0 +1,602 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+#ifndef __REBOOT_RING_H__
+#define __REBOOT_RING_H__
+
+/*!
+ * @file  ring.h
+ * @brief Bounded lock-free queues.
+ *
+ * This header provides two bounded queues of pointers,
+ * both ring buffers whose capacity is a power of two :
+ *
+ * - `reboot_ring_spsc` : Single producer and consumer.
+ * - `reboot_ring_mpmc` : Multiple producers and consumers.
+ *
+ * Each   offers  `init`,  `destroy`,  `push`,   `pop`,
+ * `push_batch`   and   `pop_batch`   functions,   e.g.
+ * `reboot_ring_mpmc_push_batch`.     Single    element
+ * operations  return  `1` on success and `0` when  the
+ * queue  is respectively full or empty, the batch ones
+ * the  number of elements actually transferred,  which
+ * may  be  less than requested. They never  block  nor
+ * spin, waiting being left to the caller.
+ *
+ * Indices   written  by  the  producers  and  by   the
+ * consumers  live  on  cache lines of their  own,  see
+ * `REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_CACHE_LINE_SIZE`,
+ * the  single producer and consumer queue additionally
+ * caching the index of the opposite side so as to only
+ * read it, and thus pull its cache line over, when the
+ * queue  looks  full  or empty. Batches  amortize  the
+ * index  updates,  and  in the multiple  producer  and
+ * consumer  queue  the swap claiming the  slots,  over
+ * every element they carry.
+ *
+ * Atomic   operations   map  to   `std::atomic`   when
+ * compiling  C++ and to `<stdatomic.h>` when compiling
+ * C  wherever the detected standard provides them, see
+ * `REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_ATOMICS`,
+ * and  to  the  GNU `__atomic` builtins  or  the  MSVC
+ * interlocked  intrinsics otherwise. Every one of them
+ * shares  the layout of the plain integer it wraps  on
+ * the  supported  targets, a queue thus  being  usable
+ * from     C     and     C++     components     alike.
+ * `REBOOT_RING_HAS_ATOMICS` is defined whenever any of
+ * them  is available, the queues being left  undefined
+ * otherwise.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "preprocessor/environment/architecture.h"
+#include "preprocessor/environment/compiler.h"
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_ATOMICS)             \
+ && defined(__cplusplus)
+#  include <atomic>
+#  define REBOOT_RING_HAS_ATOMICS
+#  define REBOOT_RING_ATOMIC_(type) std::atomic<type>
+#  define REBOOT_RING_RELAXED_      std::memory_order_relaxed
+#  define REBOOT_RING_ACQUIRE_      std::memory_order_acquire
+#  define REBOOT_RING_RELEASE_      std::memory_order_release
+#  define REBOOT_RING_LOAD_(p, order)                                         \
+      std::atomic_load_explicit((p), (order))
+#  define REBOOT_RING_STORE_(p, value, order)                                 \
+      std::atomic_store_explicit((p), (value), (order))
+#  define REBOOT_RING_CAS_(p, expected, desired)                              \
+      std::atomic_compare_exchange_weak_explicit(                             \
+         (p), (expected), (desired),                                          \
+         std::memory_order_relaxed, std::memory_order_relaxed                 \
+      )
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_STANDARD_HAS_ATOMICS)
+#  include <stdatomic.h>
+#  define REBOOT_RING_HAS_ATOMICS
+#  define REBOOT_RING_ATOMIC_(type) _Atomic(type)
+#  define REBOOT_RING_RELAXED_      memory_order_relaxed
+#  define REBOOT_RING_ACQUIRE_      memory_order_acquire
+#  define REBOOT_RING_RELEASE_      memory_order_release
+#  define REBOOT_RING_LOAD_(p, order)                                         \
+      atomic_load_explicit((p), (order))
+#  define REBOOT_RING_STORE_(p, value, order)                                 \
+      atomic_store_explicit((p), (value), (order))
+#  define REBOOT_RING_CAS_(p, expected, desired)                              \
+      atomic_compare_exchange_weak_explicit(                                  \
+         (p), (expected), (desired),                                          \
+         memory_order_relaxed, memory_order_relaxed                           \
+      )
+#elif defined(__ATOMIC_ACQUIRE)
+#  define REBOOT_RING_HAS_ATOMICS
+#  define REBOOT_RING_ATOMIC_(type) type
+#  define REBOOT_RING_RELAXED_      __ATOMIC_RELAXED
+#  define REBOOT_RING_ACQUIRE_      __ATOMIC_ACQUIRE
+#  define REBOOT_RING_RELEASE_      __ATOMIC_RELEASE
+#  define REBOOT_RING_LOAD_(p, order)                                         \
+      __atomic_load_n((p), (order))
+#  define REBOOT_RING_STORE_(p, value, order)                                 \
+      __atomic_store_n((p), (value), (order))
+#  define REBOOT_RING_CAS_(p, expected, desired)                              \
+      __atomic_compare_exchange_n(                                            \
+         (p), (expected), (desired), 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED    \
+      )
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)
+#  include <intrin.h>
+#  define REBOOT_RING_HAS_ATOMICS
+#  define REBOOT_RING_MSVC_
+#  define REBOOT_RING_ATOMIC_(type) volatile type
+#  define REBOOT_RING_RELAXED_      0
+#  define REBOOT_RING_ACQUIRE_      1
+#  define REBOOT_RING_RELEASE_      2
+#  define REBOOT_RING_LOAD_(p, order)                                         \
+      reboot_ring_load_((p), (order))
+#  define REBOOT_RING_STORE_(p, value, order)                                 \
+      reboot_ring_store_((p), (value), (order))
+#  define REBOOT_RING_CAS_(p, expected, desired)                              \
+      reboot_ring_cas_((p), (expected), (desired))
+#endif
+
+#if defined(REBOOT_RING_HAS_ATOMICS)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! <!-- MSVC atomics {{{ -->
+ * @addtogroup  ring_msvc MSVC atomics
+ * @brief Interlocked equivalents of the atomic operations
+ *
+ * Aligned  loads and stores are atomic on every target
+ * MSVC  supports. x86 orders them as needed on its own
+ * and  they only need to be kept from being  reordered
+ * by  the  compiler, whereas ARM requires an  explicit
+ * barrier.
+ * @{
+ */
+#if defined(REBOOT_RING_MSVC_)
+
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM64)
+#     define REBOOT_RING_FENCE_() __dmb(_ARM64_BARRIER_ISH)
+#  elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM)
+#     define REBOOT_RING_FENCE_() __dmb(_ARM_BARRIER_ISH)
+#  else
+#     define REBOOT_RING_FENCE_() _ReadWriteBarrier()
+#  endif
+
+static REBOOT_INLINE size_t
+reboot_ring_load_(volatile size_t *p, int order)
+{
+   size_t value = *p;
+
+   if (order == REBOOT_RING_ACQUIRE_) {
+      REBOOT_RING_FENCE_();
+   }
+
+   return value;
+}
+
+static REBOOT_INLINE void
+reboot_ring_store_(volatile size_t *p, size_t value, int order)
+{
+   if (order == REBOOT_RING_RELEASE_) {
+      REBOOT_RING_FENCE_();
+   }
+
+   *p = value;
+}
+
+static REBOOT_INLINE int
+reboot_ring_cas_(volatile size_t *p, size_t *expected, size_t desired)
+{
+   size_t seen;
+
+#  if defined(_WIN64)
+   seen = (size_t) _InterlockedCompareExchange64(
+      (volatile __int64 *) p, (__int64) desired, (__int64) *expected
+   );
+#  else
+   seen = (size_t) _InterlockedCompareExchange(
+      (volatile long *) p, (long) desired, (long) *expected
+   );
+#  endif
+
+   if (seen == *expected) {
+      return 1;
+   }
+
+   *expected = seen;
+
+   return 0;
+}
+
+#endif /*! @} <!-- }}} MSVC atomics --> */
+
+/*!
+ * @brief Capacity rounding.
+ */
+static REBOOT_INLINE size_t
+reboot_ring_capacity_(size_t capacity)
+{
+   size_t rounded = 1;
+
+   while (rounded < capacity && rounded != 0) {
+      rounded <<= 1;
+   }
+
+   return rounded;
+}
+
+/*! <!-- Single producer and consumer {{{ -->
+ * @addtogroup  ring_spsc Single producer and consumer
+ * @brief Wait-free single producer and consumer queue
+ *
+ * Only one thread may push and only one thread may pop
+ * at  any  given time, both possibly being  the  same.
+ * Both sides are wait-free.
+ * @{
+ */
+
+/*!
+ * @brief Single producer and consumer queue.
+ */
+typedef struct reboot_ring_spsc {
+   REBOOT_CACHE_ALIGNED REBOOT_RING_ATOMIC_(size_t) head;
+   size_t                                          tail_cache;
+   REBOOT_CACHE_ALIGNED REBOOT_RING_ATOMIC_(size_t) tail;
+   size_t                                          head_cache;
+   REBOOT_CACHE_ALIGNED void                     **slots;
+   size_t                                          mask;
+} reboot_ring_spsc_t;
+
+/*!
+ * @brief Queue initialization.
+ *
+ * This function initializes an empty `ring` holding up
+ * to  `capacity`  elements, rounded up to a  power  of
+ * two.  It returns `0` on success and `-1` when out of
+ * memory.
+ */
+static REBOOT_INLINE int
+reboot_ring_spsc_init(reboot_ring_spsc_t *ring, size_t capacity)
+{
+   capacity = reboot_ring_capacity_(capacity);
+
+   if (capacity == 0 || capacity > SIZE_MAX / sizeof(void *)) {
+      return -1;
+   }
+
+   ring->slots = (void **) malloc(capacity * sizeof(void *));
+
+   if (ring->slots == NULL) {
+      return -1;
+   }
+
+   REBOOT_RING_STORE_(&ring->head, (size_t) 0, REBOOT_RING_RELAXED_);
+   REBOOT_RING_STORE_(&ring->tail, (size_t) 0, REBOOT_RING_RELAXED_);
+
+   ring->head_cache = 0;
+   ring->tail_cache = 0;
+   ring->mask       = capacity - 1u;
+
+   return 0;
+}
+
+/*!
+ * @brief Queue finalization.
+ */
+static REBOOT_INLINE void
+reboot_ring_spsc_destroy(reboot_ring_spsc_t *ring)
+{
+   free(ring->slots);
+
+   ring->slots = NULL;
+}
+
+/*!
+ * @brief Batch push.
+ *
+ * This  function pushes up to `count` elements out  of
+ * `items` and returns how many were pushed.
+ */
+static REBOOT_INLINE size_t
+reboot_ring_spsc_push_batch(
+   reboot_ring_spsc_t *ring, void *const *items, size_t count
+) {
+   size_t tail = REBOOT_RING_LOAD_(&ring->tail, REBOOT_RING_RELAXED_);
+   size_t room = ring->mask + 1u - (tail - ring->head_cache);
+   size_t i;
+
+   if (room < count) {
+      ring->head_cache = REBOOT_RING_LOAD_(&ring->head, REBOOT_RING_ACQUIRE_);
+      room             = ring->mask + 1u - (tail - ring->head_cache);
+
+      if (room < count) {
+         count = room;
+      }
+   }
+
+   for (i = 0; i < count; ++i) {
+      ring->slots[(tail + i) & ring->mask] = items[i];
+   }
+
+   if (count != 0) {
+      REBOOT_RING_STORE_(&ring->tail, tail + count, REBOOT_RING_RELEASE_);
+   }
+
+   return count;
+}
+
+/*!
+ * @brief Batch pop.
+ *
+ * This  function  pops  up to  `count`  elements  into
+ * `items` and returns how many were popped.
+ */
+static REBOOT_INLINE size_t
+reboot_ring_spsc_pop_batch(
+   reboot_ring_spsc_t *ring, void **items, size_t count
+) {
+   size_t head      = REBOOT_RING_LOAD_(&ring->head, REBOOT_RING_RELAXED_);
+   size_t available = ring->tail_cache - head;
+   size_t i;
+
+   if (available < count) {
+      ring->tail_cache = REBOOT_RING_LOAD_(&ring->tail, REBOOT_RING_ACQUIRE_);
+      available        = ring->tail_cache - head;
+
+      if (available < count) {
+         count = available;
+      }
+   }
+
+   for (i = 0; i < count; ++i) {
+      items[i] = ring->slots[(head + i) & ring->mask];
+   }
+
+   if (count != 0) {
+      REBOOT_RING_STORE_(&ring->head, head + count, REBOOT_RING_RELEASE_);
+   }
+
+   return count;
+}
+
+/*!
+ * @brief Push.
+ */
+static REBOOT_INLINE int
+reboot_ring_spsc_push(reboot_ring_spsc_t *ring, void *item)
+{
+   return (int) reboot_ring_spsc_push_batch(ring, &item, 1);
+}
+
+/*!
+ * @brief Pop.
+ */
+static REBOOT_INLINE int
+reboot_ring_spsc_pop(reboot_ring_spsc_t *ring, void **item)
+{
+   return (int) reboot_ring_spsc_pop_batch(ring, item, 1);
+}
+
+/*! @} <!-- }}} Single producer and consumer --> */
+
+/*! <!-- Multiple producers and consumers {{{ -->
+ * @addtogroup  ring_mpmc Multiple producers and consumers
+ * @brief Lock-free multiple producer and consumer queue
+ *
+ * This  is  Dmitry Vyukov's bounded queue,  each  slot
+ * carrying  a  sequence number telling the lap  it  is
+ * free  or  full  for. Producers and  consumers  claim
+ * slots  by advancing their index with a swap and then
+ * publish  them by updating their sequence, contention
+ * thus  being  limited  to the index itself.  A  batch
+ * claims as many consecutive slots as are ready with a
+ * single swap.
+ *
+ * A  thread  preempted  between claiming  a  slot  and
+ * publishing  it  holds up the opposite side  once  it
+ * reaches  that slot, which makes the queue  lock-free
+ * in practice but not strictly so.
+ * @{
+ */
+
+typedef struct reboot_ring_cell_ {
+   REBOOT_RING_ATOMIC_(size_t) sequence;
+   void                       *item;
+} reboot_ring_cell_;
+
+/*!
+ * @brief Multiple producer and consumer queue.
+ */
+typedef struct reboot_ring_mpmc {
+   REBOOT_CACHE_ALIGNED REBOOT_RING_ATOMIC_(size_t) head;
+   REBOOT_CACHE_ALIGNED REBOOT_RING_ATOMIC_(size_t) tail;
+   REBOOT_CACHE_ALIGNED reboot_ring_cell_         *cells;
+   size_t                                          mask;
+} reboot_ring_mpmc_t;
+
+/*!
+ * @brief Queue initialization.
+ *
+ * This function initializes an empty `ring` holding up
+ * to  `capacity`  elements, rounded up to a  power  of
+ * two, and at least two. It returns `0` on success and
+ * `-1` when out of memory.
+ */
+static REBOOT_INLINE int
+reboot_ring_mpmc_init(reboot_ring_mpmc_t *ring, size_t capacity)
+{
+   size_t i;
+
+   capacity = reboot_ring_capacity_(capacity < 2 ? 2 : capacity);
+
+   if (capacity == 0 || capacity > SIZE_MAX / sizeof(reboot_ring_cell_)) {
+      return -1;
+   }
+
+   ring->cells = (reboot_ring_cell_ *) malloc(
+      capacity * sizeof(reboot_ring_cell_)
+   );
+
+   if (ring->cells == NULL) {
+      return -1;
+   }
+
+   for (i = 0; i < capacity; ++i) {
+      REBOOT_RING_STORE_(&ring->cells[i].sequence, i, REBOOT_RING_RELAXED_);
+   }
+
+   REBOOT_RING_STORE_(&ring->head, (size_t) 0, REBOOT_RING_RELAXED_);
+   REBOOT_RING_STORE_(&ring->tail, (size_t) 0, REBOOT_RING_RELAXED_);
+
+   ring->mask = capacity - 1u;
+
+   return 0;
+}
+
+/*!
+ * @brief Queue finalization.
+ */
+static REBOOT_INLINE void
+reboot_ring_mpmc_destroy(reboot_ring_mpmc_t *ring)
+{
+   free(ring->cells);
+
+   ring->cells = NULL;
+}
+
+/*!
+ * @brief Ready slot count.
+ *
+ * This  function  counts  the consecutive  slots  from
+ * `position`  whose  sequence is `position +  offset`,
+ * i.e.  that are free for a producer when `offset`  is
+ * `0`  and  full for a consumer when it is `1`, up  to
+ * `count`.
+ */
+static REBOOT_INLINE size_t
+reboot_ring_mpmc_ready_(
+   reboot_ring_mpmc_t *ring, size_t position, size_t offset, size_t count
+) {
+   size_t i;
+
+   for (i = 0; i < count; ++i) {
+      size_t sequence = REBOOT_RING_LOAD_(
+         &ring->cells[(position + i) & ring->mask].sequence,
+         REBOOT_RING_ACQUIRE_
+      );
+
+      if (sequence != position + i + offset) {
+         break;
+      }
+   }
+
+   return i;
+}
+
+/*!
+ * @brief Batch push.
+ *
+ * This  function pushes up to `count` elements out  of
+ * `items` and returns how many were pushed.
+ */
+static REBOOT_INLINE size_t
+reboot_ring_mpmc_push_batch(
+   reboot_ring_mpmc_t *ring, void *const *items, size_t count
+) {
+   size_t tail = REBOOT_RING_LOAD_(&ring->tail, REBOOT_RING_RELAXED_);
+   size_t ready;
+   size_t i;
+
+   for (;;) {
+      ready = reboot_ring_mpmc_ready_(ring, tail, 0, count);
+
+      if (ready != 0) {
+         if (REBOOT_RING_CAS_(&ring->tail, &tail, tail + ready)) {
+            break;
+         }
+      } else {
+         size_t current = REBOOT_RING_LOAD_(&ring->tail, REBOOT_RING_RELAXED_);
+
+         /* Full unless another producer moved on in between. */
+         if (current == tail) {
+            return 0;
+         }
+
+         tail = current;
+      }
+   }
+
+   for (i = 0; i < ready; ++i) {
+      reboot_ring_cell_ *cell = &ring->cells[(tail + i) & ring->mask];
+
+      cell->item = items[i];
+      REBOOT_RING_STORE_(&cell->sequence, tail + i + 1u, REBOOT_RING_RELEASE_);
+   }
+
+   return ready;
+}
+
+/*!
+ * @brief Batch pop.
+ *
+ * This  function  pops  up to  `count`  elements  into
+ * `items` and returns how many were popped.
+ */
+static REBOOT_INLINE size_t
+reboot_ring_mpmc_pop_batch(
+   reboot_ring_mpmc_t *ring, void **items, size_t count
+) {
+   size_t head = REBOOT_RING_LOAD_(&ring->head, REBOOT_RING_RELAXED_);
+   size_t ready;
+   size_t i;
+
+   for (;;) {
+      ready = reboot_ring_mpmc_ready_(ring, head, 1, count);
+
+      if (ready != 0) {
+         if (REBOOT_RING_CAS_(&ring->head, &head, head + ready)) {
+            break;
+         }
+      } else {
+         size_t current = REBOOT_RING_LOAD_(&ring->head, REBOOT_RING_RELAXED_);
+
+         /* Empty unless another consumer moved on in between. */
+         if (current == head) {
+            return 0;
+         }
+
+         head = current;
+      }
+   }
+
+   for (i = 0; i < ready; ++i) {
+      reboot_ring_cell_ *cell = &ring->cells[(head + i) & ring->mask];
+
+      items[i] = cell->item;
+      REBOOT_RING_STORE_(
+         &cell->sequence, head + i + ring->mask + 1u, REBOOT_RING_RELEASE_
+      );
+   }
+
+   return ready;
+}
+
+/*!
+ * @brief Push.
+ */
+static REBOOT_INLINE int
+reboot_ring_mpmc_push(reboot_ring_mpmc_t *ring, void *item)
+{
+   return (int) reboot_ring_mpmc_push_batch(ring, &item, 1);
+}
+
+/*!
+ * @brief Pop.
+ */
+static REBOOT_INLINE int
+reboot_ring_mpmc_pop(reboot_ring_mpmc_t *ring, void **item)
+{
+   return (int) reboot_ring_mpmc_pop_batch(ring, item, 1);
+}
+
+/*! @} <!-- }}} Multiple producers and consumers --> */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REBOOT_RING_HAS_ATOMICS */
+
+#endif /* __REBOOT_RING_H__ */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
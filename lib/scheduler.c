@@ -0,0 +1,1379 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+/*!
+ * @file  scheduler.c
+ * @brief Work-stealing task scheduler.
+ *
+ * The deques follow Lê, Pop, Cohen and Zappa Nardelli,
+ * "Correct and Efficient Work-Stealing for Weak Memory
+ * Models",  PPoPP  2013, with a fixed capacity,  which
+ * spares  thieves from ever following a resized array.
+ * Indices  are unsigned and only ever compared through
+ * their  wrapping  difference, the bottom index of  an
+ * empty deque dropping one below the top one while its
+ * owner looks for a task.
+ *
+ * Task records come from per-worker freelists refilled
+ * by  the  chunk,  and  go back  to  the  freelist  of
+ * whichever  worker  ran them, every list  thus  being
+ * touched  by its owner only. Foreign threads share  a
+ * freelist guarded by the lock of the queue they spawn
+ * into.  Chunks are only ever released along with  the
+ * scheduler.
+ */
+
+/* `sched_yield` in strict modes. */
+#ifndef _DEFAULT_SOURCE
+#  define _DEFAULT_SOURCE
+#endif
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include "scheduler.h"
+#include "preprocessor/environment/architecture.h"
+
+#if defined(REBOOT_SCHEDULER_HAS_THREADS)
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+#     ifndef WIN32_LEAN_AND_MEAN
+#        define WIN32_LEAN_AND_MEAN
+#     endif
+#     include <windows.h>
+#  else
+#     include <pthread.h>
+#     include <sched.h>
+#  endif
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)
+#     include <intrin.h>
+#  endif
+#endif
+
+#if defined(REBOOT_SCHEDULER_HAS_THREADS)
+
+/* <!-- Atomics {{{ --> */
+
+/*!
+ * Every  atomic  object  is  either a  `size_t`  or  a
+ * pointer,  which  share their width on  every  target
+ * MSVC  supports,  its helpers thus operating  on  the
+ * former  and  their callers casting the values  back.
+ * Compare-and-swap  and fetch-and-add are sequentially
+ * consistent, as the deque requires of the former.
+ */
+#if defined(__ATOMIC_ACQUIRE)
+#  define REBOOT_SCHEDULER_RELAXED_ __ATOMIC_RELAXED
+#  define REBOOT_SCHEDULER_ACQUIRE_ __ATOMIC_ACQUIRE
+#  define REBOOT_SCHEDULER_RELEASE_ __ATOMIC_RELEASE
+#  define REBOOT_SCHEDULER_LOAD_(p, order)                                    \
+      __atomic_load_n((p), (order))
+#  define REBOOT_SCHEDULER_STORE_(p, value, order)                            \
+      __atomic_store_n((p), (value), (order))
+#  define REBOOT_SCHEDULER_CAS_(p, expected, desired)                         \
+      __atomic_compare_exchange_n(                                            \
+         (p), (expected), (desired), 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED    \
+      )
+#  define REBOOT_SCHEDULER_ADD_(p, value)                                     \
+      __atomic_fetch_add((p), (value), __ATOMIC_SEQ_CST)
+#  define REBOOT_SCHEDULER_FENCE_() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+#  define REBOOT_SCHEDULER_RELAXED_ 0
+#  define REBOOT_SCHEDULER_ACQUIRE_ 1
+#  define REBOOT_SCHEDULER_RELEASE_ 2
+#  define REBOOT_SCHEDULER_LOAD_(p, order)                                    \
+      reboot_scheduler_load_((volatile size_t *) (p), (order))
+#  define REBOOT_SCHEDULER_STORE_(p, value, order)                            \
+      reboot_scheduler_store_(                                                \
+         (volatile size_t *) (p), (size_t) (value), (order)                   \
+      )
+#  define REBOOT_SCHEDULER_CAS_(p, expected, desired)                         \
+      reboot_scheduler_cas_((volatile size_t *) (p), (expected), (desired))
+#  define REBOOT_SCHEDULER_ADD_(p, value)                                     \
+      reboot_scheduler_add_((volatile size_t *) (p), (size_t) (value))
+#  define REBOOT_SCHEDULER_FENCE_() MemoryBarrier()
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM64)
+#     define REBOOT_SCHEDULER_BARRIER_() __dmb(_ARM64_BARRIER_ISH)
+#  elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM)
+#     define REBOOT_SCHEDULER_BARRIER_() __dmb(_ARM_BARRIER_ISH)
+#  else
+#     define REBOOT_SCHEDULER_BARRIER_() _ReadWriteBarrier()
+#  endif
+
+static size_t
+reboot_scheduler_load_(volatile size_t *p, int order)
+{
+   size_t value = *p;
+
+   if (order == REBOOT_SCHEDULER_ACQUIRE_) {
+      REBOOT_SCHEDULER_BARRIER_();
+   }
+
+   return value;
+}
+
+static void
+reboot_scheduler_store_(volatile size_t *p, size_t value, int order)
+{
+   if (order == REBOOT_SCHEDULER_RELEASE_) {
+      REBOOT_SCHEDULER_BARRIER_();
+   }
+
+   *p = value;
+}
+
+static int
+reboot_scheduler_cas_(volatile size_t *p, size_t *expected, size_t desired)
+{
+   size_t seen;
+
+#  if defined(_WIN64)
+   seen = (size_t) _InterlockedCompareExchange64(
+      (volatile __int64 *) p, (__int64) desired, (__int64) *expected
+   );
+#  else
+   seen = (size_t) _InterlockedCompareExchange(
+      (volatile long *) p, (long) desired, (long) *expected
+   );
+#  endif
+
+   if (seen == *expected) {
+      return 1;
+   }
+
+   *expected = seen;
+
+   return 0;
+}
+
+static size_t
+reboot_scheduler_add_(volatile size_t *p, size_t value)
+{
+#  if defined(_WIN64)
+   return (size_t) _InterlockedExchangeAdd64(
+      (volatile __int64 *) p, (__int64) value
+   );
+#  else
+   return (size_t) _InterlockedExchangeAdd(
+      (volatile long *) p, (long) value
+   );
+#  endif
+}
+#endif
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86)             \
+ && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)
+#  define REBOOT_SCHEDULER_PAUSE_() __builtin_ia32_pause()
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86)           \
+   && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)
+#  define REBOOT_SCHEDULER_PAUSE_() _mm_pause()
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM)           \
+   && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)
+#  define REBOOT_SCHEDULER_PAUSE_() __asm__ volatile ("yield" ::: "memory")
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM)           \
+   && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)
+#  define REBOOT_SCHEDULER_PAUSE_() __yield()
+#else
+#  define REBOOT_SCHEDULER_PAUSE_() ((void) 0)
+#endif
+
+/* <!-- }}} Atomics --> */
+
+/* <!-- Threads {{{ --> */
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+typedef HANDLE             reboot_scheduler_thread_;
+typedef SRWLOCK            reboot_scheduler_lock_;
+typedef CONDITION_VARIABLE reboot_scheduler_condition_;
+
+#  define REBOOT_SCHEDULER_LOCK_INIT_(lock)  InitializeSRWLock(lock)
+#  define REBOOT_SCHEDULER_LOCK_FREE_(lock)  ((void) (lock))
+#  define REBOOT_SCHEDULER_LOCK_(lock)       AcquireSRWLockExclusive(lock)
+#  define REBOOT_SCHEDULER_UNLOCK_(lock)     ReleaseSRWLockExclusive(lock)
+#  define REBOOT_SCHEDULER_COND_INIT_(cond)  InitializeConditionVariable(cond)
+#  define REBOOT_SCHEDULER_COND_FREE_(cond)  ((void) (cond))
+#  define REBOOT_SCHEDULER_SIGNAL_(cond)     WakeConditionVariable(cond)
+#  define REBOOT_SCHEDULER_BROADCAST_(cond)  WakeAllConditionVariable(cond)
+#  define REBOOT_SCHEDULER_SLEEP_(cond, lock)                                 \
+      SleepConditionVariableSRW((cond), (lock), INFINITE, 0)
+#  define REBOOT_SCHEDULER_YIELD_()          SwitchToThread()
+#else
+typedef pthread_t          reboot_scheduler_thread_;
+typedef pthread_mutex_t    reboot_scheduler_lock_;
+typedef pthread_cond_t     reboot_scheduler_condition_;
+
+#  define REBOOT_SCHEDULER_LOCK_INIT_(lock)  pthread_mutex_init((lock), NULL)
+#  define REBOOT_SCHEDULER_LOCK_FREE_(lock)  pthread_mutex_destroy(lock)
+#  define REBOOT_SCHEDULER_LOCK_(lock)       pthread_mutex_lock(lock)
+#  define REBOOT_SCHEDULER_UNLOCK_(lock)     pthread_mutex_unlock(lock)
+#  define REBOOT_SCHEDULER_COND_INIT_(cond)  pthread_cond_init((cond), NULL)
+#  define REBOOT_SCHEDULER_COND_FREE_(cond)  pthread_cond_destroy(cond)
+#  define REBOOT_SCHEDULER_SIGNAL_(cond)     pthread_cond_signal(cond)
+#  define REBOOT_SCHEDULER_BROADCAST_(cond)  pthread_cond_broadcast(cond)
+#  define REBOOT_SCHEDULER_SLEEP_(cond, lock)                                 \
+      pthread_cond_wait((cond), (lock))
+#  define REBOOT_SCHEDULER_YIELD_()          sched_yield()
+#endif
+
+/* <!-- }}} Threads --> */
+
+/* <!-- State {{{ --> */
+
+/*!
+ * Rounds  of  unsuccessful  stealing  a  worker  spins
+ * through  before going to sleep, and a waiting thread
+ * before  yielding,  or  sleeping  when foreign to the
+ * scheduler.
+ */
+#define REBOOT_SCHEDULER_SPINS_ 64u
+
+/*!
+ * Task records allocated at once.
+ */
+#define REBOOT_SCHEDULER_CHUNK_ 256u
+
+#define REBOOT_SCHEDULER_MASK_ ((size_t) REBOOT_SCHEDULER_DEQUE_SIZE - 1u)
+
+#define REBOOT_SCHEDULER_LINE_                                                \
+   REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_CACHE_LINE_SIZE
+
+/*!
+ * Range tasks share the description of their loop.
+ */
+struct reboot_scheduler_loop_ {
+   reboot_scheduler_range_t task;
+   void                    *argument;
+   size_t                   grain;
+};
+
+struct reboot_scheduler_record_ {
+   reboot_scheduler_task_t              task;
+   void                                *argument;
+   reboot_scheduler_group_t            *group;
+   const struct reboot_scheduler_loop_ *loop;
+   size_t                               begin;
+   size_t                               end;
+   struct reboot_scheduler_record_     *next;
+};
+
+struct reboot_scheduler_chunk_ {
+   struct reboot_scheduler_chunk_  *next;
+   struct reboot_scheduler_record_  records[REBOOT_SCHEDULER_CHUNK_];
+};
+
+/*!
+ * The  top  index, written by thieves, and the  bottom
+ * one,  written by the owner, each get a cache line of
+ * their  own.  Workers  are allocated  separately,  on
+ * their node when it is known.
+ */
+struct reboot_scheduler_worker_ {
+   size_t                           top;
+   char                             top_padding[
+      REBOOT_SCHEDULER_LINE_ - sizeof(size_t)
+   ];
+   size_t                           bottom;
+   char                             bottom_padding[
+      REBOOT_SCHEDULER_LINE_ - sizeof(size_t)
+   ];
+   struct reboot_scheduler_record_ *slots[REBOOT_SCHEDULER_DEQUE_SIZE];
+   struct reboot_scheduler_state_  *state;
+   struct reboot_scheduler_record_ *free;
+   struct reboot_scheduler_chunk_  *chunks;
+   const unsigned                  *victims;
+   unsigned                         tiers[3];
+   unsigned                         index;
+   unsigned                         cpu;
+   unsigned                         node;
+   unsigned                         cache;
+   unsigned                         random;
+   int                              pinned;
+   int                              mapped;
+   reboot_scheduler_thread_         thread;
+};
+
+/*!
+ * The  lock  guards the shared queue and freelist, and
+ * the  sleep  of  idle workers and of foreign waiters.
+ * The  queue  length  and  the numbers of sleepers and
+ * waiters are additionally read without it.
+ */
+struct reboot_scheduler_state_ {
+   reboot_scheduler_lock_            lock;
+   reboot_scheduler_condition_       wake;
+   reboot_scheduler_condition_       done;
+   struct reboot_scheduler_record_  *head;
+   struct reboot_scheduler_record_  *tail;
+   struct reboot_scheduler_record_  *free;
+   struct reboot_scheduler_chunk_   *chunks;
+   size_t                            queued;
+   size_t                            sleepers;
+   size_t                            waiters;
+   size_t                            ticket;
+   int                               stopping;
+   unsigned                          worker_count;
+   unsigned                         *victims;
+   struct reboot_scheduler_worker_ **workers;
+};
+
+static REBOOT_THREAD_LOCAL struct reboot_scheduler_worker_
+   *reboot_scheduler_self_;
+
+static struct reboot_scheduler_worker_ *
+reboot_scheduler_worker_(const struct reboot_scheduler_state_ *state)
+{
+   struct reboot_scheduler_worker_ *self = reboot_scheduler_self_;
+
+   return self != NULL && self->state == state ? self : NULL;
+}
+
+static unsigned
+reboot_scheduler_random_(unsigned *state)
+{
+   unsigned x = *state;
+
+   x ^= x << 13;
+   x ^= x >> 17;
+   x ^= x << 5;
+
+   return *state = x;
+}
+
+/* <!-- }}} State --> */
+
+/* <!-- Deque {{{ --> */
+
+static int
+reboot_scheduler_push_(
+   struct reboot_scheduler_worker_ *worker,
+   struct reboot_scheduler_record_ *record
+) {
+   size_t bottom = REBOOT_SCHEDULER_LOAD_(
+      &worker->bottom, REBOOT_SCHEDULER_RELAXED_
+   );
+   size_t top    = REBOOT_SCHEDULER_LOAD_(
+      &worker->top, REBOOT_SCHEDULER_ACQUIRE_
+   );
+
+   if (bottom - top >= (size_t) REBOOT_SCHEDULER_DEQUE_SIZE) {
+      return 0;
+   }
+
+   REBOOT_SCHEDULER_STORE_(
+      &worker->slots[bottom & REBOOT_SCHEDULER_MASK_], record,
+      REBOOT_SCHEDULER_RELAXED_
+   );
+   REBOOT_SCHEDULER_STORE_(
+      &worker->bottom, bottom + 1u, REBOOT_SCHEDULER_RELEASE_
+   );
+
+   return 1;
+}
+
+static struct reboot_scheduler_record_ *
+reboot_scheduler_pop_(struct reboot_scheduler_worker_ *worker)
+{
+   struct reboot_scheduler_record_ *record = NULL;
+   size_t                           bottom;
+   size_t                           top;
+
+   bottom = REBOOT_SCHEDULER_LOAD_(
+      &worker->bottom, REBOOT_SCHEDULER_RELAXED_
+   ) - 1u;
+
+   REBOOT_SCHEDULER_STORE_(&worker->bottom, bottom, REBOOT_SCHEDULER_RELAXED_);
+   REBOOT_SCHEDULER_FENCE_();
+
+   top = REBOOT_SCHEDULER_LOAD_(&worker->top, REBOOT_SCHEDULER_RELAXED_);
+
+   if ((ptrdiff_t) (bottom - top) < 0) {
+      REBOOT_SCHEDULER_STORE_(
+         &worker->bottom, bottom + 1u, REBOOT_SCHEDULER_RELAXED_
+      );
+
+      return NULL;
+   }
+
+   record = (struct reboot_scheduler_record_ *) REBOOT_SCHEDULER_LOAD_(
+      &worker->slots[bottom & REBOOT_SCHEDULER_MASK_],
+      REBOOT_SCHEDULER_RELAXED_
+   );
+
+   if (bottom == top) {
+      /* Last task, raced for against thieves. */
+      if (!REBOOT_SCHEDULER_CAS_(&worker->top, &top, top + 1u)) {
+         record = NULL;
+      }
+
+      REBOOT_SCHEDULER_STORE_(
+         &worker->bottom, bottom + 1u, REBOOT_SCHEDULER_RELAXED_
+      );
+   }
+
+   return record;
+}
+
+static struct reboot_scheduler_record_ *
+reboot_scheduler_steal_(struct reboot_scheduler_worker_ *victim)
+{
+   struct reboot_scheduler_record_ *record;
+   size_t                           bottom;
+   size_t                           top;
+
+   top = REBOOT_SCHEDULER_LOAD_(&victim->top, REBOOT_SCHEDULER_ACQUIRE_);
+
+   REBOOT_SCHEDULER_FENCE_();
+
+   bottom = REBOOT_SCHEDULER_LOAD_(
+      &victim->bottom, REBOOT_SCHEDULER_ACQUIRE_
+   );
+
+   if ((ptrdiff_t) (bottom - top) <= 0) {
+      return NULL;
+   }
+
+   record = (struct reboot_scheduler_record_ *) REBOOT_SCHEDULER_LOAD_(
+      &victim->slots[top & REBOOT_SCHEDULER_MASK_], REBOOT_SCHEDULER_RELAXED_
+   );
+
+   /* A lost race only ever means someone else got it. */
+   return REBOOT_SCHEDULER_CAS_(&victim->top, &top, top + 1u) ? record : NULL;
+}
+
+static int
+reboot_scheduler_empty_(const struct reboot_scheduler_worker_ *worker)
+{
+   size_t top    = REBOOT_SCHEDULER_LOAD_(
+      &worker->top, REBOOT_SCHEDULER_RELAXED_
+   );
+   size_t bottom = REBOOT_SCHEDULER_LOAD_(
+      &worker->bottom, REBOOT_SCHEDULER_RELAXED_
+   );
+
+   return (ptrdiff_t) (bottom - top) <= 0;
+}
+
+/* <!-- }}} Deque --> */
+
+/* <!-- Records {{{ --> */
+
+static struct reboot_scheduler_record_ *
+reboot_scheduler_refill_(struct reboot_scheduler_chunk_ **chunks)
+{
+   struct reboot_scheduler_chunk_ *chunk;
+   unsigned                        i;
+
+   chunk = (struct reboot_scheduler_chunk_ *) malloc(sizeof *chunk);
+
+   if (chunk == NULL) {
+      return NULL;
+   }
+
+   for (i = 0; i + 1u < REBOOT_SCHEDULER_CHUNK_; ++i) {
+      chunk->records[i].next = &chunk->records[i + 1u];
+   }
+
+   chunk->records[i].next = NULL;
+   chunk->next            = *chunks;
+   *chunks                = chunk;
+
+   return chunk->records;
+}
+
+/*!
+ * The shared freelist is only ever touched under the lock.
+ */
+static struct reboot_scheduler_record_ *
+reboot_scheduler_acquire_(
+   struct reboot_scheduler_state_  *state,
+   struct reboot_scheduler_worker_ *worker
+) {
+   struct reboot_scheduler_record_  *record;
+   struct reboot_scheduler_record_ **free;
+
+   free = worker != NULL ? &worker->free : &state->free;
+
+   if (*free == NULL) {
+      *free = reboot_scheduler_refill_(
+         worker != NULL ? &worker->chunks : &state->chunks
+      );
+
+      if (*free == NULL) {
+         return NULL;
+      }
+   }
+
+   record = *free;
+   *free  = record->next;
+
+   return record;
+}
+
+static void
+reboot_scheduler_release_(
+   struct reboot_scheduler_state_  *state,
+   struct reboot_scheduler_worker_ *worker,
+   struct reboot_scheduler_record_ *record
+) {
+   if (worker != NULL) {
+      record->next = worker->free;
+      worker->free = record;
+      return;
+   }
+
+   REBOOT_SCHEDULER_LOCK_(&state->lock);
+   record->next = state->free;
+   state->free  = record;
+   REBOOT_SCHEDULER_UNLOCK_(&state->lock);
+}
+
+static void
+reboot_scheduler_free_chunks_(struct reboot_scheduler_chunk_ *chunk)
+{
+   while (chunk != NULL) {
+      struct reboot_scheduler_chunk_ *next = chunk->next;
+
+      free(chunk);
+      chunk = next;
+   }
+}
+
+/* <!-- }}} Records --> */
+
+/* <!-- Execution {{{ --> */
+
+static void reboot_scheduler_enqueue_(
+   reboot_scheduler_group_t *group, const struct reboot_scheduler_record_ *task
+);
+
+/*!
+ * Runs  a  task  described by `task`, a  copy  of  its
+ * record or a record never queued, range tasks handing
+ * their  upper half over until they are down to  their
+ * grain.  The  group  must  not be  touched  once  its
+ * counter  has  been  decremented, as its  waiter  may
+ * return  and discard it right away, sleeping  waiters
+ * being woken through the scheduler state instead.
+ */
+static void
+reboot_scheduler_execute_(const struct reboot_scheduler_record_ *task)
+{
+   struct reboot_scheduler_state_ *state = task->group->scheduler->state;
+
+   if (task->loop != NULL) {
+      const struct reboot_scheduler_loop_ *loop  = task->loop;
+      struct reboot_scheduler_record_      half  = *task;
+      size_t                               begin = task->begin;
+      size_t                               end   = task->end;
+
+      while (end - begin > loop->grain) {
+         size_t middle = begin + (end - begin) / 2u;
+
+         half.begin = middle;
+         half.end   = end;
+         end        = middle;
+
+         reboot_scheduler_enqueue_(task->group, &half);
+      }
+
+      loop->task(loop->argument, begin, end);
+   } else {
+      task->task(task->argument);
+   }
+
+   if (REBOOT_SCHEDULER_ADD_(&task->group->pending, (size_t) -1) == 1u) {
+      REBOOT_SCHEDULER_FENCE_();
+
+      if (REBOOT_SCHEDULER_LOAD_(
+             &state->waiters, REBOOT_SCHEDULER_RELAXED_
+          ) != 0) {
+         REBOOT_SCHEDULER_LOCK_(&state->lock);
+         REBOOT_SCHEDULER_BROADCAST_(&state->done);
+         REBOOT_SCHEDULER_UNLOCK_(&state->lock);
+      }
+   }
+}
+
+static void
+reboot_scheduler_run_(
+   struct reboot_scheduler_state_  *state,
+   struct reboot_scheduler_worker_ *worker,
+   struct reboot_scheduler_record_ *record
+) {
+   struct reboot_scheduler_record_ task = *record;
+
+   reboot_scheduler_release_(state, worker, record);
+   reboot_scheduler_execute_(&task);
+}
+
+static void
+reboot_scheduler_wake_(struct reboot_scheduler_state_ *state)
+{
+   REBOOT_SCHEDULER_LOCK_(&state->lock);
+   REBOOT_SCHEDULER_SIGNAL_(&state->wake);
+   REBOOT_SCHEDULER_UNLOCK_(&state->lock);
+}
+
+/*!
+ * Workers  push  onto their own deque, then check  for
+ * sleepers,  which check for tasks once counted  among
+ * them, the fences in between guaranteeing that either
+ * sees  the  other. Records failing to be  queued  run
+ * right away.
+ */
+static void
+reboot_scheduler_enqueue_(
+   reboot_scheduler_group_t *group, const struct reboot_scheduler_record_ *task
+) {
+   struct reboot_scheduler_state_  *state  = group->scheduler->state;
+   struct reboot_scheduler_worker_ *worker = reboot_scheduler_worker_(state);
+   struct reboot_scheduler_record_ *record;
+
+   REBOOT_SCHEDULER_ADD_(&group->pending, (size_t) 1);
+
+   if (worker != NULL) {
+      record = reboot_scheduler_acquire_(state, worker);
+
+      if (record != NULL) {
+         *record       = *task;
+         record->group = group;
+
+         if (reboot_scheduler_push_(worker, record)) {
+            REBOOT_SCHEDULER_FENCE_();
+
+            if (REBOOT_SCHEDULER_LOAD_(
+                   &state->sleepers, REBOOT_SCHEDULER_RELAXED_
+                ) != 0) {
+               reboot_scheduler_wake_(state);
+            }
+
+            return;
+         }
+
+         reboot_scheduler_release_(state, worker, record);
+      }
+   } else {
+      REBOOT_SCHEDULER_LOCK_(&state->lock);
+
+      record = reboot_scheduler_acquire_(state, NULL);
+
+      if (record != NULL) {
+         *record       = *task;
+         record->group = group;
+         record->next  = NULL;
+
+         if (state->tail != NULL) {
+            state->tail->next = record;
+         } else {
+            state->head = record;
+         }
+
+         state->tail = record;
+
+         REBOOT_SCHEDULER_ADD_(&state->queued, (size_t) 1);
+
+         if (state->sleepers != 0) {
+            REBOOT_SCHEDULER_SIGNAL_(&state->wake);
+         }
+
+         REBOOT_SCHEDULER_UNLOCK_(&state->lock);
+
+         return;
+      }
+
+      REBOOT_SCHEDULER_UNLOCK_(&state->lock);
+   }
+
+   {
+      struct reboot_scheduler_record_ inline_task = *task;
+
+      inline_task.group = group;
+      reboot_scheduler_execute_(&inline_task);
+   }
+}
+
+static struct reboot_scheduler_record_ *
+reboot_scheduler_dequeue_(struct reboot_scheduler_state_ *state)
+{
+   struct reboot_scheduler_record_ *record;
+
+   if (REBOOT_SCHEDULER_LOAD_(
+          &state->queued, REBOOT_SCHEDULER_RELAXED_
+       ) == 0) {
+      return NULL;
+   }
+
+   REBOOT_SCHEDULER_LOCK_(&state->lock);
+
+   record = state->head;
+
+   if (record != NULL) {
+      state->head = record->next;
+
+      if (state->head == NULL) {
+         state->tail = NULL;
+      }
+
+      REBOOT_SCHEDULER_ADD_(&state->queued, (size_t) -1);
+   }
+
+   REBOOT_SCHEDULER_UNLOCK_(&state->lock);
+
+   return record;
+}
+
+/*!
+ * Looks  for a task in the deque of `worker`, then  in
+ * the tiers of its victims, the shared queue coming in
+ * between  the  first  tier and the others  since  its
+ * tasks  are  as local to a worker as they are to  any
+ * other.  Foreign threads go through the shared queue,
+ * then through all workers as a single tier.
+ */
+static struct reboot_scheduler_record_ *
+reboot_scheduler_find_(
+   struct reboot_scheduler_state_  *state,
+   struct reboot_scheduler_worker_ *worker,
+   unsigned                        *random
+) {
+   struct reboot_scheduler_record_ *record;
+   unsigned                         tier;
+
+   if (worker == NULL) {
+      unsigned count = state->worker_count;
+      unsigned start = reboot_scheduler_random_(random) % count;
+      unsigned i;
+
+      if ((record = reboot_scheduler_dequeue_(state)) != NULL) {
+         return record;
+      }
+
+      for (i = 0; i < count; ++i) {
+         unsigned victim = start + i < count ? start + i : start + i - count;
+
+         record = reboot_scheduler_steal_(state->workers[victim]);
+
+         if (record != NULL) {
+            return record;
+         }
+      }
+
+      return NULL;
+   }
+
+   if ((record = reboot_scheduler_pop_(worker)) != NULL) {
+      return record;
+   }
+
+   for (tier = 0; tier < 3u; ++tier) {
+      unsigned first = tier != 0 ? worker->tiers[tier - 1u] : 0;
+      unsigned count = worker->tiers[tier] - first;
+      unsigned start;
+      unsigned i;
+
+      if (tier == 1u && (record = reboot_scheduler_dequeue_(state)) != NULL) {
+         return record;
+      }
+
+      if (count == 0) {
+         continue;
+      }
+
+      start = reboot_scheduler_random_(random) % count;
+
+      for (i = 0; i < count; ++i) {
+         unsigned victim = start + i < count ? start + i : start + i - count;
+
+         record = reboot_scheduler_steal_(
+            state->workers[worker->victims[first + victim]]
+         );
+
+         if (record != NULL) {
+            return record;
+         }
+      }
+   }
+
+   return NULL;
+}
+
+/*!
+ * Puts   an  idle  worker  to  sleep  until  there  is
+ * something  to run, returning `0` once the  scheduler
+ * is stopping.
+ */
+static int
+reboot_scheduler_sleep_(struct reboot_scheduler_state_ *state)
+{
+   int stopping;
+
+   REBOOT_SCHEDULER_LOCK_(&state->lock);
+   REBOOT_SCHEDULER_ADD_(&state->sleepers, (size_t) 1);
+   REBOOT_SCHEDULER_FENCE_();
+
+   for (;;) {
+      unsigned i;
+
+      if (state->stopping || state->head != NULL) {
+         break;
+      }
+
+      for (i = 0; i < state->worker_count; ++i) {
+         if (!reboot_scheduler_empty_(state->workers[i])) {
+            break;
+         }
+      }
+
+      if (i < state->worker_count) {
+         break;
+      }
+
+      REBOOT_SCHEDULER_SLEEP_(&state->wake, &state->lock);
+   }
+
+   REBOOT_SCHEDULER_ADD_(&state->sleepers, (size_t) -1);
+
+   stopping = state->stopping;
+
+   REBOOT_SCHEDULER_UNLOCK_(&state->lock);
+
+   return !stopping;
+}
+
+static void
+reboot_scheduler_loop_(struct reboot_scheduler_worker_ *worker)
+{
+   struct reboot_scheduler_state_ *state = worker->state;
+   unsigned                        spins = 0;
+
+   if (worker->pinned) {
+      reboot_topology_pin(worker->cpu);
+   }
+
+   reboot_scheduler_self_ = worker;
+
+   for (;;) {
+      struct reboot_scheduler_record_ *record = reboot_scheduler_find_(
+         state, worker, &worker->random
+      );
+
+      if (record != NULL) {
+         reboot_scheduler_run_(state, worker, record);
+         spins = 0;
+         continue;
+      }
+
+      if (++spins < REBOOT_SCHEDULER_SPINS_) {
+         REBOOT_SCHEDULER_PAUSE_();
+         continue;
+      }
+
+      spins = 0;
+
+      if (!reboot_scheduler_sleep_(state)) {
+         break;
+      }
+   }
+
+   reboot_scheduler_self_ = NULL;
+}
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+static DWORD WINAPI
+reboot_scheduler_entry_(LPVOID worker)
+{
+   reboot_scheduler_loop_((struct reboot_scheduler_worker_ *) worker);
+
+   return 0;
+}
+#else
+static void *
+reboot_scheduler_entry_(void *worker)
+{
+   reboot_scheduler_loop_((struct reboot_scheduler_worker_ *) worker);
+
+   return NULL;
+}
+#endif
+
+/* <!-- }}} Execution --> */
+
+#endif
+
+/* <!-- Placement {{{ --> */
+
+#if defined(REBOOT_SCHEDULER_HAS_THREADS)
+
+/*!
+ * Orders  the  processors of `topology` into  `order`,
+ * the  first  one of every core coming before  any  of
+ * their SMT siblings.
+ */
+static int
+reboot_scheduler_order_(const reboot_topology_t *topology, unsigned *order)
+{
+   unsigned char *seen;
+   unsigned char *taken;
+   unsigned       count = 0;
+   unsigned       i;
+
+   seen = (unsigned char *) calloc(
+      (size_t) topology->core_count + topology->cpu_count, 1
+   );
+
+   if (seen == NULL) {
+      return -1;
+   }
+
+   taken = seen + topology->core_count;
+
+   for (i = 0; i < topology->cpu_count; ++i) {
+      unsigned core = topology->cpus[i].core;
+
+      if (core < topology->core_count && !seen[core]) {
+         seen[core]     = 1;
+         taken[i]       = 1;
+         order[count++] = i;
+      }
+   }
+
+   for (i = 0; i < topology->cpu_count; ++i) {
+      if (!taken[i]) {
+         order[count++] = i;
+      }
+   }
+
+   free(seen);
+
+   return 0;
+}
+
+/*!
+ * Lays the victims of every worker out in three tiers,
+ * those  sharing  its last level cache, those  sharing
+ * its node only, and the others.
+ */
+static void
+reboot_scheduler_tiers_(struct reboot_scheduler_state_ *state)
+{
+   unsigned count = state->worker_count;
+   unsigned i;
+
+   for (i = 0; i < count; ++i) {
+      struct reboot_scheduler_worker_ *worker = state->workers[i];
+      unsigned                        *victims;
+      unsigned                         size = 0;
+      unsigned                         tier;
+
+      victims         = state->victims + (size_t) i * (count - 1u);
+      worker->victims = victims;
+
+      for (tier = 0; tier < 3u; ++tier) {
+         unsigned j;
+
+         for (j = 0; j < count; ++j) {
+            const struct reboot_scheduler_worker_ *other = state->workers[j];
+            unsigned                               distance;
+
+            if (j == i) {
+               continue;
+            }
+
+            distance = other->cache == worker->cache ? 0u
+                     : other->node  == worker->node  ? 1u
+                     :                                 2u;
+
+            if (distance == tier) {
+               victims[size++] = j;
+            }
+         }
+
+         worker->tiers[tier] = size;
+      }
+   }
+}
+
+static void
+reboot_scheduler_release_state_(
+   struct reboot_scheduler_state_ *state, unsigned started
+) {
+   unsigned i;
+
+   REBOOT_SCHEDULER_LOCK_(&state->lock);
+   state->stopping = 1;
+   REBOOT_SCHEDULER_BROADCAST_(&state->wake);
+   REBOOT_SCHEDULER_UNLOCK_(&state->lock);
+
+   for (i = 0; i < started; ++i) {
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+      WaitForSingleObject(state->workers[i]->thread, INFINITE);
+      CloseHandle(state->workers[i]->thread);
+#  else
+      pthread_join(state->workers[i]->thread, NULL);
+#  endif
+   }
+
+   for (i = 0; i < state->worker_count; ++i) {
+      struct reboot_scheduler_worker_ *worker = state->workers[i];
+
+      if (worker == NULL) {
+         continue;
+      }
+
+      reboot_scheduler_free_chunks_(worker->chunks);
+
+      if (worker->mapped) {
+         reboot_topology_free(worker, sizeof *worker);
+      } else {
+         free(worker);
+      }
+   }
+
+   reboot_scheduler_free_chunks_(state->chunks);
+
+   REBOOT_SCHEDULER_COND_FREE_(&state->done);
+   REBOOT_SCHEDULER_COND_FREE_(&state->wake);
+   REBOOT_SCHEDULER_LOCK_FREE_(&state->lock);
+
+   free(state->victims);
+   free(state->workers);
+   free(state);
+}
+
+#endif
+
+/* <!-- }}} Placement --> */
+
+/* <!-- Scheduler {{{ --> */
+
+int
+reboot_scheduler_init(
+   reboot_scheduler_t      *scheduler,
+   const reboot_topology_t *topology,
+   unsigned                 threads
+) {
+#if defined(REBOOT_SCHEDULER_HAS_THREADS)
+   struct reboot_scheduler_state_ *state;
+   unsigned                       *order = NULL;
+   unsigned                        i;
+
+   if (topology != NULL && topology->cpu_count == 0) {
+      topology = NULL;
+   }
+
+   if (threads == 0) {
+      if (topology == NULL) {
+         errno = EINVAL;
+         return -1;
+      }
+
+      threads = topology->cpu_count;
+   }
+
+   state = (struct reboot_scheduler_state_ *) calloc(1, sizeof *state);
+
+   if (state == NULL) {
+      return -1;
+   }
+
+   state->worker_count = threads;
+   state->workers      = (struct reboot_scheduler_worker_ **) calloc(
+      threads, sizeof *state->workers
+   );
+   state->victims      = (unsigned *) malloc(
+      ((size_t) threads * (threads - 1u) + 1u) * sizeof *state->victims
+   );
+
+   if (topology != NULL) {
+      order = (unsigned *) malloc(topology->cpu_count * sizeof *order);
+
+      if (order != NULL && reboot_scheduler_order_(topology, order) != 0) {
+         free(order);
+         order = NULL;
+      }
+   }
+
+   if (state->workers == NULL || state->victims == NULL
+    || (topology != NULL && order == NULL)) {
+      free(order);
+      free(state->victims);
+      free(state->workers);
+      free(state);
+      errno = ENOMEM;
+      return -1;
+   }
+
+   REBOOT_SCHEDULER_LOCK_INIT_(&state->lock);
+   REBOOT_SCHEDULER_COND_INIT_(&state->wake);
+   REBOOT_SCHEDULER_COND_INIT_(&state->done);
+
+   for (i = 0; i < threads; ++i) {
+      struct reboot_scheduler_worker_ *worker = NULL;
+      const reboot_topology_cpu_t     *cpu    = NULL;
+
+      if (topology != NULL) {
+         cpu    = &topology->cpus[order[i % topology->cpu_count]];
+         worker = (struct reboot_scheduler_worker_ *) reboot_topology_alloc(
+            sizeof *worker, cpu->node
+         );
+      }
+
+      if (worker != NULL) {
+         worker->mapped = 1;
+      } else {
+         worker = (struct reboot_scheduler_worker_ *) calloc(
+            1, sizeof *worker
+         );
+      }
+
+      if (worker == NULL) {
+         free(order);
+         reboot_scheduler_release_state_(state, 0);
+         errno = ENOMEM;
+         return -1;
+      }
+
+      worker->state  = state;
+      worker->index  = i;
+      worker->random = 0x9E3779B9u * (i + 1u);
+
+      if (cpu != NULL) {
+         worker->cpu    = cpu->id;
+         worker->node   = cpu->node;
+         worker->cache  = cpu->cache;
+         worker->pinned = 1;
+      }
+
+      state->workers[i] = worker;
+   }
+
+   free(order);
+
+   reboot_scheduler_tiers_(state);
+
+   for (i = 0; i < threads; ++i) {
+      struct reboot_scheduler_worker_ *worker = state->workers[i];
+
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+      worker->thread = CreateThread(
+         NULL, 0, reboot_scheduler_entry_, worker, 0, NULL
+      );
+
+      if (worker->thread == NULL) {
+         break;
+      }
+#  else
+      if (pthread_create(
+             &worker->thread, NULL, reboot_scheduler_entry_, worker
+          ) != 0) {
+         break;
+      }
+#  endif
+   }
+
+   if (i < threads) {
+      reboot_scheduler_release_state_(state, i);
+      errno = EAGAIN;
+      return -1;
+   }
+
+   scheduler->state        = state;
+   scheduler->worker_count = threads;
+
+   return 0;
+#else
+   (void) topology;
+   (void) threads;
+
+   scheduler->state        = NULL;
+   scheduler->worker_count = 0;
+
+   return 0;
+#endif
+}
+
+void
+reboot_scheduler_destroy(reboot_scheduler_t *scheduler)
+{
+#if defined(REBOOT_SCHEDULER_HAS_THREADS)
+   reboot_scheduler_release_state_(scheduler->state, scheduler->worker_count);
+#endif
+
+   scheduler->state        = NULL;
+   scheduler->worker_count = 0;
+}
+
+int
+reboot_scheduler_current(const reboot_scheduler_t *scheduler)
+{
+#if defined(REBOOT_SCHEDULER_HAS_THREADS)
+   const struct reboot_scheduler_worker_ *worker = reboot_scheduler_worker_(
+      scheduler->state
+   );
+
+   return worker != NULL ? (int) worker->index : -1;
+#else
+   (void) scheduler;
+
+   return -1;
+#endif
+}
+
+/* <!-- }}} Scheduler --> */
+
+/* <!-- Groups {{{ --> */
+
+/*!
+ * Puts   a  foreign  waiter  to  sleep  until  `group`
+ * completes,  the  task  completing  it  checking  for
+ * waiters  once  the  counter  is decremented, and the
+ * waiter checking the counter once counted among them,
+ * the  fences in between guaranteeing that either sees
+ * the  other.  Workers  never block this way, as every
+ * one of them could end up waiting on a task queued in
+ * its own deque.
+ */
+static void
+reboot_scheduler_block_(
+   struct reboot_scheduler_state_ *state, reboot_scheduler_group_t *group
+) {
+   REBOOT_SCHEDULER_LOCK_(&state->lock);
+   REBOOT_SCHEDULER_ADD_(&state->waiters, (size_t) 1);
+   REBOOT_SCHEDULER_FENCE_();
+
+   while (REBOOT_SCHEDULER_LOAD_(
+             &group->pending, REBOOT_SCHEDULER_ACQUIRE_
+          ) != 0) {
+      REBOOT_SCHEDULER_SLEEP_(&state->done, &state->lock);
+   }
+
+   REBOOT_SCHEDULER_ADD_(&state->waiters, (size_t) -1);
+   REBOOT_SCHEDULER_UNLOCK_(&state->lock);
+}
+
+void
+reboot_scheduler_spawn(
+   reboot_scheduler_group_t *group, reboot_scheduler_task_t task,
+   void *argument
+) {
+#if defined(REBOOT_SCHEDULER_HAS_THREADS)
+   struct reboot_scheduler_record_ record = {0};
+
+   record.task     = task;
+   record.argument = argument;
+
+   reboot_scheduler_enqueue_(group, &record);
+#else
+   (void) group;
+
+   task(argument);
+#endif
+}
+
+void
+reboot_scheduler_wait(reboot_scheduler_group_t *group)
+{
+#if defined(REBOOT_SCHEDULER_HAS_THREADS)
+   struct reboot_scheduler_state_  *state  = group->scheduler->state;
+   struct reboot_scheduler_worker_ *worker = reboot_scheduler_worker_(state);
+   unsigned                        *random;
+   unsigned                         seed;
+   unsigned                         spins  = 0;
+
+   if (worker != NULL) {
+      random = &worker->random;
+   } else {
+      seed   = 0x9E3779B9u * (unsigned) (1u + REBOOT_SCHEDULER_ADD_(
+         &state->ticket, (size_t) 1
+      ));
+      random = &seed;
+   }
+
+   while (REBOOT_SCHEDULER_LOAD_(
+             &group->pending, REBOOT_SCHEDULER_ACQUIRE_
+          ) != 0) {
+      struct reboot_scheduler_record_ *record = reboot_scheduler_find_(
+         state, worker, random
+      );
+
+      if (record != NULL) {
+         reboot_scheduler_run_(state, worker, record);
+         spins = 0;
+         continue;
+      }
+
+      if (++spins < REBOOT_SCHEDULER_SPINS_) {
+         REBOOT_SCHEDULER_PAUSE_();
+      } else if (worker != NULL) {
+         REBOOT_SCHEDULER_YIELD_();
+         spins = 0;
+      } else {
+         reboot_scheduler_block_(state, group);
+      }
+   }
+#else
+   (void) group;
+#endif
+}
+
+/* <!-- }}} Groups --> */
+
+/* <!-- Parallel for {{{ --> */
+
+void
+reboot_scheduler_parallel_for(
+   reboot_scheduler_t      *scheduler,
+   size_t                   begin,
+   size_t                   end,
+   size_t                   grain,
+   reboot_scheduler_range_t task,
+   void                    *argument
+) {
+#if defined(REBOOT_SCHEDULER_HAS_THREADS)
+   struct reboot_scheduler_loop_   loop;
+   struct reboot_scheduler_record_ record = {0};
+   reboot_scheduler_group_t        group;
+
+   if (begin >= end) {
+      return;
+   }
+
+   if (grain == 0) {
+      grain = (end - begin) / (8u * (size_t) scheduler->worker_count);
+   }
+
+   loop.task       = task;
+   loop.argument   = argument;
+   loop.grain      = grain != 0 ? grain : 1u;
+
+   reboot_scheduler_group_init(&group, scheduler);
+
+   record.group    = &group;
+   record.loop     = &loop;
+   record.begin    = begin;
+   record.end      = end;
+
+   /* The caller takes the first half, accounted as a task. */
+   group.pending   = 1u;
+
+   reboot_scheduler_execute_(&record);
+   reboot_scheduler_wait(&group);
+#else
+   (void) scheduler;
+   (void) grain;
+
+   if (begin < end) {
+      task(argument, begin, end);
+   }
+#endif
+}
+
+/* <!-- }}} Parallel for --> */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
@@ -0,0 +1,284 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+#ifndef __REBOOT_SCHEDULER_H__
+#define __REBOOT_SCHEDULER_H__
+
+/*!
+ * @file  scheduler.h
+ * @brief Work-stealing task scheduler.
+ *
+ * This  header  provides  a  pool  of  worker  threads
+ * running  tasks,  grouped so that they can be  waited
+ * upon together :
+ *
+ * - `reboot_scheduler_init`         : Initialization.
+ * - `reboot_scheduler_group_init`   : Group initialization.
+ * - `reboot_scheduler_spawn`        : Task submission.
+ * - `reboot_scheduler_wait`         : Group completion.
+ * - `reboot_scheduler_parallel_for` : Range splitting.
+ * - `reboot_scheduler_current`      : Worker identification.
+ * - `reboot_scheduler_destroy`      : Finalization.
+ *
+ * Every  worker  owns a Chase-Lev deque,  pushing  and
+ * popping  the  tasks it spawns at its bottom  without
+ * any  contention,  while idle workers steal from  its
+ * top.  Workers  thus run their own tasks most  recent
+ * first,  while  their  data is still  in  cache,  and
+ * thieves  take  the  oldest,  typically  the  largest
+ * remaining  pieces  of work. Threads foreign  to  the
+ * scheduler  spawn  into a shared queue guarded  by  a
+ * lock,  which  workers  only look at once  their  own
+ * deque  is empty, large fan-outs being better spawned
+ * from      within      a     task     or      through
+ * `reboot_scheduler_parallel_for`  so as to spread  by
+ * stealing :
+ *
+ * ```c
+ * reboot_scheduler_t       scheduler;
+ * reboot_scheduler_group_t group;
+ *
+ * reboot_scheduler_init(&scheduler, &topology, 0);
+ * reboot_scheduler_group_init(&group, &scheduler);
+ *
+ * for (i = 0; i < shard_count; ++i) {
+ *    reboot_scheduler_spawn(&group, query_shard, &shards[i]);
+ * }
+ *
+ * reboot_scheduler_wait(&group);
+ *
+ * reboot_scheduler_parallel_for(&scheduler, 0, rows, 0, scan, table);
+ * ```
+ *
+ * Given  a  topology,  see `topology.h`,  workers  are
+ * pinned to its logical processors, spreading over the
+ * physical  cores before doubling up on SMT  siblings,
+ * and allocate their deque on the memory of their NUMA
+ * node.  Thieves  try the workers sharing  their  last
+ * level  cache  first, then those on their NUMA  node,
+ * and  only  then  the other nodes,  starting  from  a
+ * random  victim within each of these tiers so as  not
+ * to converge on the same one.
+ *
+ * Waiting on a group runs other tasks meanwhile, which
+ * lets  tasks  spawn and wait on groups of  their  own
+ * without  ever  blocking a worker. Idle workers  spin
+ * for  a while looking for tasks to steal, then  sleep
+ * until some are spawned.
+ *
+ * Atomic operations map to the GNU `__atomic` builtins
+ * or to the MSVC interlocked intrinsics, both of which
+ * operate  on  plain integers, unlike  `<stdatomic.h>`
+ * whose  types  would leak into the  group  structure.
+ * `REBOOT_SCHEDULER_HAS_THREADS`  is defined  wherever
+ * they,    threads   and   `REBOOT_THREAD_LOCAL`   are
+ * available,  the scheduler otherwise having no worker
+ * and  running  every  task as it  is  spawned.  These
+ * functions  are usable from both C and C++, and  live
+ * in `scheduler.c`.
+ */
+
+#include <stddef.h>
+
+#include "preprocessor/environment/compiler.h"
+#include "preprocessor/environment/os.h"
+#include "topology.h"
+
+#if ((defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_UNIX)                    \
+   && !defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WASI))                  \
+  || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS))                 \
+ && (defined(__ATOMIC_ACQUIRE)                                                \
+  || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC))              \
+ && defined(REBOOT_HAS_THREAD_LOCAL)
+#  define REBOOT_SCHEDULER_HAS_THREADS
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! <!-- Scheduler {{{ -->
+ * @addtogroup  scheduler_scheduler Scheduler
+ * @brief Scheduler state and lifetime
+ *
+ * The   scheduler   is   a   plain   structure   whose
+ * `worker_count`  field may be read freely, the  other
+ * being private.
+ * @{
+ */
+
+/*!
+ * @def   REBOOT_SCHEDULER_DEQUE_SIZE
+ * @brief Deque capacity.
+ *
+ * This  is  the  number  of tasks a  worker  may  have
+ * pending  in  its  deque, a power of  two.  A  worker
+ * spawning  into a full deque runs the task right away
+ * instead.  It  may  be overridden when  building  the
+ * library.
+ */
+#ifndef REBOOT_SCHEDULER_DEQUE_SIZE
+#  define REBOOT_SCHEDULER_DEQUE_SIZE 4096u
+#endif
+
+/*!
+ * @brief Scheduler.
+ */
+typedef struct reboot_scheduler {
+   struct reboot_scheduler_state_ *state;
+   unsigned                        worker_count;
+} reboot_scheduler_t;
+
+/*!
+ * @brief Scheduler initialization.
+ *
+ * This   function   starts  `threads`   workers   into
+ * `scheduler`, one per logical processor of `topology`
+ * when  `threads` is `0`. `topology` may be `NULL`, in
+ * which  case  workers are neither pinned nor  placed,
+ * which  then  requires  `threads` to  be  given.  The
+ * topology  is  not retained and may be  destroyed  as
+ * soon  as  the  function returns. It returns  `0`  on
+ * success and `-1` on failure, leaving `errno` set.
+ */
+int reboot_scheduler_init(
+   reboot_scheduler_t      *scheduler,
+   const reboot_topology_t *topology,
+   unsigned                 threads
+);
+
+/*!
+ * @brief Scheduler finalization.
+ *
+ * This   function  stops  and  joins  the  workers  of
+ * `scheduler`,  every  group having to be waited  upon
+ * beforehand.
+ */
+void reboot_scheduler_destroy(reboot_scheduler_t *scheduler);
+
+/*!
+ * @brief Worker identification.
+ *
+ * This  function  returns the index of the  worker  of
+ * `scheduler`   running  the  calling  thread,   below
+ * `worker_count`  and  thus suitable as an index  into
+ * per-worker  arrays,  or  `-1`  when  the  thread  is
+ * foreign to the scheduler.
+ */
+int reboot_scheduler_current(const reboot_scheduler_t *scheduler);
+
+/*! @} <!-- }}} Scheduler --> */
+
+/*! <!-- Groups {{{ -->
+ * @addtogroup  scheduler_groups Groups
+ * @brief Task submission and completion
+ *
+ * A  group counts the tasks spawned into it which have
+ * not  yet  completed. It is a plain  structure  whose
+ * fields  are  private, and which must  outlive  every
+ * task  spawned  into  it, i.e. must be  waited  upon.
+ * Tasks  may be spawned into a group from any  thread,
+ * including from tasks of the same group.
+ * @{
+ */
+
+/*!
+ * @brief Task.
+ */
+typedef void (*reboot_scheduler_task_t)(void *argument);
+
+/*!
+ * @brief Task group.
+ */
+typedef struct reboot_scheduler_group {
+   reboot_scheduler_t *scheduler;
+   size_t              pending;
+} reboot_scheduler_group_t;
+
+/*!
+ * @brief Group initialization.
+ */
+static REBOOT_INLINE void
+reboot_scheduler_group_init(
+   reboot_scheduler_group_t *group, reboot_scheduler_t *scheduler
+) {
+   group->scheduler = scheduler;
+   group->pending   = 0;
+}
+
+/*!
+ * @brief Task submission.
+ *
+ * This  function  spawns  `task` into `group`,  to  be
+ * called  with `argument` by whichever thread gets  to
+ * it  first.  It never fails, running the  task  right
+ * away when it cannot be queued.
+ */
+void reboot_scheduler_spawn(
+   reboot_scheduler_group_t *group, reboot_scheduler_task_t task,
+   void *argument
+);
+
+/*!
+ * @brief Group completion.
+ *
+ * This  function returns once every task spawned  into
+ * `group`   has   completed,  running  tasks  in   the
+ * meantime,  after which their effects are visible  to
+ * the caller. The group may then be reused.
+ */
+void reboot_scheduler_wait(reboot_scheduler_group_t *group);
+
+/*! @} <!-- }}} Groups --> */
+
+/*! <!-- Parallel for {{{ -->
+ * @addtogroup  scheduler_parallel_for Parallel for
+ * @brief Range splitting
+ * @{
+ */
+
+/*!
+ * @brief Range task.
+ */
+typedef void (*reboot_scheduler_range_t)(
+   void *argument, size_t begin, size_t end
+);
+
+/*!
+ * @brief Parallel for.
+ *
+ * This  function  calls  `task` with  `argument`  over
+ * subranges  of `[begin, end)` partitioning it, of  at
+ * most  `grain` indices, and returns once every one of
+ * them  has  completed.  Ranges are  split  in  halves
+ * lazily,  the  thread  running a range  spawning  its
+ * upper  half  and carrying on with the lower one,  so
+ * that  idle workers steal the largest pieces left.  A
+ * `grain`  of  `0`  splits the range  in  about  eight
+ * pieces per worker.
+ */
+void reboot_scheduler_parallel_for(
+   reboot_scheduler_t      *scheduler,
+   size_t                   begin,
+   size_t                   end,
+   size_t                   grain,
+   reboot_scheduler_range_t task,
+   void                    *argument
+);
+
+/*! @} <!-- }}} Parallel for --> */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __REBOOT_SCHEDULER_H__ */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
@@ -0,0 +1,272 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+/*!
+ * @file  simd/bytes.c
+ * @brief AVX2 byte string primitives and dispatch.
+ *
+ * The  AVX2 implementations are kept out of the header
+ * as  they  require  `<immintrin.h>`,  by far the most
+ * expensive  of  the  intrinsics  headers to parse, on
+ * every x86 target the compiler can retarget.
+ */
+
+#include "simd/bytes.h"
+#include "preprocessor/environment/cpu.h"
+
+#if defined(REBOOT_BYTES_HAS_AVX2)
+#  include <immintrin.h>
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX2)
+#     define REBOOT_BYTES_AVX2_TARGET_
+#  else
+#     define REBOOT_BYTES_AVX2_TARGET_ REBOOT_TARGET("avx2")
+#  endif
+#endif
+
+/* <!-- AVX2 {{{ --> */
+
+#if defined(REBOOT_BYTES_HAS_AVX2)
+
+REBOOT_BYTES_AVX2_TARGET_ static REBOOT_ALWAYS_INLINE unsigned
+reboot_bytes_eq_avx2_(const unsigned char *p, __m256i needle)
+{
+   __m256i chunk = _mm256_loadu_si256((const __m256i *) (const void *) p);
+
+   return (unsigned) _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle));
+}
+
+REBOOT_BYTES_AVX2_TARGET_ static REBOOT_ALWAYS_INLINE unsigned
+reboot_bytes_any_avx2_(
+   const unsigned char *p, const __m256i *needles, size_t count
+) {
+   __m256i chunk = _mm256_loadu_si256((const __m256i *) (const void *) p);
+   __m256i match = _mm256_cmpeq_epi8(chunk, needles[0]);
+   size_t  i;
+
+   for (i = 1; i < count; ++i) {
+      match = _mm256_or_si256(match, _mm256_cmpeq_epi8(chunk, needles[i]));
+   }
+
+   return (unsigned) _mm256_movemask_epi8(match);
+}
+
+REBOOT_BYTES_AVX2_TARGET_ size_t
+reboot_bytes_find_byte_avx2(const void *data, size_t size, unsigned char byte)
+{
+   const unsigned char *bytes = (const unsigned char *) data;
+   __m256i              needle;
+   unsigned             mask;
+   size_t               i;
+
+   if (size < 32u) {
+      return reboot_bytes_find_byte_sse2(data, size, byte);
+   }
+
+   needle = _mm256_set1_epi8((char) byte);
+
+   for (i = 0; i + 32u <= size; i += 32u) {
+      if ((mask = reboot_bytes_eq_avx2_(bytes + i, needle)) != 0) {
+         return i + reboot_bits_ctz32(mask);
+      }
+   }
+
+   if (i < size
+    && (mask = reboot_bytes_eq_avx2_(bytes + size - 32u, needle)) != 0) {
+      return size - 32u + reboot_bits_ctz32(mask);
+   }
+
+   return size;
+}
+
+REBOOT_BYTES_AVX2_TARGET_ size_t
+reboot_bytes_find_any_of_avx2(
+   const void *data, size_t size, const char *set, size_t set_size
+) {
+   const unsigned char *bytes = (const unsigned char *) data;
+   __m256i              needles[REBOOT_BYTES_SET_MAX];
+   unsigned             mask;
+   size_t               i;
+
+   if (size < 32u || set_size == 0 || set_size > REBOOT_BYTES_SET_MAX) {
+      return reboot_bytes_find_any_of_sse2(data, size, set, set_size);
+   }
+
+   for (i = 0; i < set_size; ++i) {
+      needles[i] = _mm256_set1_epi8(set[i]);
+   }
+
+   for (i = 0; i + 32u <= size; i += 32u) {
+      if ((mask = reboot_bytes_any_avx2_(bytes + i, needles, set_size)) != 0) {
+         return i + reboot_bits_ctz32(mask);
+      }
+   }
+
+   if (i < size && (mask = reboot_bytes_any_avx2_(
+      bytes + size - 32u, needles, set_size
+   )) != 0) {
+      return size - 32u + reboot_bits_ctz32(mask);
+   }
+
+   return size;
+}
+
+REBOOT_BYTES_AVX2_TARGET_ size_t
+reboot_bytes_count_byte_avx2(
+   const void *data, size_t size, unsigned char byte
+) {
+   const unsigned char *bytes  = (const unsigned char *) data;
+   const __m256i        needle = _mm256_set1_epi8((char) byte);
+   const __m256i        zero   = _mm256_setzero_si256();
+   __m256i              total  = zero;
+   uint64_t             lanes[4];
+   size_t               i      = 0;
+
+   while (i + 32u <= size) {
+      __m256i  counts = zero;
+      unsigned n;
+
+      for (n = 0; n < 255u && i + 32u <= size; ++n, i += 32u) {
+         __m256i chunk = _mm256_loadu_si256(
+            (const __m256i *) (const void *) (bytes + i)
+         );
+
+         counts = _mm256_sub_epi8(counts, _mm256_cmpeq_epi8(chunk, needle));
+      }
+
+      total = _mm256_add_epi64(total, _mm256_sad_epu8(counts, zero));
+   }
+
+   _mm256_storeu_si256((__m256i *) (void *) lanes, total);
+
+   return (size_t) (lanes[0] + lanes[1] + lanes[2] + lanes[3])
+        + reboot_bytes_count_byte_sse2(bytes + i, size - i, byte);
+}
+
+REBOOT_BYTES_AVX2_TARGET_ int
+reboot_bytes_mem_eq_avx2(const void *a, const void *b, size_t size)
+{
+   const unsigned char *left  = (const unsigned char *) a;
+   const unsigned char *right = (const unsigned char *) b;
+   size_t               i;
+
+   if (size < 32u) {
+      return reboot_bytes_mem_eq_sse2(a, b, size);
+   }
+
+   for (i = 0; i + 32u <= size; i += 32u) {
+      __m256i x = _mm256_loadu_si256(
+         (const __m256i *) (const void *) (left + i)
+      );
+      __m256i y = _mm256_loadu_si256(
+         (const __m256i *) (const void *) (right + i)
+      );
+
+      if (~(unsigned) _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)) != 0) {
+         return 0;
+      }
+   }
+
+   if (i < size) {
+      __m256i x = _mm256_loadu_si256(
+         (const __m256i *) (const void *) (left + size - 32u)
+      );
+      __m256i y = _mm256_loadu_si256(
+         (const __m256i *) (const void *) (right + size - 32u)
+      );
+
+      return ~(unsigned) _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)) == 0;
+   }
+
+   return 1;
+}
+
+REBOOT_BYTES_AVX2_TARGET_ int
+reboot_bytes_is_ascii_avx2(const void *data, size_t size)
+{
+   const unsigned char *bytes = (const unsigned char *) data;
+   __m256i              seen  = _mm256_setzero_si256();
+   size_t               i;
+
+   if (size < 32u) {
+      return reboot_bytes_is_ascii_sse2(data, size);
+   }
+
+   for (i = 0; i + 32u <= size; i += 32u) {
+      seen = _mm256_or_si256(seen, _mm256_loadu_si256(
+         (const __m256i *) (const void *) (bytes + i)
+      ));
+   }
+
+   if (i < size) {
+      seen = _mm256_or_si256(seen, _mm256_loadu_si256(
+         (const __m256i *) (const void *) (bytes + size - 32u)
+      ));
+   }
+
+   return _mm256_movemask_epi8(seen) == 0;
+}
+
+#endif
+
+/* <!-- }}} AVX2 --> */
+
+/* <!-- Dispatch {{{ --> */
+
+/*!
+ * The dispatch is skipped altogether when the baseline
+ * primitives  already  are  the widest implementations
+ * the compiler is able to build.
+ */
+#if defined(REBOOT_BYTES_HAS_AVX2)                                            \
+ && !defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX2)
+#  define REBOOT_BYTES_DISPATCH_(type, primitive, parameters, arguments)      \
+      REBOOT_CPU_DISPATCH(                                                    \
+         type, reboot_bytes_##primitive##_dispatch, parameters, arguments,    \
+         REBOOT_CPU_DISPATCH_ENTRY(                                           \
+            REBOOT_CPU_AVX2, reboot_bytes_##primitive##_avx2                  \
+         ),                                                                   \
+         REBOOT_CPU_DISPATCH_ENTRY(0, reboot_bytes_##primitive)               \
+      )
+#else
+#  define REBOOT_BYTES_DISPATCH_(type, primitive, parameters, arguments)      \
+      type                                                                    \
+      reboot_bytes_##primitive##_dispatch parameters                          \
+      {                                                                       \
+         return reboot_bytes_##primitive arguments;                           \
+      }
+#endif
+
+REBOOT_BYTES_DISPATCH_(
+   size_t, find_byte,
+   (const void *data, size_t size, unsigned char byte), (data, size, byte)
+)
+
+REBOOT_BYTES_DISPATCH_(
+   size_t, find_any_of,
+   (const void *data, size_t size, const char *set, size_t set_size),
+   (data, size, set, set_size)
+)
+
+REBOOT_BYTES_DISPATCH_(
+   size_t, count_byte,
+   (const void *data, size_t size, unsigned char byte), (data, size, byte)
+)
+
+REBOOT_BYTES_DISPATCH_(
+   int, mem_eq, (const void *a, const void *b, size_t size), (a, b, size)
+)
+
+REBOOT_BYTES_DISPATCH_(
+   int, is_ascii, (const void *data, size_t size), (data, size)
+)
+
+/* <!-- }}} Dispatch --> */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
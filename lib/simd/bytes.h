@@ -0,0 +1,739 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+#ifndef __REBOOT_SIMD_BYTES_H__
+#define __REBOOT_SIMD_BYTES_H__
+
+/*!
+ * @file  simd/bytes.h
+ * @brief Vectorized byte string primitives.
+ *
+ * This  header  provides the byte scanning  primitives
+ * parsers spend their time in :
+ *
+ * - `find_byte`   : First occurrence of a byte.
+ * - `find_any_of` : First byte of a set.
+ * - `count_byte`  : Occurrences of a byte.
+ * - `mem_eq`      : Equality of two ranges.
+ * - `is_ascii`    : Absence of high bits.
+ *
+ * Each  one  is named  `reboot_bytes_<primitive>`  and
+ * maps     to     the    widest    instruction     set
+ * `preprocessor/environment/architecture.h`    reports
+ * for  the  translation unit. Every implementation  is
+ * also  available  on its own, suffixed with  `_avx2`,
+ * `_sse2`,  `_neon`  or `_scalar`, wherever it can  be
+ * compiled,   and  `REBOOT_BYTES_HAS_<ISA>`  is   then
+ * defined.
+ *
+ * Only  the  baseline instruction sets are implemented
+ * inline, the AVX2 implementations being compiled into
+ * the  library instead, with `REBOOT_TARGET` when AVX2
+ * is  not  part of the baseline. They may then only be
+ * called  once  the  host was found to support it. The
+ * `reboot_bytes_<primitive>_dispatch`  functions do so
+ * on    their    own,   forwarding   to   the   widest
+ * implementation    the    host    supports    through
+ * `REBOOT_CPU_DISPATCH`.  Being  out of line, they pay
+ * off on inputs long enough to amortize the call.
+ *
+ * Keeping  `<immintrin.h>`  out  of this header spares
+ * its includers from parsing it, which would otherwise
+ * make   this   header  an  order  of  magnitude  more
+ * expensive than the rest of the library.
+ *
+ * Searches  return  the index of the first  match,  or
+ * `size`  when there is none. No implementation  reads
+ * past  the  end of its input : tails shorter  than  a
+ * vector  are  handled  by overlapping the  last  full
+ * vector  with  the previous one, or by  the  narrower
+ * implementation  when  the  input is shorter  than  a
+ * vector altogether.
+ *
+ * The  scalar  `find_byte`  and  `mem_eq`  forward  to
+ * `memchr`  and `memcmp`, which every C library  worth
+ * its salt vectorizes already.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "bits.h"
+#include "multiversion.h"
+#include "preprocessor/environment/architecture.h"
+#include "preprocessor/environment/compiler.h"
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_SSE2)
+#  include <emmintrin.h>
+#  define REBOOT_BYTES_HAS_SSE2
+#endif
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86)             \
+ && defined(REBOOT_BYTES_HAS_SSE2)                                            \
+ && (  defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX2)         \
+    || defined(REBOOT_MULTIVERSION_HAS_TARGET))
+#  define REBOOT_BYTES_HAS_AVX2
+#endif
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_NEON)
+#  include <arm_neon.h>
+#  define REBOOT_BYTES_HAS_NEON
+#endif
+
+/*!
+ * Sets  larger than this are matched through a  lookup
+ * table  by  the  scalar  implementation,  one  vector
+ * comparison per set byte no longer paying off.
+ */
+#define REBOOT_BYTES_SET_MAX 16
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! <!-- Scalar {{{ -->
+ * @addtogroup  bytes_scalar Scalar
+ * @brief Portable implementations
+ * @{
+ */
+
+static REBOOT_INLINE size_t
+reboot_bytes_find_byte_scalar(
+   const void *data, size_t size, unsigned char byte
+) {
+   const void *match = memchr(data, byte, size);
+
+   return match != NULL
+      ? (size_t) ((const unsigned char *) match - (const unsigned char *) data)
+      : size;
+}
+
+static REBOOT_INLINE size_t
+reboot_bytes_find_any_of_scalar(
+   const void *data, size_t size, const char *set, size_t set_size
+) {
+   const unsigned char *bytes = (const unsigned char *) data;
+   unsigned char        table[256];
+   size_t               i;
+
+   memset(table, 0, sizeof table);
+
+   for (i = 0; i < set_size; ++i) {
+      table[(unsigned char) set[i]] = 1;
+   }
+
+   for (i = 0; i < size && !table[bytes[i]]; ++i) {
+      /* Table lookup. */
+   }
+
+   return i;
+}
+
+static REBOOT_INLINE size_t
+reboot_bytes_count_byte_scalar(
+   const void *data, size_t size, unsigned char byte
+) {
+   const unsigned char *bytes = (const unsigned char *) data;
+   size_t               count = 0;
+   size_t               i;
+
+   for (i = 0; i < size; ++i) {
+      count += bytes[i] == byte;
+   }
+
+   return count;
+}
+
+static REBOOT_INLINE int
+reboot_bytes_mem_eq_scalar(const void *a, const void *b, size_t size)
+{
+   return memcmp(a, b, size) == 0;
+}
+
+/*!
+ * Eight  bytes are tested at once, `memcpy`  compiling
+ * to  a  single  unaligned load  wherever  the  target
+ * allows one.
+ */
+static REBOOT_INLINE int
+reboot_bytes_is_ascii_scalar(const void *data, size_t size)
+{
+   const unsigned char *bytes = (const unsigned char *) data;
+   uint64_t             seen  = 0;
+   size_t               i     = 0;
+
+   for (; i + 8u <= size; i += 8u) {
+      uint64_t word;
+
+      memcpy(&word, bytes + i, sizeof word);
+      seen |= word;
+   }
+
+   for (; i < size; ++i) {
+      seen |= bytes[i];
+   }
+
+   return (seen & ((uint64_t) 0x80808080u << 32 | 0x80808080u)) == 0;
+}
+
+/*! @} <!-- }}} Scalar --> */
+
+/*! <!-- SSE2 {{{ -->
+ * @addtogroup  bytes_sse2 SSE2
+ * @brief 16-byte x86 implementations
+ * @{
+ */
+
+#if defined(REBOOT_BYTES_HAS_SSE2)
+
+static REBOOT_ALWAYS_INLINE unsigned
+reboot_bytes_eq_sse2_(const unsigned char *p, __m128i needle)
+{
+   __m128i chunk = _mm_loadu_si128((const __m128i *) (const void *) p);
+
+   return (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+}
+
+static REBOOT_ALWAYS_INLINE unsigned
+reboot_bytes_any_sse2_(
+   const unsigned char *p, const __m128i *needles, size_t count
+) {
+   __m128i chunk = _mm_loadu_si128((const __m128i *) (const void *) p);
+   __m128i match = _mm_cmpeq_epi8(chunk, needles[0]);
+   size_t  i;
+
+   for (i = 1; i < count; ++i) {
+      match = _mm_or_si128(match, _mm_cmpeq_epi8(chunk, needles[i]));
+   }
+
+   return (unsigned) _mm_movemask_epi8(match);
+}
+
+static REBOOT_INLINE size_t
+reboot_bytes_find_byte_sse2(const void *data, size_t size, unsigned char byte)
+{
+   const unsigned char *bytes = (const unsigned char *) data;
+   __m128i              needle;
+   unsigned             mask;
+   size_t               i;
+
+   if (size < 16u) {
+      return reboot_bytes_find_byte_scalar(data, size, byte);
+   }
+
+   needle = _mm_set1_epi8((char) byte);
+
+   for (i = 0; i + 16u <= size; i += 16u) {
+      if ((mask = reboot_bytes_eq_sse2_(bytes + i, needle)) != 0) {
+         return i + reboot_bits_ctz32(mask);
+      }
+   }
+
+   if (i < size
+    && (mask = reboot_bytes_eq_sse2_(bytes + size - 16u, needle)) != 0) {
+      return size - 16u + reboot_bits_ctz32(mask);
+   }
+
+   return size;
+}
+
+static REBOOT_INLINE size_t
+reboot_bytes_find_any_of_sse2(
+   const void *data, size_t size, const char *set, size_t set_size
+) {
+   const unsigned char *bytes = (const unsigned char *) data;
+   __m128i              needles[REBOOT_BYTES_SET_MAX];
+   unsigned             mask;
+   size_t               i;
+
+   if (size < 16u || set_size == 0 || set_size > REBOOT_BYTES_SET_MAX) {
+      return reboot_bytes_find_any_of_scalar(data, size, set, set_size);
+   }
+
+   for (i = 0; i < set_size; ++i) {
+      needles[i] = _mm_set1_epi8(set[i]);
+   }
+
+   for (i = 0; i + 16u <= size; i += 16u) {
+      if ((mask = reboot_bytes_any_sse2_(bytes + i, needles, set_size)) != 0) {
+         return i + reboot_bits_ctz32(mask);
+      }
+   }
+
+   if (i < size && (mask = reboot_bytes_any_sse2_(
+      bytes + size - 16u, needles, set_size
+   )) != 0) {
+      return size - 16u + reboot_bits_ctz32(mask);
+   }
+
+   return size;
+}
+
+/*!
+ * Matches  are accumulated as bytes by subtracting the
+ * all  ones comparison results, and folded into 64-bit
+ * lanes  by `psadbw` every 255 vectors, before a  lane
+ * may overflow.
+ */
+static REBOOT_INLINE size_t
+reboot_bytes_count_byte_sse2(
+   const void *data, size_t size, unsigned char byte
+) {
+   const unsigned char *bytes  = (const unsigned char *) data;
+   const __m128i        needle = _mm_set1_epi8((char) byte);
+   const __m128i        zero   = _mm_setzero_si128();
+   __m128i              total  = zero;
+   uint64_t             lanes[2];
+   size_t               i      = 0;
+
+   while (i + 16u <= size) {
+      __m128i  counts = zero;
+      unsigned n;
+
+      for (n = 0; n < 255u && i + 16u <= size; ++n, i += 16u) {
+         __m128i chunk = _mm_loadu_si128(
+            (const __m128i *) (const void *) (bytes + i)
+         );
+
+         counts = _mm_sub_epi8(counts, _mm_cmpeq_epi8(chunk, needle));
+      }
+
+      total = _mm_add_epi64(total, _mm_sad_epu8(counts, zero));
+   }
+
+   _mm_storeu_si128((__m128i *) (void *) lanes, total);
+
+   return (size_t) (lanes[0] + lanes[1])
+        + reboot_bytes_count_byte_scalar(bytes + i, size - i, byte);
+}
+
+static REBOOT_INLINE int
+reboot_bytes_mem_eq_sse2(const void *a, const void *b, size_t size)
+{
+   const unsigned char *left  = (const unsigned char *) a;
+   const unsigned char *right = (const unsigned char *) b;
+   size_t               i;
+
+   if (size < 16u) {
+      return reboot_bytes_mem_eq_scalar(a, b, size);
+   }
+
+   for (i = 0; i + 16u <= size; i += 16u) {
+      __m128i x = _mm_loadu_si128(
+         (const __m128i *) (const void *) (left + i)
+      );
+      __m128i y = _mm_loadu_si128(
+         (const __m128i *) (const void *) (right + i)
+      );
+
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) != 0xFFFF) {
+         return 0;
+      }
+   }
+
+   if (i < size) {
+      __m128i x = _mm_loadu_si128(
+         (const __m128i *) (const void *) (left + size - 16u)
+      );
+      __m128i y = _mm_loadu_si128(
+         (const __m128i *) (const void *) (right + size - 16u)
+      );
+
+      return _mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) == 0xFFFF;
+   }
+
+   return 1;
+}
+
+static REBOOT_INLINE int
+reboot_bytes_is_ascii_sse2(const void *data, size_t size)
+{
+   const unsigned char *bytes = (const unsigned char *) data;
+   __m128i              seen  = _mm_setzero_si128();
+   __m128i              other = _mm_setzero_si128();
+   size_t               i     = 0;
+
+   if (size < 16u) {
+      return reboot_bytes_is_ascii_scalar(data, size);
+   }
+
+   /* Two accumulators, for the loads not to wait on a single `por`. */
+   for (; i + 32u <= size; i += 32u) {
+      seen = _mm_or_si128(
+         seen, _mm_loadu_si128((const __m128i *) (const void *) (bytes + i))
+      );
+      other = _mm_or_si128(other, _mm_loadu_si128(
+         (const __m128i *) (const void *) (bytes + i + 16u)
+      ));
+   }
+
+   seen = _mm_or_si128(seen, other);
+
+   for (; i + 16u <= size; i += 16u) {
+      seen = _mm_or_si128(
+         seen, _mm_loadu_si128((const __m128i *) (const void *) (bytes + i))
+      );
+   }
+
+   if (i < size) {
+      seen = _mm_or_si128(seen, _mm_loadu_si128(
+         (const __m128i *) (const void *) (bytes + size - 16u)
+      ));
+   }
+
+   return _mm_movemask_epi8(seen) == 0;
+}
+
+#endif
+
+/*! @} <!-- }}} SSE2 --> */
+
+/*! <!-- NEON {{{ -->
+ * @addtogroup  bytes_neon NEON
+ * @brief 16-byte ARM implementations
+ *
+ * NEON  has  no equivalent of  `movemask`.  Comparison
+ * results  are  narrowed  to four bits per byte  by  a
+ * shift  right  and narrow instead, the index  of  the
+ * first  match  being a quarter of the  trailing  zero
+ * count of the resulting 64-bit word.
+ * @{
+ */
+
+#if defined(REBOOT_BYTES_HAS_NEON)
+
+static REBOOT_ALWAYS_INLINE uint64_t
+reboot_bytes_mask_neon_(uint8x16_t match)
+{
+   uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(match), 4);
+
+   return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+}
+
+static REBOOT_ALWAYS_INLINE uint64_t
+reboot_bytes_sum_neon_(uint8x16_t counts)
+{
+   uint64x2_t sums = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(counts)));
+
+   return vgetq_lane_u64(sums, 0) + vgetq_lane_u64(sums, 1);
+}
+
+static REBOOT_ALWAYS_INLINE uint64_t
+reboot_bytes_any_neon_(
+   const unsigned char *p, const uint8x16_t *needles, size_t count
+) {
+   uint8x16_t chunk = vld1q_u8(p);
+   uint8x16_t match = vceqq_u8(chunk, needles[0]);
+   size_t     i;
+
+   for (i = 1; i < count; ++i) {
+      match = vorrq_u8(match, vceqq_u8(chunk, needles[i]));
+   }
+
+   return reboot_bytes_mask_neon_(match);
+}
+
+static REBOOT_INLINE size_t
+reboot_bytes_find_byte_neon(const void *data, size_t size, unsigned char byte)
+{
+   const unsigned char *bytes = (const unsigned char *) data;
+   uint8x16_t           needle;
+   uint64_t             mask;
+   size_t               i;
+
+   if (size < 16u) {
+      return reboot_bytes_find_byte_scalar(data, size, byte);
+   }
+
+   needle = vdupq_n_u8(byte);
+
+   for (i = 0; i + 16u <= size; i += 16u) {
+      mask = reboot_bytes_mask_neon_(vceqq_u8(vld1q_u8(bytes + i), needle));
+
+      if (mask != 0) {
+         return i + (reboot_bits_ctz64(mask) >> 2);
+      }
+   }
+
+   if (i < size) {
+      mask = reboot_bytes_mask_neon_(
+         vceqq_u8(vld1q_u8(bytes + size - 16u), needle)
+      );
+
+      if (mask != 0) {
+         return size - 16u + (reboot_bits_ctz64(mask) >> 2);
+      }
+   }
+
+   return size;
+}
+
+static REBOOT_INLINE size_t
+reboot_bytes_find_any_of_neon(
+   const void *data, size_t size, const char *set, size_t set_size
+) {
+   const unsigned char *bytes = (const unsigned char *) data;
+   uint8x16_t           needles[REBOOT_BYTES_SET_MAX];
+   uint64_t             mask;
+   size_t               i;
+
+   if (size < 16u || set_size == 0 || set_size > REBOOT_BYTES_SET_MAX) {
+      return reboot_bytes_find_any_of_scalar(data, size, set, set_size);
+   }
+
+   for (i = 0; i < set_size; ++i) {
+      needles[i] = vdupq_n_u8((unsigned char) set[i]);
+   }
+
+   for (i = 0; i + 16u <= size; i += 16u) {
+      if ((mask = reboot_bytes_any_neon_(bytes + i, needles, set_size)) != 0) {
+         return i + (reboot_bits_ctz64(mask) >> 2);
+      }
+   }
+
+   if (i < size && (mask = reboot_bytes_any_neon_(
+      bytes + size - 16u, needles, set_size
+   )) != 0) {
+      return size - 16u + (reboot_bits_ctz64(mask) >> 2);
+   }
+
+   return size;
+}
+
+static REBOOT_INLINE size_t
+reboot_bytes_count_byte_neon(
+   const void *data, size_t size, unsigned char byte
+) {
+   const unsigned char *bytes  = (const unsigned char *) data;
+   const uint8x16_t     needle = vdupq_n_u8(byte);
+   uint64_t             total  = 0;
+   size_t               i      = 0;
+
+   while (i + 16u <= size) {
+      uint8x16_t counts = vdupq_n_u8(0);
+      unsigned   n;
+
+      for (n = 0; n < 255u && i + 16u <= size; ++n, i += 16u) {
+         counts = vsubq_u8(counts, vceqq_u8(vld1q_u8(bytes + i), needle));
+      }
+
+      total += reboot_bytes_sum_neon_(counts);
+   }
+
+   return (size_t) total
+        + reboot_bytes_count_byte_scalar(bytes + i, size - i, byte);
+}
+
+static REBOOT_INLINE int
+reboot_bytes_mem_eq_neon(const void *a, const void *b, size_t size)
+{
+   const unsigned char *left  = (const unsigned char *) a;
+   const unsigned char *right = (const unsigned char *) b;
+   size_t               i;
+
+   if (size < 16u) {
+      return reboot_bytes_mem_eq_scalar(a, b, size);
+   }
+
+   for (i = 0; i + 16u <= size; i += 16u) {
+      uint8x16_t diff = veorq_u8(vld1q_u8(left + i), vld1q_u8(right + i));
+
+      if (reboot_bytes_mask_neon_(vtstq_u8(diff, diff)) != 0) {
+         return 0;
+      }
+   }
+
+   if (i < size) {
+      uint8x16_t diff = veorq_u8(
+         vld1q_u8(left + size - 16u), vld1q_u8(right + size - 16u)
+      );
+
+      return reboot_bytes_mask_neon_(vtstq_u8(diff, diff)) == 0;
+   }
+
+   return 1;
+}
+
+static REBOOT_INLINE int
+reboot_bytes_is_ascii_neon(const void *data, size_t size)
+{
+   const unsigned char *bytes = (const unsigned char *) data;
+   uint8x16_t           seen  = vdupq_n_u8(0);
+   size_t               i;
+
+   if (size < 16u) {
+      return reboot_bytes_is_ascii_scalar(data, size);
+   }
+
+   for (i = 0; i + 16u <= size; i += 16u) {
+      seen = vorrq_u8(seen, vld1q_u8(bytes + i));
+   }
+
+   if (i < size) {
+      seen = vorrq_u8(seen, vld1q_u8(bytes + size - 16u));
+   }
+
+   return reboot_bytes_mask_neon_(vtstq_u8(seen, vdupq_n_u8(0x80))) == 0;
+}
+
+#endif
+
+/*! @} <!-- }}} NEON --> */
+
+/*! <!-- AVX2 {{{ -->
+ * @addtogroup  bytes_avx2 AVX2
+ * @brief 32-byte x86 implementations
+ *
+ * Inputs  shorter than a 32-byte vector are handed  to
+ * the SSE2 implementations.
+ * @{
+ */
+
+#if defined(REBOOT_BYTES_HAS_AVX2)
+
+size_t reboot_bytes_find_byte_avx2(
+   const void *data, size_t size, unsigned char byte
+);
+
+size_t reboot_bytes_find_any_of_avx2(
+   const void *data, size_t size, const char *set, size_t set_size
+);
+
+size_t reboot_bytes_count_byte_avx2(
+   const void *data, size_t size, unsigned char byte
+);
+
+int reboot_bytes_mem_eq_avx2(const void *a, const void *b, size_t size);
+
+int reboot_bytes_is_ascii_avx2(const void *data, size_t size);
+
+#endif
+
+/*! @} <!-- }}} AVX2 --> */
+
+/*! <!-- Primitives {{{ -->
+ * @addtogroup  bytes_primitives Primitives
+ * @brief Best implementations for the baseline
+ * @{
+ */
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_AVX2)
+#  define REBOOT_BYTES_BEST_(primitive) reboot_bytes_##primitive##_avx2
+#elif defined(REBOOT_BYTES_HAS_SSE2)
+#  define REBOOT_BYTES_BEST_(primitive) reboot_bytes_##primitive##_sse2
+#elif defined(REBOOT_BYTES_HAS_NEON)
+#  define REBOOT_BYTES_BEST_(primitive) reboot_bytes_##primitive##_neon
+#else
+#  define REBOOT_BYTES_BEST_(primitive) reboot_bytes_##primitive##_scalar
+#endif
+
+/*!
+ * @brief Byte search.
+ *
+ * This  function returns the index of the first `byte`
+ * in `data`, or `size` if there is none.
+ */
+static REBOOT_INLINE size_t
+reboot_bytes_find_byte(const void *data, size_t size, unsigned char byte)
+{
+   return REBOOT_BYTES_BEST_(find_byte)(data, size, byte);
+}
+
+/*!
+ * @brief Byte set search.
+ *
+ * This function returns the index of the first byte of
+ * `data` found among the `set_size` bytes of `set`, or
+ * `size`  if  there  is none.  Vector  implementations
+ * compare  every vector against every byte of the set,
+ * and   are   thus  best  suited  to  small  sets   of
+ * delimiters.
+ */
+static REBOOT_INLINE size_t
+reboot_bytes_find_any_of(
+   const void *data, size_t size, const char *set, size_t set_size
+) {
+   return REBOOT_BYTES_BEST_(find_any_of)(data, size, set, set_size);
+}
+
+/*!
+ * @brief Byte count.
+ */
+static REBOOT_INLINE size_t
+reboot_bytes_count_byte(const void *data, size_t size, unsigned char byte)
+{
+   return REBOOT_BYTES_BEST_(count_byte)(data, size, byte);
+}
+
+/*!
+ * @brief Range equality.
+ *
+ * This function returns non-zero when the `size` bytes
+ * at  `a` and `b` are equal. Unlike `memcmp`, it  does
+ * not  order  them,  which spares locating  the  first
+ * difference.
+ */
+static REBOOT_INLINE int
+reboot_bytes_mem_eq(const void *a, const void *b, size_t size)
+{
+   return REBOOT_BYTES_BEST_(mem_eq)(a, b, size);
+}
+
+/*!
+ * @brief ASCII validation.
+ *
+ * This  function  returns  non-zero when  no  byte  of
+ * `data` has its high bit set. It does not exit early,
+ * valid input being the case worth optimizing for.
+ */
+static REBOOT_INLINE int
+reboot_bytes_is_ascii(const void *data, size_t size)
+{
+   return REBOOT_BYTES_BEST_(is_ascii)(data, size);
+}
+
+/*! @} <!-- }}} Primitives --> */
+
+/*! <!-- Dispatch {{{ -->
+ * @addtogroup  bytes_dispatch Dispatch
+ * @brief Best implementations for the host
+ *
+ * These  functions  behave  as their baseline namesake
+ * while  selecting  the widest implementation the host
+ * supports on their first call.
+ * @{
+ */
+
+size_t reboot_bytes_find_byte_dispatch(
+   const void *data, size_t size, unsigned char byte
+);
+
+size_t reboot_bytes_find_any_of_dispatch(
+   const void *data, size_t size, const char *set, size_t set_size
+);
+
+size_t reboot_bytes_count_byte_dispatch(
+   const void *data, size_t size, unsigned char byte
+);
+
+int reboot_bytes_mem_eq_dispatch(const void *a, const void *b, size_t size);
+
+int reboot_bytes_is_ascii_dispatch(const void *data, size_t size);
+
+/*! @} <!-- }}} Dispatch --> */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __REBOOT_SIMD_BYTES_H__ */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
@@ -0,0 +1,630 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+/*!
+ * @file  timer.c
+ * @brief Tick counters and latency probes.
+ *
+ * Every  thread owns an open addressing table  mapping
+ * probe  names, by address, to histograms. Tables  are
+ * linked  into a global list, under a lock only  taken
+ * when a thread meets a probe for the first time, when
+ * it grows its table, and by readers.
+ */
+
+/* `CLOCK_MONOTONIC_RAW` in strict modes. */
+#ifndef _DEFAULT_SOURCE
+#  define _DEFAULT_SOURCE
+#endif
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "timer.h"
+#include "bits.h"
+#include "preprocessor/environment/os.h"
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+#  ifndef WIN32_LEAN_AND_MEAN
+#     define WIN32_LEAN_AND_MEAN
+#  endif
+#  include <windows.h>
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_UNIX)
+#  include <pthread.h>
+#endif
+
+/* <!-- Clock {{{ --> */
+
+uint64_t
+reboot_timer_clock(void)
+{
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+   LARGE_INTEGER counter;
+   LARGE_INTEGER frequency;
+   uint64_t      ticks;
+   uint64_t      rate;
+
+   QueryPerformanceCounter(&counter);
+   QueryPerformanceFrequency(&frequency);
+
+   ticks = (uint64_t) counter.QuadPart;
+   rate  = (uint64_t) frequency.QuadPart;
+
+   return ticks / rate * 1000000000u + ticks % rate * 1000000000u / rate;
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_UNIX)
+   struct timespec now;
+
+#  if defined(CLOCK_MONOTONIC_RAW)
+   clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+#  else
+   clock_gettime(CLOCK_MONOTONIC, &now);
+#  endif
+
+   return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+#else
+   return (uint64_t) clock() * 1000000000u / CLOCKS_PER_SEC;
+#endif
+}
+
+/* <!-- }}} Clock --> */
+
+/* <!-- Frequency {{{ --> */
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86)             \
+ && defined(REBOOT_TIMER_HAS_COUNTER)
+
+#  define REBOOT_TIMER_CALIBRATION_NS_ 10000000u
+
+static uint64_t reboot_timer_frequency_;
+
+/*!
+ * The  counter is sampled on both sides of a busy wait
+ * on  the  monotonic clock, ordered reads keeping  the
+ * clock   reads   from  drifting  into  the   measured
+ * interval.
+ */
+static void
+reboot_timer_calibrate_(void)
+{
+   uint64_t clock_start = reboot_timer_clock();
+   uint64_t ticks_start = reboot_timer_ticks_ordered();
+   uint64_t clock_end;
+   uint64_t ticks_end;
+
+   do {
+      clock_end = reboot_timer_clock();
+   } while (clock_end - clock_start < REBOOT_TIMER_CALIBRATION_NS_);
+
+   ticks_end = reboot_timer_ticks_ordered();
+
+   reboot_timer_frequency_ = (ticks_end - ticks_start) * 1000000000u
+                           / (clock_end - clock_start);
+}
+
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+
+static INIT_ONCE reboot_timer_once_ = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK
+reboot_timer_calibrate_once_(INIT_ONCE *once, void *parameter, void **context)
+{
+   (void) once;
+   (void) parameter;
+   (void) context;
+
+   reboot_timer_calibrate_();
+
+   return TRUE;
+}
+
+uint64_t
+reboot_timer_frequency(void)
+{
+   InitOnceExecuteOnce(
+      &reboot_timer_once_, reboot_timer_calibrate_once_, NULL, NULL
+   );
+
+   return reboot_timer_frequency_;
+}
+
+#  elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_UNIX)
+
+static pthread_once_t reboot_timer_once_ = PTHREAD_ONCE_INIT;
+
+uint64_t
+reboot_timer_frequency(void)
+{
+   pthread_once(&reboot_timer_once_, reboot_timer_calibrate_);
+
+   return reboot_timer_frequency_;
+}
+
+#  else
+
+uint64_t
+reboot_timer_frequency(void)
+{
+   if (reboot_timer_frequency_ == 0) {
+      reboot_timer_calibrate_();
+   }
+
+   return reboot_timer_frequency_;
+}
+
+#  endif
+
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM64)         \
+   && defined(REBOOT_TIMER_HAS_COUNTER)
+
+uint64_t
+reboot_timer_frequency(void)
+{
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)
+   return (uint64_t) _ReadStatusReg(ARM64_SYSREG(3, 3, 14, 0, 0));
+#  else
+   uint64_t frequency;
+
+   __asm__ __volatile__ ("mrs %0, cntfrq_el0" : "=r" (frequency));
+
+   return frequency;
+#  endif
+}
+
+#else
+
+uint64_t
+reboot_timer_frequency(void)
+{
+   return 1000000000u;
+}
+
+#endif
+
+/* <!-- }}} Frequency --> */
+
+/* <!-- Registry {{{ --> */
+
+#define REBOOT_PROBE_TABLE_SIZE_ 16u
+
+typedef struct reboot_probe_entry_ {
+   const char               *name;
+   reboot_probe_histogram_t *histogram;
+} reboot_probe_entry_;
+
+typedef struct reboot_probe_thread_ {
+   struct reboot_probe_thread_ *next;
+   reboot_probe_entry_         *entries;
+   size_t                       mask;
+   size_t                       count;
+} reboot_probe_thread_;
+
+static reboot_probe_thread_ *reboot_probe_threads_;
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+
+static SRWLOCK reboot_probe_lock_ = SRWLOCK_INIT;
+
+#  define REBOOT_PROBE_LOCK_()   AcquireSRWLockExclusive(&reboot_probe_lock_)
+#  define REBOOT_PROBE_UNLOCK_() ReleaseSRWLockExclusive(&reboot_probe_lock_)
+
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_UNIX)
+
+static pthread_mutex_t reboot_probe_lock_ = PTHREAD_MUTEX_INITIALIZER;
+
+#  define REBOOT_PROBE_LOCK_()   pthread_mutex_lock(&reboot_probe_lock_)
+#  define REBOOT_PROBE_UNLOCK_() pthread_mutex_unlock(&reboot_probe_lock_)
+
+#else
+
+#  define REBOOT_PROBE_LOCK_()   ((void) 0)
+#  define REBOOT_PROBE_UNLOCK_() ((void) 0)
+
+#endif
+
+/* <!-- }}} Registry --> */
+
+/* <!-- Recording {{{ --> */
+
+#if defined(REBOOT_HAS_THREAD_LOCAL)
+
+static REBOOT_THREAD_LOCAL reboot_probe_thread_ *reboot_probe_self_;
+
+static REBOOT_INLINE size_t
+reboot_probe_hash_(const char *name)
+{
+   return (size_t) (((uintptr_t) name >> 3) * 2654435761u);
+}
+
+static void
+reboot_probe_place_(reboot_probe_thread_ *thread, reboot_probe_entry_ entry)
+{
+   size_t slot = reboot_probe_hash_(entry.name) & thread->mask;
+
+   while (thread->entries[slot].name != NULL) {
+      slot = (slot + 1u) & thread->mask;
+   }
+
+   thread->entries[slot] = entry;
+   thread->count        += 1u;
+}
+
+/*!
+ * Tables are kept at most half full, which keeps probe
+ * sequences  short.  Growing  swaps the table  of  the
+ * calling thread under the lock, so that readers never
+ * walk a freed one.
+ */
+static int
+reboot_probe_grow_(reboot_probe_thread_ *thread)
+{
+   reboot_probe_entry_ *entries = thread->entries;
+   size_t               size    = thread->mask + 1u;
+   size_t               i;
+
+   thread->entries = (reboot_probe_entry_ *) calloc(
+      2u * size, sizeof *thread->entries
+   );
+
+   if (thread->entries == NULL) {
+      thread->entries = entries;
+      return -1;
+   }
+
+   thread->mask  = 2u * size - 1u;
+   thread->count = 0;
+
+   for (i = 0; i < size; ++i) {
+      if (entries[i].name != NULL) {
+         reboot_probe_place_(thread, entries[i]);
+      }
+   }
+
+   free(entries);
+
+   return 0;
+}
+
+static reboot_probe_thread_ *
+reboot_probe_thread_create_(void)
+{
+   reboot_probe_thread_ *thread = (reboot_probe_thread_ *) calloc(
+      1, sizeof *thread
+   );
+
+   if (thread == NULL) {
+      return NULL;
+   }
+
+   thread->entries = (reboot_probe_entry_ *) calloc(
+      REBOOT_PROBE_TABLE_SIZE_, sizeof *thread->entries
+   );
+
+   if (thread->entries == NULL) {
+      free(thread);
+      return NULL;
+   }
+
+   thread->mask          = REBOOT_PROBE_TABLE_SIZE_ - 1u;
+   thread->next          = reboot_probe_threads_;
+   reboot_probe_threads_ = thread;
+
+   return thread;
+}
+
+static REBOOT_COLD reboot_probe_histogram_t *
+reboot_probe_insert_(const char *name)
+{
+   reboot_probe_thread_     *thread    = reboot_probe_self_;
+   reboot_probe_histogram_t *histogram = NULL;
+   reboot_probe_entry_       entry;
+
+   REBOOT_PROBE_LOCK_();
+
+   if (thread == NULL) {
+      thread = reboot_probe_self_ = reboot_probe_thread_create_();
+   }
+
+   if (thread == NULL
+    || ((thread->count + 1u) * 2u > thread->mask + 1u
+     && reboot_probe_grow_(thread) != 0)) {
+      REBOOT_PROBE_UNLOCK_();
+      return NULL;
+   }
+
+   histogram = (reboot_probe_histogram_t *) calloc(1, sizeof *histogram);
+
+   if (histogram != NULL) {
+      entry.name      = name;
+      entry.histogram = histogram;
+
+      reboot_probe_place_(thread, entry);
+   }
+
+   REBOOT_PROBE_UNLOCK_();
+
+   return histogram;
+}
+
+/*!
+ * Buckets below `4` hold a single value. Above, bucket
+ * `4 * (e - 1) + s` holds the values whose highest set
+ * bit is `e` and whose next two bits are `s`.
+ */
+static REBOOT_INLINE unsigned
+reboot_probe_bucket_(uint64_t ticks)
+{
+   unsigned exponent;
+
+   if (ticks < 4u) {
+      return (unsigned) ticks;
+   }
+
+   exponent = 63u - reboot_bits_clz64(ticks);
+
+   return ((exponent - 1u) << 2)
+        + (unsigned) ((ticks >> (exponent - 2u)) & 3u);
+}
+
+void
+reboot_probe_record(const char *name, uint64_t ticks)
+{
+   reboot_probe_thread_     *thread    = reboot_probe_self_;
+   reboot_probe_histogram_t *histogram = NULL;
+
+   if (REBOOT_LIKELY(thread != NULL)) {
+      size_t slot = reboot_probe_hash_(name) & thread->mask;
+
+      for (; thread->entries[slot].name != NULL;) {
+         if (thread->entries[slot].name == name) {
+            histogram = thread->entries[slot].histogram;
+            break;
+         }
+
+         slot = (slot + 1u) & thread->mask;
+      }
+   }
+
+   if (REBOOT_UNLIKELY(histogram == NULL)) {
+      histogram = reboot_probe_insert_(name);
+
+      if (histogram == NULL) {
+         return;
+      }
+   }
+
+   if (ticks < histogram->min || histogram->count == 0) {
+      histogram->min = ticks;
+   }
+
+   if (ticks > histogram->max) {
+      histogram->max = ticks;
+   }
+
+   histogram->count += 1u;
+   histogram->sum   += ticks;
+   histogram->buckets[reboot_probe_bucket_(ticks)] += 1u;
+}
+
+#else
+
+void
+reboot_probe_record(const char *name, uint64_t ticks)
+{
+   (void) name;
+   (void) ticks;
+}
+
+#endif
+
+/* <!-- }}} Recording --> */
+
+/* <!-- Reporting {{{ --> */
+
+static void
+reboot_probe_merge_(
+   reboot_probe_histogram_t *into, const reboot_probe_histogram_t *from
+) {
+   size_t i;
+
+   if (from->count == 0) {
+      return;
+   }
+
+   if (from->min < into->min || into->count == 0) {
+      into->min = from->min;
+   }
+
+   if (from->max > into->max) {
+      into->max = from->max;
+   }
+
+   into->count += from->count;
+   into->sum   += from->sum;
+
+   for (i = 0; i < REBOOT_PROBE_BUCKETS; ++i) {
+      into->buckets[i] += from->buckets[i];
+   }
+}
+
+/*!
+ * Names  are compared by content here, string literals
+ * of different translation units not necessarily being
+ * merged.
+ */
+static int
+reboot_probe_collect_locked_(
+   const char *name, reboot_probe_histogram_t *histogram
+) {
+   reboot_probe_thread_ *thread;
+   int                   found = -1;
+
+   memset(histogram, 0, sizeof *histogram);
+
+   for (thread = reboot_probe_threads_; thread; thread = thread->next) {
+      size_t i;
+
+      for (i = 0; i <= thread->mask; ++i) {
+         const reboot_probe_entry_ *entry = &thread->entries[i];
+
+         if (entry->name != NULL && strcmp(entry->name, name) == 0) {
+            reboot_probe_merge_(histogram, entry->histogram);
+            found = 0;
+         }
+      }
+   }
+
+   return found;
+}
+
+int
+reboot_probe_collect(const char *name, reboot_probe_histogram_t *histogram)
+{
+   int found;
+
+   REBOOT_PROBE_LOCK_();
+   found = reboot_probe_collect_locked_(name, histogram);
+   REBOOT_PROBE_UNLOCK_();
+
+   return found;
+}
+
+uint64_t
+reboot_probe_percentile(
+   const reboot_probe_histogram_t *histogram, double fraction
+) {
+   uint64_t rank;
+   uint64_t seen = 0;
+   unsigned i;
+
+   if (histogram->count == 0) {
+      return 0;
+   }
+
+   fraction = fraction < 0.0 ? 0.0 : fraction > 1.0 ? 1.0 : fraction;
+   rank     = (uint64_t) (fraction * (double) histogram->count + 0.5);
+   rank     = rank != 0 ? rank : 1u;
+
+   for (i = 0; i < REBOOT_PROBE_BUCKETS; ++i) {
+      seen += histogram->buckets[i];
+
+      if (seen >= rank) {
+         break;
+      }
+   }
+
+   if (i >= 4u && i < REBOOT_PROBE_BUCKETS) {
+      unsigned exponent = (i >> 2) + 1u;
+      uint64_t lower    = (uint64_t) (4u + (i & 3u)) << (exponent - 2u);
+      uint64_t upper    = lower + (((uint64_t) 1u << (exponent - 2u)) - 1u);
+
+      return upper < histogram->max ? upper : histogram->max;
+   }
+
+   return i < REBOOT_PROBE_BUCKETS ? i : histogram->max;
+}
+
+void
+reboot_probe_report(FILE *stream)
+{
+   reboot_probe_thread_     *thread;
+   reboot_probe_histogram_t  histogram;
+   const char              **names    = NULL;
+   size_t                    count    = 0;
+   size_t                    capacity = 0;
+
+   REBOOT_PROBE_LOCK_();
+
+   fprintf(
+      stream, "%-24s %12s %12s %12s %12s %12s\n",
+      "probe", "count", "min", "p50", "p99", "max"
+   );
+
+   for (thread = reboot_probe_threads_; thread; thread = thread->next) {
+      size_t i;
+
+      for (i = 0; i <= thread->mask; ++i) {
+         const char *name = thread->entries[i].name;
+         size_t      j;
+
+         if (name == NULL) {
+            continue;
+         }
+
+         for (j = 0; j < count && strcmp(names[j], name) != 0; ++j) {
+            /* Linear search. */
+         }
+
+         if (j < count) {
+            continue;
+         }
+
+         if (count == capacity) {
+            const char **grown = (const char **) realloc(
+               (void *) names, (capacity * 2u + 8u) * sizeof *names
+            );
+
+            if (grown == NULL) {
+               break;
+            }
+
+            names     = grown;
+            capacity = capacity * 2u + 8u;
+         }
+
+         names[count++] = name;
+
+         reboot_probe_collect_locked_(name, &histogram);
+
+         fprintf(
+            stream,
+            "%-24s %12" PRIu64 " %12" PRIu64 " %12" PRIu64 " %12" PRIu64
+            " %12" PRIu64 "\n",
+            name, histogram.count,
+            reboot_timer_nanoseconds(histogram.min),
+            reboot_timer_nanoseconds(reboot_probe_percentile(&histogram, .5)),
+            reboot_timer_nanoseconds(reboot_probe_percentile(&histogram, .99)),
+            reboot_timer_nanoseconds(histogram.max)
+         );
+      }
+   }
+
+   REBOOT_PROBE_UNLOCK_();
+
+   free((void *) names);
+}
+
+void
+reboot_probe_reset(void)
+{
+   reboot_probe_thread_ *thread;
+
+   REBOOT_PROBE_LOCK_();
+
+   for (thread = reboot_probe_threads_; thread; thread = thread->next) {
+      size_t i;
+
+      for (i = 0; i <= thread->mask; ++i) {
+         if (thread->entries[i].histogram != NULL) {
+            memset(
+               thread->entries[i].histogram, 0,
+               sizeof *thread->entries[i].histogram
+            );
+         }
+      }
+   }
+
+   REBOOT_PROBE_UNLOCK_();
+}
+
+/* <!-- }}} Reporting --> */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
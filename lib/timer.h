@@ -0,0 +1,327 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+#ifndef __REBOOT_TIMER_H__
+#define __REBOOT_TIMER_H__
+
+/*!
+ * @file  timer.h
+ * @brief Tick counters and latency probes.
+ *
+ * This  header reads the cheapest monotonic counter of
+ * the           target           detected           by
+ * `preprocessor/environment/architecture.h` :
+ *
+ * - x86     : `rdtsc`, the time stamp counter.
+ * - ARM64   : `cntvct_el0`, the virtual counter.
+ * - Others  : `CLOCK_MONOTONIC_RAW`, in nanoseconds.
+ *
+ * `REBOOT_TIMER_HAS_COUNTER` is defined whenever ticks
+ * are  read straight from a hardware counter, in a few
+ * cycles  and  without a system call.  `clock_gettime`
+ * goes  through the vDSO on Linux, which is cheap  but
+ * still  costs tens of nanoseconds, and a system  call
+ * elsewhere.
+ *
+ * Neither  counter counts core cycles : the time stamp
+ * counter  of  every x86 processor of the last  decade
+ * ticks  at  a constant rate regardless  of  frequency
+ * scaling, and `cntvct_el0` ticks at the rate reported
+ * by  `cntfrq_el0`.  `reboot_timer_frequency`  returns
+ * that  rate,  which  is calibrated once  against  the
+ * monotonic clock on x86.
+ *
+ * On    top    of   it,    `REBOOT_PROBE_BEGIN`    and
+ * `REBOOT_PROBE_END`  record  the latency of  a  scope
+ * into  per-thread histograms. They compile to a  bare
+ * block  unless `REBOOT_PROBE_ENABLE` is defined, e.g.
+ * by the `REBOOT_ENABLE_PROBES` CMake option, and thus
+ * cost nothing in production builds.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "preprocessor/environment/architecture.h"
+#include "preprocessor/environment/compiler.h"
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)                \
+ && (defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86)            \
+  || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM64))
+#  include <intrin.h>
+#  define REBOOT_TIMER_HAS_COUNTER
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)              \
+   && (defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86)          \
+    || defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM64))
+#  define REBOOT_TIMER_HAS_COUNTER
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! <!-- Counter {{{ -->
+ * @addtogroup  timer_counter Counter
+ * @brief Raw monotonic ticks
+ *
+ * `REBOOT_RDTSC`   reads   the  counter  as  soon   as
+ * possible, possibly before the preceding instructions
+ * retire,   and  is  meant  to  start  a  measurement.
+ * `REBOOT_RDTSCP` waits for them first and is meant to
+ * end  one, so that the measured code is not cut short
+ * by out of order execution.
+ *
+ * The  latter  issues `lfence` before  `rdtsc`  rather
+ * than  using  `rdtscp`, which Core 2 processors  lack
+ * and  which  clobbers  a register for  the  processor
+ * number.  `lfence`  is dispatch serializing on  Intel
+ * processors,  and on AMD ones since operating systems
+ * enabled it against speculative execution attacks. On
+ * ARM64, `isb` serves the same purpose.
+ * @{
+ */
+
+/*!
+ * @brief Monotonic clock.
+ *
+ * This   function   returns   a  monotonic   time   in
+ * nanoseconds,    from   `CLOCK_MONOTONIC_RAW`   where
+ * available,  which  unlike `CLOCK_MONOTONIC`  is  not
+ * slewed  by NTP, or from `QueryPerformanceCounter` on
+ * Windows.
+ */
+uint64_t reboot_timer_clock(void);
+
+/*!
+ * @brief Counter frequency.
+ *
+ * This  function  returns  the  number  of  ticks  per
+ * second.  The  first call on x86 spins for  about  10
+ * milliseconds to calibrate it, later calls return the
+ * cached value.
+ */
+uint64_t reboot_timer_frequency(void);
+
+/*!
+ * @brief Tick count.
+ */
+static REBOOT_ALWAYS_INLINE uint64_t
+reboot_timer_ticks(void)
+{
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)                \
+ && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86)
+   return (uint64_t) __rdtsc();
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)              \
+   && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM64)
+   return (uint64_t) _ReadStatusReg(ARM64_CNTVCT);
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)              \
+   && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86)
+   uint32_t low;
+   uint32_t high;
+
+   __asm__ __volatile__ ("rdtsc" : "=a" (low), "=d" (high));
+
+   return (uint64_t) high << 32 | low;
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)              \
+   && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM64)
+   uint64_t ticks;
+
+   __asm__ __volatile__ ("mrs %0, cntvct_el0" : "=r" (ticks));
+
+   return ticks;
+#else
+   return reboot_timer_clock();
+#endif
+}
+
+/*!
+ * @brief Ordered tick count.
+ */
+static REBOOT_ALWAYS_INLINE uint64_t
+reboot_timer_ticks_ordered(void)
+{
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)                \
+ && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86)
+   _mm_lfence();
+
+   return (uint64_t) __rdtsc();
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_MSVC)              \
+   && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM64)
+   __isb(_ARM64_BARRIER_SY);
+
+   return (uint64_t) _ReadStatusReg(ARM64_CNTVCT);
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)              \
+   && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_X86)
+   uint32_t low;
+   uint32_t high;
+
+   __asm__ __volatile__ (
+      "lfence\n\trdtsc" : "=a" (low), "=d" (high) : : "memory"
+   );
+
+   return (uint64_t) high << 32 | low;
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_COMPILER_HAS_GNUC)              \
+   && defined(REBOOT_PREPROCESSOR_ENVIRONMENT_ARCHITECTURE_HAS_ARM64)
+   uint64_t ticks;
+
+   __asm__ __volatile__ (
+      "isb\n\tmrs %0, cntvct_el0" : "=r" (ticks) : : "memory"
+   );
+
+   return ticks;
+#else
+   return reboot_timer_clock();
+#endif
+}
+
+/*!
+ * @brief Tick to nanosecond conversion.
+ *
+ * The  conversion is split around whole seconds so  as
+ * not to overflow for tick counts spanning years.
+ */
+static REBOOT_INLINE uint64_t
+reboot_timer_nanoseconds(uint64_t ticks)
+{
+   uint64_t frequency = reboot_timer_frequency();
+
+   return ticks / frequency * 1000000000u
+        + ticks % frequency * 1000000000u / frequency;
+}
+
+#define REBOOT_RDTSC()  reboot_timer_ticks()
+#define REBOOT_RDTSCP() reboot_timer_ticks_ordered()
+
+/*! @} <!-- }}} Counter --> */
+
+/*! <!-- Probes {{{ -->
+ * @addtogroup  timer_probes Probes
+ * @brief Per-thread latency histograms
+ *
+ * A  probe is identified by its name, and every thread
+ * records  into  a  histogram  of  its  own,  so  that
+ * recording  takes  no lock and shares no cache  line.
+ * Recording  costs  a  hash  table lookup  on  top  of
+ * reading  the  counter  twice, in the  order  of  ten
+ * nanoseconds.
+ *
+ * Histograms  are  log-linear : every power of two  is
+ * split  into  `4` buckets, which bounds the  relative
+ * error of a percentile to `25%` over the whole 64-bit
+ * range.  Histograms of exited threads are kept  until
+ * the process exits, so that short lived workers still
+ * get reported.
+ *
+ * `reboot_probe_collect`   and   `reboot_probe_report`
+ * read  the  histograms  of  running  threads  without
+ * synchronization,  and should thus be called once the
+ * probed code is quiescent for exact figures.
+ * @{
+ */
+
+#define REBOOT_PROBE_BUCKETS 252
+
+/*!
+ * @brief Latency histogram.
+ *
+ * Every  field  is in ticks. `buckets[i]`  counts  the
+ * samples   falling   into  bucket  `i`,  bounded   by
+ * `reboot_probe_percentile`.
+ */
+typedef struct reboot_probe_histogram {
+   uint64_t count;
+   uint64_t sum;
+   uint64_t min;
+   uint64_t max;
+   uint64_t buckets[REBOOT_PROBE_BUCKETS];
+} reboot_probe_histogram_t;
+
+/*!
+ * @brief Sample recording.
+ *
+ * This  function adds `ticks` to the histogram of  the
+ * calling  thread  for  the  probe  `name`,  which  is
+ * compared  by address and must therefore be a  string
+ * literal or otherwise outlive the process.
+ */
+REBOOT_HOT void reboot_probe_record(const char *name, uint64_t ticks);
+
+/*!
+ * @brief Histogram collection.
+ *
+ * This  function merges the histograms of every thread
+ * for  probes  called  `name`  into  `histogram`,  and
+ * returns  `0`,  or  `-1`  when  no  sample  was  ever
+ * recorded under that name.
+ */
+int reboot_probe_collect(
+   const char *name, reboot_probe_histogram_t *histogram
+);
+
+/*!
+ * @brief Histogram percentile.
+ *
+ * This  function returns the upper bound, in ticks, of
+ * the  bucket  holding the sample of rank  `fraction`,
+ * between `0` and `1`.
+ */
+uint64_t reboot_probe_percentile(
+   const reboot_probe_histogram_t *histogram, double fraction
+);
+
+/*!
+ * @brief Probe report.
+ *
+ * This  function  writes  one line per probe  name  to
+ * `stream`,  with  its sample count and  its  minimum,
+ * median,  99th  percentile and maximum  latencies  in
+ * nanoseconds.
+ */
+void reboot_probe_report(FILE *stream);
+
+/*!
+ * @brief Probe reset.
+ *
+ * This function clears the histograms of every thread,
+ * e.g. after a warmup run.
+ */
+void reboot_probe_reset(void);
+
+/*!
+ * @def   REBOOT_PROBE_BEGIN(name)
+ * @brief Probed scope opening.
+ *
+ * This  macro opens a block whose latency is  recorded
+ * under   `name`,  an  identifier,  by  the   matching
+ * `REBOOT_PROBE_END`.  Leaving  the  block  otherwise,
+ * e.g. through `return`, discards the sample.
+ *
+ * @def   REBOOT_PROBE_END(name)
+ * @brief Probed scope closing.
+ */
+#if defined(REBOOT_PROBE_ENABLE)
+#  define REBOOT_PROBE_BEGIN(name)                                            \
+      { const uint64_t reboot_probe_##name##_ = REBOOT_RDTSC();
+#  define REBOOT_PROBE_END(name)                                              \
+      reboot_probe_record(#name, REBOOT_RDTSCP() - reboot_probe_##name##_); }
+#else
+#  define REBOOT_PROBE_BEGIN(name) {
+#  define REBOOT_PROBE_END(name)   }
+#endif
+
+/*! @} <!-- }}} Probes --> */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __REBOOT_TIMER_H__ */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
@@ -0,0 +1,1041 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+/*!
+ * @file  topology.c
+ * @brief Processor topology discovery and placement.
+ *
+ * Each  operating  system family fills  the  processor
+ * list  in  with  raw identifiers, e.g.  `sysfs`  core
+ * numbers,  which are then renumbered densely once and
+ * for all by `reboot_topology_dense_`.
+ */
+
+/* `sched_getaffinity` and the `CPU_*` macros. */
+#ifndef _GNU_SOURCE
+#  define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "topology.h"
+#include "preprocessor/environment/os.h"
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_LINUX)
+#  include <dirent.h>
+#  include <sched.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+#  ifndef WIN32_LEAN_AND_MEAN
+#     define WIN32_LEAN_AND_MEAN
+#  endif
+#  include <limits.h>
+#  include <windows.h>
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_DARWIN)
+#  include <stdint.h>
+#  include <sys/types.h>
+#  include <sys/sysctl.h>
+#  include <unistd.h>
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_FREEBSD)
+#  include <sys/param.h>
+#  include <sys/cpuset.h>
+#  include <sys/sysctl.h>
+#  include <unistd.h>
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_UNIX)
+#  include <unistd.h>
+#endif
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MMAP)
+#  include <sys/mman.h>
+#  if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#     define MAP_ANONYMOUS MAP_ANON
+#  endif
+#endif
+
+/* <!-- Helpers {{{ --> */
+
+/*!
+ * Renumbers  the  field  found at  `offset`  in  every
+ * processor densely, in order of first appearance, and
+ * stores   the   number   of  distinct   values   into
+ * `*distinct`. It returns `0` on success and `-1` when
+ * out  of  memory,  the field  being  left  untouched.
+ * Processor  counts  are low enough for the  quadratic
+ * search not to matter.
+ */
+static int
+reboot_topology_dense_(
+   reboot_topology_t *topology, size_t offset, unsigned *distinct
+) {
+   unsigned *seen = (unsigned *) malloc(topology->cpu_count * sizeof *seen);
+   unsigned  count = 0;
+   unsigned  i;
+
+   if (seen == NULL && topology->cpu_count != 0) {
+      return -1;
+   }
+
+   for (i = 0; i < topology->cpu_count; ++i) {
+      unsigned *field = (unsigned *) ((char *) &topology->cpus[i] + offset);
+      unsigned  j;
+
+      for (j = 0; j < count && seen[j] != *field; ++j) {
+         /* Linear search. */
+      }
+
+      if (j == count) {
+         seen[count++] = *field;
+      }
+
+      *field = j;
+   }
+
+   free(seen);
+
+   *distinct = count;
+
+   return 0;
+}
+
+static unsigned
+reboot_topology_distinct_nodes_(const reboot_topology_t *topology)
+{
+   unsigned count = 0;
+   unsigned i;
+
+   for (i = 0; i < topology->cpu_count; ++i) {
+      unsigned j;
+
+      for (j = 0; j < i && topology->cpus[j].node != topology->cpus[i].node;) {
+         ++j;
+      }
+
+      count += j == i;
+   }
+
+   return count;
+}
+
+static int
+reboot_topology_allocate_(reboot_topology_t *topology, unsigned count)
+{
+   topology->cpus = (reboot_topology_cpu_t *) calloc(
+      count != 0 ? count : 1u, sizeof *topology->cpus
+   );
+
+   if (topology->cpus == NULL) {
+      return -1;
+   }
+
+   topology->cpu_count = count;
+
+   return 0;
+}
+
+#if !defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_LINUX)                    \
+ && !defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+
+/*!
+ * Lays  processors  out as consecutive  SMT  siblings,
+ * cores  and  packages, the layout macOS  and  FreeBSD
+ * number  them  with,  for systems  not  exposing  the
+ * actual relations.
+ */
+static void
+reboot_topology_uniform_(
+   reboot_topology_t *topology, unsigned threads_per_core,
+   unsigned cores_per_package, unsigned cpus_per_cache
+) {
+   unsigned i;
+
+   threads_per_core  = threads_per_core  != 0 ? threads_per_core  : 1u;
+   cores_per_package = cores_per_package != 0 ? cores_per_package : ~0u;
+   cpus_per_cache    = cpus_per_cache    != 0 ? cpus_per_cache    : ~0u;
+
+   for (i = 0; i < topology->cpu_count; ++i) {
+      unsigned id = topology->cpus[i].id;
+
+      topology->cpus[i].core    = id / threads_per_core;
+      topology->cpus[i].package = id / threads_per_core / cores_per_package;
+      topology->cpus[i].node    = 0;
+      topology->cpus[i].cache   = id / cpus_per_cache;
+   }
+}
+
+#endif
+
+/* <!-- }}} Helpers --> */
+
+/* <!-- Linux {{{ --> */
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_LINUX)
+
+#  define REBOOT_TOPOLOGY_SYSFS_ "/sys/devices/system/cpu/cpu"
+
+static int
+reboot_topology_read_(const char *path, char *buffer, size_t size)
+{
+   FILE  *file = fopen(path, "r");
+   size_t length;
+
+   if (file == NULL) {
+      return -1;
+   }
+
+   length = fread(buffer, 1, size - 1u, file);
+   fclose(file);
+
+   buffer[length] = '\0';
+
+   return 0;
+}
+
+static unsigned
+reboot_topology_read_unsigned_(const char *path, unsigned fallback)
+{
+   char buffer[32];
+
+   if (reboot_topology_read_(path, buffer, sizeof buffer) != 0) {
+      return fallback;
+   }
+
+   return (unsigned) strtol(buffer, NULL, 10);
+}
+
+static unsigned
+reboot_topology_linux_node_(unsigned cpu)
+{
+   char           path[64];
+   DIR           *directory;
+   struct dirent *entry;
+   unsigned       node = 0;
+
+   snprintf(path, sizeof path, REBOOT_TOPOLOGY_SYSFS_ "%u", cpu);
+
+   directory = opendir(path);
+
+   if (directory == NULL) {
+      return node;
+   }
+
+   while ((entry = readdir(directory)) != NULL) {
+      if (strncmp(entry->d_name, "node", 4) == 0
+       && entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+         node = (unsigned) strtoul(entry->d_name + 4, NULL, 10);
+         break;
+      }
+   }
+
+   closedir(directory);
+
+   return node;
+}
+
+/*!
+ * The  last  level cache is the highest level data  or
+ * unified  cache,  identified by the  first  processor
+ * sharing it.
+ */
+static unsigned
+reboot_topology_linux_cache_(unsigned cpu, size_t *size)
+{
+   char     path[96];
+   char     buffer[64];
+   unsigned index;
+   unsigned best  = 0;
+   unsigned cache = cpu;
+
+   for (index = 0;; ++index) {
+      unsigned level;
+
+      snprintf(
+         path, sizeof path, REBOOT_TOPOLOGY_SYSFS_ "%u/cache/index%u/type",
+         cpu, index
+      );
+
+      if (reboot_topology_read_(path, buffer, sizeof buffer) != 0) {
+         break;
+      }
+
+      if (strncmp(buffer, "Instruction", 11) == 0) {
+         continue;
+      }
+
+      snprintf(
+         path, sizeof path, REBOOT_TOPOLOGY_SYSFS_ "%u/cache/index%u/level",
+         cpu, index
+      );
+
+      level = reboot_topology_read_unsigned_(path, 0);
+
+      if (level <= best) {
+         continue;
+      }
+
+      best = level;
+
+      snprintf(
+         path, sizeof path,
+         REBOOT_TOPOLOGY_SYSFS_ "%u/cache/index%u/shared_cpu_list", cpu, index
+      );
+
+      cache = reboot_topology_read_unsigned_(path, cpu);
+
+      snprintf(
+         path, sizeof path, REBOOT_TOPOLOGY_SYSFS_ "%u/cache/index%u/size",
+         cpu, index
+      );
+
+      if (reboot_topology_read_(path, buffer, sizeof buffer) == 0) {
+         char  *unit;
+         size_t bytes = (size_t) strtoul(buffer, &unit, 10);
+
+         if (*unit == 'K') bytes <<= 10;
+         if (*unit == 'M') bytes <<= 20;
+
+         *size = bytes;
+      }
+   }
+
+   return cache;
+}
+
+static int
+reboot_topology_discover_(reboot_topology_t *topology)
+{
+   long       configured = sysconf(_SC_NPROCESSORS_CONF);
+   size_t     capacity   = configured > 0 ? (size_t) configured : 1u;
+   cpu_set_t *set;
+   size_t     size;
+   unsigned   cpu;
+   unsigned   i;
+
+   /* The kernel may be configured for more processors than are present. */
+   for (;;) {
+      set  = CPU_ALLOC(capacity);
+      size = CPU_ALLOC_SIZE(capacity);
+
+      if (set == NULL) {
+         return -1;
+      }
+
+      if (sched_getaffinity(0, size, set) == 0) {
+         break;
+      }
+
+      CPU_FREE(set);
+
+      if (capacity >= 65536u) {
+         return reboot_topology_allocate_(topology, 0);
+      }
+
+      capacity *= 2u;
+   }
+
+   if (reboot_topology_allocate_(
+      topology, (unsigned) CPU_COUNT_S(size, set)
+   ) != 0) {
+      CPU_FREE(set);
+      return -1;
+   }
+
+   for (cpu = 0, i = 0; cpu < capacity && i < topology->cpu_count; ++cpu) {
+      char     path[96];
+      unsigned package;
+      unsigned core;
+
+      if (!CPU_ISSET_S(cpu, size, set)) {
+         continue;
+      }
+
+      snprintf(
+         path, sizeof path,
+         REBOOT_TOPOLOGY_SYSFS_ "%u/topology/physical_package_id", cpu
+      );
+      package = reboot_topology_read_unsigned_(path, 0);
+
+      snprintf(
+         path, sizeof path, REBOOT_TOPOLOGY_SYSFS_ "%u/topology/core_id", cpu
+      );
+      core = reboot_topology_read_unsigned_(path, cpu);
+
+      topology->cpus[i].id      = cpu;
+      topology->cpus[i].package = package;
+      topology->cpus[i].core    = package << 16 ^ core;
+      topology->cpus[i].node    = reboot_topology_linux_node_(cpu);
+      topology->cpus[i].cache   = reboot_topology_linux_cache_(
+         cpu, &topology->cache_size
+      );
+
+      ++i;
+   }
+
+   CPU_FREE(set);
+
+   return 0;
+}
+
+static int
+reboot_topology_affinity_(const unsigned *cpus, unsigned count)
+{
+   unsigned   highest = 0;
+   cpu_set_t *set;
+   size_t     size;
+   unsigned   i;
+   int        status;
+
+   for (i = 0; i < count; ++i) {
+      highest = cpus[i] > highest ? cpus[i] : highest;
+   }
+
+   set  = CPU_ALLOC(highest + 1u);
+   size = CPU_ALLOC_SIZE(highest + 1u);
+
+   if (set == NULL) {
+      return -1;
+   }
+
+   CPU_ZERO_S(size, set);
+
+   for (i = 0; i < count; ++i) {
+      CPU_SET_S(cpus[i], size, set);
+   }
+
+   /* A zero identifier designates the calling thread. */
+   status = sched_setaffinity(0, size, set) == 0 ? 0 : -1;
+
+   CPU_FREE(set);
+
+   return status;
+}
+
+/*!
+ * `mbind`  is  called  directly  rather  than  through
+ * libnuma,   whose  header  and  library  are   seldom
+ * installed.  The preferred policy lets the allocation
+ * spill  over  to other nodes instead of failing.  The
+ * kernel reads one bit less than `maxnode` says.
+ */
+#  define REBOOT_TOPOLOGY_MPOL_PREFERRED_ 1
+#  define REBOOT_TOPOLOGY_MAX_NODES_      1024u
+#  define REBOOT_TOPOLOGY_BITS_           (8u * sizeof(unsigned long))
+
+static void
+reboot_topology_bind_(void *memory, size_t size, unsigned node)
+{
+#  if defined(SYS_mbind)
+   unsigned long mask[REBOOT_TOPOLOGY_MAX_NODES_ / REBOOT_TOPOLOGY_BITS_];
+   unsigned      bits = REBOOT_TOPOLOGY_BITS_;
+
+   if (node >= REBOOT_TOPOLOGY_MAX_NODES_) {
+      return;
+   }
+
+   memset(mask, 0, sizeof mask);
+   mask[node / bits] = 1ul << (node % bits);
+
+   syscall(
+      SYS_mbind, memory, (unsigned long) size, REBOOT_TOPOLOGY_MPOL_PREFERRED_,
+      mask, (unsigned long) node + 2u, 0u
+   );
+#  else
+   (void) memory;
+   (void) size;
+   (void) node;
+#  endif
+}
+
+#endif
+/* <!-- }}} Linux --> */
+
+/* <!-- Windows {{{ --> */
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+
+/*!
+ * Processor  groups  hold as many processors  as  their
+ * affinity  mask has bits, that is 32 on 32-bit Windows
+ * and 64 elsewhere.
+ */
+#  define REBOOT_TOPOLOGY_GROUP_BITS_                                         \
+   ((unsigned) (sizeof(KAFFINITY) * CHAR_BIT))
+
+#  define REBOOT_TOPOLOGY_NEXT_(entry)                                        \
+   ((SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *)                               \
+      ((char *) (entry) + (entry)->Size))
+
+static int
+reboot_topology_compare_(const void *left, const void *right)
+{
+   unsigned a = ((const reboot_topology_cpu_t *) left)->id;
+   unsigned b = ((const reboot_topology_cpu_t *) right)->id;
+
+   return (a > b) - (a < b);
+}
+
+static reboot_topology_cpu_t *
+reboot_topology_find_(reboot_topology_t *topology, unsigned id)
+{
+   unsigned i;
+
+   for (i = 0; i < topology->cpu_count; ++i) {
+      if (topology->cpus[i].id == id) {
+         return &topology->cpus[i];
+      }
+   }
+
+   return NULL;
+}
+
+/*!
+ * Applies  `field`  to  every processor of  the  given
+ * group   affinities,  processor  identifiers  counting
+ * `REBOOT_TOPOLOGY_GROUP_BITS_` per group.
+ */
+static void
+reboot_topology_mark_(
+   reboot_topology_t *topology, const GROUP_AFFINITY *groups, WORD count,
+   size_t offset, unsigned value
+) {
+   WORD g;
+
+   for (g = 0; g < count; ++g) {
+      unsigned bit;
+
+      for (bit = 0; bit < REBOOT_TOPOLOGY_GROUP_BITS_; ++bit) {
+         reboot_topology_cpu_t *cpu;
+
+         if (!((groups[g].Mask >> bit) & 1u)) {
+            continue;
+         }
+
+         cpu = reboot_topology_find_(
+            topology, groups[g].Group * REBOOT_TOPOLOGY_GROUP_BITS_ + bit
+         );
+
+         if (cpu != NULL) {
+            *(unsigned *) ((char *) cpu + offset) = value;
+         }
+      }
+   }
+}
+
+static int
+reboot_topology_discover_(reboot_topology_t *topology)
+{
+   SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *buffer;
+   SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *entry;
+   char                                    *end;
+   DWORD                                    length = 0;
+   unsigned                                 count  = 0;
+   unsigned                                 marked = 0;
+   unsigned                                 domain = 0;
+   BYTE                                     level  = 0;
+
+   GetLogicalProcessorInformationEx(RelationAll, NULL, &length);
+
+   buffer = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *) malloc(length);
+
+   if (buffer == NULL) {
+      return -1;
+   }
+
+   if (!GetLogicalProcessorInformationEx(RelationAll, buffer, &length)) {
+      free(buffer);
+      return reboot_topology_allocate_(topology, 0);
+   }
+
+   end = (char *) buffer + length;
+
+   for (entry = buffer; (char *) entry < end;) {
+      if (entry->Relationship == RelationProcessorCore) {
+         WORD g;
+
+         for (g = 0; g < entry->Processor.GroupCount; ++g) {
+            KAFFINITY mask = entry->Processor.GroupMask[g].Mask;
+
+            for (; mask != 0; mask &= mask - 1u) {
+               ++count;
+            }
+         }
+      } else if (entry->Relationship == RelationCache
+              && entry->Cache.Type != CacheInstruction
+              && entry->Cache.Level > level) {
+         level = entry->Cache.Level;
+      }
+
+      entry = REBOOT_TOPOLOGY_NEXT_(entry);
+   }
+
+   if (reboot_topology_allocate_(topology, count) != 0) {
+      free(buffer);
+      return -1;
+   }
+
+   /* Processor identifiers first, every other relation refers to them. */
+   for (entry = buffer; (char *) entry < end;) {
+      if (entry->Relationship == RelationProcessorCore) {
+         WORD g;
+
+         for (g = 0; g < entry->Processor.GroupCount; ++g) {
+            GROUP_AFFINITY *group = &entry->Processor.GroupMask[g];
+            unsigned        bit;
+
+            for (bit = 0; bit < REBOOT_TOPOLOGY_GROUP_BITS_; ++bit) {
+               if ((group->Mask >> bit) & 1u) {
+                  topology->cpus[marked++].id =
+                     group->Group * REBOOT_TOPOLOGY_GROUP_BITS_ + bit;
+               }
+            }
+         }
+      }
+
+      entry = REBOOT_TOPOLOGY_NEXT_(entry);
+   }
+
+   qsort(
+      topology->cpus, topology->cpu_count, sizeof *topology->cpus,
+      reboot_topology_compare_
+   );
+
+   for (entry = buffer; (char *) entry < end;) {
+      switch (entry->Relationship) {
+         case RelationProcessorCore:
+            reboot_topology_mark_(
+               topology, entry->Processor.GroupMask,
+               entry->Processor.GroupCount,
+               offsetof(reboot_topology_cpu_t, core), domain++
+            );
+            break;
+
+         case RelationProcessorPackage:
+            reboot_topology_mark_(
+               topology, entry->Processor.GroupMask,
+               entry->Processor.GroupCount,
+               offsetof(reboot_topology_cpu_t, package), domain++
+            );
+            break;
+
+         case RelationNumaNode:
+            reboot_topology_mark_(
+               topology, &entry->NumaNode.GroupMask, 1,
+               offsetof(reboot_topology_cpu_t, node),
+               (unsigned) entry->NumaNode.NodeNumber
+            );
+            break;
+
+         case RelationCache:
+            if (entry->Cache.Type != CacheInstruction
+             && entry->Cache.Level == level) {
+               reboot_topology_mark_(
+                  topology, &entry->Cache.GroupMask, 1,
+                  offsetof(reboot_topology_cpu_t, cache), domain++
+               );
+               topology->cache_size = (size_t) entry->Cache.CacheSize;
+            }
+            break;
+
+         default:
+            break;
+      }
+
+      entry = REBOOT_TOPOLOGY_NEXT_(entry);
+   }
+
+   free(buffer);
+
+   return 0;
+}
+
+/*!
+ * Threads  run  within a single processor  group,  the
+ * affinity is therefore restricted to the group of the
+ * first processor.
+ */
+static int
+reboot_topology_affinity_(const unsigned *cpus, unsigned count)
+{
+   GROUP_AFFINITY affinity;
+   unsigned       i;
+
+   if (count == 0) {
+      return -1;
+   }
+
+   memset(&affinity, 0, sizeof affinity);
+   affinity.Group = (WORD) (cpus[0] / REBOOT_TOPOLOGY_GROUP_BITS_);
+
+   for (i = 0; i < count; ++i) {
+      if (cpus[i] / REBOOT_TOPOLOGY_GROUP_BITS_ == affinity.Group) {
+         affinity.Mask |=
+            (KAFFINITY) 1u << (cpus[i] % REBOOT_TOPOLOGY_GROUP_BITS_);
+      }
+   }
+
+   return SetThreadGroupAffinity(GetCurrentThread(), &affinity, NULL) ? 0 : -1;
+}
+
+#endif
+/* <!-- }}} Windows --> */
+
+/* <!-- macOS {{{ --> */
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_DARWIN)
+
+static unsigned
+reboot_topology_sysctl_(const char *name)
+{
+   int    value  = 0;
+   size_t length = sizeof value;
+
+   if (sysctlbyname(name, &value, &length, NULL, 0) != 0 || value < 0) {
+      return 0;
+   }
+
+   return (unsigned) value;
+}
+
+/*!
+ * `hw.cacheconfig`  holds, for every level, the number
+ * of  processors sharing a cache of that level, memory
+ * being level `0`.
+ */
+static int
+reboot_topology_discover_(reboot_topology_t *topology)
+{
+   unsigned logical  = reboot_topology_sysctl_("hw.logicalcpu");
+   unsigned physical = reboot_topology_sysctl_("hw.physicalcpu");
+   unsigned packages = reboot_topology_sysctl_("hw.packages");
+   uint64_t levels[8];
+   size_t   length   = sizeof levels;
+   unsigned sharing  = 0;
+   unsigned level    = 0;
+   unsigned i;
+
+   if (reboot_topology_allocate_(topology, logical != 0 ? logical : 1u)) {
+      return -1;
+   }
+
+   for (i = 0; i < topology->cpu_count; ++i) {
+      topology->cpus[i].id = i;
+   }
+
+   memset(levels, 0, sizeof levels);
+
+   if (sysctlbyname("hw.cacheconfig", levels, &length, NULL, 0) == 0) {
+      for (i = 1; i < length / sizeof *levels; ++i) {
+         if (levels[i] != 0) {
+            sharing = (unsigned) levels[i];
+            level   = i;
+         }
+      }
+   }
+
+   if (level >= 2u) {
+      uint64_t size = 0;
+
+      length = sizeof size;
+
+      if (sysctlbyname(
+         level == 2u ? "hw.l2cachesize" : "hw.l3cachesize",
+         &size, &length, NULL, 0
+      ) == 0) {
+         topology->cache_size = (size_t) size;
+      }
+   }
+
+   reboot_topology_uniform_(
+      topology,
+      physical != 0 ? logical / physical : 1u,
+      packages != 0 ? physical / packages : 0u,
+      sharing
+   );
+
+   return 0;
+}
+
+static int
+reboot_topology_affinity_(const unsigned *cpus, unsigned count)
+{
+   (void) cpus;
+   (void) count;
+
+   return -1;
+}
+
+#endif
+/* <!-- }}} macOS --> */
+
+/* <!-- FreeBSD {{{ --> */
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_FREEBSD)
+
+static unsigned
+reboot_topology_sysctl_(const char *name)
+{
+   int    value  = 0;
+   size_t length = sizeof value;
+
+   if (sysctlbyname(name, &value, &length, NULL, 0) != 0 || value < 0) {
+      return 0;
+   }
+
+   return (unsigned) value;
+}
+
+/*!
+ * FreeBSD  only  describes  its topology  as  a  whole
+ * through `kern.sched.topology_spec`, every package is
+ * therefore assumed to hold a single last level cache.
+ */
+static int
+reboot_topology_discover_(reboot_topology_t *topology)
+{
+   unsigned cores   = reboot_topology_sysctl_("kern.smp.cores");
+   unsigned threads = reboot_topology_sysctl_("kern.smp.threads_per_core");
+   cpuset_t set;
+   unsigned cpu;
+   unsigned i;
+
+   if (cpuset_getaffinity(
+      CPU_LEVEL_WHICH, CPU_WHICH_PID, -1, sizeof set, &set
+   ) != 0) {
+      return reboot_topology_allocate_(topology, 0);
+   }
+
+   if (reboot_topology_allocate_(topology, (unsigned) CPU_COUNT(&set)) != 0) {
+      return -1;
+   }
+
+   for (cpu = 0, i = 0; cpu < CPU_SETSIZE && i < topology->cpu_count; ++cpu) {
+      if (CPU_ISSET(cpu, &set)) {
+         topology->cpus[i++].id = cpu;
+      }
+   }
+
+   reboot_topology_uniform_(topology, threads, cores, 0);
+
+   for (i = 0; i < topology->cpu_count; ++i) {
+      topology->cpus[i].cache = topology->cpus[i].package;
+   }
+
+   return 0;
+}
+
+static int
+reboot_topology_affinity_(const unsigned *cpus, unsigned count)
+{
+   cpuset_t set;
+   unsigned i;
+
+   CPU_ZERO(&set);
+
+   for (i = 0; i < count; ++i) {
+      if (cpus[i] < CPU_SETSIZE) {
+         CPU_SET(cpus[i], &set);
+      }
+   }
+
+   return cpuset_setaffinity(
+      CPU_LEVEL_WHICH, CPU_WHICH_TID, -1, sizeof set, &set
+   ) == 0 ? 0 : -1;
+}
+
+#endif
+/* <!-- }}} FreeBSD --> */
+
+/* <!-- Generic {{{ --> */
+#if !defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_LINUX)                    \
+ && !defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)                  \
+ && !defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_DARWIN)                   \
+ && !defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_FREEBSD)
+
+static int
+reboot_topology_discover_(reboot_topology_t *topology)
+{
+   unsigned count = 1;
+   unsigned i;
+
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_UNIX)                    \
+   && defined(_SC_NPROCESSORS_ONLN)
+   long online = sysconf(_SC_NPROCESSORS_ONLN);
+
+   count = online > 0 ? (unsigned) online : 1u;
+#  endif
+
+   if (reboot_topology_allocate_(topology, count) != 0) {
+      return -1;
+   }
+
+   for (i = 0; i < count; ++i) {
+      topology->cpus[i].id = i;
+   }
+
+   reboot_topology_uniform_(topology, 1, 0, 0);
+
+   return 0;
+}
+
+static int
+reboot_topology_affinity_(const unsigned *cpus, unsigned count)
+{
+   (void) cpus;
+   (void) count;
+
+   return -1;
+}
+
+#endif
+/* <!-- }}} Generic --> */
+
+/* <!-- Discovery {{{ --> */
+
+int
+reboot_topology_init(reboot_topology_t *topology)
+{
+   memset(topology, 0, sizeof *topology);
+
+   if (reboot_topology_discover_(topology) != 0) {
+      return -1;
+   }
+
+   if (reboot_topology_dense_(
+          topology, offsetof(reboot_topology_cpu_t, core),
+          &topology->core_count
+       ) != 0
+    || reboot_topology_dense_(
+          topology, offsetof(reboot_topology_cpu_t, package),
+          &topology->package_count
+       ) != 0
+    || reboot_topology_dense_(
+          topology, offsetof(reboot_topology_cpu_t, cache),
+          &topology->cache_count
+       ) != 0) {
+      reboot_topology_destroy(topology);
+      return -1;
+   }
+
+   topology->node_count = reboot_topology_distinct_nodes_(topology);
+
+   return 0;
+}
+
+void
+reboot_topology_destroy(reboot_topology_t *topology)
+{
+   free(topology->cpus);
+
+   memset(topology, 0, sizeof *topology);
+}
+
+/* <!-- }}} Discovery --> */
+
+/* <!-- Placement {{{ --> */
+
+int
+reboot_topology_pin(unsigned cpu)
+{
+   return reboot_topology_affinity_(&cpu, 1);
+}
+
+int
+reboot_topology_pin_node(const reboot_topology_t *topology, unsigned node)
+{
+   unsigned *cpus = (unsigned *) malloc(
+      (topology->cpu_count != 0 ? topology->cpu_count : 1u) * sizeof *cpus
+   );
+   unsigned  count = 0;
+   unsigned  i;
+   int       status;
+
+   if (cpus == NULL) {
+      return -1;
+   }
+
+   for (i = 0; i < topology->cpu_count; ++i) {
+      if (topology->cpus[i].node == node) {
+         cpus[count++] = topology->cpus[i].id;
+      }
+   }
+
+   status = count != 0 ? reboot_topology_affinity_(cpus, count) : -1;
+
+   free(cpus);
+
+   return status;
+}
+
+int
+reboot_topology_current(void)
+{
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_LINUX)
+   return sched_getcpu();
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+   PROCESSOR_NUMBER number;
+
+   GetCurrentProcessorNumberEx(&number);
+
+   return (int) (number.Group * REBOOT_TOPOLOGY_GROUP_BITS_ + number.Number);
+#else
+   return -1;
+#endif
+}
+
+void *
+reboot_topology_alloc(size_t size, unsigned node)
+{
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+   return VirtualAllocExNuma(
+      GetCurrentProcess(), NULL, size, MEM_RESERVE | MEM_COMMIT,
+      PAGE_READWRITE, (DWORD) node
+   );
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MMAP)
+   void *memory = mmap(
+      NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0
+   );
+
+   if (memory == MAP_FAILED) {
+      return NULL;
+   }
+
+#  if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_LINUX)
+   reboot_topology_bind_(memory, size, node);
+#  else
+   (void) node;
+#  endif
+
+   return memory;
+#else
+   (void) node;
+
+   return calloc(1, size);
+#endif
+}
+
+void
+reboot_topology_free(void *memory, size_t size)
+{
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+   (void) size;
+
+   VirtualFree(memory, 0, MEM_RELEASE);
+#elif defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_MMAP)
+   if (memory != NULL) {
+      munmap(memory, size);
+   }
+#else
+   (void) size;
+
+   free(memory);
+#endif
+}
+
+/* <!-- }}} Placement --> */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
@@ -0,0 +1,184 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+#ifndef __REBOOT_TOPOLOGY_H__
+#define __REBOOT_TOPOLOGY_H__
+
+/*!
+ * @file  topology.h
+ * @brief Processor topology discovery and placement.
+ *
+ * This  header  describes the logical  processors  the
+ * calling  process may run on, and how they relate  to
+ * one another :
+ *
+ * - `core`    : Physical core, shared by SMT siblings.
+ * - `package` : Physical package, i.e. socket.
+ * - `node`    : NUMA node.
+ * - `cache`   : Last level cache domain.
+ *
+ * Cores, packages and caches are numbered densely from
+ * `0`,  in order of first appearance, which makes them
+ * suitable  as  indices into per-core arrays.  Logical
+ * processors  and nodes keep the number the  operating
+ * system  gives  them,  counting processor  groups  on
+ * Windows, so that they can be handed back to it.
+ *
+ * It  is  discovered at runtime through the  interface
+ * `preprocessor/environment/os.h` reports :
+ *
+ * - Linux   : `sched_getaffinity` and `sysfs`.
+ * - Windows : `GetLogicalProcessorInformationEx`.
+ * - macOS   : `hw.*` `sysctl` entries.
+ * - FreeBSD : `kern.smp.*` `sysctl` entries.
+ * - Others  : `sysconf`, one core per processor.
+ *
+ * Where  the  operating  system does  not  expose  the
+ * relation  between  processor numbers and cores,  SMT
+ * siblings  are assumed to be numbered  consecutively,
+ * which is what macOS and FreeBSD do.
+ *
+ * On    top    of    it,   `reboot_topology_pin`   and
+ * `reboot_topology_pin_node`  bind  the calling thread
+ * to  a processor or to every processor of a node, and
+ * return  `-1`  where  the  operating system offers no
+ * such   control,   e.g.  macOS  which  only  supports
+ * affinity  hints. `reboot_topology_alloc` maps memory
+ * backed  by  a  given  node,  falling back to unbound
+ * memory on operating systems without NUMA control.
+ */
+
+#include <stddef.h>
+
+#include "preprocessor/environment/compiler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! <!-- Discovery {{{ -->
+ * @addtogroup  topology_discovery Discovery
+ * @brief Topology snapshot
+ * @{
+ */
+
+/*!
+ * @brief Logical processor.
+ */
+typedef struct reboot_topology_cpu {
+   unsigned id;
+   unsigned core;
+   unsigned package;
+   unsigned node;
+   unsigned cache;
+} reboot_topology_cpu_t;
+
+/*!
+ * @brief Processor topology.
+ *
+ * `cpus`  lists the `cpu_count` logical processors  by
+ * increasing `id`. `cache_size` is the size, in bytes,
+ * of a last level cache, `0` when unknown.
+ */
+typedef struct reboot_topology {
+   reboot_topology_cpu_t *cpus;
+   unsigned               cpu_count;
+   unsigned               core_count;
+   unsigned               package_count;
+   unsigned               node_count;
+   unsigned               cache_count;
+   size_t                 cache_size;
+} reboot_topology_t;
+
+/*!
+ * @brief Topology discovery.
+ *
+ * This  function fills `topology` in, returning `0` on
+ * success and `-1` when out of memory. Discovery reads
+ * a  few files per processor on Linux and should  thus
+ * be done once, at startup.
+ */
+int reboot_topology_init(reboot_topology_t *topology);
+
+/*!
+ * @brief Topology finalization.
+ */
+void reboot_topology_destroy(reboot_topology_t *topology);
+
+/*! @} <!-- }}} Discovery --> */
+
+/*! <!-- Placement {{{ -->
+ * @addtogroup  topology_placement Placement
+ * @brief Thread affinity and node-local memory
+ *
+ * Pinned threads stop migrating across nodes, and thus
+ * keep  hitting the caches and the memory they  warmed
+ * up. Memory allocated from a node is only bound to it
+ * once touched, pages being allocated lazily.
+ * @{
+ */
+
+/*!
+ * @brief Processor pinning.
+ *
+ * This  function  binds  the  calling  thread  to  the
+ * logical  processor  `cpu`, returning `0` on  success
+ * and `-1` otherwise.
+ */
+int reboot_topology_pin(unsigned cpu);
+
+/*!
+ * @brief Node pinning.
+ *
+ * This  function  binds  the calling thread  to  every
+ * logical  processor  of `node` found  in  `topology`,
+ * returning `0` on success and `-1` otherwise.
+ */
+int reboot_topology_pin_node(const reboot_topology_t *topology, unsigned node);
+
+/*!
+ * @brief Current processor.
+ *
+ * This  function  returns  the logical  processor  the
+ * calling   thread  is  running  on,  numbered  as  in
+ * `reboot_topology_cpu_t`, or `-1` where the operating
+ * system  does not tell. The thread may have  migrated
+ * by the time it is returned, which only ever makes it
+ * a hint, see `percpu.h` for a faster reading.
+ */
+int reboot_topology_current(void);
+
+/*!
+ * @brief Node-local allocation.
+ *
+ * This  function  maps `size` bytes of zeroed  memory,
+ * page  aligned  and preferably backed by  `node`,  or
+ * returns  `NULL` on failure. The memory falls back to
+ * other  nodes  once `node` is exhausted, and  is  not
+ * bound  at  all  on operating  systems  without  NUMA
+ * control.      It     must     be     released     by
+ * `reboot_topology_free`.
+ */
+void *reboot_topology_alloc(size_t size, unsigned node);
+
+/*!
+ * @brief Node-local deallocation.
+ */
+void reboot_topology_free(void *memory, size_t size);
+
+/*! @} <!-- }}} Placement --> */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __REBOOT_TOPOLOGY_H__ */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
@@ -0,0 +1,275 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+/*!
+ * @file  bytes.c
+ * @brief Byte kernel test.
+ *
+ * Every  implementation compiled for the target, along
+ * with  the  dispatched  and baseline entry points, is
+ * checked  against the scalar one over every length up
+ * to  four  32-byte  vectors, at every offset within a
+ * vector,  with  matches,  mismatches  and  high  bits
+ * placed  at  every  position  in turn. Long runs of a
+ * single  byte  then  cover  the  folding  of the byte
+ * counters.
+ *
+ * AVX2  implementations  are  only  exercised when the
+ * host supports them.
+ */
+
+#include "check.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "preprocessor/environment/cpu.h"
+#include "simd/bytes.h"
+
+#define REBOOT_TEST_VECTOR_ 32u
+#define REBOOT_TEST_LENGTH_ (4u * REBOOT_TEST_VECTOR_)
+#define REBOOT_TEST_LONG_   (2u * 255u * REBOOT_TEST_VECTOR_ + 37u)
+
+/* Bytes outside of the alphabet the buffers are filled with. */
+static const char reboot_test_set_[] = "#,;:!?.-+*/=<>@$%";
+
+static int reboot_test_avx2_;
+
+/* <!-- Variants {{{ --> */
+
+#define REBOOT_TEST_SAME_(value, expected)                                    \
+   REBOOT_CHECK((value) == (expected))
+
+#define REBOOT_TEST_TRUTH_(value, expected)                                   \
+   REBOOT_CHECK(!(value) == !(expected))
+
+#if defined(REBOOT_BYTES_HAS_SSE2)
+#  define REBOOT_TEST_SSE2_(check, primitive, expected, ...)                  \
+      check(reboot_bytes_##primitive##_sse2(__VA_ARGS__), expected)
+#else
+#  define REBOOT_TEST_SSE2_(check, primitive, expected, ...) ((void) 0)
+#endif
+
+#if defined(REBOOT_BYTES_HAS_AVX2)
+#  define REBOOT_TEST_AVX2_(check, primitive, expected, ...)                  \
+      do {                                                                    \
+         if (reboot_test_avx2_) {                                             \
+            check(reboot_bytes_##primitive##_avx2(__VA_ARGS__), expected);    \
+         }                                                                    \
+      } while (0)
+#else
+#  define REBOOT_TEST_AVX2_(check, primitive, expected, ...) ((void) 0)
+#endif
+
+#if defined(REBOOT_BYTES_HAS_NEON)
+#  define REBOOT_TEST_NEON_(check, primitive, expected, ...)                  \
+      check(reboot_bytes_##primitive##_neon(__VA_ARGS__), expected)
+#else
+#  define REBOOT_TEST_NEON_(check, primitive, expected, ...) ((void) 0)
+#endif
+
+/*!
+ * Checks  every  implementation of `primitive` against
+ * `expected` through `check`.
+ */
+#define REBOOT_TEST_VARIANTS_(check, primitive, expected, ...)                \
+   do {                                                                       \
+      check(reboot_bytes_##primitive(__VA_ARGS__), expected);                 \
+      check(reboot_bytes_##primitive##_dispatch(__VA_ARGS__), expected);      \
+      REBOOT_TEST_SSE2_(check, primitive, expected, __VA_ARGS__);             \
+      REBOOT_TEST_AVX2_(check, primitive, expected, __VA_ARGS__);             \
+      REBOOT_TEST_NEON_(check, primitive, expected, __VA_ARGS__);             \
+   } while (0)
+
+/* <!-- }}} Variants --> */
+
+/* <!-- Kernels {{{ --> */
+
+static void
+reboot_test_fill_(unsigned char *data, size_t size, uint64_t *state)
+{
+   size_t i;
+
+   for (i = 0; i < size; ++i) {
+      data[i] = (unsigned char) ('a' + reboot_check_random(state) % 16u);
+   }
+}
+
+static void
+reboot_test_find_(unsigned char *data, size_t length)
+{
+   static const size_t sizes[] = { 1u, 3u, REBOOT_BYTES_SET_MAX,
+                                   REBOOT_BYTES_SET_MAX + 1u };
+
+   size_t position;
+   size_t s;
+
+   for (position = 0; position <= length; ++position) {
+      unsigned char saved[2];
+      size_t        expected;
+
+      /* A second match past the first one must not be reported. */
+      saved[0] = position < length ? data[position] : 0;
+      saved[1] = position + 7u < length ? data[position + 7u] : 0;
+
+      if (position < length) {
+         data[position] = '#';
+      }
+
+      if (position + 7u < length) {
+         data[position + 7u] = '#';
+      }
+
+      expected = reboot_bytes_find_byte_scalar(data, length, '#');
+
+      REBOOT_CHECK(expected == position);
+      REBOOT_TEST_VARIANTS_(
+         REBOOT_TEST_SAME_, find_byte, expected, data, length, '#'
+      );
+
+      for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+         if (position < length) {
+            data[position] = (unsigned char) reboot_test_set_[
+               position % sizes[s]
+            ];
+         }
+
+         expected = reboot_bytes_find_any_of_scalar(
+            data, length, reboot_test_set_, sizes[s]
+         );
+
+         REBOOT_CHECK(expected == position);
+         REBOOT_TEST_VARIANTS_(
+            REBOOT_TEST_SAME_, find_any_of, expected,
+            data, length, reboot_test_set_, sizes[s]
+         );
+      }
+
+      if (position < length) {
+         data[position] = saved[0];
+      }
+
+      if (position + 7u < length) {
+         data[position + 7u] = saved[1];
+      }
+   }
+}
+
+static void
+reboot_test_count_(
+   unsigned char *data, size_t length, uint64_t *state
+) {
+   size_t expected;
+   size_t i;
+
+   for (i = 0; i < length; ++i) {
+      data[i] = (unsigned char) ("#abc"[reboot_check_random(state) % 4u]);
+   }
+
+   expected = reboot_bytes_count_byte_scalar(data, length, '#');
+
+   REBOOT_TEST_VARIANTS_(
+      REBOOT_TEST_SAME_, count_byte, expected, data, length, '#'
+   );
+   REBOOT_TEST_VARIANTS_(REBOOT_TEST_SAME_, count_byte, 0, data, length, 'z');
+}
+
+static void
+reboot_test_compare_(
+   unsigned char *data, unsigned char *copy, size_t length
+) {
+   size_t position;
+
+   memcpy(copy, data, length);
+
+   REBOOT_TEST_VARIANTS_(REBOOT_TEST_TRUTH_, mem_eq, 1, data, copy, length);
+   REBOOT_TEST_VARIANTS_(REBOOT_TEST_TRUTH_, is_ascii, 1, data, length);
+
+   for (position = 0; position < length; ++position) {
+      copy[position] ^= 0x01u;
+      REBOOT_TEST_VARIANTS_(
+         REBOOT_TEST_TRUTH_, mem_eq, 0, data, copy, length
+      );
+      copy[position] ^= 0x01u;
+
+      data[position] |= 0x80u;
+      REBOOT_TEST_VARIANTS_(REBOOT_TEST_TRUTH_, is_ascii, 0, data, length);
+      data[position] &= 0x7Fu;
+   }
+}
+
+static void
+reboot_test_long_(void)
+{
+   static const size_t lengths[] = {
+      255u * 16u, 255u * 16u + 15u, 255u * REBOOT_TEST_VECTOR_,
+      255u * REBOOT_TEST_VECTOR_ + 31u, REBOOT_TEST_LONG_
+   };
+
+   unsigned char *data = (unsigned char *) malloc(REBOOT_TEST_LONG_);
+   size_t         i;
+
+   REBOOT_CHECK(data != NULL);
+   memset(data, 'x', REBOOT_TEST_LONG_);
+
+   for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i) {
+      REBOOT_TEST_VARIANTS_(
+         REBOOT_TEST_SAME_, count_byte, lengths[i], data, lengths[i], 'x'
+      );
+      REBOOT_TEST_VARIANTS_(
+         REBOOT_TEST_SAME_, count_byte, 0, data, lengths[i], 'y'
+      );
+   }
+
+   free(data);
+}
+
+/* <!-- }}} Kernels --> */
+
+int
+main(void)
+{
+   enum { SIZE = REBOOT_TEST_VECTOR_ + REBOOT_TEST_LENGTH_ };
+
+   unsigned char  storage[2][SIZE + REBOOT_TEST_VECTOR_];
+   unsigned char *data;
+   unsigned char *copy;
+   uint64_t       state = 0x9E3779B97F4A7C15u;
+   size_t         offset;
+   size_t         length;
+
+   reboot_test_avx2_ = (reboot_cpu_features() & REBOOT_CPU_AVX2) != 0;
+
+   /* Vector aligned, so that offsets walk through every misalignment. */
+   data = storage[0] + (REBOOT_TEST_VECTOR_
+        - (uintptr_t) storage[0] % REBOOT_TEST_VECTOR_);
+   copy = storage[1] + (REBOOT_TEST_VECTOR_
+        - (uintptr_t) storage[1] % REBOOT_TEST_VECTOR_);
+
+   for (offset = 0; offset < REBOOT_TEST_VECTOR_; ++offset) {
+      for (length = 0; length <= REBOOT_TEST_LENGTH_; ++length) {
+         unsigned char *start = data + offset;
+
+         reboot_test_fill_(start, length, &state);
+         reboot_test_find_(start, length);
+         reboot_test_compare_(
+            start, copy + (offset * 7u + 3u) % REBOOT_TEST_VECTOR_, length
+         );
+         reboot_test_count_(start, length, &state);
+      }
+   }
+
+   reboot_test_long_();
+
+   return EXIT_SUCCESS;
+}
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
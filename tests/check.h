@@ -0,0 +1,186 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+#ifndef __REBOOT_TESTS_CHECK_H__
+#define __REBOOT_TESTS_CHECK_H__
+
+/*!
+ * @file  check.h
+ * @brief Unit test helpers.
+ *
+ * This  header provides the helpers shared by the unit
+ * tests, every one of which is a standalone executable
+ * run  by  `ctest` and failing through a non-zero exit
+ * status :
+ *
+ * - `REBOOT_CHECK`        : Assertion.
+ * - `reboot_check_start`  : Thread creation.
+ * - `reboot_check_join`   : Thread completion.
+ * - `reboot_check_yield`  : Processor yield.
+ * - `reboot_check_random` : Pseudo-random numbers.
+ *
+ * `REBOOT_CHECK`  reports  the  failed condition along
+ * with  its location and exits right away, failures in
+ * worker threads thus ending the test as well. Threads
+ * are  POSIX  or  Windows  ones,  whichever the target
+ * provides.
+ *
+ * The  header  must  be  included  first, ahead of any
+ * system header.
+ */
+
+/* `sched_yield` in strict modes. */
+#ifndef _DEFAULT_SOURCE
+#  define _DEFAULT_SOURCE
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "preprocessor/environment/compiler.h"
+#include "preprocessor/environment/os.h"
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+#  ifndef WIN32_LEAN_AND_MEAN
+#     define WIN32_LEAN_AND_MEAN
+#  endif
+#  include <windows.h>
+#else
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
+/*!
+ * @brief Assertion.
+ *
+ * Exits  with a failure status, naming `condition`, if
+ * it does not hold.
+ */
+#define REBOOT_CHECK(condition)                                               \
+   do {                                                                       \
+      if (!(condition)) {                                                     \
+         fprintf(stderr, "%s:%d: check failed: %s\n",                         \
+            __FILE__, __LINE__, #condition);                                  \
+         exit(EXIT_FAILURE);                                                  \
+      }                                                                       \
+   } while (0)
+
+/*!
+ * @brief Thread entry point.
+ */
+typedef void (*reboot_check_task_t)(void *argument);
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+typedef HANDLE reboot_check_thread_t;
+#else
+typedef pthread_t reboot_check_thread_t;
+#endif
+
+typedef struct reboot_check_start_ {
+   reboot_check_task_t  task;
+   void                *argument;
+} reboot_check_start_;
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+static REBOOT_INLINE DWORD WINAPI
+reboot_check_main_(LPVOID start)
+#else
+static REBOOT_INLINE void *
+reboot_check_main_(void *start)
+#endif
+{
+   reboot_check_start_ copy = *(reboot_check_start_ *) start;
+
+   free(start);
+   copy.task(copy.argument);
+
+   return 0;
+}
+
+/*!
+ * @brief Thread creation.
+ *
+ * This  function  starts  a thread calling `task` with
+ * `argument`, failing the test if it cannot.
+ */
+static REBOOT_INLINE void
+reboot_check_start(
+   reboot_check_thread_t *thread, reboot_check_task_t task, void *argument
+) {
+   reboot_check_start_ *start
+      = (reboot_check_start_ *) malloc(sizeof(*start));
+
+   REBOOT_CHECK(start != NULL);
+
+   start->task     = task;
+   start->argument = argument;
+
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+   *thread = CreateThread(NULL, 0, reboot_check_main_, start, 0, NULL);
+   REBOOT_CHECK(*thread != NULL);
+#else
+   REBOOT_CHECK(pthread_create(thread, NULL, reboot_check_main_, start) == 0);
+#endif
+}
+
+/*!
+ * @brief Thread completion.
+ */
+static REBOOT_INLINE void
+reboot_check_join(reboot_check_thread_t thread)
+{
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+   WaitForSingleObject(thread, INFINITE);
+   CloseHandle(thread);
+#else
+   pthread_join(thread, NULL);
+#endif
+}
+
+/*!
+ * @brief Processor yield.
+ *
+ * Spinning  threads yield in between attempts, so that
+ * the  thread  they  wait  for gets to run on a single
+ * processor.
+ */
+static REBOOT_INLINE void
+reboot_check_yield(void)
+{
+#if defined(REBOOT_PREPROCESSOR_ENVIRONMENT_OS_HAS_WINDOWS)
+   SwitchToThread();
+#else
+   sched_yield();
+#endif
+}
+
+/*!
+ * @brief Pseudo-random numbers.
+ *
+ * This   function  returns  the  next  number  of  the
+ * xorshift sequence seeded by `*state`, which must not
+ * be `0`.
+ */
+static REBOOT_INLINE uint64_t
+reboot_check_random(uint64_t *state)
+{
+   uint64_t x = *state;
+
+   x ^= x << 13;
+   x ^= x >> 7;
+   x ^= x << 17;
+
+   return *state = x;
+}
+
+#endif /* __REBOOT_TESTS_CHECK_H__ */
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
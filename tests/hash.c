@@ -0,0 +1,136 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+/*!
+ * @file  hash.c
+ * @brief CRC-32C known-answer test.
+ *
+ * Both the dispatched and the table-driven CRC-32C are
+ * checked against the check value of the algorithm and
+ * the  iSCSI  vectors  of  RFC 3720, then against each
+ * other  over  every  length up to a kilobyte at every
+ * alignment within a word, in one go and split in two.
+ * Lengths  around  three  4096-byte chunks, past which
+ * `hash.c`  folds three long streams, and around three
+ * such  chunks  followed  by three 128-byte ones and a
+ * tail, are checked the same way.
+ *
+ * Sources :
+ *
+ * - https://www.rfc-editor.org/rfc/rfc3720#appendix-B.4
+ */
+
+#include "check.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash.h"
+
+#define REBOOT_TEST_LENGTH_ 1024u
+
+/* Three streams of `REBOOT_HASH_LONG_` and `REBOOT_HASH_SHORT_` bytes. */
+#define REBOOT_TEST_LONG_   (3u * 4096u)
+#define REBOOT_TEST_SHORT_  (3u * 128u)
+
+typedef uint32_t (*reboot_test_crc_)(uint32_t, const void *, size_t);
+
+static void
+reboot_test_vectors_(reboot_test_crc_ crc)
+{
+   unsigned char buffer[32];
+   size_t        i;
+
+   REBOOT_CHECK(crc(0, "", 0) == 0);
+   REBOOT_CHECK(crc(0, "123456789", 9) == 0xE3069283u);
+   REBOOT_CHECK(crc(crc(0, "1234", 4), "56789", 5) == 0xE3069283u);
+
+   memset(buffer, 0x00, sizeof(buffer));
+   REBOOT_CHECK(crc(0, buffer, sizeof(buffer)) == 0x8A9136AAu);
+
+   memset(buffer, 0xFF, sizeof(buffer));
+   REBOOT_CHECK(crc(0, buffer, sizeof(buffer)) == 0x62A8AB43u);
+
+   for (i = 0; i < sizeof(buffer); ++i) {
+      buffer[i] = (unsigned char) i;
+   }
+
+   REBOOT_CHECK(crc(0, buffer, sizeof(buffer)) == 0x46DD794Eu);
+
+   for (i = 0; i < sizeof(buffer); ++i) {
+      buffer[i] = (unsigned char) (31u - i);
+   }
+
+   REBOOT_CHECK(crc(0, buffer, sizeof(buffer)) == 0x113FDB5Cu);
+}
+
+static void
+reboot_test_agree_(const unsigned char *data, size_t length)
+{
+   uint32_t expected = reboot_hash_crc32c_scalar(0, data, length);
+
+   REBOOT_CHECK(reboot_hash_crc32c(0, data, length) == expected);
+   REBOOT_CHECK(
+      reboot_hash_crc32c(
+         reboot_hash_crc32c(0, data, length / 3u),
+         data + length / 3u, length - length / 3u
+      ) == expected
+   );
+}
+
+int
+main(void)
+{
+   enum { SIZE = 2u * REBOOT_TEST_LONG_ + REBOOT_TEST_SHORT_ + 64u };
+
+   static const size_t lengths[] = {
+      REBOOT_TEST_LONG_ - 1u,
+      REBOOT_TEST_LONG_,
+      REBOOT_TEST_LONG_ + 1u,
+      REBOOT_TEST_LONG_ + REBOOT_TEST_SHORT_ - 1u,
+      REBOOT_TEST_LONG_ + REBOOT_TEST_SHORT_,
+      REBOOT_TEST_LONG_ + REBOOT_TEST_SHORT_ + 7u,
+      REBOOT_TEST_LONG_ + REBOOT_TEST_SHORT_ + 63u,
+      2u * REBOOT_TEST_LONG_ + REBOOT_TEST_SHORT_ + 13u
+   };
+
+   unsigned char *buffer;
+   uint64_t       state = 0x9E3779B97F4A7C15u;
+   size_t         offset;
+   size_t         length;
+   size_t         i;
+
+   reboot_test_vectors_(reboot_hash_crc32c);
+   reboot_test_vectors_(reboot_hash_crc32c_scalar);
+
+   buffer = (unsigned char *) malloc(SIZE + 8u);
+   REBOOT_CHECK(buffer != NULL);
+
+   for (i = 0; i < SIZE + 8u; ++i) {
+      buffer[i] = (unsigned char) reboot_check_random(&state);
+   }
+
+   for (offset = 0; offset < 8u; ++offset) {
+      for (length = 0; length <= REBOOT_TEST_LENGTH_; ++length) {
+         reboot_test_agree_(buffer + offset, length);
+      }
+
+      for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i) {
+         reboot_test_agree_(buffer + offset, lengths[i]);
+      }
+   }
+
+   free(buffer);
+
+   return EXIT_SUCCESS;
+}
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
@@ -0,0 +1,173 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+/*!
+ * @file  hashmap.c
+ * @brief Hash map churn test.
+ *
+ * Random insertions, removals and lookups over a small
+ * key  space are mirrored into plain arrays, every one
+ * of  them being checked against those, along with the
+ * size  and  a  full  iteration  of the map at regular
+ * intervals. The churn runs once with the default hash
+ * and  once with one mapping eight keys to every hash,
+ * which  makes for long probe sequences through groups
+ * littered with tombstones.
+ *
+ * The  test is built twice, with the groups the target
+ * selects and with `REBOOT_HASHMAP_FORCE_SWAR`.
+ */
+
+#include "check.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hashmap.h"
+
+#define REBOOT_TEST_KEYS_       2048u
+#define REBOOT_TEST_OPERATIONS_ 400000u
+#define REBOOT_TEST_INTERVAL_   4096u
+
+typedef struct reboot_test_model_ {
+   unsigned char present[REBOOT_TEST_KEYS_];
+   uint64_t      values[REBOOT_TEST_KEYS_];
+   size_t        size;
+} reboot_test_model_;
+
+static uint64_t
+reboot_test_collide_(const void *key, size_t size)
+{
+   uint32_t value;
+
+   REBOOT_CHECK(size == sizeof(value));
+   memcpy(&value, key, sizeof(value));
+
+   return value >> 3;
+}
+
+static void
+reboot_test_verify_(
+   const reboot_hashmap_t *map, const reboot_test_model_ *model
+) {
+   unsigned char seen[REBOOT_TEST_KEYS_];
+   size_t        cursor = 0;
+   size_t        count  = 0;
+   void         *key;
+   void         *value;
+
+   REBOOT_CHECK(map->size == model->size);
+
+   memset(seen, 0, sizeof(seen));
+
+   while (reboot_hashmap_next(map, &cursor, &key, &value)) {
+      uint32_t k;
+      uint64_t v;
+
+      memcpy(&k, key, sizeof(k));
+      memcpy(&v, value, sizeof(v));
+
+      REBOOT_CHECK(k < REBOOT_TEST_KEYS_);
+      REBOOT_CHECK(model->present[k] && !seen[k]);
+      REBOOT_CHECK(model->values[k] == v);
+
+      seen[k]  = 1;
+      count   += 1u;
+   }
+
+   REBOOT_CHECK(count == model->size);
+}
+
+static void
+reboot_test_churn_(reboot_hashmap_hash_t hash, uint64_t seed)
+{
+   reboot_hashmap_t    map;
+   reboot_test_model_ *model;
+   uint64_t            state = seed;
+   size_t              i;
+
+   model = (reboot_test_model_ *) calloc(1, sizeof(*model));
+   REBOOT_CHECK(model != NULL);
+
+   reboot_hashmap_init(&map, sizeof(uint32_t), sizeof(uint64_t), hash, NULL);
+
+   for (i = 0; i < REBOOT_TEST_OPERATIONS_; ++i) {
+      uint64_t  random = reboot_check_random(&state);
+      uint32_t  key    = (uint32_t) (random % REBOOT_TEST_KEYS_);
+      uint64_t *value;
+      int       inserted;
+
+      switch ((random >> 32) % 4u) {
+      case 0:
+      case 1:
+         value = (uint64_t *) reboot_hashmap_insert(&map, &key, &inserted);
+
+         REBOOT_CHECK(value != NULL);
+         REBOOT_CHECK(inserted != model->present[key]);
+
+         if (!inserted) {
+            REBOOT_CHECK(*value == model->values[key]);
+         }
+
+         *value              = random;
+         model->values[key]  = random;
+         model->size        += (size_t) inserted;
+         model->present[key] = 1;
+         break;
+
+      case 2:
+         REBOOT_CHECK(reboot_hashmap_erase(&map, &key) == model->present[key]);
+
+         model->size        -= model->present[key];
+         model->present[key] = 0;
+         break;
+
+      default:
+         value = (uint64_t *) reboot_hashmap_find(&map, &key);
+
+         if (model->present[key]) {
+            REBOOT_CHECK(value != NULL && *value == model->values[key]);
+         } else {
+            REBOOT_CHECK(value == NULL);
+         }
+         break;
+      }
+
+      if (i % REBOOT_TEST_INTERVAL_ == 0) {
+         reboot_test_verify_(&map, model);
+      }
+   }
+
+   reboot_test_verify_(&map, model);
+
+   for (i = 0; i < REBOOT_TEST_KEYS_; ++i) {
+      uint32_t key = (uint32_t) i;
+
+      REBOOT_CHECK(reboot_hashmap_erase(&map, &key) == model->present[i]);
+      REBOOT_CHECK(reboot_hashmap_find(&map, &key) == NULL);
+   }
+
+   REBOOT_CHECK(map.size == 0);
+
+   reboot_hashmap_destroy(&map);
+   free(model);
+}
+
+int
+main(void)
+{
+   reboot_test_churn_(NULL, 0x9E3779B97F4A7C15u);
+   reboot_test_churn_(reboot_test_collide_, 0xD1B54A32D192ED03u);
+
+   return EXIT_SUCCESS;
+}
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
@@ -0,0 +1,139 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+/*!
+ * @file  pool.c
+ * @brief Object pool stress test.
+ *
+ * Threads  allocate  batches  of  objects, stamp every
+ * word  of  each  with a value of their own, check the
+ * stamps  back and free the objects, so that an object
+ * handed  out  twice  at  once  shows up as a checksum
+ * mismatch.  The objects left in the freelist are then
+ * drained at once and must all be distinct.
+ */
+
+#include "check.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "pool.h"
+
+#define REBOOT_TEST_THREADS_ 8u
+#define REBOOT_TEST_ROUNDS_  20000u
+#define REBOOT_TEST_BATCH_   16u
+#define REBOOT_TEST_WORDS_   8u
+
+typedef struct reboot_test_worker_ {
+   reboot_pool_t *pool;
+   uint64_t       index;
+   uint64_t       written;
+   uint64_t       read;
+   size_t         allocated;
+   size_t         freed;
+} reboot_test_worker_;
+
+static void
+reboot_test_churn_(void *argument)
+{
+   reboot_test_worker_ *worker = (reboot_test_worker_ *) argument;
+   uint64_t            *objects[REBOOT_TEST_BATCH_];
+   uint64_t             round;
+   size_t               i;
+   size_t               j;
+
+   for (round = 0; round < REBOOT_TEST_ROUNDS_; ++round) {
+      for (i = 0; i < REBOOT_TEST_BATCH_; ++i) {
+         uint64_t stamp = worker->index << 48 | round << 8 | i;
+
+         objects[i] = (uint64_t *) reboot_pool_alloc(worker->pool);
+         REBOOT_CHECK(objects[i] != NULL);
+         worker->allocated += 1u;
+
+         for (j = 0; j < REBOOT_TEST_WORDS_; ++j) {
+            objects[i][j]    = stamp;
+            worker->written += stamp;
+         }
+      }
+
+      for (i = REBOOT_TEST_BATCH_; i-- != 0;) {
+         for (j = 0; j < REBOOT_TEST_WORDS_; ++j) {
+            worker->read += objects[i][j];
+         }
+
+         reboot_pool_free(worker->pool, objects[i]);
+         worker->freed += 1u;
+      }
+   }
+}
+
+static int
+reboot_test_compare_(const void *left, const void *right)
+{
+   uintptr_t a = (uintptr_t) *(void *const *) left;
+   uintptr_t b = (uintptr_t) *(void *const *) right;
+
+   return (a > b) - (a < b);
+}
+
+int
+main(void)
+{
+   enum { COUNT = REBOOT_TEST_THREADS_ * REBOOT_TEST_BATCH_ };
+
+   reboot_pool_t         pool;
+   reboot_test_worker_   workers[REBOOT_TEST_THREADS_];
+   reboot_check_thread_t threads[REBOOT_TEST_THREADS_];
+   void                 *objects[COUNT];
+   size_t                i;
+
+   reboot_pool_init(&pool, REBOOT_TEST_WORDS_ * sizeof(uint64_t), 0, 0);
+
+   for (i = 0; i < REBOOT_TEST_THREADS_; ++i) {
+      workers[i].pool      = &pool;
+      workers[i].index     = i;
+      workers[i].written   = 0;
+      workers[i].read      = 0;
+      workers[i].allocated = 0;
+      workers[i].freed     = 0;
+
+      reboot_check_start(&threads[i], reboot_test_churn_, &workers[i]);
+   }
+
+   for (i = 0; i < REBOOT_TEST_THREADS_; ++i) {
+      reboot_check_join(threads[i]);
+
+      REBOOT_CHECK(workers[i].read == workers[i].written);
+      REBOOT_CHECK(workers[i].allocated == workers[i].freed);
+      REBOOT_CHECK(
+         workers[i].allocated
+         == (size_t) REBOOT_TEST_ROUNDS_ * REBOOT_TEST_BATCH_
+      );
+   }
+
+   /* A freelist linked into a cycle hands the same object out twice. */
+   for (i = 0; i < COUNT; ++i) {
+      objects[i] = reboot_pool_alloc(&pool);
+      REBOOT_CHECK(objects[i] != NULL);
+   }
+
+   qsort(objects, COUNT, sizeof(objects[0]), reboot_test_compare_);
+
+   for (i = 1; i < COUNT; ++i) {
+      REBOOT_CHECK(objects[i - 1] != objects[i]);
+   }
+
+   reboot_pool_destroy(&pool);
+
+   return EXIT_SUCCESS;
+}
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
@@ -0,0 +1,282 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+/*!
+ * @file  ring.c
+ * @brief Bounded queue stress test.
+ *
+ * Producers push increasing values of their own into a
+ * small   multiple   producer   and   consumer  queue,
+ * alternating single and batch pushes, while consumers
+ * pop  them until each gets a null sentinel. Consumers
+ * check  that  the values of every producer reach them
+ * in  order,  and  the  counts and sums of every value
+ * popped  must  match  those pushed. A single producer
+ * and  consumer  pair then checks that values come out
+ * in the exact order they went in.
+ */
+
+#include "check.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "ring.h"
+
+#define REBOOT_TEST_PRODUCERS_ 4u
+#define REBOOT_TEST_CONSUMERS_ 4u
+#define REBOOT_TEST_VALUES_    100000u
+#define REBOOT_TEST_BATCH_     7u
+#define REBOOT_TEST_CAPACITY_  64u
+
+#if defined(REBOOT_RING_HAS_ATOMICS)
+
+/* <!-- Multiple producers and consumers {{{ --> */
+
+typedef struct reboot_test_producer_ {
+   reboot_ring_mpmc_t *ring;
+   uintptr_t           index;
+} reboot_test_producer_;
+
+typedef struct reboot_test_consumer_ {
+   reboot_ring_mpmc_t *ring;
+   uintptr_t           last[REBOOT_TEST_PRODUCERS_];
+   uint64_t            sum;
+   size_t              count;
+} reboot_test_consumer_;
+
+static void
+reboot_test_produce_(void *argument)
+{
+   reboot_test_producer_ *producer = (reboot_test_producer_ *) argument;
+   void                  *items[REBOOT_TEST_BATCH_];
+   uintptr_t              base = producer->index * REBOOT_TEST_VALUES_ + 1u;
+   size_t                 round;
+   size_t                 i;
+
+   for (i = 0, round = 0; i < REBOOT_TEST_VALUES_; ++round) {
+      size_t count = REBOOT_TEST_VALUES_ - i;
+      size_t pushed;
+      size_t k;
+
+      if (count > REBOOT_TEST_BATCH_) {
+         count = REBOOT_TEST_BATCH_;
+      }
+
+      for (k = 0; k < count; ++k) {
+         items[k] = (void *) (base + i + k);
+      }
+
+      pushed = round & 1u
+             ? reboot_ring_mpmc_push_batch(producer->ring, items, count)
+             : (size_t) reboot_ring_mpmc_push(producer->ring, items[0]);
+
+      if (pushed == 0) {
+         reboot_check_yield();
+      }
+
+      i += pushed;
+   }
+}
+
+static void
+reboot_test_consume_(void *argument)
+{
+   reboot_test_consumer_ *consumer = (reboot_test_consumer_ *) argument;
+   void                  *items[REBOOT_TEST_BATCH_];
+   size_t                 sentinels = 0;
+   size_t                 round;
+
+   for (round = 0; sentinels == 0; ++round) {
+      size_t popped;
+      size_t k;
+
+      popped = round & 1u
+             ? reboot_ring_mpmc_pop_batch(
+                  consumer->ring, items, REBOOT_TEST_BATCH_
+               )
+             : (size_t) reboot_ring_mpmc_pop(consumer->ring, &items[0]);
+
+      if (popped == 0) {
+         reboot_check_yield();
+         continue;
+      }
+
+      for (k = 0; k < popped; ++k) {
+         uintptr_t value = (uintptr_t) items[k];
+         uintptr_t index;
+         uintptr_t sequence;
+
+         if (value == 0) {
+            sentinels += 1u;
+            continue;
+         }
+
+         index    = (value - 1u) / REBOOT_TEST_VALUES_;
+         sequence = (value - 1u) % REBOOT_TEST_VALUES_ + 1u;
+
+         REBOOT_CHECK(index < REBOOT_TEST_PRODUCERS_);
+         REBOOT_CHECK(sequence > consumer->last[index]);
+
+         consumer->last[index]  = sequence;
+         consumer->sum         += value;
+         consumer->count       += 1u;
+      }
+   }
+
+   /* Sentinels popped along with our own belong to other consumers. */
+   while (--sentinels != 0) {
+      while (!reboot_ring_mpmc_push(consumer->ring, NULL)) {
+         reboot_check_yield();
+      }
+   }
+}
+
+static void
+reboot_test_mpmc_(void)
+{
+   enum { COUNT = REBOOT_TEST_PRODUCERS_ * REBOOT_TEST_VALUES_ };
+
+   reboot_ring_mpmc_t    ring;
+   reboot_test_producer_ producers[REBOOT_TEST_PRODUCERS_];
+   reboot_test_consumer_ consumers[REBOOT_TEST_CONSUMERS_];
+   reboot_check_thread_t threads[REBOOT_TEST_PRODUCERS_
+                                 + REBOOT_TEST_CONSUMERS_];
+   uint64_t              sum   = 0;
+   size_t                count = 0;
+   size_t                i;
+   size_t                k;
+
+   REBOOT_CHECK(reboot_ring_mpmc_init(&ring, REBOOT_TEST_CAPACITY_) == 0);
+
+   for (i = 0; i < REBOOT_TEST_CONSUMERS_; ++i) {
+      consumers[i].ring  = &ring;
+      consumers[i].sum   = 0;
+      consumers[i].count = 0;
+
+      for (k = 0; k < REBOOT_TEST_PRODUCERS_; ++k) {
+         consumers[i].last[k] = 0;
+      }
+
+      reboot_check_start(
+         &threads[REBOOT_TEST_PRODUCERS_ + i],
+         reboot_test_consume_, &consumers[i]
+      );
+   }
+
+   for (i = 0; i < REBOOT_TEST_PRODUCERS_; ++i) {
+      producers[i].ring  = &ring;
+      producers[i].index = i;
+
+      reboot_check_start(&threads[i], reboot_test_produce_, &producers[i]);
+   }
+
+   for (i = 0; i < REBOOT_TEST_PRODUCERS_; ++i) {
+      reboot_check_join(threads[i]);
+   }
+
+   for (i = 0; i < REBOOT_TEST_CONSUMERS_; ++i) {
+      while (!reboot_ring_mpmc_push(&ring, NULL)) {
+         reboot_check_yield();
+      }
+   }
+
+   for (i = 0; i < REBOOT_TEST_CONSUMERS_; ++i) {
+      reboot_check_join(threads[REBOOT_TEST_PRODUCERS_ + i]);
+
+      sum   += consumers[i].sum;
+      count += consumers[i].count;
+   }
+
+   REBOOT_CHECK(count == COUNT);
+   REBOOT_CHECK(sum == (uint64_t) COUNT * (COUNT + 1u) / 2u);
+
+   reboot_ring_mpmc_destroy(&ring);
+}
+
+/* <!-- }}} Multiple producers and consumers --> */
+
+/* <!-- Single producer and consumer {{{ --> */
+
+static void
+reboot_test_spsc_produce_(void *argument)
+{
+   reboot_ring_spsc_t *ring = (reboot_ring_spsc_t *) argument;
+   void               *items[REBOOT_TEST_BATCH_];
+   size_t              i;
+
+   for (i = 0; i < REBOOT_TEST_VALUES_;) {
+      size_t count = REBOOT_TEST_VALUES_ - i;
+      size_t pushed;
+      size_t k;
+
+      if (count > REBOOT_TEST_BATCH_) {
+         count = REBOOT_TEST_BATCH_;
+      }
+
+      for (k = 0; k < count; ++k) {
+         items[k] = (void *) (uintptr_t) (i + k + 1u);
+      }
+
+      pushed = reboot_ring_spsc_push_batch(ring, items, count);
+
+      if (pushed == 0) {
+         reboot_check_yield();
+      }
+
+      i += pushed;
+   }
+}
+
+static void
+reboot_test_spsc_(void)
+{
+   reboot_ring_spsc_t    ring;
+   reboot_check_thread_t thread;
+   uintptr_t             expected = 1u;
+   void                 *item;
+
+   REBOOT_CHECK(reboot_ring_spsc_init(&ring, REBOOT_TEST_CAPACITY_) == 0);
+
+   reboot_check_start(&thread, reboot_test_spsc_produce_, &ring);
+
+   while (expected <= REBOOT_TEST_VALUES_) {
+      if (!reboot_ring_spsc_pop(&ring, &item)) {
+         reboot_check_yield();
+         continue;
+      }
+
+      REBOOT_CHECK((uintptr_t) item == expected);
+      expected += 1u;
+   }
+
+   reboot_check_join(thread);
+
+   REBOOT_CHECK(!reboot_ring_spsc_pop(&ring, &item));
+
+   reboot_ring_spsc_destroy(&ring);
+}
+
+/* <!-- }}} Single producer and consumer --> */
+
+#endif /* REBOOT_RING_HAS_ATOMICS */
+
+int
+main(void)
+{
+#if defined(REBOOT_RING_HAS_ATOMICS)
+   reboot_test_mpmc_();
+   reboot_test_spsc_();
+#endif
+
+   return EXIT_SUCCESS;
+}
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */
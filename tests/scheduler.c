@@ -0,0 +1,249 @@
+/* ***************************************************
+ *                                                   *
+ *     (C) Copyright scheatkode 2021.                *
+ *                                                   *
+ *     Distributed under  the MIT  License. (See     *
+ *     accompanying file LICENSE  at the root of     *
+ *     the project).                                 *
+ *                                                   *
+ *************************************************** */
+
+/*!
+ * @file  scheduler.c
+ * @brief Task scheduler test.
+ *
+ * Fibonacci  numbers  are  computed with one group per
+ * call,  every  task  spawning  its  two halves into a
+ * group  of  its  own and waiting on it, from the main
+ * thread  and  from  two more foreign threads at once.
+ * Parallel  loops  then cover ranges of various bounds
+ * and  grains,  and are nested within the subranges of
+ * another,  every  index  having to be visited exactly
+ * once and every subrange to respect the grain.
+ */
+
+#include "check.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "scheduler.h"
+
+#define REBOOT_TEST_WORKERS_ 4u
+#define REBOOT_TEST_FOREIGN_ 2u
+#define REBOOT_TEST_LENGTH_  (1u << 18)
+#define REBOOT_TEST_ROWS_    64u
+#define REBOOT_TEST_COLUMNS_ 1024u
+
+/* <!-- Nested groups {{{ --> */
+
+typedef struct reboot_test_call_ {
+   reboot_scheduler_t *scheduler;
+   unsigned            n;
+   uint64_t            result;
+} reboot_test_call_;
+
+static void
+reboot_test_fibonacci_task_(void *argument)
+{
+   reboot_test_call_       *call = (reboot_test_call_ *) argument;
+   reboot_test_call_        halves[2];
+   reboot_scheduler_group_t group;
+   int                      worker;
+
+   worker = reboot_scheduler_current(call->scheduler);
+   REBOOT_CHECK(
+      worker == -1 || (unsigned) worker < call->scheduler->worker_count
+   );
+
+   if (call->n < 2u) {
+      call->result = call->n;
+      return;
+   }
+
+   halves[0].scheduler = call->scheduler;
+   halves[0].n         = call->n - 1u;
+   halves[1].scheduler = call->scheduler;
+   halves[1].n         = call->n - 2u;
+
+   reboot_scheduler_group_init(&group, call->scheduler);
+   reboot_scheduler_spawn(&group, reboot_test_fibonacci_task_, &halves[0]);
+   reboot_scheduler_spawn(&group, reboot_test_fibonacci_task_, &halves[1]);
+   reboot_scheduler_wait(&group);
+
+   call->result = halves[0].result + halves[1].result;
+}
+
+static uint64_t
+reboot_test_fibonacci_(reboot_scheduler_t *scheduler, unsigned n)
+{
+   reboot_test_call_        call;
+   reboot_scheduler_group_t group;
+
+   call.scheduler = scheduler;
+   call.n         = n;
+   call.result    = 0;
+
+   reboot_scheduler_group_init(&group, scheduler);
+   reboot_scheduler_spawn(&group, reboot_test_fibonacci_task_, &call);
+   reboot_scheduler_wait(&group);
+
+   return call.result;
+}
+
+static void
+reboot_test_foreign_(void *argument)
+{
+   reboot_scheduler_t *scheduler = (reboot_scheduler_t *) argument;
+
+   REBOOT_CHECK(reboot_scheduler_current(scheduler) == -1);
+   REBOOT_CHECK(reboot_test_fibonacci_(scheduler, 20u) == 6765u);
+}
+
+static void
+reboot_test_groups_(reboot_scheduler_t *scheduler)
+{
+   reboot_check_thread_t threads[REBOOT_TEST_FOREIGN_];
+   size_t                i;
+
+   for (i = 0; i < REBOOT_TEST_FOREIGN_; ++i) {
+      reboot_check_start(&threads[i], reboot_test_foreign_, scheduler);
+   }
+
+   REBOOT_CHECK(reboot_test_fibonacci_(scheduler, 22u) == 17711u);
+
+   for (i = 0; i < REBOOT_TEST_FOREIGN_; ++i) {
+      reboot_check_join(threads[i]);
+   }
+}
+
+/* <!-- }}} Nested groups --> */
+
+/* <!-- Parallel for {{{ --> */
+
+typedef struct reboot_test_range_ {
+   unsigned char *visits;
+   size_t         grain;
+} reboot_test_range_;
+
+static void
+reboot_test_range_task_(void *argument, size_t begin, size_t end)
+{
+   reboot_test_range_ *range = (reboot_test_range_ *) argument;
+
+   REBOOT_CHECK(begin < end);
+   REBOOT_CHECK(range->grain == 0 || end - begin <= range->grain);
+
+   for (; begin < end; ++begin) {
+      range->visits[begin] += 1u;
+   }
+}
+
+static void
+reboot_test_parallel_for_(
+   reboot_scheduler_t *scheduler, unsigned char *visits,
+   size_t begin, size_t end, size_t grain
+) {
+   reboot_test_range_ range;
+   size_t             i;
+
+   range.visits = visits;
+   range.grain  = grain;
+
+   memset(visits, 0, REBOOT_TEST_LENGTH_);
+
+   reboot_scheduler_parallel_for(
+      scheduler, begin, end, grain, reboot_test_range_task_, &range
+   );
+
+   for (i = 0; i < REBOOT_TEST_LENGTH_; ++i) {
+      REBOOT_CHECK(visits[i] == (i >= begin && i < end));
+   }
+}
+
+typedef struct reboot_test_grid_ {
+   reboot_scheduler_t *scheduler;
+   unsigned char      *visits;
+} reboot_test_grid_;
+
+static void
+reboot_test_row_task_(void *argument, size_t begin, size_t end)
+{
+   reboot_test_grid_ *grid = (reboot_test_grid_ *) argument;
+   reboot_test_range_ range;
+
+   range.grain = 16u;
+
+   for (; begin < end; ++begin) {
+      range.visits = grid->visits + begin * REBOOT_TEST_COLUMNS_;
+
+      reboot_scheduler_parallel_for(
+         grid->scheduler, 0, REBOOT_TEST_COLUMNS_, range.grain,
+         reboot_test_range_task_, &range
+      );
+   }
+}
+
+static void
+reboot_test_ranges_(reboot_scheduler_t *scheduler)
+{
+   static const size_t grains[] = { 0, 1, 7, 1000 };
+
+   reboot_test_grid_ grid;
+   unsigned char    *visits;
+   size_t            i;
+
+   visits = (unsigned char *) malloc(REBOOT_TEST_LENGTH_);
+   REBOOT_CHECK(visits != NULL);
+
+   for (i = 0; i < sizeof(grains) / sizeof(grains[0]); ++i) {
+      reboot_test_parallel_for_(
+         scheduler, visits, 0, REBOOT_TEST_LENGTH_, grains[i]
+      );
+      reboot_test_parallel_for_(
+         scheduler, visits, 13u, REBOOT_TEST_LENGTH_ - 5u, grains[i]
+      );
+      reboot_test_parallel_for_(scheduler, visits, 5u, 6u, grains[i]);
+      reboot_test_parallel_for_(scheduler, visits, 5u, 5u, grains[i]);
+   }
+
+   memset(visits, 0, REBOOT_TEST_LENGTH_);
+
+   grid.scheduler = scheduler;
+   grid.visits    = visits;
+
+   reboot_scheduler_parallel_for(
+      scheduler, 0, REBOOT_TEST_ROWS_, 1u, reboot_test_row_task_, &grid
+   );
+
+   for (i = 0; i < REBOOT_TEST_LENGTH_; ++i) {
+      REBOOT_CHECK(
+         visits[i] == (i < REBOOT_TEST_ROWS_ * REBOOT_TEST_COLUMNS_)
+      );
+   }
+
+   free(visits);
+}
+
+/* <!-- }}} Parallel for --> */
+
+int
+main(void)
+{
+   reboot_scheduler_t scheduler;
+
+   REBOOT_CHECK(
+      reboot_scheduler_init(&scheduler, NULL, REBOOT_TEST_WORKERS_) == 0
+   );
+   REBOOT_CHECK(reboot_scheduler_current(&scheduler) == -1);
+
+   reboot_test_groups_(&scheduler);
+   reboot_test_ranges_(&scheduler);
+
+   reboot_scheduler_destroy(&scheduler);
+
+   return EXIT_SUCCESS;
+}
+
+/* vim: set ft=c et sw=3 fdm=marker fmr={{{,}}} fdl=0: */